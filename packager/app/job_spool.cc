@@ -0,0 +1,113 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/job_spool.h"
+
+#include <algorithm>
+
+#include "packager/base/file_util.h"
+#include "packager/base/files/file_enumerator.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/media/file/file.h"
+
+namespace {
+const char kJobExtension[] = ".job";
+const char kRunningExtension[] = ".running";
+const char kResultExtension[] = ".result";
+const char kTemporaryExtension[] = ".tmp";
+
+// Returns the files in |dir| matching |pattern|, sorted by name.
+std::vector<base::FilePath> ListFiles(const base::FilePath& dir,
+                                      const std::string& pattern) {
+  std::vector<base::FilePath> files;
+  base::FileEnumerator enumerator(
+      dir, false, base::FileEnumerator::FILES, pattern);
+  for (base::FilePath file = enumerator.Next(); !file.empty();
+       file = enumerator.Next()) {
+    files.push_back(file);
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+JobSpool::JobSpool(const std::string& spool_dir)
+    : spool_dir_(spool_dir), recovered_(false) {}
+
+JobSpool::~JobSpool() {}
+
+bool JobSpool::ClaimNextJob(std::string* job_name,
+                            std::vector<std::string>* args) {
+  DCHECK(job_name);
+  DCHECK(args);
+
+  if (!recovered_) {
+    std::vector<base::FilePath> running_jobs =
+        ListFiles(spool_dir_, std::string("*") + kRunningExtension);
+    for (size_t i = 0; i < running_jobs.size(); ++i) {
+      const std::string name =
+          running_jobs[i].BaseName().RemoveExtension().value();
+      LOG(WARNING) << "Job '" << name << "' was interrupted.";
+      CompleteJob(name, false);
+    }
+    recovered_ = true;
+  }
+
+  std::vector<base::FilePath> jobs =
+      ListFiles(spool_dir_, std::string("*") + kJobExtension);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const std::string name = jobs[i].BaseName().RemoveExtension().value();
+    const base::FilePath running_job = GetJobPath(name, kRunningExtension);
+    // The job may have been withdrawn since it was listed.
+    if (!base::Move(jobs[i], running_job))
+      continue;
+
+    std::string contents;
+    if (!File::ReadFileToString(running_job.value().c_str(), &contents)) {
+      LOG(ERROR) << "Failed to read job '" << name << "'.";
+      CompleteJob(name, false);
+      continue;
+    }
+    *job_name = name;
+    args->clear();
+    std::vector<std::string> lines;
+    base::SplitString(contents, '\n', &lines);
+    for (size_t j = 0; j < lines.size(); ++j) {
+      if (!lines[j].empty())
+        args->push_back(lines[j]);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool JobSpool::CompleteJob(const std::string& job_name, bool success) {
+  const std::string result = success ? "OK\n" : "FAILED\n";
+  // Write the result to a temporary file first, so that it is never read
+  // partially.
+  const base::FilePath temporary_result =
+      GetJobPath(job_name, kTemporaryExtension);
+  const int result_size = static_cast<int>(result.size());
+  if (file_util::WriteFile(temporary_result, result.data(), result_size) !=
+          result_size ||
+      !base::Move(temporary_result, GetJobPath(job_name, kResultExtension))) {
+    LOG(ERROR) << "Failed to write the result of job '" << job_name << "'.";
+    return false;
+  }
+  return base::DeleteFile(GetJobPath(job_name, kRunningExtension), false);
+}
+
+base::FilePath JobSpool::GetJobPath(const std::string& job_name,
+                                    const char* extension) const {
+  return spool_dir_.Append(job_name + extension);
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,69 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef APP_JOB_SPOOL_H_
+#define APP_JOB_SPOOL_H_
+
+#include <string>
+#include <vector>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/macros.h"
+
+namespace edash_packager {
+namespace media {
+
+/// Spool directory through which packaging jobs are submitted to a packager
+/// daemon.
+///
+/// A job is submitted by moving a file named <name>.job into the directory.
+/// The file contains the arguments of the job, one per line, in the same
+/// syntax as the packager command line: stream descriptors and --flag=value
+/// options. Arguments may therefore contain spaces. Leading and trailing
+/// white space and empty lines are ignored. The file should be written
+/// elsewhere and renamed into the spool directory, so that it is never read
+/// partially.
+///
+/// While the job runs, the file is renamed to <name>.running. When it
+/// completes, <name>.result is written with "OK" or "FAILED" and the job
+/// file is removed. Jobs are claimed in the order of their names.
+///
+/// Thread Safety: Not thread safe.
+class JobSpool {
+ public:
+  /// @param spool_dir is the spool directory. It should exist.
+  explicit JobSpool(const std::string& spool_dir);
+  ~JobSpool();
+
+  /// Claim the next pending job. Jobs left running by a previous daemon are
+  /// completed as failed.
+  /// @param[out] job_name is set to the name of the job.
+  /// @param[out] args is set to the arguments of the job.
+  /// @return true if a job was claimed, false if there is no pending job.
+  bool ClaimNextJob(std::string* job_name, std::vector<std::string>* args);
+
+  /// Write the result of a job claimed with ClaimNextJob() and remove it from
+  /// the spool.
+  /// @param job_name is the name of the job.
+  /// @param success tells whether the job succeeded.
+  /// @return true on success, false otherwise.
+  bool CompleteJob(const std::string& job_name, bool success);
+
+ private:
+  base::FilePath GetJobPath(const std::string& job_name,
+                            const char* extension) const;
+
+  const base::FilePath spool_dir_;
+  // Set once the jobs left running by a previous daemon have been completed.
+  bool recovered_;
+
+  DISALLOW_COPY_AND_ASSIGN(JobSpool);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // APP_JOB_SPOOL_H_
@@ -51,3 +51,9 @@ DEFINE_double(suggested_presentation_delay,
               0.0,
               "Specifies a delay, in seconds, to be added to the media "
               "presentation time. This value is used for live profile only.");
+DEFINE_double(mpd_write_interval,
+              0.0,
+              "Minimum interval between two writes of the MPD file, in "
+              "seconds. If positive, MPD updates are coalesced and written in "
+              "the background at most once per interval; otherwise the MPD "
+              "is rewritten on every update.");
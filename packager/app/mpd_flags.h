@@ -20,5 +20,6 @@ DECLARE_double(minimum_update_period);
 DECLARE_double(min_buffer_time);
 DECLARE_double(time_shift_buffer_depth);
 DECLARE_double(suggested_presentation_delay);
+DECLARE_double(mpd_write_interval);
 
 #endif  // APP_MPD_FLAGS_H_
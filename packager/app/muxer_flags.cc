@@ -51,3 +51,14 @@ DEFINE_string(temp_dir,
               "Specify a directory in which to store temporary (intermediate) "
               " files. Used only if single_segment=true.");
 
+DEFINE_int32(muxer_queue_size,
+             0,
+             "If positive, each muxer runs on its own thread and receives "
+             "samples from the demuxer through a queue holding up to this "
+             "many samples. The demuxer blocks while a queue is full. If 0, "
+             "samples are muxed on the demuxer thread.");
+DEFINE_int32(num_encryption_threads,
+             0,
+             "Number of threads used to encrypt the samples of a fragment in "
+             "parallel. The threads are shared by all the outputs. If less "
+             "than 2, samples are encrypted one by one on the muxer thread.");
@@ -20,5 +20,7 @@ DECLARE_double(fragment_duration);
 DECLARE_bool(fragment_sap_aligned);
 DECLARE_int32(num_subsegments_per_sidx);
 DECLARE_string(temp_dir);
+DECLARE_int32(muxer_queue_size);
+DECLARE_int32(num_encryption_threads);
 
 #endif  // APP_MUXER_FLAGS_H_
@@ -4,29 +4,30 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <gflags/gflags.h>
+#include <signal.h>
+#include <string.h>
 #include <iostream>
+#include <list>
 
 #include "packager/app/fixed_key_encryption_flags.h"
+#include "packager/app/job_spool.h"
 #include "packager/app/libcrypto_threading.h"
-#include "packager/app/mpd_flags.h"
 #include "packager/app/muxer_flags.h"
 #include "packager/app/packager_util.h"
 #include "packager/app/stream_descriptor.h"
 #include "packager/app/widevine_encryption_flags.h"
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
-#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
 #include "packager/base/strings/stringprintf.h"
-#include "packager/base/threading/simple_thread.h"
-#include "packager/media/base/demuxer.h"
-#include "packager/media/base/key_source.h"
-#include "packager/media/base/muxer_options.h"
-#include "packager/media/base/muxer_util.h"
-#include "packager/media/event/mpd_notify_muxer_listener.h"
-#include "packager/media/event/vod_media_info_dump_muxer_listener.h"
-#include "packager/media/formats/mp4/mp4_muxer.h"
-#include "packager/mpd/base/mpd_builder.h"
-#include "packager/mpd/base/simple_mpd_notifier.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/http_key_fetcher.h"
+#include "packager/packager.h"
 
 namespace {
 const char kUsage[] =
@@ -36,7 +37,7 @@ const char kUsage[] =
     "field_name=value,[field_name=value,]...\n"
     "Supported field names are as follows:\n"
     "  - input (in): Required input/source media file path or network stream "
-    "URL.\n"
+    "URL. Local files prefixed with 'mmap://' are memory mapped.\n"
     "  - stream_selector (stream): Required field with value 'audio', 'video', "
     "or stream number (zero based).\n"
     "  - output (out): Required output file (single file) or initialization "
@@ -48,7 +49,10 @@ const char kUsage[] =
     "  - bandwidth (bw): Optional value which contains a user-specified "
     "content bit rate for the stream, in bits/sec. If specified, this value is "
     "propagated to the $Bandwidth$ template parameter for segment names. "
-    "If not specified, its value may be estimated.\n";
+    "If not specified, its value may be estimated.\n"
+    "With --spool_dir, the packager runs as a daemon and the stream "
+    "descriptors and options of each job are read from a job file instead:\n"
+    "%s --spool_dir=<dir> [flags]\n";
 
 enum ExitStatus {
   kSuccess = 0,
@@ -57,260 +61,246 @@ enum ExitStatus {
   kPackagingFailed,
   kInternalError,
 };
+
+// Set on SIGINT or SIGTERM to stop the daemon.
+volatile sig_atomic_t g_stop_requested = 0;
+
+void RequestStop(int signal_number) {
+  g_stop_requested = 1;
+}
 }  // namespace
 
 namespace edash_packager {
 namespace media {
 
-using event::MpdNotifyMuxerListener;
-using event::MuxerListener;
-using event::VodMediaInfoDumpMuxerListener;
-
-// Demux, Mux(es) and worker thread used to remux a source file/stream.
-class RemuxJob : public base::SimpleThread {
- public:
-  RemuxJob(scoped_ptr<Demuxer> demuxer)
-      : SimpleThread("RemuxJob"),
-        demuxer_(demuxer.Pass()) {}
-
-  virtual ~RemuxJob() {
-    STLDeleteElements(&muxers_);
-  }
-
-  void AddMuxer(scoped_ptr<Muxer> mux) {
-    muxers_.push_back(mux.release());
+// Creates the Packager running the jobs, as configured by the flags.
+scoped_ptr<Packager> CreatePackager() {
+  scoped_ptr<Packager> packager(
+      new Packager(FLAGS_num_remux_threads, FLAGS_num_encryption_threads));
+  if (FLAGS_num_live_ingest_threads > 0) {
+    const size_t kNumLiveIngestReceiveThreads = 1;
+    packager->EnableLiveIngest(kNumLiveIngestReceiveThreads,
+                               FLAGS_num_live_ingest_threads);
   }
+  return packager.Pass();
+}
 
-  Demuxer* demuxer() { return demuxer_.get(); }
-  Status status() { return status_; }
+// Converts the flags to the parameters of a job and runs it.
+bool RunPackager(const StreamDescriptorList& stream_descriptors,
+                 Packager* packager) {
+  PackagingParams params;
+  if (!GetPackagingParams(FlagOverrides(), &params))
+    return false;
 
- private:
-  virtual void Run() OVERRIDE {
-    DCHECK(demuxer_);
-    status_ = demuxer_->Run();
+  Status status = packager->Run(
+      params, std::vector<StreamDescriptor>(stream_descriptors.begin(),
+                                            stream_descriptors.end()));
+  if (!status.ok()) {
+    LOG(ERROR) << "Packaging Error: " << status.ToString();
+    return false;
   }
 
-  scoped_ptr<Demuxer> demuxer_;
-  std::vector<Muxer*> muxers_;
-  Status status_;
-
-  DISALLOW_COPY_AND_ASSIGN(RemuxJob);
-};
+  printf("Packaging completed successfully.\n");
+  return true;
+}
 
-bool CreateRemuxJobs(const StreamDescriptorList& stream_descriptors,
-                     const MuxerOptions& muxer_options,
-                     KeySource* key_source,
-                     MpdNotifier* mpd_notifier,
-                     std::vector<MuxerListener*>* muxer_listeners,
-                     std::vector<RemuxJob*>* remux_jobs) {
-  DCHECK(muxer_listeners);
-  DCHECK(remux_jobs);
-
-  std::string previous_input;
-  for (StreamDescriptorList::const_iterator stream_iter =
-           stream_descriptors.begin();
-       stream_iter != stream_descriptors.end();
-       ++stream_iter) {
-    // Process stream descriptor.
-    MuxerOptions stream_muxer_options(muxer_options);
-    stream_muxer_options.output_file_name = stream_iter->output;
-    if (!stream_iter->segment_template.empty()) {
-      if (!ValidateSegmentTemplate(stream_iter->segment_template)) {
-        LOG(ERROR) << "ERROR: segment template with '"
-                   << stream_iter->segment_template << "' is invalid.";
+// Converts the arguments of a job submitted to the daemon to its parameters.
+// The options of the job override the flags of the daemon.
+bool ParseDaemonJob(const std::vector<std::string>& args,
+                    PackagingParams* params,
+                    std::vector<StreamDescriptor>* stream_descriptors) {
+  FlagOverrides overrides;
+  StreamDescriptorList descriptor_list;
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (StartsWithASCII(args[i], "--", true)) {
+      if (!ParseFlagOverride(args[i], &overrides)) {
+        LOG(ERROR) << "Invalid job option '" << args[i] << "'.";
         return false;
       }
-      stream_muxer_options.segment_template = stream_iter->segment_template;
-    }
-    stream_muxer_options.bandwidth = stream_iter->bandwidth;
-
-    if (stream_iter->input != previous_input) {
-      // New remux job needed. Create demux and job thread.
-      scoped_ptr<Demuxer> demuxer(new Demuxer(stream_iter->input));
-      if (FLAGS_enable_widevine_decryption ||
-          FLAGS_enable_fixed_key_decryption) {
-        scoped_ptr<KeySource> key_source(CreateDecryptionKeySource());
-        if (!key_source)
-          return false;
-        demuxer->SetKeySource(key_source.Pass());
-      }
-      Status status = demuxer->Initialize();
-      if (!status.ok()) {
-        LOG(ERROR) << "Demuxer failed to initialize: " << status.ToString();
-        return false;
-      }
-      if (FLAGS_dump_stream_info) {
-        printf("\nFile \"%s\":\n", stream_iter->input.c_str());
-        DumpStreamInfo(demuxer->streams());
-        if (stream_iter->output.empty())
-          continue;  // just need stream info.
-      }
-      remux_jobs->push_back(new RemuxJob(demuxer.Pass()));
-      previous_input = stream_iter->input;
-    }
-    DCHECK(!remux_jobs->empty());
-
-    scoped_ptr<Muxer> muxer(new mp4::MP4Muxer(stream_muxer_options));
-    if (key_source) {
-      muxer->SetKeySource(key_source,
-                          FLAGS_max_sd_pixels,
-                          FLAGS_clear_lead,
-                          FLAGS_crypto_period_duration);
-    }
-
-    scoped_ptr<MuxerListener> muxer_listener;
-    DCHECK(!(FLAGS_output_media_info && mpd_notifier));
-    if (FLAGS_output_media_info) {
-      const std::string output_mpd_file_name =
-          stream_muxer_options.output_file_name + ".media_info";
-      scoped_ptr<VodMediaInfoDumpMuxerListener>
-          vod_media_info_dump_muxer_listener(
-              new VodMediaInfoDumpMuxerListener(output_mpd_file_name));
-      vod_media_info_dump_muxer_listener->SetContentProtectionSchemeIdUri(
-          FLAGS_scheme_id_uri);
-      muxer_listener = vod_media_info_dump_muxer_listener.Pass();
-    }
-    if (mpd_notifier) {
-      scoped_ptr<MpdNotifyMuxerListener> mpd_notify_muxer_listener(
-          new MpdNotifyMuxerListener(mpd_notifier));
-      mpd_notify_muxer_listener->SetContentProtectionSchemeIdUri(
-          FLAGS_scheme_id_uri);
-      muxer_listener = mpd_notify_muxer_listener.Pass();
-    }
-
-    if (muxer_listener) {
-      muxer_listeners->push_back(muxer_listener.release());
-      muxer->SetMuxerListener(muxer_listeners->back());
-    }
-
-    if (!AddStreamToMuxer(remux_jobs->back()->demuxer()->streams(),
-                          stream_iter->stream_selector,
-                          muxer.get()))
+    } else if (!InsertStreamDescriptor(args[i], &descriptor_list)) {
       return false;
-    remux_jobs->back()->AddMuxer(muxer.Pass());
+    }
   }
-
+  if (!GetPackagingParams(overrides, params))
+    return false;
+  stream_descriptors->assign(descriptor_list.begin(), descriptor_list.end());
   return true;
 }
 
-Status RunRemuxJobs(const std::vector<RemuxJob*>& remux_jobs) {
-  // Start the job threads.
-  for (std::vector<RemuxJob*>::const_iterator job_iter = remux_jobs.begin();
-       job_iter != remux_jobs.end();
-       ++job_iter) {
-    (*job_iter)->Start();
+// A job submitted to the daemon, run on its own thread.
+class DaemonJob {
+ public:
+  DaemonJob(const std::string& name,
+            const PackagingParams& params,
+            const std::vector<StreamDescriptor>& stream_descriptors,
+            Packager* packager)
+      : name_(name),
+        params_(params),
+        stream_descriptors_(stream_descriptors),
+        packager_(packager),
+        done_(true, false),
+        thread_("DaemonJob",
+                base::Bind(&DaemonJob::Run, base::Unretained(this))) {}
+
+  void Start() { thread_.Start(); }
+  bool IsDone() { return done_.IsSignaled(); }
+
+  // Waits for the job to complete. Returns true if it succeeded.
+  bool Join() {
+    thread_.Join();
+    return status_.ok();
   }
 
-  // Wait for all jobs to complete or an error occurs.
-  Status status;
-  bool all_joined;
-  do {
-    all_joined = true;
-    for (std::vector<RemuxJob*>::const_iterator job_iter = remux_jobs.begin();
-         job_iter != remux_jobs.end();
-         ++job_iter) {
-      if ((*job_iter)->HasBeenJoined()) {
-        status = (*job_iter)->status();
-        if (!status.ok())
-          break;
-      } else {
-        all_joined = false;
-        (*job_iter)->Join();
-      }
-    }
-  } while (!all_joined && status.ok());
+  const std::string& name() const { return name_; }
 
-  return status;
-}
-
-bool RunPackager(const StreamDescriptorList& stream_descriptors) {
-  if (!AssignFlagsFromProfile())
-    return false;
-
-  if (FLAGS_output_media_info && !FLAGS_mpd_output.empty()) {
-    NOTIMPLEMENTED() << "ERROR: --output_media_info and --mpd_output do not "
-                        "work together.";
-    return false;
-  }
-  if (FLAGS_output_media_info && !FLAGS_single_segment) {
-    // TODO(rkuroiwa, kqyang): Support partial media info dump for live.
-    NOTIMPLEMENTED() << "ERROR: --output_media_info is only supported if "
-                        "--single_segment is true.";
-    return false;
+ private:
+  void Run() {
+    status_ = packager_->Run(params_, stream_descriptors_);
+    if (status_.ok())
+      LOG(INFO) << "Job '" << name_ << "' completed successfully.";
+    else
+      LOG(ERROR) << "Job '" << name_ << "' failed: " << status_.ToString();
+    done_.Signal();
   }
 
-  // Get basic muxer options.
-  MuxerOptions muxer_options;
-  if (!GetMuxerOptions(&muxer_options))
-    return false;
+  const std::string name_;
+  const PackagingParams params_;
+  const std::vector<StreamDescriptor> stream_descriptors_;
+  Packager* packager_;
+  Status status_;
+  base::WaitableEvent done_;
+  // Declared last, as it runs Run().
+  ClosureThread thread_;
 
-  MpdOptions mpd_options;
-  if (!GetMpdOptions(&mpd_options))
-    return false;
+  DISALLOW_COPY_AND_ASSIGN(DaemonJob);
+};
 
-  // Create encryption key source if needed.
-  scoped_ptr<KeySource> encryption_key_source;
-  if (FLAGS_enable_widevine_encryption || FLAGS_enable_fixed_key_encryption) {
-    encryption_key_source = CreateEncryptionKeySource();
-    if (!encryption_key_source)
-      return false;
+// Writes the result of the jobs in |running_jobs| which have completed, or of
+// all of them, after waiting for them, if |wait| is true. Returns false if a
+// result could not be written.
+bool CompleteDaemonJobs(bool wait,
+                        std::list<DaemonJob*>* running_jobs,
+                        JobSpool* job_spool) {
+  bool success = true;
+  std::list<DaemonJob*>::iterator it = running_jobs->begin();
+  while (it != running_jobs->end()) {
+    if (!wait && !(*it)->IsDone()) {
+      ++it;
+      continue;
+    }
+    const bool job_success = (*it)->Join();
+    if (!job_spool->CompleteJob((*it)->name(), job_success))
+      success = false;
+    delete *it;
+    it = running_jobs->erase(it);
   }
+  return success;
+}
 
-  scoped_ptr<MpdNotifier> mpd_notifier;
-  if (!FLAGS_mpd_output.empty()) {
-    DashProfile profile =
-        FLAGS_single_segment ? kOnDemandProfile : kLiveProfile;
-    std::vector<std::string> base_urls;
-    base::SplitString(FLAGS_base_urls, ',', &base_urls);
-    mpd_notifier.reset(new SimpleMpdNotifier(profile, mpd_options, base_urls,
-                                             FLAGS_mpd_output));
-    if (!mpd_notifier->Init()) {
-      LOG(ERROR) << "MpdNotifier failed to initialize.";
-      return false;
+// Runs the jobs submitted to |FLAGS_spool_dir|, concurrently, until SIGINT or
+// SIGTERM is received. The running jobs are then waited for. A second signal
+// terminates the daemon right away. Returns false on error.
+bool RunDaemon() {
+  JobSpool job_spool(FLAGS_spool_dir);
+  // Keeps the threads and the encryption key sources across jobs.
+  scoped_ptr<Packager> packager = CreatePackager();
+  // Keeps libcurl initialized between the jobs using a key server.
+  HttpKeyFetcher http_key_fetcher;
+
+  struct sigaction stop_action;
+  memset(&stop_action, 0, sizeof(stop_action));
+  stop_action.sa_handler = RequestStop;
+  stop_action.sa_flags = SA_RESETHAND;
+  sigemptyset(&stop_action.sa_mask);
+  sigaction(SIGINT, &stop_action, NULL);
+  sigaction(SIGTERM, &stop_action, NULL);
+
+  std::list<DaemonJob*> running_jobs;
+  STLElementDeleter<std::list<DaemonJob*> > running_jobs_deleter(
+      &running_jobs);
+  const size_t max_running_jobs = FLAGS_spool_max_running_jobs;
+  bool success = true;
+
+  printf("Waiting for jobs in '%s'.\n", FLAGS_spool_dir.c_str());
+  while (!g_stop_requested) {
+    if (!CompleteDaemonJobs(false, &running_jobs, &job_spool)) {
+      success = false;
+      break;
+    }
+    std::string job_name;
+    std::vector<std::string> args;
+    if ((max_running_jobs > 0 && running_jobs.size() >= max_running_jobs) ||
+        !job_spool.ClaimNextJob(&job_name, &args)) {
+      base::PlatformThread::Sleep(
+          base::TimeDelta::FromMilliseconds(FLAGS_spool_poll_interval_ms));
+      continue;
     }
-  }
 
-  // TODO(kqyang): Should Muxer::SetMuxerListener take owership of the
-  // muxer_listeners object? Then we can get rid of |muxer_listeners|.
-  std::vector<MuxerListener*> muxer_listeners;
-  STLElementDeleter<std::vector<MuxerListener*> > deleter(&muxer_listeners);
-  std::vector<RemuxJob*> remux_jobs;
-  STLElementDeleter<std::vector<RemuxJob*> > scoped_jobs_deleter(&remux_jobs);
-  if (!CreateRemuxJobs(stream_descriptors,
-                       muxer_options,
-                       encryption_key_source.get(),
-                       mpd_notifier.get(),
-                       &muxer_listeners,
-                       &remux_jobs)) {
-    return false;
+    PackagingParams params;
+    std::vector<StreamDescriptor> stream_descriptors;
+    if (!ParseDaemonJob(args, &params, &stream_descriptors)) {
+      LOG(ERROR) << "Invalid job '" << job_name << "'.";
+      if (!job_spool.CompleteJob(job_name, false)) {
+        success = false;
+        break;
+      }
+      continue;
+    }
+    LOG(INFO) << "Running job '" << job_name << "'.";
+    DaemonJob* job =
+        new DaemonJob(job_name, params, stream_descriptors, packager.get());
+    running_jobs.push_back(job);
+    job->Start();
   }
 
-  Status status = RunRemuxJobs(remux_jobs);
-  if (!status.ok()) {
-    LOG(ERROR) << "Packaging Error: " << status.ToString();
-    return false;
+  if (!running_jobs.empty()) {
+    printf("Stopping: waiting for %zu running job(s).\n",
+           running_jobs.size());
   }
-
-  printf("Packaging completed successfully.\n");
-  return true;
+  if (!CompleteDaemonJobs(true, &running_jobs, &job_spool))
+    success = false;
+  return success;
 }
 
 int PackagerMain(int argc, char** argv) {
-  google::SetUsageMessage(base::StringPrintf(kUsage, argv[0]));
+  google::SetUsageMessage(base::StringPrintf(kUsage, argv[0], argv[0]));
   google::ParseCommandLineFlags(&argc, &argv, true);
-  if (argc < 2) {
+  if (argc < 2 && FLAGS_spool_dir.empty()) {
     google::ShowUsageWithFlags(argv[0]);
     return kNoArgument;
   }
+  if (argc >= 2 && !FLAGS_spool_dir.empty()) {
+    LOG(ERROR) << "Stream descriptors cannot be specified with --spool_dir.";
+    return kArgumentValidationFailed;
+  }
+  if (FLAGS_spool_max_running_jobs < 0) {
+    LOG(ERROR) << "--spool_max_running_jobs should not be negative.";
+    return kArgumentValidationFailed;
+  }
 
   if (!ValidateWidevineCryptoFlags() || !ValidateFixedCryptoFlags())
     return kArgumentValidationFailed;
+  if (FLAGS_num_remux_threads < 0) {
+    LOG(ERROR) << "--num_remux_threads should not be negative.";
+    return kArgumentValidationFailed;
+  }
+  if (FLAGS_num_encryption_threads < 0) {
+    LOG(ERROR) << "--num_encryption_threads should not be negative.";
+    return kArgumentValidationFailed;
+  }
+  if (FLAGS_num_live_ingest_threads < 0) {
+    LOG(ERROR) << "--num_live_ingest_threads should not be negative.";
+    return kArgumentValidationFailed;
+  }
 
   edash_packager::media::LibcryptoThreading libcrypto_threading;
   if (!libcrypto_threading.Initialize()) {
     LOG(ERROR) << "Could not initialize libcrypto threading.";
     return kInternalError;
   }
+  if (!FLAGS_spool_dir.empty())
+    return RunDaemon() ? kSuccess : kInternalError;
+
   // TODO(tinskip): Make InsertStreamDescriptor a member of
   // StreamDescriptorList.
   StreamDescriptorList stream_descriptors;
@@ -318,7 +308,9 @@ int PackagerMain(int argc, char** argv) {
     if (!InsertStreamDescriptor(argv[i], &stream_descriptors))
       return kArgumentValidationFailed;
   }
-  return RunPackager(stream_descriptors) ? kSuccess : kPackagingFailed;
+  scoped_ptr<Packager> packager = CreatePackager();
+  return RunPackager(stream_descriptors, packager.get()) ? kSuccess
+                                                        : kPackagingFailed;
 }
 
 }  // namespace media
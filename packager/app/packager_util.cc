@@ -8,207 +8,292 @@
 
 #include <gflags/gflags.h>
 #include <iostream>
+#include <set>
 
-#include "packager/app/fixed_key_encryption_flags.h"
-#include "packager/app/mpd_flags.h"
-#include "packager/app/muxer_flags.h"
-#include "packager/app/widevine_encryption_flags.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
-#include "packager/media/base/media_stream.h"
-#include "packager/media/base/muxer.h"
+#include "packager/base/strings/string_split.h"
+#include "packager/base/strings/string_util.h"
 #include "packager/media/base/muxer_options.h"
-#include "packager/media/base/request_signer.h"
-#include "packager/media/base/stream_info.h"
-#include "packager/media/base/widevine_key_source.h"
-#include "packager/media/file/file.h"
 #include "packager/mpd/base/mpd_builder.h"
+#include "packager/packager.h"
 
 DEFINE_bool(dump_stream_info, false, "Dump demuxed stream info.");
+DEFINE_int32(read_ahead_num_buffers,
+             0,
+             "If at least 2, input files are read ahead on a separate thread "
+             "using this many buffers, so that reads overlap with parsing. "
+             "Useful for inputs on network file systems.");
+DEFINE_int32(read_ahead_buffer_size,
+             0x40000,
+             "Size in bytes of each read-ahead buffer. Used only if "
+             "read_ahead_num_buffers is at least 2.");
+DEFINE_int32(num_remux_threads,
+             0,
+             "Maximum number of inputs remuxed at the same time. Inputs are "
+             "queued until a thread is available, and the first failure "
+             "cancels the remaining inputs. If 0, all the inputs are remuxed "
+             "at the same time. Live inputs need one thread each, unless "
+             "received with --num_live_ingest_threads.");
+DEFINE_int32(num_live_ingest_threads,
+             0,
+             "If positive, the UDP inputs are received by a single epoll "
+             "thread and parsed and muxed on this many shared threads, "
+             "instead of each being read on its own thread. They do not use "
+             "the --num_remux_threads threads. Only supported on Linux. "
+             "Useful to ingest many live channels.");
+DEFINE_string(performance_report,
+              "",
+              "If set, write a JSON report of the time spent and the data "
+              "processed by each stage of the pipeline (read, parse, "
+              "decrypt, encrypt, fragment, segment, write), for each stream, "
+              "to this file when packaging completes.");
+DEFINE_double(performance_report_interval,
+              0,
+              "If positive, also rewrite --performance_report at this "
+              "interval, in seconds, while packaging. Useful for live "
+              "inputs.");
+DEFINE_string(spool_dir,
+              "",
+              "If set, run as a daemon packaging the jobs submitted to this "
+              "directory. A job is a file named <name>.job, moved into the "
+              "directory, which contains the stream descriptors and the "
+              "--flag=value packaging options of the job, one per line. The "
+              "result is written to <name>.result. On SIGINT or SIGTERM, the "
+              "daemon stops claiming jobs and exits once the running jobs "
+              "complete.");
+DEFINE_int32(spool_poll_interval_ms,
+             1000,
+             "Interval in milliseconds between scans of --spool_dir for new "
+             "jobs while idle.");
+DEFINE_int32(spool_max_running_jobs,
+             0,
+             "Maximum number of jobs run at the same time by the daemon. "
+             "Jobs are claimed from --spool_dir when a slot is available. If "
+             "0, all the jobs submitted are run at the same time. Live jobs "
+             "need one slot each.");
 
 namespace edash_packager {
 namespace media {
 
-void DumpStreamInfo(const std::vector<MediaStream*>& streams) {
-  printf("Found %zu stream(s).\n", streams.size());
-  for (size_t i = 0; i < streams.size(); ++i)
-    printf("Stream [%zu] %s\n", i, streams[i]->info()->ToString().c_str());
-}
+namespace {
 
-scoped_ptr<RequestSigner> CreateSigner() {
-  scoped_ptr<RequestSigner> signer;
-
-  if (!FLAGS_aes_signing_key.empty()) {
-    signer.reset(AesRequestSigner::CreateSigner(
-        FLAGS_signer, FLAGS_aes_signing_key, FLAGS_aes_signing_iv));
-    if (!signer) {
-      LOG(ERROR) << "Cannot create an AES signer object from '"
-                 << FLAGS_aes_signing_key << "':'" << FLAGS_aes_signing_iv
-                 << "'.";
-      return scoped_ptr<RequestSigner>();
-    }
-  } else if (!FLAGS_rsa_signing_key_path.empty()) {
-    std::string rsa_private_key;
-    if (!File::ReadFileToString(FLAGS_rsa_signing_key_path.c_str(),
-                                &rsa_private_key)) {
-      LOG(ERROR) << "Failed to read from '" << FLAGS_rsa_signing_key_path
-                 << "'.";
-      return scoped_ptr<RequestSigner>();
-    }
-    signer.reset(RsaRequestSigner::CreateSigner(FLAGS_signer, rsa_private_key));
-    if (!signer) {
-      LOG(ERROR) << "Cannot create a RSA signer object from '"
-                 << FLAGS_rsa_signing_key_path << "'.";
-      return scoped_ptr<RequestSigner>();
-    }
+// Reads the values of the flags, or of their overrides.
+class FlagReader {
+ public:
+  explicit FlagReader(const FlagOverrides& overrides)
+      : overrides_(overrides), success_(true) {}
+
+  std::string GetString(const char* name) { return GetValue(name); }
+
+  bool GetBool(const char* name) {
+    const std::string value = GetValue(name);
+    if (value == "true" || value == "1")
+      return true;
+    if (value != "false" && value != "0")
+      ReportInvalidValue(name, value);
+    return false;
   }
-  return signer.Pass();
-}
 
-scoped_ptr<KeySource> CreateEncryptionKeySource() {
-  scoped_ptr<KeySource> encryption_key_source;
-  if (FLAGS_enable_widevine_encryption) {
-    scoped_ptr<WidevineKeySource> widevine_key_source(
-        new WidevineKeySource(FLAGS_key_server_url));
-    if (!FLAGS_signer.empty()) {
-      scoped_ptr<RequestSigner> request_signer(CreateSigner());
-      if (!request_signer)
-        return scoped_ptr<KeySource>();
-      widevine_key_source->set_signer(request_signer.Pass());
-    }
+  int GetInt32(const char* name) {
+    const std::string value = GetValue(name);
+    int result = 0;
+    if (!base::StringToInt(value, &result))
+      ReportInvalidValue(name, value);
+    return result;
+  }
 
-    std::vector<uint8_t> content_id;
-    if (!base::HexStringToBytes(FLAGS_content_id, &content_id)) {
-      LOG(ERROR) << "Invalid content_id hex string specified.";
-      return scoped_ptr<KeySource>();
-    }
-    Status status = widevine_key_source->FetchKeys(content_id, FLAGS_policy);
-    if (!status.ok()) {
-      LOG(ERROR) << "Widevine encryption key source failed to fetch keys: "
-                 << status.ToString();
-      return scoped_ptr<KeySource>();
-    }
-    encryption_key_source = widevine_key_source.Pass();
-  } else if (FLAGS_enable_fixed_key_encryption) {
-    encryption_key_source = KeySource::CreateFromHexStrings(
-        FLAGS_key_id, FLAGS_key, FLAGS_pssh, "");
+  double GetDouble(const char* name) {
+    const std::string value = GetValue(name);
+    double result = 0;
+    if (!base::StringToDouble(value, &result))
+      ReportInvalidValue(name, value);
+    return result;
   }
-  return encryption_key_source.Pass();
-}
 
-scoped_ptr<KeySource> CreateDecryptionKeySource() {
-  scoped_ptr<KeySource> decryption_key_source;
-  if (FLAGS_enable_widevine_decryption) {
-    scoped_ptr<WidevineKeySource> widevine_key_source(
-        new WidevineKeySource(FLAGS_key_server_url));
-    if (!FLAGS_signer.empty()) {
-      scoped_ptr<RequestSigner> request_signer(CreateSigner());
-      if (!request_signer)
-        return scoped_ptr<KeySource>();
-      widevine_key_source->set_signer(request_signer.Pass());
+  // Returns true if all the values read were valid and all the overrides
+  // were read.
+  bool Finish() {
+    for (FlagOverrides::const_iterator it = overrides_.begin();
+         it != overrides_.end();
+         ++it) {
+      if (read_names_.find(it->first) == read_names_.end()) {
+        LOG(ERROR) << "'--" << it->first << "' is not a packaging option.";
+        success_ = false;
+      }
     }
+    return success_;
+  }
 
-    decryption_key_source = widevine_key_source.Pass();
-  } else if (FLAGS_enable_fixed_key_decryption) {
-    decryption_key_source =
-        KeySource::CreateFromHexStrings(FLAGS_key_id, FLAGS_key, "", "");
+ private:
+  std::string GetValue(const char* name) {
+    read_names_.insert(name);
+    FlagOverrides::const_iterator it = overrides_.find(name);
+    if (it != overrides_.end())
+      return it->second;
+    std::string value;
+    CHECK(google::GetCommandLineOption(name, &value)) << name;
+    return value;
   }
-  return decryption_key_source.Pass();
-}
 
-bool AssignFlagsFromProfile() {
-  bool single_segment = FLAGS_single_segment;
-  if (FLAGS_profile == "on-demand") {
-    single_segment = true;
-  } else if (FLAGS_profile == "live") {
-    single_segment = false;
-  } else if (FLAGS_profile != "") {
+  void ReportInvalidValue(const char* name, const std::string& value) {
+    LOG(ERROR) << "Invalid value '" << value << "' for '--" << name << "'.";
+    success_ = false;
+  }
+
+  const FlagOverrides& overrides_;
+  std::set<std::string> read_names_;
+  bool success_;
+
+  DISALLOW_COPY_AND_ASSIGN(FlagReader);
+};
+
+// Gets --single_segment, as implied by --profile if set.
+bool GetSingleSegment(FlagReader* reader, bool* single_segment) {
+  const std::string profile = reader->GetString("profile");
+  const bool single_segment_flag = reader->GetBool("single_segment");
+  *single_segment = single_segment_flag;
+  if (profile == "on-demand") {
+    *single_segment = true;
+  } else if (profile == "live") {
+    *single_segment = false;
+  } else if (profile != "") {
     fprintf(stderr, "ERROR: --profile '%s' is not supported.\n",
-            FLAGS_profile.c_str());
+            profile.c_str());
     return false;
   }
 
-  if (FLAGS_single_segment != single_segment) {
-    FLAGS_single_segment = single_segment;
+  if (single_segment_flag != *single_segment) {
     fprintf(stdout, "Profile %s: set --single_segment to %s.\n",
-            FLAGS_profile.c_str(), single_segment ? "true" : "false");
+            profile.c_str(), *single_segment ? "true" : "false");
   }
   return true;
 }
 
-bool GetMuxerOptions(MuxerOptions* muxer_options) {
-  DCHECK(muxer_options);
-
-  muxer_options->single_segment = FLAGS_single_segment;
-  muxer_options->segment_duration = FLAGS_segment_duration;
-  muxer_options->fragment_duration = FLAGS_fragment_duration;
-  muxer_options->segment_sap_aligned = FLAGS_segment_sap_aligned;
-  muxer_options->fragment_sap_aligned = FLAGS_fragment_sap_aligned;
-  muxer_options->num_subsegments_per_sidx = FLAGS_num_subsegments_per_sidx;
-  muxer_options->temp_dir = FLAGS_temp_dir;
+bool GetMuxerOptions(FlagReader* reader, MuxerOptions* muxer_options) {
+  if (!GetSingleSegment(reader, &muxer_options->single_segment))
+    return false;
+  muxer_options->segment_duration = reader->GetDouble("segment_duration");
+  muxer_options->fragment_duration = reader->GetDouble("fragment_duration");
+  muxer_options->segment_sap_aligned = reader->GetBool("segment_sap_aligned");
+  muxer_options->fragment_sap_aligned =
+      reader->GetBool("fragment_sap_aligned");
+  muxer_options->num_subsegments_per_sidx =
+      reader->GetInt32("num_subsegments_per_sidx");
+  muxer_options->temp_dir = reader->GetString("temp_dir");
   return true;
 }
 
-bool GetMpdOptions(MpdOptions* mpd_options) {
-  DCHECK(mpd_options);
-
-  mpd_options->availability_time_offset = FLAGS_availability_time_offset;
-  mpd_options->minimum_update_period = FLAGS_minimum_update_period;
-  mpd_options->min_buffer_time = FLAGS_min_buffer_time;
-  mpd_options->time_shift_buffer_depth = FLAGS_time_shift_buffer_depth;
+void GetMpdOptions(FlagReader* reader, MpdOptions* mpd_options) {
+  mpd_options->availability_time_offset =
+      reader->GetDouble("availability_time_offset");
+  mpd_options->minimum_update_period =
+      reader->GetDouble("minimum_update_period");
+  mpd_options->min_buffer_time = reader->GetDouble("min_buffer_time");
+  mpd_options->time_shift_buffer_depth =
+      reader->GetDouble("time_shift_buffer_depth");
   mpd_options->suggested_presentation_delay =
-      FLAGS_suggested_presentation_delay;
-  return true;
+      reader->GetDouble("suggested_presentation_delay");
+  mpd_options->mpd_write_interval = reader->GetDouble("mpd_write_interval");
 }
 
-MediaStream* FindFirstStreamOfType(const std::vector<MediaStream*>& streams,
-                                   StreamType stream_type) {
-  typedef std::vector<MediaStream*>::const_iterator StreamIterator;
-  for (StreamIterator it = streams.begin(); it != streams.end(); ++it) {
-    if ((*it)->info()->stream_type() == stream_type)
-      return *it;
+}  // namespace
+
+bool ParseFlagOverride(const std::string& argument, FlagOverrides* overrides) {
+  DCHECK(overrides);
+
+  if (!StartsWithASCII(argument, "--", true))
+    return false;
+  const std::string option = argument.substr(2);
+  const size_t equal_pos = option.find('=');
+  if (equal_pos != std::string::npos) {
+    (*overrides)[option.substr(0, equal_pos)] = option.substr(equal_pos + 1);
+    return true;
   }
-  return NULL;
-}
-MediaStream* FindFirstVideoStream(const std::vector<MediaStream*>& streams) {
-  return FindFirstStreamOfType(streams, kStreamVideo);
-}
-MediaStream* FindFirstAudioStream(const std::vector<MediaStream*>& streams) {
-  return FindFirstStreamOfType(streams, kStreamAudio);
+  google::CommandLineFlagInfo flag_info;
+  if (google::GetCommandLineFlagInfo(option.c_str(), &flag_info) &&
+      flag_info.type == "bool") {
+    (*overrides)[option] = "true";
+    return true;
+  }
+  if (StartsWithASCII(option, "no", true) &&
+      google::GetCommandLineFlagInfo(option.substr(2).c_str(), &flag_info) &&
+      flag_info.type == "bool") {
+    (*overrides)[option.substr(2)] = "false";
+    return true;
+  }
+  return false;
 }
 
-bool AddStreamToMuxer(const std::vector<MediaStream*>& streams,
-                      const std::string& stream_selector,
-                      Muxer* muxer) {
-  DCHECK(muxer);
-
-  MediaStream* stream = NULL;
-  if (stream_selector == "video") {
-    stream = FindFirstVideoStream(streams);
-  } else if (stream_selector == "audio") {
-    stream = FindFirstAudioStream(streams);
-  } else {
-    // Expect stream_selector to be a zero based stream id.
-    size_t stream_id;
-    if (!base::StringToSizeT(stream_selector, &stream_id) ||
-        stream_id >= streams.size()) {
-      LOG(ERROR) << "Invalid argument --stream=" << stream_selector << "; "
-                 << "should be 'audio', 'video', or a number within [0, "
-                 << streams.size() - 1 << "].";
-      return false;
-    }
-    stream = streams[stream_id];
-    DCHECK(stream);
-  }
+bool GetPackagingParams(const FlagOverrides& overrides,
+                        PackagingParams* params) {
+  DCHECK(params);
 
-  // This could occur only if stream_selector=audio|video and the corresponding
-  // stream does not exist in the input.
-  if (!stream) {
-    LOG(ERROR) << "No " << stream_selector << " stream found in the input.";
+  FlagReader reader(overrides);
+  if (!GetMuxerOptions(&reader, &params->muxer_options))
     return false;
+  GetMpdOptions(&reader, &params->mpd_options);
+
+  params->mpd_output = reader.GetString("mpd_output");
+  base::SplitString(reader.GetString("base_urls"), ',', &params->base_urls);
+  params->output_media_info = reader.GetBool("output_media_info");
+  params->scheme_id_uri = reader.GetString("scheme_id_uri");
+  params->dump_stream_info = reader.GetBool("dump_stream_info");
+  params->muxer_queue_size = reader.GetInt32("muxer_queue_size");
+  params->read_ahead_num_buffers = reader.GetInt32("read_ahead_num_buffers");
+  params->read_ahead_buffer_size = reader.GetInt32("read_ahead_buffer_size");
+  params->performance_report_output = reader.GetString("performance_report");
+  params->performance_report_interval =
+      reader.GetDouble("performance_report_interval");
+
+  WidevineKeyServerParams key_server;
+  key_server.key_server_url = reader.GetString("key_server_url");
+  key_server.signer = reader.GetString("signer");
+  key_server.aes_signing_key = reader.GetString("aes_signing_key");
+  key_server.aes_signing_iv = reader.GetString("aes_signing_iv");
+  key_server.rsa_signing_key_path = reader.GetString("rsa_signing_key_path");
+  // All the options are read, so that none is reported as unexpected.
+  const bool enable_widevine_encryption =
+      reader.GetBool("enable_widevine_encryption");
+  const bool enable_fixed_key_encryption =
+      reader.GetBool("enable_fixed_key_encryption");
+  const bool enable_widevine_decryption =
+      reader.GetBool("enable_widevine_decryption");
+  const bool enable_fixed_key_decryption =
+      reader.GetBool("enable_fixed_key_decryption");
+  const std::string content_id = reader.GetString("content_id");
+  const std::string policy = reader.GetString("policy");
+  const std::string key_id = reader.GetString("key_id");
+  const std::string key = reader.GetString("key");
+  const std::string pssh = reader.GetString("pssh");
+
+  EncryptionParams* encryption_params = &params->encryption_params;
+  if (enable_widevine_encryption) {
+    encryption_params->key_provider = kWidevineKeyProvider;
+    encryption_params->key_server = key_server;
+    encryption_params->content_id = content_id;
+    encryption_params->policy = policy;
+  } else if (enable_fixed_key_encryption) {
+    encryption_params->key_provider = kFixedKeyProvider;
+    encryption_params->key_id = key_id;
+    encryption_params->key = key;
+    encryption_params->pssh = pssh;
   }
-  muxer->AddStream(stream);
-  return true;
+  encryption_params->max_sd_pixels = reader.GetInt32("max_sd_pixels");
+  encryption_params->clear_lead = reader.GetDouble("clear_lead");
+  encryption_params->crypto_period_duration =
+      reader.GetInt32("crypto_period_duration");
+
+  DecryptionParams* decryption_params = &params->decryption_params;
+  if (enable_widevine_decryption) {
+    decryption_params->key_provider = kWidevineKeyProvider;
+    decryption_params->key_server = key_server;
+  } else if (enable_fixed_key_decryption) {
+    decryption_params->key_provider = kFixedKeyProvider;
+    decryption_params->key_id = key_id;
+    decryption_params->key = key;
+  }
+  return reader.Finish();
 }
 
 }  // namespace media
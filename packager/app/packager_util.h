@@ -10,59 +10,42 @@
 #define APP_PACKAGER_UTIL_H_
 
 #include <gflags/gflags.h>
-#include <string>
-#include <vector>
 
-#include "packager/base/memory/scoped_ptr.h"
+#include <map>
+#include <string>
 
 DECLARE_bool(dump_stream_info);
+DECLARE_int32(read_ahead_num_buffers);
+DECLARE_int32(read_ahead_buffer_size);
+DECLARE_int32(num_remux_threads);
+DECLARE_int32(num_live_ingest_threads);
+DECLARE_string(performance_report);
+DECLARE_double(performance_report_interval);
+DECLARE_string(spool_dir);
+DECLARE_int32(spool_poll_interval_ms);
+DECLARE_int32(spool_max_running_jobs);
 
 namespace edash_packager {
-
-struct MpdOptions;
-
 namespace media {
 
-class KeySource;
-class MediaInfo;
-class MediaStream;
-class Muxer;
-struct MuxerOptions;
-
-/// Print all the stream info for the provided strings to standard output.
-void DumpStreamInfo(const std::vector<MediaStream*>& streams);
-
-/// Create KeySource based on provided command line options for content
-/// encryption. Also fetches keys.
-/// @return A scoped_ptr containing a new KeySource, or NULL if
-///         encryption is not required.
-scoped_ptr<KeySource> CreateEncryptionKeySource();
-
-/// Create KeySource based on provided command line options for content
-/// decryption. Does not fetch keys.
-/// @return A scoped_ptr containing a new KeySource, or NULL if decryption
-///         is not required.
-scoped_ptr<KeySource> CreateDecryptionKeySource();
-
-/// Set flags according to profile.
-bool AssignFlagsFromProfile();
+struct PackagingParams;
 
-/// Fill MuxerOptions members using provided command line options.
-bool GetMuxerOptions(MuxerOptions* muxer_options);
+/// Values overriding the command line options, keyed by flag name.
+typedef std::map<std::string, std::string> FlagOverrides;
 
-/// Fill MpdOptions members using provided command line options.
-bool GetMpdOptions(edash_packager::MpdOptions* mpd_options);
+/// Parse an option of the form "--name=value", "--name" or "--noname", the
+/// latter two for boolean flags, into |overrides|. The flags are not
+/// modified.
+/// @return true on success, false if |argument| is not an option.
+bool ParseFlagOverride(const std::string& argument, FlagOverrides* overrides);
 
-/// Select and add a stream from a provided set to a muxer.
-/// @param streams contains the set of MediaStreams from which to select.
-/// @param stream_selector is a string containing one of the following values:
-///        "audio" to select the first audio track, "video" to select the first
-///        video track, or a decimal number indicating which track number to
-///        select (start at "1").
-/// @return true if successful, false otherwise.
-bool AddStreamToMuxer(const std::vector<MediaStream*>& streams,
-                      const std::string& stream_selector,
-                      Muxer* muxer);
+/// Fill PackagingParams members using provided command line options, with the
+/// values in |overrides| taking precedence. The options in |overrides| are
+/// expected to be packaging options, and to convert to the type of their
+/// flag.
+/// @return true on success, false otherwise. May print error messages.
+bool GetPackagingParams(const FlagOverrides& overrides,
+                        PackagingParams* params);
 
 }  // namespace media
 }  // namespace edash_packager
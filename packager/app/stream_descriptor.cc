@@ -6,7 +6,6 @@
 
 #include "packager/app/stream_descriptor.h"
 
-#include "packager/app/packager_util.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_split.h"
@@ -55,10 +54,6 @@ FieldType GetFieldType(const std::string& field_name) {
 
 }  // anonymous namespace
 
-StreamDescriptor::StreamDescriptor() : bandwidth(0) {}
-
-StreamDescriptor::~StreamDescriptor() {}
-
 bool InsertStreamDescriptor(const std::string& descriptor_string,
                             StreamDescriptorList* descriptor_list) {
   StreamDescriptor descriptor;
@@ -108,14 +103,6 @@ bool InsertStreamDescriptor(const std::string& descriptor_string,
     LOG(ERROR) << "Stream input not specified.";
     return false;
   }
-  if (!FLAGS_dump_stream_info && descriptor.stream_selector.empty()) {
-    LOG(ERROR) << "Stream stream_selector not specified.";
-    return false;
-  }
-  if (!FLAGS_dump_stream_info && descriptor.output.empty()) {
-    LOG(ERROR) << "Stream output not specified.";
-    return false;
-  }
   descriptor_list->insert(descriptor);
   return true;
 }
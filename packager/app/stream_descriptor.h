@@ -7,27 +7,14 @@
 #ifndef APP_STREAM_DESCRIPTOR_H_
 #define APP_STREAM_DESCRIPTOR_H_
 
-#include <stdint.h>
-
 #include <set>
 #include <string>
 
+#include "packager/packager.h"
+
 namespace edash_packager {
 namespace media {
 
-/// Defines a single input/output stream, it's input source, output destination,
-/// stream selector, and optional segment template and user-specified bandwidth.
-struct StreamDescriptor {
-  StreamDescriptor();
-  ~StreamDescriptor();
-
-  std::string stream_selector;
-  std::string input;
-  std::string output;
-  std::string segment_template;
-  uint32_t bandwidth;
-};
-
 class StreamDescriptorCompareFn {
  public:
   bool operator()(const StreamDescriptor& a, const StreamDescriptor& b) {
@@ -0,0 +1,135 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/key_source_cache.h"
+
+#include "packager/base/logging.h"
+#include "packager/media/base/key_source.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+// Returns true if the key sources created from |a| and |b| are the same.
+// Only the fields used to create a key source are compared.
+bool IsSameKeySource(const EncryptionParams& a, const EncryptionParams& b) {
+  const WidevineKeyServerParams& a_server = a.key_server;
+  const WidevineKeyServerParams& b_server = b.key_server;
+  return a.key_provider == b.key_provider &&
+         a_server.key_server_url == b_server.key_server_url &&
+         a_server.signer == b_server.signer &&
+         a_server.aes_signing_key == b_server.aes_signing_key &&
+         a_server.aes_signing_iv == b_server.aes_signing_iv &&
+         a_server.rsa_signing_key_path == b_server.rsa_signing_key_path &&
+         a.content_id == b.content_id && a.policy == b.policy &&
+         a.key_id == b.key_id && a.key == b.key && a.pssh == b.pssh;
+}
+
+}  // namespace
+
+KeySourceCache::KeySourceCache(size_t max_entries,
+                               const CreateKeySourceCB& create_key_source_cb)
+    : max_entries_(max_entries),
+      create_key_source_cb_(create_key_source_cb),
+      created_cv_(&lock_) {}
+
+KeySourceCache::~KeySourceCache() {
+  for (std::list<Entry>::iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    DCHECK_EQ(0, it->num_users);
+    delete it->key_source;
+  }
+}
+
+Status KeySourceCache::Acquire(const EncryptionParams& params,
+                               KeySource** key_source) {
+  DCHECK(key_source);
+
+  base::AutoLock auto_lock(lock_);
+  std::list<Entry>::iterator it = FindEntry(params);
+  // Another thread is creating the key source. The entry is removed if the
+  // creation fails, in which case it is created again.
+  while (it != entries_.end() && !it->key_source) {
+    created_cv_.Wait();
+    it = FindEntry(params);
+  }
+  if (it != entries_.end()) {
+    ++it->num_users;
+    *key_source = it->key_source;
+    return Status::OK;
+  }
+
+  if (entries_.size() >= max_entries_)
+    EvictOldestUnused();
+  // Entries in use are not evicted, so |it| remains valid while the lock is
+  // released.
+  entries_.push_back(Entry());
+  it = --entries_.end();
+  it->params = params;
+  it->key_source = NULL;
+  it->num_users = 1;
+
+  scoped_ptr<KeySource> new_key_source;
+  Status status;
+  {
+    base::AutoUnlock auto_unlock(lock_);
+    status = create_key_source_cb_.Run(params, &new_key_source);
+  }
+  created_cv_.Broadcast();
+  if (!status.ok()) {
+    entries_.erase(it);
+    return status;
+  }
+  DCHECK(new_key_source);
+  it->key_source = new_key_source.release();
+  *key_source = it->key_source;
+  return Status::OK;
+}
+
+void KeySourceCache::Release(KeySource* key_source) {
+  base::AutoLock auto_lock(lock_);
+  for (std::list<Entry>::iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->key_source == key_source) {
+      DCHECK_GT(it->num_users, 0);
+      --it->num_users;
+      return;
+    }
+  }
+  NOTREACHED();
+}
+
+size_t KeySourceCache::size() {
+  base::AutoLock auto_lock(lock_);
+  return entries_.size();
+}
+
+std::list<KeySourceCache::Entry>::iterator KeySourceCache::FindEntry(
+    const EncryptionParams& params) {
+  lock_.AssertAcquired();
+  for (std::list<Entry>::iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (IsSameKeySource(it->params, params))
+      return it;
+  }
+  return entries_.end();
+}
+
+void KeySourceCache::EvictOldestUnused() {
+  lock_.AssertAcquired();
+  for (std::list<Entry>::iterator it = entries_.begin(); it != entries_.end();
+       ++it) {
+    if (it->num_users == 0) {
+      delete it->key_source;
+      entries_.erase(it);
+      return;
+    }
+  }
+}
+
+}  // namespace media
+}  // namespace edash_packager
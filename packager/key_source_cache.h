@@ -0,0 +1,89 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_KEY_SOURCE_CACHE_H_
+#define PACKAGER_KEY_SOURCE_CACHE_H_
+
+#include <list>
+
+#include "packager/base/callback.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/base/status.h"
+#include "packager/packager.h"
+
+namespace edash_packager {
+namespace media {
+
+class KeySource;
+
+/// Encryption key sources shared by packaging jobs, keyed by the parameters
+/// they are created from, so that the keys, request signer and key server
+/// requests of a content packaged by several jobs are set up once. Key
+/// sources in use are never evicted.
+///
+/// Thread Safety: All the methods may be called from any thread. A key
+/// source is created without holding the lock of the cache, e.g. while its
+/// keys are fetched from a key server, so that the other key sources can be
+/// acquired meanwhile. Acquiring the key source being created waits for it.
+class KeySourceCache {
+ public:
+  typedef base::Callback<Status(const EncryptionParams&,
+                                scoped_ptr<KeySource>*)> CreateKeySourceCB;
+
+  /// @param max_entries is the number of key sources from which the oldest
+  ///        one not in use is evicted to make room for a new one.
+  /// @param create_key_source_cb creates the key source for a set of
+  ///        parameters.
+  KeySourceCache(size_t max_entries,
+                 const CreateKeySourceCB& create_key_source_cb);
+  ~KeySourceCache();
+
+  /// Get the key source for @a params, creating it if it is not cached.
+  /// @param params contains the parameters of the key source.
+  /// @param[out] key_source is set to the key source, owned by the cache. It
+  ///             remains valid until it is released with Release().
+  /// @return OK on success, the error returned by the creation callback
+  ///         otherwise.
+  Status Acquire(const EncryptionParams& params, KeySource** key_source);
+
+  /// Release a key source returned by Acquire().
+  void Release(KeySource* key_source);
+
+  /// @return the number of cached key sources, including the ones being
+  ///         created.
+  size_t size();
+
+ private:
+  struct Entry {
+    EncryptionParams params;
+    // NULL while the key source is created.
+    KeySource* key_source;
+    // Includes the creator of the key source while it is created.
+    int num_users;
+  };
+
+  // Returns the entry of the key source for |params|, or entries_.end().
+  std::list<Entry>::iterator FindEntry(const EncryptionParams& params);
+  void EvictOldestUnused();
+
+  const size_t max_entries_;
+  const CreateKeySourceCB create_key_source_cb_;
+
+  base::Lock lock_;
+  // Signaled when a key source is created, or fails to be.
+  base::ConditionVariable created_cv_;
+  // In order of creation. Protected by |lock_|.
+  std::list<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeySourceCache);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // PACKAGER_KEY_SOURCE_CACHE_H_
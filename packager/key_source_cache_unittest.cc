@@ -0,0 +1,231 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/key_source_cache.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/key_source.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+const size_t kMaxEntries = 2;
+const char kKeyIdHex[] = "e5007e6e9dcd5ac095202ed3758382cd";
+const char kKeyHex[] = "6fc96fe628a265b13aeddec0bc421f4d";
+const char kFailingContentId[] = "failing";
+const char kSlowContentId[] = "slow";
+
+EncryptionParams GetParams(const std::string& key_id,
+                           const std::string& key) {
+  EncryptionParams params;
+  params.key_provider = kFixedKeyProvider;
+  params.key_id = key_id;
+  params.key = key;
+  return params;
+}
+
+void AcquireKeySource(KeySourceCache* cache,
+                      const EncryptionParams& params,
+                      Status* status,
+                      KeySource** key_source) {
+  *status = cache->Acquire(params, key_source);
+}
+
+}  // namespace
+
+class KeySourceCacheTest : public ::testing::Test {
+ public:
+  KeySourceCacheTest()
+      : num_created_(0),
+        slow_creation_started_(true, false),
+        slow_creation_released_(true, false),
+        cache_(kMaxEntries,
+               base::Bind(&KeySourceCacheTest::CreateKeySource,
+                          base::Unretained(this))) {}
+
+ protected:
+  // Creates the same key source whatever the parameters, so that the cache
+  // alone tells the parameters apart.
+  // Creating the key source for kSlowContentId blocks until
+  // |slow_creation_released_| is signaled, like a key server request.
+  Status CreateKeySource(const EncryptionParams& params,
+                         scoped_ptr<KeySource>* key_source) {
+    if (params.content_id == kFailingContentId)
+      return Status(error::SERVER_ERROR, "Key server error.");
+    if (params.content_id == kSlowContentId) {
+      slow_creation_started_.Signal();
+      slow_creation_released_.Wait();
+    }
+    {
+      base::AutoLock auto_lock(lock_);
+      ++num_created_;
+    }
+    *key_source = KeySource::CreateFromHexStrings(kKeyIdHex, kKeyHex, "", "");
+    return Status::OK;
+  }
+
+  int num_created() {
+    base::AutoLock auto_lock(lock_);
+    return num_created_;
+  }
+
+  base::Lock lock_;
+  int num_created_;
+  base::WaitableEvent slow_creation_started_;
+  base::WaitableEvent slow_creation_released_;
+  KeySourceCache cache_;
+};
+
+TEST_F(KeySourceCacheTest, SameParamsShareKeySource) {
+  KeySource* key_source1 = NULL;
+  KeySource* key_source2 = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source1));
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source2));
+  EXPECT_EQ(key_source1, key_source2);
+  EXPECT_EQ(1, num_created());
+  EXPECT_EQ(1u, cache_.size());
+
+  cache_.Release(key_source1);
+  cache_.Release(key_source2);
+  // Kept after its last release.
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source1));
+  EXPECT_EQ(key_source2, key_source1);
+  EXPECT_EQ(1, num_created());
+  cache_.Release(key_source1);
+}
+
+TEST_F(KeySourceCacheTest, DifferentParams) {
+  // Joined with a separator, these parameters would look the same.
+  KeySource* key_source1 = NULL;
+  KeySource* key_source2 = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("01,02", "03"), &key_source1));
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02,03"), &key_source2));
+  EXPECT_NE(key_source1, key_source2);
+  EXPECT_EQ(2, num_created());
+
+  cache_.Release(key_source1);
+  cache_.Release(key_source2);
+}
+
+TEST_F(KeySourceCacheTest, IgnoresParamsNotUsedByKeySource) {
+  EncryptionParams params1 = GetParams("01", "02");
+  EncryptionParams params2 = params1;
+  params2.clear_lead = 10;
+  params2.max_sd_pixels = 1;
+
+  KeySource* key_source1 = NULL;
+  KeySource* key_source2 = NULL;
+  ASSERT_OK(cache_.Acquire(params1, &key_source1));
+  ASSERT_OK(cache_.Acquire(params2, &key_source2));
+  EXPECT_EQ(key_source1, key_source2);
+
+  cache_.Release(key_source1);
+  cache_.Release(key_source2);
+}
+
+TEST_F(KeySourceCacheTest, CreationFailureNotCached) {
+  EncryptionParams params = GetParams("01", "02");
+  params.content_id = kFailingContentId;
+
+  KeySource* key_source = NULL;
+  EXPECT_EQ(error::SERVER_ERROR,
+            cache_.Acquire(params, &key_source).error_code());
+  EXPECT_EQ(0u, cache_.size());
+}
+
+TEST_F(KeySourceCacheTest, EvictOldestUnused) {
+  KeySource* key_source1 = NULL;
+  KeySource* key_source2 = NULL;
+  KeySource* key_source3 = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source1));
+  ASSERT_OK(cache_.Acquire(GetParams("03", "04"), &key_source2));
+  cache_.Release(key_source1);
+  ASSERT_OK(cache_.Acquire(GetParams("05", "06"), &key_source3));
+  EXPECT_EQ(kMaxEntries, cache_.size());
+  EXPECT_EQ(3, num_created());
+
+  // The first key source was evicted, the second one is still cached.
+  KeySource* key_source = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("03", "04"), &key_source));
+  EXPECT_EQ(key_source2, key_source);
+  EXPECT_EQ(3, num_created());
+  cache_.Release(key_source);
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source));
+  EXPECT_EQ(4, num_created());
+  cache_.Release(key_source);
+
+  cache_.Release(key_source2);
+  cache_.Release(key_source3);
+}
+
+TEST_F(KeySourceCacheTest, KeySourcesInUseNotEvicted) {
+  KeySource* key_sources[kMaxEntries + 1];
+  for (size_t i = 0; i < arraysize(key_sources); ++i) {
+    const std::string key_id(1, static_cast<char>('a' + i));
+    ASSERT_OK(cache_.Acquire(GetParams(key_id, "02"), &key_sources[i]));
+  }
+  // The cache grows past its limit instead.
+  EXPECT_EQ(kMaxEntries + 1, cache_.size());
+
+  KeySource* key_source = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("a", "02"), &key_source));
+  EXPECT_EQ(key_sources[0], key_source);
+  cache_.Release(key_source);
+
+  for (size_t i = 0; i < arraysize(key_sources); ++i)
+    cache_.Release(key_sources[i]);
+}
+
+TEST_F(KeySourceCacheTest, OtherKeySourcesAcquiredDuringCreation) {
+  KeySource* cached_key_source = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &cached_key_source));
+  cache_.Release(cached_key_source);
+
+  EncryptionParams slow_params = GetParams("03", "04");
+  slow_params.content_id = kSlowContentId;
+  Status slow_statuses[2];
+  KeySource* slow_key_sources[2] = {NULL, NULL};
+  ClosureThread slow_thread1(
+      "SlowAcquire",
+      base::Bind(&AcquireKeySource, &cache_, slow_params, &slow_statuses[0],
+                 &slow_key_sources[0]));
+  ClosureThread slow_thread2(
+      "SlowAcquire",
+      base::Bind(&AcquireKeySource, &cache_, slow_params, &slow_statuses[1],
+                 &slow_key_sources[1]));
+  slow_thread1.Start();
+  slow_creation_started_.Wait();
+  // Waits for the key source being created.
+  slow_thread2.Start();
+
+  // The other key sources are available meanwhile.
+  KeySource* key_source = NULL;
+  ASSERT_OK(cache_.Acquire(GetParams("01", "02"), &key_source));
+  EXPECT_EQ(cached_key_source, key_source);
+  cache_.Release(key_source);
+
+  slow_creation_released_.Signal();
+  slow_thread1.Join();
+  slow_thread2.Join();
+  ASSERT_OK(slow_statuses[0]);
+  ASSERT_OK(slow_statuses[1]);
+  EXPECT_EQ(slow_key_sources[0], slow_key_sources[1]);
+  // Created once.
+  EXPECT_EQ(2, num_created());
+  cache_.Release(slow_key_sources[0]);
+  cache_.Release(slow_key_sources[1]);
+}
+
+}  // namespace media
+}  // namespace edash_packager
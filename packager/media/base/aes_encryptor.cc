@@ -8,9 +8,13 @@
 
 #include <openssl/aes.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/rand.h>
 
+#include <algorithm>
+
 #include "packager/base/logging.h"
+#include "packager/base/sys_byteorder.h"
 
 namespace {
 
@@ -35,6 +39,30 @@ bool IsKeySizeValidForAes(size_t key_size) {
 // CENC protection scheme uses 128-bit keys in counter mode.
 const uint32_t kCencKeySize = 16;
 
+// Number of counter blocks encrypted together in AES-CTR. Large enough for
+// AES-NI to pipeline the blocks, small enough for the key stream to live on
+// the stack.
+const size_t kCtrBlocksPerBatch = 32;
+
+// XOR |size| bytes of |input| with |key_stream| into |output|, eight bytes at
+// a time. |output| may be the same as |input|.
+void XorKeyStream(const uint8_t* input,
+                  const uint8_t* key_stream,
+                  size_t size,
+                  uint8_t* output) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t data;
+    uint64_t key;
+    memcpy(&data, input + i, sizeof(data));
+    memcpy(&key, key_stream + i, sizeof(key));
+    data ^= key;
+    memcpy(output + i, &data, sizeof(data));
+  }
+  for (; i < size; ++i)
+    output[i] = input[i] ^ key_stream[i];
+}
+
 }  // namespace
 
 namespace edash_packager {
@@ -42,13 +70,17 @@ namespace media {
 
 AesCtrEncryptor::AesCtrEncryptor()
     : block_offset_(0),
+      cipher_ctx_(NULL),
       encrypted_counter_(AES_BLOCK_SIZE, 0),
       counter_overflow_(false) {
   COMPILE_ASSERT(AES_BLOCK_SIZE == kCencKeySize,
                  cenc_key_size_should_be_the_same_as_aes_block_size);
 }
 
-AesCtrEncryptor::~AesCtrEncryptor() {}
+AesCtrEncryptor::~AesCtrEncryptor() {
+  if (cipher_ctx_)
+    EVP_CIPHER_CTX_free(cipher_ctx_);
+}
 
 bool AesCtrEncryptor::InitializeWithRandomIv(const std::vector<uint8_t>& key,
                                              uint8_t iv_size) {
@@ -72,8 +104,14 @@ bool AesCtrEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
     return false;
   }
 
-  aes_key_.reset(new AES_KEY());
-  CHECK_EQ(AES_set_encrypt_key(&key[0], AES_BLOCK_SIZE * 8, aes_key_.get()), 0);
+  if (!cipher_ctx_)
+    cipher_ctx_ = EVP_CIPHER_CTX_new();
+  CHECK(cipher_ctx_);
+  CHECK_EQ(EVP_EncryptInit_ex(cipher_ctx_, EVP_aes_128_ecb(), NULL, &key[0],
+                              NULL),
+           1);
+  // Counter blocks are always whole blocks.
+  EVP_CIPHER_CTX_set_padding(cipher_ctx_, 0);
   return SetIv(iv);
 }
 
@@ -82,21 +120,79 @@ bool AesCtrEncryptor::Encrypt(const uint8_t* plaintext,
                               uint8_t* ciphertext) {
   DCHECK(plaintext);
   DCHECK(ciphertext);
-  DCHECK(aes_key_);
-
-  for (size_t i = 0; i < plaintext_size; ++i) {
-    if (block_offset_ == 0) {
-      AES_encrypt(&counter_[0], &encrypted_counter_[0], aes_key_.get());
-      // As mentioned in ISO/IEC FDIS 23001-7: CENC spec, of the 16 byte counter
-      // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
-      // simple 64 bit unsigned integer that is incremented by one for each
-      // subsequent block of sample data processed and is kept in network byte
-      // order.
-      if (Increment64(&counter_[8]))
-        counter_overflow_ = true;
-    }
-    ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_];
-    block_offset_ = (block_offset_ + 1) % AES_BLOCK_SIZE;
+  DCHECK(cipher_ctx_);
+
+  // Use up the remaining key stream of the current block first.
+  if (block_offset_ != 0) {
+    const size_t size =
+        std::min(plaintext_size, static_cast<size_t>(AES_BLOCK_SIZE -
+                                                     block_offset_));
+    XorKeyStream(plaintext, &encrypted_counter_[block_offset_], size,
+                 ciphertext);
+    block_offset_ = (block_offset_ + size) % AES_BLOCK_SIZE;
+    plaintext += size;
+    ciphertext += size;
+    plaintext_size -= size;
+  }
+
+  // Whole blocks, in batches.
+  uint8_t key_stream[kCtrBlocksPerBatch * AES_BLOCK_SIZE];
+  while (plaintext_size >= AES_BLOCK_SIZE) {
+    const size_t num_blocks =
+        std::min(plaintext_size / AES_BLOCK_SIZE, kCtrBlocksPerBatch);
+    if (!GenerateKeyStream(num_blocks, key_stream))
+      return false;
+    const size_t size = num_blocks * AES_BLOCK_SIZE;
+    XorKeyStream(plaintext, key_stream, size, ciphertext);
+    plaintext += size;
+    ciphertext += size;
+    plaintext_size -= size;
+  }
+
+  // Trailing partial block. The rest of its key stream is kept for the next
+  // call.
+  if (plaintext_size > 0) {
+    if (!GenerateKeyStream(1, &encrypted_counter_[0]))
+      return false;
+    XorKeyStream(plaintext, &encrypted_counter_[0], plaintext_size,
+                 ciphertext);
+    block_offset_ = plaintext_size;
+  }
+  return true;
+}
+
+bool AesCtrEncryptor::GenerateKeyStream(size_t num_blocks,
+                                        uint8_t* key_stream) {
+  DCHECK_LE(num_blocks, kCtrBlocksPerBatch);
+
+  // As mentioned in ISO/IEC FDIS 23001-7: CENC spec, of the 16 byte counter
+  // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
+  // simple 64 bit unsigned integer that is incremented by one for each
+  // subsequent block of sample data processed and is kept in network byte
+  // order.
+  uint64_t block_counter;
+  memcpy(&block_counter, &counter_[8], sizeof(block_counter));
+  block_counter = base::NetToHost64(block_counter);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    uint8_t* block = key_stream + i * AES_BLOCK_SIZE;
+    memcpy(block, &counter_[0], 8);
+    const uint64_t block_counter_be = base::HostToNet64(block_counter);
+    memcpy(block + 8, &block_counter_be, sizeof(block_counter_be));
+    if (++block_counter == 0)
+      counter_overflow_ = true;
+  }
+  const uint64_t block_counter_be = base::HostToNet64(block_counter);
+  memcpy(&counter_[8], &block_counter_be, sizeof(block_counter_be));
+
+  // Encrypt the counter blocks in place.
+  const int size = num_blocks * AES_BLOCK_SIZE;
+  int output_size = 0;
+  if (EVP_EncryptUpdate(cipher_ctx_, key_stream, &output_size, key_stream,
+                        size) != 1 ||
+      output_size != size) {
+    LOG(ERROR) << "EVP_EncryptUpdate failed with error: "
+               << ERR_error_string(ERR_get_error(), NULL);
+    return false;
   }
   return true;
 }
@@ -130,6 +226,23 @@ void AesCtrEncryptor::UpdateIv() {
   counter_overflow_ = false;
 }
 
+void AesCtrEncryptor::SkipKeyStreamAndUpdateIv(size_t size) {
+  // The key stream left in the current block is used first.
+  if (block_offset_ != 0)
+    size -= std::min(size, static_cast<size_t>(AES_BLOCK_SIZE - block_offset_));
+  const uint64_t num_blocks = (size + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE;
+
+  uint64_t block_counter;
+  memcpy(&block_counter, &counter_[8], sizeof(block_counter));
+  block_counter = base::NetToHost64(block_counter);
+  if (block_counter + num_blocks < block_counter)
+    counter_overflow_ = true;
+  block_counter = base::HostToNet64(block_counter + num_blocks);
+  memcpy(&counter_[8], &block_counter, sizeof(block_counter));
+
+  UpdateIv();
+}
+
 bool AesCtrEncryptor::SetIv(const std::vector<uint8_t>& iv) {
   if (!IsIvSizeValid(iv.size())) {
     LOG(ERROR) << "Invalid IV size: " << iv.size();
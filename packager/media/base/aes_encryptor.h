@@ -17,6 +17,8 @@
 
 struct aes_key_st;
 typedef struct aes_key_st AES_KEY;
+struct evp_cipher_ctx_st;
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
 
 namespace edash_packager {
 namespace media {
@@ -85,6 +87,13 @@ class AesCtrEncryptor {
   ///   For 128-bit IV size, new_iv = old_iv + previous_sample_block_count.
   void UpdateIv();
 
+  /// Update IV for next sample as if @a size more bytes of the current sample
+  /// had been encrypted, without doing the encryption. This allows the IVs of
+  /// consecutive samples to be computed up front, e.g. to encrypt the samples
+  /// in parallel. @a block_offset_ is reset to 0.
+  /// @param size is the number of bytes to skip in the key stream.
+  void SkipKeyStreamAndUpdateIv(size_t size);
+
   /// Set IV. @a block_offset_ is reset to 0 on success.
   /// @return true if successful, false if the input is invalid.
   bool SetIv(const std::vector<uint8_t>& iv);
@@ -94,12 +103,17 @@ class AesCtrEncryptor {
   uint32_t block_offset() const { return block_offset_; }
 
  private:
+  // Generate the key stream for |num_blocks| consecutive counter blocks into
+  // |key_stream|, advancing |counter_| accordingly. The counter blocks are
+  // encrypted in a single call so that they can be pipelined.
+  bool GenerateKeyStream(size_t num_blocks, uint8_t* key_stream);
+
   // Initialization vector, with size 8 or 16.
   std::vector<uint8_t> iv_;
   // Current block offset.
   uint32_t block_offset_;
-  // Openssl AES_KEY.
-  scoped_ptr<AES_KEY> aes_key_;
+  // Openssl AES-ECB cipher context used to encrypt the counter blocks.
+  EVP_CIPHER_CTX* cipher_ctx_;
   // Current AES-CTR counter.
   std::vector<uint8_t> counter_;
   // Encrypted counter.
@@ -0,0 +1,131 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/aes_encryptor.h"
+#include "packager/media/test/benchmark_util.h"
+
+namespace {
+
+const uint8_t kKey[] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+const uint8_t kIv[] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                       0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+
+// About the size of a video frame.
+const size_t kSampleSize = 64 * 1024;
+// Typical subsample: a few clear header bytes followed by the slice data.
+const size_t kSubsampleClearBytes = 5;
+const size_t kNumSubsamples = 16;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class AesEncryptorBenchmark : public ::testing::Test {
+ public:
+  AesEncryptorBenchmark()
+      : key_(kKey, kKey + arraysize(kKey)),
+        iv_(kIv, kIv + arraysize(kIv)),
+        plaintext_(GenerateSyntheticData(kSampleSize)),
+        ciphertext_(kSampleSize) {}
+
+  // Encrypts a whole sample, as for audio.
+  void EncryptCtrSample() {
+    ASSERT_TRUE(ctr_encryptor_.Encrypt(&plaintext_[0], kSampleSize,
+                                       &ciphertext_[0]));
+    ctr_encryptor_.UpdateIv();
+  }
+
+  // Encrypts a sample in subsamples, as for video.
+  void EncryptCtrSubsamples() {
+    const size_t subsample_size = kSampleSize / kNumSubsamples;
+    for (size_t i = 0; i < kNumSubsamples; ++i) {
+      const size_t offset = i * subsample_size + kSubsampleClearBytes;
+      ASSERT_TRUE(ctr_encryptor_.Encrypt(&plaintext_[offset],
+                                         subsample_size - kSubsampleClearBytes,
+                                         &ciphertext_[offset]));
+    }
+    ctr_encryptor_.UpdateIv();
+  }
+
+  void EncryptCbcCts() {
+    cts_encryptor_.Encrypt(&plaintext_[0], kSampleSize, &ciphertext_[0]);
+  }
+
+  void DecryptCbcCts() {
+    cts_decryptor_.Decrypt(&ciphertext_[0], kSampleSize, &plaintext_[0]);
+  }
+
+  void EncryptCbcPkcs5() {
+    pkcs5_encryptor_.Encrypt(pkcs5_plaintext_, &pkcs5_ciphertext_);
+  }
+
+ protected:
+  std::vector<uint8_t> key_;
+  std::vector<uint8_t> iv_;
+  std::vector<uint8_t> plaintext_;
+  std::vector<uint8_t> ciphertext_;
+  std::string pkcs5_plaintext_;
+  std::string pkcs5_ciphertext_;
+  AesCtrEncryptor ctr_encryptor_;
+  AesCbcCtsEncryptor cts_encryptor_;
+  AesCbcCtsDecryptor cts_decryptor_;
+  AesCbcPkcs5Encryptor pkcs5_encryptor_;
+};
+
+TEST_F(AesEncryptorBenchmark, AesCtr) {
+  ASSERT_TRUE(ctr_encryptor_.InitializeWithIv(key_, iv_));
+  RunThroughputBenchmark(
+      "AesCtrEncryptor",
+      kSampleSize,
+      base::Bind(&AesEncryptorBenchmark::EncryptCtrSample,
+                 base::Unretained(this)));
+}
+
+TEST_F(AesEncryptorBenchmark, AesCtrSubsamples) {
+  ASSERT_TRUE(ctr_encryptor_.InitializeWithIv(key_, iv_));
+  RunThroughputBenchmark(
+      "AesCtrEncryptorSubsamples",
+      kSampleSize - kNumSubsamples * kSubsampleClearBytes,
+      base::Bind(&AesEncryptorBenchmark::EncryptCtrSubsamples,
+                 base::Unretained(this)));
+}
+
+TEST_F(AesEncryptorBenchmark, AesCbcCtsEncrypt) {
+  ASSERT_TRUE(cts_encryptor_.InitializeWithIv(key_, iv_));
+  RunThroughputBenchmark(
+      "AesCbcCtsEncryptor",
+      kSampleSize,
+      base::Bind(&AesEncryptorBenchmark::EncryptCbcCts,
+                 base::Unretained(this)));
+}
+
+TEST_F(AesEncryptorBenchmark, AesCbcCtsDecrypt) {
+  ASSERT_TRUE(cts_decryptor_.InitializeWithIv(key_, iv_));
+  RunThroughputBenchmark(
+      "AesCbcCtsDecryptor",
+      kSampleSize,
+      base::Bind(&AesEncryptorBenchmark::DecryptCbcCts,
+                 base::Unretained(this)));
+}
+
+TEST_F(AesEncryptorBenchmark, AesCbcPkcs5Encrypt) {
+  ASSERT_TRUE(pkcs5_encryptor_.InitializeWithIv(key_, iv_));
+  pkcs5_plaintext_.assign(plaintext_.begin(), plaintext_.end());
+  RunThroughputBenchmark(
+      "AesCbcPkcs5Encryptor",
+      kSampleSize,
+      base::Bind(&AesEncryptorBenchmark::EncryptCbcPkcs5,
+                 base::Unretained(this)));
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -218,6 +218,75 @@ TEST_F(AesCtrEncryptorTest, 128BitIVBoundaryCaseEncryption) {
   EXPECT_EQ(encrypted, encrypted_verify);
 }
 
+// Encrypting a large buffer at once should be the same as encrypting it in
+// pieces of arbitrary sizes, including across the 64-bit counter wraparound.
+TEST_F(AesCtrEncryptorTest, LargeBufferInPieces) {
+  const size_t kLargeTextSize = 5000;
+  std::vector<uint8_t> plaintext(kLargeTextSize);
+  for (size_t i = 0; i < plaintext.size(); ++i)
+    plaintext[i] = i * 31 % 256;
+
+  // The block counter wraps around after 16 blocks.
+  std::vector<uint8_t> iv(kIv128Max64, kIv128Max64 + arraysize(kIv128Max64));
+  iv[15] = 0xf0;
+
+  ASSERT_TRUE(encryptor_.InitializeWithIv(key_, iv));
+  std::vector<uint8_t> encrypted;
+  EXPECT_TRUE(encryptor_.Encrypt(plaintext, &encrypted));
+  encryptor_.UpdateIv();
+  const std::vector<uint8_t> next_iv = encryptor_.iv();
+
+  const size_t kPieceSizes[] = {1, 7, 16, 33, 515, 8, 1024, 15, 17};
+  ASSERT_TRUE(encryptor_.InitializeWithIv(key_, iv));
+  std::vector<uint8_t> encrypted_in_pieces(plaintext.size());
+  size_t offset = 0;
+  for (size_t i = 0; offset < plaintext.size(); ++i) {
+    const size_t size = std::min(kPieceSizes[i % arraysize(kPieceSizes)],
+                                 plaintext.size() - offset);
+    EXPECT_TRUE(encryptor_.Encrypt(&plaintext[offset], size,
+                                   &encrypted_in_pieces[offset]));
+    offset += size;
+    EXPECT_EQ(offset % kAesBlockSize, encryptor_.block_offset());
+  }
+  EXPECT_EQ(encrypted, encrypted_in_pieces);
+  encryptor_.UpdateIv();
+  EXPECT_EQ(next_iv, encryptor_.iv());
+}
+
+// Skipping the key stream of a sample should yield the same IV as encrypting
+// it, for both IV sizes and across the 64-bit counter wraparound.
+TEST_F(AesCtrEncryptorTest, SkipKeyStreamAndUpdateIv) {
+  std::vector<uint8_t> iv128(kIv128Max64, kIv128Max64 + arraysize(kIv128Max64));
+  iv128[15] = 0xf0;
+  const std::vector<uint8_t> iv64(kIv128Max64, kIv128Max64 + 8);
+  const std::vector<uint8_t> ivs[] = {iv128, iv64};
+  const size_t kSampleSizes[] = {0, 1, 15, 16, 17, 255, 256, 1000};
+
+  for (size_t i = 0; i < arraysize(ivs); ++i) {
+    AesCtrEncryptor skipping_encryptor;
+    ASSERT_TRUE(encryptor_.InitializeWithIv(key_, ivs[i]));
+    ASSERT_TRUE(skipping_encryptor.InitializeWithIv(key_, ivs[i]));
+    for (size_t j = 0; j < arraysize(kSampleSizes); ++j) {
+      const size_t sample_size = kSampleSizes[j];
+      // One extra byte so that the buffers are never empty.
+      std::vector<uint8_t> plaintext(sample_size + 1, 0);
+      std::vector<uint8_t> encrypted(sample_size + 1);
+      // Encrypt in two pieces to exercise a non-zero block offset.
+      const size_t first_piece_size = sample_size / 3;
+      EXPECT_TRUE(
+          encryptor_.Encrypt(&plaintext[0], first_piece_size, &encrypted[0]));
+      EXPECT_TRUE(encryptor_.Encrypt(&plaintext[first_piece_size],
+                                     sample_size - first_piece_size,
+                                     &encrypted[first_piece_size]));
+      encryptor_.UpdateIv();
+
+      skipping_encryptor.SkipKeyStreamAndUpdateIv(sample_size);
+      EXPECT_EQ(encryptor_.iv(), skipping_encryptor.iv());
+      EXPECT_EQ(0u, skipping_encryptor.block_offset());
+    }
+  }
+}
+
 TEST_F(AesCtrEncryptorTest, InitWithRandomIv) {
   const uint8_t kIvSize = 8;
   ASSERT_TRUE(encryptor_.InitializeWithRandomIv(key_, kIvSize));
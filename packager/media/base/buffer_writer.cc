@@ -6,23 +6,29 @@
 
 #include "packager/media/base/buffer_writer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "packager/base/sys_byteorder.h"
 #include "packager/media/file/file.h"
 
 namespace edash_packager {
 namespace media {
 
-BufferWriter::BufferWriter() {
+BufferWriter::BufferWriter() : size_(0), capacity_(0) {
   const size_t kDefaultReservedCapacity = 0x40000;  // 256KB.
-  buf_.reserve(kDefaultReservedCapacity);
+  Reserve(kDefaultReservedCapacity);
 }
-BufferWriter::BufferWriter(size_t reserved_size_in_bytes) {
-  buf_.reserve(reserved_size_in_bytes);
+BufferWriter::BufferWriter(size_t reserved_size_in_bytes)
+    : size_(0), capacity_(0) {
+  Reserve(reserved_size_in_bytes);
 }
 BufferWriter::~BufferWriter() {}
 
 void BufferWriter::AppendInt(uint8_t v) {
-  buf_.push_back(v);
+  Reserve(1);
+  buf_[size_++] = v;
 }
 void BufferWriter::AppendInt(uint16_t v) {
   AppendInternal(base::HostToNet16(v));
@@ -51,22 +57,47 @@ void BufferWriter::AppendNBytes(uint64_t v, size_t num_bytes) {
 }
 
 void BufferWriter::AppendVector(const std::vector<uint8_t>& v) {
-  buf_.insert(buf_.end(), v.begin(), v.end());
+  if (!v.empty())
+    AppendArray(&v[0], v.size());
 }
 
 void BufferWriter::AppendArray(const uint8_t* buf, size_t size) {
-  buf_.insert(buf_.end(), buf, buf + size);
+  if (size == 0)
+    return;
+  memcpy(Grow(size), buf, size);
 }
 
 void BufferWriter::AppendBuffer(const BufferWriter& buffer) {
-  buf_.insert(buf_.end(), buffer.buf_.begin(), buffer.buf_.end());
+  AppendArray(buffer.buf_.get(), buffer.size_);
+}
+
+uint8_t* BufferWriter::Grow(size_t size) {
+  Reserve(size);
+  uint8_t* added = buf_.get() + size_;
+  size_ += size;
+  return added;
+}
+
+void BufferWriter::Swap(BufferWriter* buffer) {
+  DCHECK(buffer);
+  buf_.swap(buffer->buf_);
+  std::swap(size_, buffer->size_);
+  std::swap(capacity_, buffer->capacity_);
+}
+
+void BufferWriter::SwapBuffer(std::vector<uint8_t>* buffer) {
+  DCHECK(buffer);
+  std::vector<uint8_t> data(buf_.get(), buf_.get() + size_);
+  Clear();
+  AppendVector(*buffer);
+  buffer->swap(data);
 }
 
 Status BufferWriter::WriteToFile(File* file) {
   DCHECK(file);
 
-  size_t remaining_size = buf_.size();
-  const uint8_t* buf = &buf_[0];
+  size_t remaining_size = size_;
+  const uint8_t* buf = buf_.get();
   while (remaining_size > 0) {
     int64_t size_written = file->Write(buf, remaining_size);
     if (size_written <= 0) {
@@ -76,7 +107,7 @@ Status BufferWriter::WriteToFile(File* file) {
     remaining_size -= size_written;
     buf += size_written;
   }
-  buf_.clear();
+  Clear();
   return Status::OK;
 }
 
@@ -85,5 +116,18 @@ void BufferWriter::AppendInternal(T v) {
   AppendArray(reinterpret_cast<uint8_t*>(&v), sizeof(T));
 }
 
+void BufferWriter::Reserve(size_t size) {
+  if (capacity_ - size_ >= size)
+    return;
+  // Grow geometrically, like std::vector, so that appends stay amortized
+  // constant time. new[] leaves the bytes uninitialized.
+  const size_t capacity = std::max(size_ + size, 2 * capacity_);
+  scoped_ptr<uint8_t[]> buf(new uint8_t[capacity]);
+  if (size_ > 0)
+    memcpy(buf.get(), buf_.get(), size_);
+  buf_.swap(buf);
+  capacity_ = capacity;
+}
+
 }  // namespace media
 }  // namespace edash_packager
@@ -7,9 +7,11 @@
 #ifndef MEDIA_BASE_BUFFER_WRITER_H_
 #define MEDIA_BASE_BUFFER_WRITER_H_
 
+#include <stdint.h>
+
 #include <vector>
 
-#include "packager/base/stl_util.h"
+#include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/status.h"
 
 namespace edash_packager {
@@ -50,13 +52,23 @@ class BufferWriter {
   void AppendArray(const uint8_t* buf, size_t size);
   void AppendBuffer(const BufferWriter& buffer);
 
-  void Swap(BufferWriter* buffer) { buf_.swap(buffer->buf_); }
-  void SwapBuffer(std::vector<uint8_t>* buffer) { buf_.swap(*buffer); }
-
-  void Clear() { buf_.clear(); }
-  size_t Size() const { return buf_.size(); }
+  /// Grow the buffer by @a size bytes, to be filled in by the caller. This
+  /// allows data to be produced directly into the buffer, e.g. encrypted,
+  /// without going through an intermediate buffer.
+  /// @return A pointer to the first added byte. The added bytes are
+  ///         uninitialized: the caller should write all of them. The pointer
+  ///         is invalidated by any subsequent append.
+  uint8_t* Grow(size_t size);
+
+  void Swap(BufferWriter* buffer);
+  /// Exchange the content of the buffer with @a buffer. Unlike Swap(), the
+  /// data is copied.
+  void SwapBuffer(std::vector<uint8_t>* buffer);
+
+  void Clear() { size_ = 0; }
+  size_t Size() const { return size_; }
   /// @return Underlying buffer. Behavior is undefined if the buffer size is 0.
-  const uint8_t* Buffer() const { return vector_as_array(&buf_); }
+  const uint8_t* Buffer() const { return buf_.get(); }
 
   /// Write the buffer to file. The internal buffer will be cleared after
   /// writing.
@@ -69,7 +81,14 @@ class BufferWriter {
   template <typename T>
   void AppendInternal(T v);
 
-  std::vector<uint8_t> buf_;
+  // Makes room for |size| more bytes, without initializing them.
+  void Reserve(size_t size);
+
+  // The bytes of |buf_| beyond |size_| are not initialized, so that Grow()
+  // does not write bytes the caller overwrites anyway.
+  scoped_ptr<uint8_t[]> buf_;
+  size_t size_;
+  size_t capacity_;
 
   DISALLOW_COPY_AND_ASSIGN(BufferWriter);
 };
@@ -0,0 +1,65 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/test/benchmark_util.h"
+
+namespace {
+
+const size_t kNumInts = 256 * 1024;
+const size_t kChunkSize = 188;
+const size_t kNumChunks = 4096;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class BufferWriterBenchmark : public ::testing::Test {
+ public:
+  BufferWriterBenchmark() : chunk_(GenerateSyntheticData(kChunkSize)) {}
+
+  // Box serialization is dominated by the appending of integers.
+  void AppendInts() {
+    BufferWriter writer;
+    for (size_t i = 0; i < kNumInts; ++i)
+      writer.AppendInt(static_cast<uint32_t>(i));
+    ASSERT_EQ(kNumInts * sizeof(uint32_t), writer.Size());
+  }
+
+  // Sample data is appended in chunks.
+  void AppendArrays() {
+    BufferWriter writer;
+    for (size_t i = 0; i < kNumChunks; ++i)
+      writer.AppendArray(&chunk_[0], chunk_.size());
+    ASSERT_EQ(kNumChunks * kChunkSize, writer.Size());
+  }
+
+ protected:
+  std::vector<uint8_t> chunk_;
+};
+
+TEST_F(BufferWriterBenchmark, AppendInt) {
+  RunThroughputBenchmark(
+      "BufferWriterAppendInt",
+      kNumInts * sizeof(uint32_t),
+      base::Bind(&BufferWriterBenchmark::AppendInts, base::Unretained(this)));
+}
+
+TEST_F(BufferWriterBenchmark, AppendArray) {
+  RunThroughputBenchmark(
+      "BufferWriterAppendArray",
+      kNumChunks * kChunkSize,
+      base::Bind(&BufferWriterBenchmark::AppendArrays,
+                 base::Unretained(this)));
+}
+
+}  // namespace media
+}  // namespace edash_packager
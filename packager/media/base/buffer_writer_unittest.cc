@@ -136,6 +136,24 @@ TEST_F(BufferWriterTest, AppendBufferWriter) {
   ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint32));
 }
 
+TEST_F(BufferWriterTest, Grow) {
+  writer_->AppendInt(kuint16);
+  uint8_t* buf = writer_->Grow(sizeof(kuint8Array));
+  memcpy(buf, kuint8Array, sizeof(kuint8Array));
+  writer_->AppendInt(kuint32);
+  ASSERT_EQ(sizeof(kuint16) + sizeof(kuint8Array) + sizeof(kuint32),
+            writer_->Size());
+
+  CreateReader();
+  ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint16));
+  std::vector<uint8_t> data_read;
+  ASSERT_TRUE(reader_->ReadToVector(&data_read, sizeof(kuint8Array)));
+  EXPECT_EQ(std::vector<uint8_t>(kuint8Array,
+                                 kuint8Array + sizeof(kuint8Array)),
+            data_read);
+  ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint32));
+}
+
 TEST_F(BufferWriterTest, Swap) {
   BufferWriter local_writer;
   local_writer.AppendInt(kuint16);
@@ -151,6 +169,39 @@ TEST_F(BufferWriterTest, Swap) {
   ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kint64));
 }
 
+TEST_F(BufferWriterTest, GrowBeyondReservedCapacity) {
+  BufferWriter writer(2);
+  writer.AppendInt(kuint16);
+  uint8_t* buf = writer.Grow(sizeof(kuint8Array));
+  memcpy(buf, kuint8Array, sizeof(kuint8Array));
+  writer.AppendInt(kuint64);
+  ASSERT_EQ(sizeof(kuint16) + sizeof(kuint8Array) + sizeof(kuint64),
+            writer.Size());
+
+  writer_->AppendBuffer(writer);
+  CreateReader();
+  ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint16));
+  std::vector<uint8_t> data_read;
+  ASSERT_TRUE(reader_->ReadToVector(&data_read, sizeof(kuint8Array)));
+  EXPECT_EQ(std::vector<uint8_t>(kuint8Array,
+                                 kuint8Array + sizeof(kuint8Array)),
+            data_read);
+  ASSERT_NO_FATAL_FAILURE(ReadAndExpect(kuint64));
+}
+
+TEST_F(BufferWriterTest, SwapBuffer) {
+  std::vector<uint8_t> buffer(kuint8Array, kuint8Array + sizeof(kuint8Array));
+  writer_->AppendInt(kuint32);
+  writer_->SwapBuffer(&buffer);
+
+  ASSERT_EQ(sizeof(kuint8Array), writer_->Size());
+  ASSERT_EQ(sizeof(kuint32), buffer.size());
+  EXPECT_EQ(std::vector<uint8_t>(kuint8Array,
+                                 kuint8Array + sizeof(kuint8Array)),
+            std::vector<uint8_t>(writer_->Buffer(),
+                                 writer_->Buffer() + writer_->Size()));
+}
+
 TEST_F(BufferWriterTest, Clear) {
   writer_->AppendInt(kuint32);
   ASSERT_EQ(sizeof(kuint32), writer_->Size());
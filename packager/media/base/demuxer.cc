@@ -6,14 +6,23 @@
 
 #include "packager/media/base/demuxer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "packager/base/bind.h"
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/synchronization/waitable_event.h"
 #include "packager/media/base/container_names.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/key_source.h"
+#include "packager/media/base/live_ingest_reactor.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/media_stream.h"
+#include "packager/media/base/pipeline_stats.h"
+#include "packager/media/base/read_ahead_reader.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/file/file.h"
 #include "packager/media/formats/mp2t/mp2t_media_parser.h"
@@ -29,14 +38,44 @@ const size_t kBufSize = 0x40000;  // 256KB.
 namespace edash_packager {
 namespace media {
 
+namespace {
+
+void SetStatusAndSignal(Status* status_out,
+                        base::WaitableEvent* event,
+                        const Status& status) {
+  *status_out = status;
+  event->Signal();
+}
+
+}  // namespace
+
 Demuxer::Demuxer(const std::string& file_name)
     : file_name_(file_name),
       media_file_(NULL),
       init_event_received_(false),
-      buffer_(new uint8_t[kBufSize]) {
+      random_access_parser_(NULL),
+      buffer_(new uint8_t[kBufSize]),
+      read_ahead_num_buffers_(0),
+      read_ahead_buffer_size_(0),
+      pipeline_stats_(NULL),
+      read_stats_(NULL),
+      parse_stats_(NULL),
+      num_parsed_samples_(0),
+      num_parsed_bytes_(0),
+      live_ingest_reactor_(NULL),
+      live_channel_id_(-1),
+      live_cv_(&live_lock_),
+      live_init_done_(false),
+      live_running_(false),
+      live_closing_(false) {
 }
 
 Demuxer::~Demuxer() {
+  // Stop receiving before the streams are deleted.
+  if (live_channel_id_ >= 0)
+    live_ingest_reactor_->RemoveChannel(live_channel_id_);
+  // Stop reading ahead before closing the file.
+  read_ahead_reader_.reset();
   if (media_file_)
     media_file_->Close();
   STLDeleteElements(&streams_);
@@ -46,18 +85,55 @@ void Demuxer::SetKeySource(scoped_ptr<KeySource> key_source) {
   key_source_ = key_source.Pass();
 }
 
+void Demuxer::EnableReadAhead(size_t num_buffers, size_t buffer_size) {
+  DCHECK(!media_file_);
+  DCHECK_GE(num_buffers, 2u);
+  DCHECK_GT(buffer_size, 0u);
+  read_ahead_num_buffers_ = num_buffers;
+  read_ahead_buffer_size_ = buffer_size;
+}
+
+void Demuxer::SetPipelineStats(PipelineStats* pipeline_stats) {
+  DCHECK(!media_file_);
+  DCHECK(pipeline_stats);
+  pipeline_stats_ = pipeline_stats;
+  read_stats_ = pipeline_stats->GetStageStats(file_name_, kReadStage);
+  parse_stats_ = pipeline_stats->GetStageStats(file_name_, kParseStage);
+}
+
+void Demuxer::SetLiveIngestReactor(LiveIngestReactor* reactor) {
+  DCHECK(!media_file_);
+  DCHECK(reactor);
+  live_ingest_reactor_ = reactor;
+}
+
 Status Demuxer::Initialize() {
   DCHECK(!media_file_);
   DCHECK(!init_event_received_);
 
-  media_file_ = File::Open(file_name_.c_str(), "r");
-  if (!media_file_) {
+  if (live_ingest_reactor_ && StartsWithASCII(file_name_, kUdpFilePrefix, true))
+    return InitializeLiveIngest();
+
+  File* media_file = File::Open(file_name_.c_str(), "r");
+  if (!media_file) {
     return Status(error::FILE_FAILURE,
                   "Cannot open file for reading " + file_name_);
   }
+  {
+    base::AutoLock scoped_lock(media_file_lock_);
+    media_file_ = media_file;
+    if (cancelled_.IsSet())
+      media_file_->Cancel();
+  }
 
   // Determine media container.
-  int64_t bytes_read = media_file_->Read(buffer_.get(), kInitBufSize);
+  int64_t bytes_read = 0;
+  {
+    ScopedStageTimer read_timer(read_stats_);
+    bytes_read = media_file_->Read(buffer_.get(), kInitBufSize);
+    read_timer.set_count(1);
+    read_timer.set_bytes(std::max<int64_t>(bytes_read, 0));
+  }
   if (bytes_read <= 0)
     return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   MediaContainerName container = DetermineContainer(buffer_.get(), bytes_read);
@@ -81,11 +157,41 @@ Status Demuxer::Initialize() {
   parser_->Init(base::Bind(&Demuxer::ParserInitEvent, base::Unretained(this)),
                 base::Bind(&Demuxer::NewSampleEvent, base::Unretained(this)),
                 key_source_.get());
+  if (pipeline_stats_ && key_source_) {
+    parser_->set_decryption_stats(
+        pipeline_stats_->GetStageStats(file_name_, kDecryptStage));
+  }
+
+  if (container == CONTAINER_MOV) {
+    // Non-fragmented mp4 files are read randomly to avoid buffering the whole
+    // 'mdat', which happens if 'moov' is placed after 'mdat'.
+    mp4::MP4MediaParser* mp4_parser =
+        static_cast<mp4::MP4MediaParser*>(parser_.get());
+    if (!mp4_parser->LoadMoov(media_file_)) {
+      return Status(error::PARSER_FAILURE,
+                    "Cannot load 'moov' from media file " + file_name_);
+    }
+    if (mp4_parser->random_access()) {
+      DCHECK(init_event_received_);
+      random_access_parser_ = mp4_parser;
+      return Status::OK;
+    }
+  }
 
+  // Memory-mapped files are prefetched by the kernel and read without copies,
+  // so reading ahead would not help.
+  if (read_ahead_num_buffers_ > 0 && !media_file_->SupportsReadView()) {
+    read_ahead_reader_.reset(new ReadAheadReader(
+        media_file_, read_ahead_num_buffers_, read_ahead_buffer_size_));
+    read_ahead_reader_->Start();
+  }
+
+  BeginParseStats();
   if (!parser_->Parse(buffer_.get(), bytes_read)) {
     init_parsing_status_ =
         Status(error::PARSER_FAILURE, "Cannot parse media file " + file_name_);
   }
+  EndParseStats();
 
   // Parse until init event received or on error.
   while (!init_event_received_ && init_parsing_status_.ok())
@@ -94,6 +200,120 @@ Status Demuxer::Initialize() {
   return init_event_received_ ? Status::OK : init_parsing_status_;
 }
 
+Status Demuxer::InitializeLiveIngest() {
+  parser_.reset(new mp2t::Mp2tMediaParser());
+  parser_->Init(base::Bind(&Demuxer::ParserInitEvent, base::Unretained(this)),
+                base::Bind(&Demuxer::NewSampleEvent, base::Unretained(this)),
+                key_source_.get());
+  if (pipeline_stats_ && key_source_) {
+    parser_->set_decryption_stats(
+        pipeline_stats_->GetStageStats(file_name_, kDecryptStage));
+  }
+
+  // Held while the channel is added, so that the parser calls see
+  // |live_channel_id_|.
+  base::AutoLock scoped_lock(live_lock_);
+  Status status = live_ingest_reactor_->AddChannel(
+      file_name_.substr(strlen(kUdpFilePrefix)),
+      base::Bind(&Demuxer::OnLiveIngestData, base::Unretained(this)),
+      &live_channel_id_);
+  if (!status.ok())
+    return status;
+
+  // The channel is paused once the streams are known, until Run() or
+  // RunAsync().
+  while (!live_init_done_ && live_status_.ok() && !cancelled_.IsSet())
+    live_cv_.Wait();
+  if (!live_status_.ok())
+    return live_status_;
+  if (!live_init_done_)
+    return Status(error::CANCELLED, "Demuxer initialization cancelled.");
+  return Status::OK;
+}
+
+Status Demuxer::RunLiveIngest() {
+  Status status;
+  base::WaitableEvent done_event(false, false);
+  RunAsync(base::Bind(&SetStatusAndSignal, &status, &done_event));
+  done_event.Wait();
+  return status;
+}
+
+void Demuxer::RunAsync(const RunDoneCB& done_cb) {
+  DCHECK(SupportsRunAsync());
+  Status status = StartStreams();
+  if (!status.ok()) {
+    done_cb.Run(status);
+    return;
+  }
+
+  base::AutoLock scoped_lock(live_lock_);
+  DCHECK(!live_running_);
+  live_running_ = true;
+  live_done_cb_ = done_cb;
+  if (!live_status_.ok() || cancelled_.IsSet()) {
+    CloseLiveIngestChannel();
+    return;
+  }
+  live_ingest_reactor_->ResumeChannel(live_channel_id_);
+}
+
+void Demuxer::OnLiveIngestData(const uint8_t* data, size_t size) {
+  {
+    base::AutoLock scoped_lock(live_lock_);
+    if (!live_status_.ok() || cancelled_.IsSet())
+      return;
+  }
+
+  BeginParseStats();
+  const bool success = parser_->Parse(data, size);
+  EndParseStats();
+
+  base::AutoLock scoped_lock(live_lock_);
+  if (!success) {
+    live_status_ =
+        Status(error::PARSER_FAILURE, "Cannot parse media file " + file_name_);
+  }
+  if (live_running_) {
+    if (!live_status_.ok())
+      CloseLiveIngestChannel();
+    return;
+  }
+  if (init_event_received_)
+    live_init_done_ = true;
+  // The samples are not pushed until the streams are started.
+  if (live_init_done_ || !live_status_.ok())
+    live_ingest_reactor_->PauseChannel(live_channel_id_);
+  live_cv_.Broadcast();
+}
+
+void Demuxer::CloseLiveIngestChannel() {
+  live_lock_.AssertAcquired();
+  DCHECK(live_running_);
+  if (live_closing_)
+    return;
+  live_closing_ = true;
+  live_ingest_reactor_->CloseChannel(
+      live_channel_id_,
+      base::Bind(&Demuxer::OnLiveIngestChannelClosed, base::Unretained(this)));
+}
+
+void Demuxer::OnLiveIngestChannelClosed() {
+  RunDoneCB done_cb;
+  Status status;
+  {
+    base::AutoLock scoped_lock(live_lock_);
+    live_channel_id_ = -1;
+    done_cb = live_done_cb_;
+    live_done_cb_.Reset();
+    status = cancelled_.IsSet()
+                 ? Status(error::CANCELLED, "Demuxer run cancelled.")
+                 : live_status_;
+  }
+  // The demuxer may be destroyed by the callback.
+  done_cb.Run(status);
+}
+
 void Demuxer::ParserInitEvent(
     const std::vector<scoped_refptr<StreamInfo> >& streams) {
   init_event_received_ = true;
@@ -109,26 +329,61 @@ bool Demuxer::NewSampleEvent(uint32_t track_id,
   std::vector<MediaStream*>::iterator it = streams_.begin();
   for (; it != streams_.end(); ++it) {
     if (track_id == (*it)->info()->track_id()) {
-      return (*it)->PushSample(sample).ok();
+      if (!parse_stats_)
+        return (*it)->PushSample(sample).ok();
+
+      ++num_parsed_samples_;
+      num_parsed_bytes_ += sample->data_size();
+      const base::TimeTicks push_start = base::TimeTicks::Now();
+      const bool pushed = (*it)->PushSample(sample).ok();
+      downstream_time_ += base::TimeTicks::Now() - push_start;
+      return pushed;
     }
   }
   return false;
 }
 
-Status Demuxer::Run() {
-  Status status;
+void Demuxer::BeginParseStats() {
+  if (!parse_stats_)
+    return;
+  parse_start_ = base::TimeTicks::Now();
+  downstream_time_ = base::TimeDelta();
+  num_parsed_samples_ = 0;
+  num_parsed_bytes_ = 0;
+}
+
+void Demuxer::EndParseStats() {
+  if (!parse_stats_)
+    return;
+  parse_stats_->Add(
+      num_parsed_samples_,
+      num_parsed_bytes_,
+      base::TimeTicks::Now() - parse_start_ - downstream_time_);
+}
 
-  // Start the streams.
+Status Demuxer::StartStreams() {
   for (std::vector<MediaStream*>::iterator it = streams_.begin();
        it != streams_.end();
        ++it) {
-    status = (*it)->Start(MediaStream::kPush);
+    Status status = (*it)->Start(MediaStream::kPush);
     if (!status.ok())
       return status;
   }
+  return Status::OK;
+}
+
+Status Demuxer::Run() {
+  if (SupportsRunAsync())
+    return RunLiveIngest();
+
+  Status status = StartStreams();
+  if (!status.ok())
+    return status;
 
-  while ((status = Parse()).ok())
+  while (!cancelled_.IsSet() && (status = Parse()).ok())
     continue;
+  if (cancelled_.IsSet())
+    return Status(error::CANCELLED, "Demuxer run cancelled.");
 
   if (status.error_code() == error::END_OF_STREAM) {
     // Push EOS sample to muxer to indicate end of stream.
@@ -144,6 +399,18 @@ Status Demuxer::Run() {
   return status;
 }
 
+void Demuxer::Cancel() {
+  base::AutoLock scoped_lock(media_file_lock_);
+  cancelled_.Set();
+  // Wake up a read blocked on the source.
+  if (media_file_)
+    media_file_->Cancel();
+  base::AutoLock live_scoped_lock(live_lock_);
+  if (live_running_)
+    CloseLiveIngestChannel();
+  live_cv_.Broadcast();
+}
+
 Status Demuxer::Parse() {
   DCHECK(media_file_);
   DCHECK(parser_);
@@ -154,19 +421,56 @@ Status Demuxer::Parse() {
   if (!init_parsing_status_.ok())
     return init_parsing_status_;
 
-  int64_t bytes_read = media_file_->Read(buffer_.get(), kBufSize);
+  if (random_access_parser_) {
+    // The parser reads the file itself, so the parse stats include the reads.
+    bool eos = false;
+    BeginParseStats();
+    const bool success = random_access_parser_->ReadSamples(kBufSize, &eos);
+    EndParseStats();
+    if (!success) {
+      return Status(error::PARSER_FAILURE,
+                    "Cannot parse media file " + file_name_);
+    }
+    return eos ? Status(error::END_OF_STREAM, "") : Status::OK;
+  }
+
+  const uint8_t* data = buffer_.get();
+  int64_t bytes_read = 0;
+  bool eof = false;
+  {
+    ScopedStageTimer read_timer(read_stats_);
+    if (read_ahead_reader_) {
+      bytes_read = read_ahead_reader_->Read(&data);
+      eof = bytes_read == 0;
+    } else if (media_file_->SupportsReadView()) {
+      // Hand the mapped data to the parser directly.
+      bytes_read = media_file_->ReadView(&data, kBufSize);
+      eof = bytes_read == 0;
+    } else {
+      bytes_read = media_file_->Read(buffer_.get(), kBufSize);
+      eof = bytes_read <= 0 && media_file_->Eof();
+    }
+    if (bytes_read > 0) {
+      read_timer.set_count(1);
+      read_timer.set_bytes(bytes_read);
+    }
+  }
   if (bytes_read <= 0) {
-    if (media_file_->Eof()) {
+    if (eof) {
+      BeginParseStats();
       parser_->Flush();
+      EndParseStats();
       return Status(error::END_OF_STREAM, "");
     }
     return Status(error::FILE_FAILURE, "Cannot read file " + file_name_);
   }
 
-  return parser_->Parse(buffer_.get(), bytes_read)
-             ? Status::OK
-             : Status(error::PARSER_FAILURE,
-                      "Cannot parse media file " + file_name_);
+  BeginParseStats();
+  const bool success = parser_->Parse(data, bytes_read);
+  EndParseStats();
+  return success ? Status::OK
+                 : Status(error::PARSER_FAILURE,
+                          "Cannot parse media file " + file_name_);
 }
 
 }  // namespace media
@@ -9,8 +9,13 @@
 
 #include <vector>
 
+#include "packager/base/callback.h"
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/cancellation_flag.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
 #include "packager/media/base/container_names.h"
 #include "packager/media/base/status.h"
 
@@ -20,18 +25,31 @@ namespace media {
 class Decryptor;
 class File;
 class KeySource;
+class LiveIngestReactor;
 class MediaParser;
 class MediaSample;
 class MediaStream;
+class PipelineStats;
+class ReadAheadReader;
+class StageStats;
 class StreamInfo;
 
+namespace mp4 {
+class MP4MediaParser;
+}  // namespace mp4
+
 /// Demuxer is responsible for extracting elementary stream samples from a
 /// media file, e.g. an ISO BMFF file.
 class Demuxer {
  public:
+  /// Called with the result of RunAsync().
+  typedef base::Callback<void(const Status& status)> RunDoneCB;
+
   /// @param file_name specifies the input source. It uses prefix matching to
   ///        create a proper File object. The user can extend File to support
-  ///        a custom File object with its own prefix.
+  ///        a custom File object with its own prefix. Local files opened
+  ///        with the "mmap://" prefix are memory mapped and their data is
+  ///        passed to the parser without copying.
   explicit Demuxer(const std::string& file_name);
   ~Demuxer();
 
@@ -41,6 +59,29 @@ class Demuxer {
   ///        demuxed.
   void SetKeySource(scoped_ptr<KeySource> key_source);
 
+  /// Read the media file ahead on a separate thread, so that file reads
+  /// overlap with parsing. Should be called before Initialize(). Has no
+  /// effect on non-fragmented mp4 files, which are read randomly, or on
+  /// memory-mapped files.
+  /// @param num_buffers is the number of buffers used for reading ahead. Should
+  ///        be at least 2.
+  /// @param buffer_size is the size of each buffer, in bytes.
+  void EnableReadAhead(size_t num_buffers, size_t buffer_size);
+
+  /// Record the read, parse and decryption stats of the input, under the
+  /// input file name. Should be called before Initialize().
+  /// @param pipeline_stats is the collector of the stats. The caller retains
+  ///        ownership. It should outlive the demuxer.
+  void SetPipelineStats(PipelineStats* pipeline_stats);
+
+  /// Receive a UDP input through a LiveIngestReactor, which parses it on its
+  /// worker threads, instead of reading it on the thread calling Run(). See
+  /// RunAsync(). The input is expected to be an MPEG-2 TS. Should be called before
+  /// Initialize(). Has no effect on other inputs.
+  /// @param reactor is the reactor receiving the input. The caller retains
+  ///        ownership. It should outlive the demuxer.
+  void SetLiveIngestReactor(LiveIngestReactor* reactor);
+
   /// Initialize the Demuxer. Calling other public methods of this class
   /// without this method returning OK, results in an undefined behavior.
   /// This method primes the demuxer by parsing portions of the media file to
@@ -50,8 +91,29 @@ class Demuxer {
 
   /// Drive the remuxing from demuxer side (push). Read the file and push
   /// the Data to Muxer until Eof.
+  /// @return OK on success, CANCELLED if Cancel() was called before the end
+  ///         of the file was reached.
   Status Run();
 
+  /// @return true if RunAsync() can be called instead of Run(), i.e. if the
+  ///         input is received through a LiveIngestReactor. Only valid after
+  ///         Initialize() returns OK.
+  bool SupportsRunAsync() const { return live_channel_id_ >= 0; }
+
+  /// Push the samples to the muxers, like Run(), but from the worker threads
+  /// of the LiveIngestReactor receiving the input, without blocking the
+  /// calling thread. The demuxer should not be destroyed until @a done_cb is
+  /// called.
+  /// @param done_cb is called, on any thread, with the status Run() would
+  ///        have returned, once the streams are no longer used. It may be
+  ///        called before RunAsync() returns.
+  void RunAsync(const RunDoneCB& done_cb);
+
+  /// Stop Run() or RunAsync() as soon as possible. A read from the source in
+  /// progress, e.g. from a silent live stream, is interrupted. Can be called
+  /// from any thread, including while Initialize() is running.
+  void Cancel();
+
   /// Read from the source and send it to the parser.
   Status Parse();
 
@@ -67,14 +129,72 @@ class Demuxer {
   bool NewSampleEvent(uint32_t track_id,
                       const scoped_refptr<MediaSample>& sample);
 
+  // Bracket parser calls, to record their stats, excluding the time spent
+  // downstream, if stats are recorded.
+  void BeginParseStats();
+  void EndParseStats();
+
+  // Starts the streams. Called before pushing samples to them.
+  Status StartStreams();
+
+  // Initialize() and Run() for an input received through
+  // |live_ingest_reactor_|.
+  Status InitializeLiveIngest();
+  Status RunLiveIngest();
+  // Parses data received through |live_ingest_reactor_|. Called on the
+  // worker threads of the reactor, never concurrently.
+  void OnLiveIngestData(const uint8_t* data, size_t size);
+  // Closes the channel of a running input, once it failed or was cancelled.
+  // Called with |live_lock_| held.
+  void CloseLiveIngestChannel();
+  // Reports the end of RunAsync(). Called on a worker thread of the reactor
+  // once the channel is closed.
+  void OnLiveIngestChannelClosed();
+
   std::string file_name_;
   File* media_file_;
+  // Protects the assignment of |media_file_| against Cancel().
+  base::Lock media_file_lock_;
   bool init_event_received_;
   Status init_parsing_status_;
   scoped_ptr<MediaParser> parser_;
+  // Set if the parser reads samples directly from |media_file_| instead of
+  // being fed through MediaParser::Parse(). Aliases |parser_|.
+  mp4::MP4MediaParser* random_access_parser_;
   std::vector<MediaStream*> streams_;
   scoped_ptr<uint8_t[]> buffer_;
   scoped_ptr<KeySource> key_source_;
+  size_t read_ahead_num_buffers_;
+  size_t read_ahead_buffer_size_;
+  // Set if the file is read ahead. Must be destroyed before |media_file_| is
+  // closed.
+  scoped_ptr<ReadAheadReader> read_ahead_reader_;
+  base::CancellationFlag cancelled_;
+  // Set if stats are recorded.
+  PipelineStats* pipeline_stats_;
+  StageStats* read_stats_;
+  StageStats* parse_stats_;
+  // Stats of the current parser call.
+  base::TimeTicks parse_start_;
+  // Time spent downstream of the parser, in NewSampleEvent.
+  base::TimeDelta downstream_time_;
+  int64_t num_parsed_samples_;
+  int64_t num_parsed_bytes_;
+
+  // Set if the input is received through a LiveIngestReactor.
+  LiveIngestReactor* live_ingest_reactor_;
+  // Channel of the input in |live_ingest_reactor_|, or -1 once it is closed.
+  // Set under |live_lock_|.
+  int live_channel_id_;
+  base::Lock live_lock_;
+  // Signaled when a field protected by |live_lock_| changes, or on Cancel().
+  base::ConditionVariable live_cv_;
+  // Protected by |live_lock_|.
+  bool live_init_done_;
+  bool live_running_;
+  bool live_closing_;
+  Status live_status_;
+  RunDoneCB live_done_cb_;
 
   DISALLOW_COPY_AND_ASSIGN(Demuxer);
 };
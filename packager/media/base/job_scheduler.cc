@@ -0,0 +1,234 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/job_scheduler.h"
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/base/worker_pool.h"
+
+namespace edash_packager {
+namespace media {
+
+class JobScheduler::Core : public base::RefCountedThreadSafe<Core> {
+ public:
+  Core() : done_cv_(&lock_), num_pending_jobs_(0) {}
+
+  void AddJob(const std::string& name, Job* job) {
+    jobs_.push_back(job);
+    job_stats_.push_back(JobStats());
+    job_stats_.back().name = name;
+  }
+
+  size_t num_jobs() const { return jobs_.size(); }
+  bool IsAsynchronousJob(size_t index) {
+    return jobs_[index]->IsAsynchronous();
+  }
+  const std::vector<JobStats>& job_stats() const { return job_stats_; }
+
+  // Marks all the jobs as queued. Should be called before their tasks are
+  // posted.
+  void QueueJobs();
+
+  // Runs job |index| on a worker thread, unless it was cancelled before it
+  // started.
+  void RunJob(size_t index);
+
+  // Starts asynchronous job |index|, unless it was cancelled.
+  void StartJob(size_t index);
+
+  // Blocks until all the jobs are completed or cancelled.
+  // @return the status of the first job that failed.
+  Status WaitForJobs();
+
+ private:
+  friend class base::RefCountedThreadSafe<Core>;
+
+  enum JobState {
+    kJobQueued,
+    kJobRunning,
+    kJobDone,
+  };
+
+  ~Core() {}
+
+  // Called when asynchronous job |index|, started at |start_time|,
+  // completes.
+  void OnJobDone(size_t index,
+                 base::TimeTicks start_time,
+                 const Status& status);
+
+  // Records the completion of job |index|. Cancels the other jobs on the
+  // first failure.
+  void CompleteJob(size_t index, const Status& status);
+
+  std::vector<Job*> jobs_;
+  std::vector<JobStats> job_stats_;
+
+  base::Lock lock_;
+  // Signaled when |num_pending_jobs_| drops to 0.
+  base::ConditionVariable done_cv_;
+  // Protected by |lock_|.
+  std::vector<JobState> job_states_;
+  // Number of jobs not completed or cancelled yet. Protected by |lock_|.
+  size_t num_pending_jobs_;
+  // Status of the first job that failed. Protected by |lock_|.
+  Status status_;
+
+  DISALLOW_COPY_AND_ASSIGN(Core);
+};
+
+void JobScheduler::Core::QueueJobs() {
+  base::AutoLock auto_lock(lock_);
+  job_states_.assign(jobs_.size(), kJobQueued);
+  num_pending_jobs_ = jobs_.size();
+}
+
+void JobScheduler::Core::RunJob(size_t index) {
+  {
+    base::AutoLock auto_lock(lock_);
+    // The job may have been cancelled, and Run() may have returned, while
+    // this task was queued.
+    if (job_states_[index] != kJobQueued)
+      return;
+    job_states_[index] = kJobRunning;
+  }
+
+  const bool measure_cpu_time = base::TimeTicks::IsThreadNowSupported();
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  const base::TimeTicks start_cpu_time =
+      measure_cpu_time ? base::TimeTicks::ThreadNow() : base::TimeTicks();
+
+  Status status = jobs_[index]->Run();
+
+  JobStats& stats = job_stats_[index];
+  stats.wall_time = base::TimeTicks::Now() - start_time;
+  if (measure_cpu_time)
+    stats.cpu_time = base::TimeTicks::ThreadNow() - start_cpu_time;
+  stats.status = status;
+  CompleteJob(index, status);
+}
+
+void JobScheduler::Core::StartJob(size_t index) {
+  {
+    base::AutoLock auto_lock(lock_);
+    if (job_states_[index] != kJobQueued)
+      return;
+    job_states_[index] = kJobRunning;
+  }
+  // The job may complete before Start() returns.
+  jobs_[index]->Start(
+      base::Bind(&Core::OnJobDone, this, index, base::TimeTicks::Now()));
+}
+
+void JobScheduler::Core::OnJobDone(size_t index,
+                                   base::TimeTicks start_time,
+                                   const Status& status) {
+  JobStats& stats = job_stats_[index];
+  stats.wall_time = base::TimeTicks::Now() - start_time;
+  stats.status = status;
+  CompleteJob(index, status);
+}
+
+void JobScheduler::Core::CompleteJob(size_t index, const Status& status) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK_EQ(kJobRunning, job_states_[index]);
+  job_states_[index] = kJobDone;
+  --num_pending_jobs_;
+  if (!status.ok() && status_.ok()) {
+    // First failure: cancel the running jobs, and the queued jobs right away
+    // rather than when their tasks are dequeued, as a shared pool may be
+    // busy with the jobs of other schedulers for long.
+    status_ = status;
+    for (size_t i = 0; i < jobs_.size(); ++i) {
+      if (job_states_[i] == kJobRunning) {
+        jobs_[i]->Cancel();
+      } else if (job_states_[i] == kJobQueued) {
+        job_states_[i] = kJobDone;
+        job_stats_[i].status =
+            Status(error::CANCELLED, "Job cancelled before it started.");
+        --num_pending_jobs_;
+      }
+    }
+  }
+  if (num_pending_jobs_ == 0)
+    done_cv_.Signal();
+}
+
+Status JobScheduler::Core::WaitForJobs() {
+  base::AutoLock auto_lock(lock_);
+  while (num_pending_jobs_ > 0)
+    done_cv_.Wait();
+  return status_;
+}
+
+JobScheduler::JobStats::JobStats() {}
+
+JobScheduler::JobScheduler(size_t max_concurrent_jobs)
+    : max_concurrent_jobs_(max_concurrent_jobs),
+      shared_worker_pool_(NULL),
+      core_(new Core) {}
+
+JobScheduler::JobScheduler(WorkerPool* worker_pool)
+    : max_concurrent_jobs_(0),
+      shared_worker_pool_(worker_pool),
+      core_(new Core) {
+  DCHECK(worker_pool);
+}
+
+JobScheduler::~JobScheduler() {}
+
+void JobScheduler::AddJob(const std::string& name, Job* job) {
+  DCHECK(job);
+  core_->AddJob(name, job);
+}
+
+Status JobScheduler::Run() {
+  const size_t num_jobs = core_->num_jobs();
+  if (num_jobs == 0)
+    return Status::OK;
+
+  core_->QueueJobs();
+
+  std::vector<size_t> synchronous_jobs;
+  for (size_t i = 0; i < num_jobs; ++i) {
+    if (core_->IsAsynchronousJob(i))
+      core_->StartJob(i);
+    else
+      synchronous_jobs.push_back(i);
+  }
+
+  scoped_ptr<WorkerPool> owned_worker_pool;
+  WorkerPool* worker_pool = shared_worker_pool_;
+  if (!worker_pool && !synchronous_jobs.empty()) {
+    size_t num_threads = synchronous_jobs.size();
+    if (max_concurrent_jobs_ > 0)
+      num_threads = std::min(num_threads, max_concurrent_jobs_);
+    owned_worker_pool.reset(new WorkerPool("JobScheduler", num_threads));
+    worker_pool = owned_worker_pool.get();
+  }
+  // The tasks hold a reference to |core_|, so that the tasks of cancelled
+  // jobs can still be dequeued from a shared pool once this method returns.
+  for (size_t i = 0; i < synchronous_jobs.size(); ++i) {
+    worker_pool->PostTask(
+        base::Bind(&Core::RunJob, core_, synchronous_jobs[i]));
+  }
+
+  // A shared pool may be running the jobs of other schedulers, so wait for
+  // this scheduler's jobs only.
+  return core_->WaitForJobs();
+}
+
+const std::vector<JobScheduler::JobStats>& JobScheduler::job_stats() const {
+  return core_->job_stats();
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,125 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_JOB_SCHEDULER_H_
+#define MEDIA_BASE_JOB_SCHEDULER_H_
+
+#include <string>
+#include <vector>
+
+#include "packager/base/callback.h"
+#include "packager/base/memory/ref_counted.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/status.h"
+
+namespace edash_packager {
+namespace media {
+
+class WorkerPool;
+
+/// Runs a queue of jobs with a limited number of threads. The first job to
+/// fail cancels the jobs that are running and the jobs that have not started
+/// yet.
+///
+/// Several schedulers can share a WorkerPool, in which case the limit on
+/// the number of threads applies to all their jobs together.
+///
+/// Asynchronous jobs, whose work is done on threads of their own, e.g. those
+/// of a LiveIngestReactor, do not use the scheduler threads. They are all
+/// started by Run(), whatever the limit on the number of threads.
+///
+/// Thread Safety: All the methods should be called from the creating thread.
+class JobScheduler {
+ public:
+  /// Interface of the jobs run by the scheduler.
+  class Job {
+   public:
+    /// Called with the result of an asynchronous job.
+    typedef base::Callback<void(const Status& status)> DoneCB;
+
+    virtual ~Job() {}
+
+    /// Run the job. Called on one of the scheduler threads.
+    /// @return OK on success, an error status otherwise.
+    virtual Status Run() = 0;
+
+    /// Make a running Run() return as soon as possible. Called from another
+    /// thread while Run() is running, so it must be thread safe. For an
+    /// asynchronous job, make it call its DoneCB as soon as possible instead.
+    /// Should not call the DoneCB itself.
+    virtual void Cancel() = 0;
+
+    /// @return true if the job is asynchronous, in which case Start() is
+    ///         called instead of Run().
+    virtual bool IsAsynchronous() { return false; }
+
+    /// Start an asynchronous job, without blocking. Called on the thread
+    /// running the scheduler.
+    /// @param done_cb is called once, on any thread, with the result of the
+    ///        job when it completes. It may be called before Start()
+    ///        returns.
+    virtual void Start(const DoneCB& done_cb) {}
+  };
+
+  /// Statistics collected for each job.
+  struct JobStats {
+    JobStats();
+
+    std::string name;
+    /// Result of the job. CANCELLED if the job was cancelled before it
+    /// started.
+    Status status;
+    /// Time elapsed between the start and the end of the job.
+    base::TimeDelta wall_time;
+    /// CPU time used by the job thread while running the job. Zero if the
+    /// platform cannot measure per-thread CPU time, or if the job is
+    /// asynchronous.
+    base::TimeDelta cpu_time;
+  };
+
+  /// @param max_concurrent_jobs is the maximum number of jobs run at the same
+  ///        time. If 0, all the jobs are run at the same time.
+  explicit JobScheduler(size_t max_concurrent_jobs);
+  /// @param worker_pool is the pool running the jobs. Not owned. It should
+  ///        outlive the scheduler.
+  explicit JobScheduler(WorkerPool* worker_pool);
+  ~JobScheduler();
+
+  /// Add a job to the queue. Jobs are started in the order they are added,
+  /// asynchronous jobs first.
+  /// Should not be called once Run() has been called.
+  /// @param name is the name of the job, used in its statistics.
+  /// @param job is the job to run. Not owned. It should outlive the
+  ///        scheduler.
+  void AddJob(const std::string& name, Job* job);
+
+  /// Run all the jobs and wait for them to complete. Should be called once.
+  /// @return OK if all the jobs succeeded, otherwise the status of the first
+  ///         job that failed.
+  Status Run();
+
+  /// @return The statistics of the jobs, in the order they were added.
+  ///         Only valid after Run() returns.
+  const std::vector<JobStats>& job_stats() const;
+
+ private:
+  // State shared with the tasks posted to the worker pool. Reference counted,
+  // as the tasks of the jobs cancelled before they started may only be
+  // dequeued after Run() has returned.
+  class Core;
+
+  const size_t max_concurrent_jobs_;
+  // Set if the jobs are run by a pool shared with other schedulers.
+  WorkerPool* const shared_worker_pool_;
+  scoped_refptr<Core> core_;
+
+  DISALLOW_COPY_AND_ASSIGN(JobScheduler);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_BASE_JOB_SCHEDULER_H_
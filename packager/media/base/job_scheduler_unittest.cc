@@ -0,0 +1,285 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/job_scheduler.h"
+#include "packager/media/base/worker_pool.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace {
+
+const size_t kMaxConcurrentJobs = 3;
+const int kNumJobs = 10;
+const int kJobDurationMs = 10;
+const int kCancellationTimeoutMs = 5000;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+// Keeps track of the number of jobs running at the same time.
+class ConcurrencyCounter {
+ public:
+  ConcurrencyCounter() : num_running_(0), max_num_running_(0) {}
+
+  void Enter() {
+    base::AutoLock auto_lock(lock_);
+    ++num_running_;
+    max_num_running_ = std::max(max_num_running_, num_running_);
+  }
+
+  void Leave() {
+    base::AutoLock auto_lock(lock_);
+    --num_running_;
+  }
+
+  int max_num_running() {
+    base::AutoLock auto_lock(lock_);
+    return max_num_running_;
+  }
+
+ private:
+  base::Lock lock_;
+  int num_running_;
+  int max_num_running_;
+};
+
+class FakeJob : public JobScheduler::Job {
+ public:
+  // |status| is the status returned by Run(). If |wait_for_cancel| is true,
+  // Run() blocks until Cancel() is called, then returns CANCELLED.
+  FakeJob(ConcurrencyCounter* counter, Status status, bool wait_for_cancel)
+      : counter_(counter),
+        status_(status),
+        wait_for_cancel_(wait_for_cancel),
+        run_(false),
+        cancelled_(true, false) {}
+  virtual ~FakeJob() {}
+
+  virtual Status Run() OVERRIDE {
+    run_ = true;
+    counter_->Enter();
+    if (wait_for_cancel_) {
+      const bool cancelled = cancelled_.TimedWait(
+          base::TimeDelta::FromMilliseconds(kCancellationTimeoutMs));
+      counter_->Leave();
+      return cancelled ? Status(error::CANCELLED, "Cancelled.") : status_;
+    }
+    base::PlatformThread::Sleep(
+        base::TimeDelta::FromMilliseconds(kJobDurationMs));
+    counter_->Leave();
+    return status_;
+  }
+
+  virtual void Cancel() OVERRIDE { cancelled_.Signal(); }
+
+  bool run() const { return run_; }
+
+ private:
+  ConcurrencyCounter* counter_;
+  Status status_;
+  bool wait_for_cancel_;
+  bool run_;
+  base::WaitableEvent cancelled_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeJob);
+};
+
+// Asynchronous job completing on a thread of its own when cancelled.
+class FakeAsyncJob : public JobScheduler::Job {
+ public:
+  FakeAsyncJob() : cancelled_(true, false) {}
+  virtual ~FakeAsyncJob() {}
+
+  virtual Status Run() OVERRIDE {
+    NOTREACHED();
+    return Status::OK;
+  }
+
+  virtual void Cancel() OVERRIDE { cancelled_.Signal(); }
+
+  virtual bool IsAsynchronous() OVERRIDE { return true; }
+
+  virtual void Start(const DoneCB& done_cb) OVERRIDE {
+    done_cb_ = done_cb;
+    thread_.reset(new ClosureThread(
+        "FakeAsyncJob",
+        base::Bind(&FakeAsyncJob::WaitForCancel, base::Unretained(this))));
+    thread_->Start();
+  }
+
+  bool started() const { return thread_.get() != NULL; }
+
+ private:
+  void WaitForCancel() {
+    const bool cancelled = cancelled_.TimedWait(
+        base::TimeDelta::FromMilliseconds(kCancellationTimeoutMs));
+    done_cb_.Run(cancelled ? Status(error::CANCELLED, "Cancelled.")
+                           : Status::OK);
+  }
+
+  base::WaitableEvent cancelled_;
+  DoneCB done_cb_;
+  // Joins on destruction.
+  scoped_ptr<ClosureThread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeAsyncJob);
+};
+
+class JobSchedulerTest : public ::testing::Test {
+ public:
+  virtual ~JobSchedulerTest() { STLDeleteElements(&jobs_); }
+
+ protected:
+  FakeJob* AddJob(JobScheduler* scheduler,
+                  Status status,
+                  bool wait_for_cancel) {
+    jobs_.push_back(new FakeJob(&counter_, status, wait_for_cancel));
+    scheduler->AddJob("FakeJob", jobs_.back());
+    return jobs_.back();
+  }
+
+  ConcurrencyCounter counter_;
+  std::vector<FakeJob*> jobs_;
+};
+
+TEST_F(JobSchedulerTest, NoJobs) {
+  JobScheduler scheduler(kMaxConcurrentJobs);
+  ASSERT_OK(scheduler.Run());
+  EXPECT_TRUE(scheduler.job_stats().empty());
+}
+
+TEST_F(JobSchedulerTest, MaxConcurrentJobs) {
+  JobScheduler scheduler(kMaxConcurrentJobs);
+  for (int i = 0; i < kNumJobs; ++i)
+    AddJob(&scheduler, Status::OK, false);
+  ASSERT_OK(scheduler.Run());
+
+  EXPECT_LE(counter_.max_num_running(), static_cast<int>(kMaxConcurrentJobs));
+  ASSERT_EQ(static_cast<size_t>(kNumJobs), scheduler.job_stats().size());
+  for (int i = 0; i < kNumJobs; ++i) {
+    EXPECT_TRUE(jobs_[i]->run());
+    const JobScheduler::JobStats& stats = scheduler.job_stats()[i];
+    EXPECT_EQ("FakeJob", stats.name);
+    EXPECT_OK(stats.status);
+    EXPECT_GE(stats.wall_time.InMilliseconds(), kJobDurationMs);
+  }
+}
+
+TEST_F(JobSchedulerTest, SharedWorkerPool) {
+  WorkerPool worker_pool("TestJobScheduler", kMaxConcurrentJobs);
+  JobScheduler scheduler1(&worker_pool);
+  JobScheduler scheduler2(&worker_pool);
+  for (int i = 0; i < kNumJobs; ++i) {
+    AddJob(&scheduler1, Status::OK, false);
+    AddJob(&scheduler2, Status::OK, false);
+  }
+  // The jobs of the second scheduler wait for the pool threads to be done
+  // with the jobs of the first one.
+  ASSERT_OK(scheduler1.Run());
+  ASSERT_OK(scheduler2.Run());
+
+  EXPECT_LE(counter_.max_num_running(), static_cast<int>(kMaxConcurrentJobs));
+  for (size_t i = 0; i < jobs_.size(); ++i)
+    EXPECT_TRUE(jobs_[i]->run());
+}
+
+TEST_F(JobSchedulerTest, UnlimitedConcurrentJobs) {
+  const size_t kUnlimited = 0;
+  JobScheduler scheduler(kUnlimited);
+  for (int i = 0; i < kNumJobs; ++i)
+    AddJob(&scheduler, Status::OK, true);
+  // The other jobs block until cancelled, so the failing job only runs
+  // before they time out if all the jobs run at the same time.
+  AddJob(&scheduler, Status(error::UNKNOWN, "Failed."), false);
+
+  EXPECT_EQ(error::UNKNOWN, scheduler.Run().error_code());
+  for (int i = 0; i < kNumJobs; ++i)
+    EXPECT_EQ(error::CANCELLED, scheduler.job_stats()[i].status.error_code());
+}
+
+TEST_F(JobSchedulerTest, FirstErrorCancelsOtherJobs) {
+  JobScheduler scheduler(2);
+  FakeJob* blocked_job = AddJob(&scheduler, Status::OK, true);
+  AddJob(&scheduler, Status(error::PARSER_FAILURE, "Failed."), false);
+  std::vector<FakeJob*> queued_jobs;
+  for (int i = 0; i < kNumJobs; ++i)
+    queued_jobs.push_back(AddJob(&scheduler, Status::OK, false));
+
+  EXPECT_EQ(error::PARSER_FAILURE, scheduler.Run().error_code());
+
+  const std::vector<JobScheduler::JobStats>& stats = scheduler.job_stats();
+  // The blocked job is either cancelled while running or before it starts.
+  EXPECT_EQ(error::CANCELLED, stats[0].status.error_code());
+  if (blocked_job->run()) {
+    EXPECT_LT(stats[0].wall_time.InMilliseconds(), kCancellationTimeoutMs);
+  }
+  EXPECT_EQ(error::PARSER_FAILURE, stats[1].status.error_code());
+  for (int i = 0; i < kNumJobs; ++i) {
+    EXPECT_FALSE(queued_jobs[i]->run());
+    EXPECT_EQ(error::CANCELLED, stats[i + 2].status.error_code());
+  }
+}
+
+TEST_F(JobSchedulerTest, AsynchronousJobsDoNotUseSchedulerThreads) {
+  FakeAsyncJob async_jobs[kNumJobs];
+  // A single scheduler thread is enough to run the failing job, as the other
+  // jobs are asynchronous.
+  JobScheduler scheduler(1);
+  for (int i = 0; i < kNumJobs; ++i)
+    scheduler.AddJob("FakeAsyncJob", &async_jobs[i]);
+  AddJob(&scheduler, Status(error::PARSER_FAILURE, "Failed."), false);
+
+  EXPECT_EQ(error::PARSER_FAILURE, scheduler.Run().error_code());
+
+  const std::vector<JobScheduler::JobStats>& stats = scheduler.job_stats();
+  for (int i = 0; i < kNumJobs; ++i) {
+    EXPECT_TRUE(async_jobs[i].started());
+    EXPECT_EQ(error::CANCELLED, stats[i].status.error_code());
+    EXPECT_LT(stats[i].wall_time.InMilliseconds(), kCancellationTimeoutMs);
+  }
+}
+
+TEST_F(JobSchedulerTest, FirstErrorCancelsJobsQueuedInBusySharedPool) {
+  base::WaitableEvent release_pool(true, false);
+  WorkerPool worker_pool("TestJobScheduler", 2);
+  // Keeps a thread of the pool busy, like a long job of another scheduler.
+  worker_pool.PostTask(base::Bind(&base::WaitableEvent::Wait,
+                                  base::Unretained(&release_pool)));
+
+  JobScheduler scheduler(&worker_pool);
+  AddJob(&scheduler, Status(error::PARSER_FAILURE, "Failed."), false);
+  std::vector<FakeJob*> queued_jobs;
+  for (int i = 0; i < kNumJobs; ++i)
+    queued_jobs.push_back(AddJob(&scheduler, Status::OK, false));
+
+  // Returns while the tasks of the queued jobs are still in the pool.
+  EXPECT_EQ(error::PARSER_FAILURE, scheduler.Run().error_code());
+
+  const std::vector<JobScheduler::JobStats>& stats = scheduler.job_stats();
+  for (int i = 0; i < kNumJobs; ++i)
+    EXPECT_EQ(error::CANCELLED, stats[i + 1].status.error_code());
+
+  release_pool.Signal();
+  worker_pool.WaitForIdle();
+  for (int i = 0; i < kNumJobs; ++i)
+    EXPECT_FALSE(queued_jobs[i]->run());
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,494 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/live_ingest_reactor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(OS_LINUX)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/worker_pool.h"
+#include "packager/media/file/udp_file.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+// Largest UDP payload over IPv4.
+const size_t kMaxDatagramSize = 65507;
+// Number of datagrams received per recvmmsg call.
+const size_t kReceiveBatchSize = 32;
+// Maximum number of recvmmsg calls on a socket per wakeup, so that a busy
+// channel does not starve the other channels of the same receive thread.
+const size_t kMaxBatchesPerWakeup = 4;
+// Maximum number of events returned by epoll_wait.
+const int kMaxEvents = 64;
+// Maximum amount of data queued for a channel.
+const size_t kMaxQueuedBytesPerChannel = 16 * 1024 * 1024;
+// Event identifier of the wakeup eventfd. Channel identifiers are
+// non-negative.
+const uint64_t kWakeupEventId = std::numeric_limits<uint64_t>::max();
+
+}  // namespace
+
+struct LiveIngestReactor::Channel {
+  Channel(int id, int socket, const DataCB& data_cb)
+      : id(id),
+        socket(socket),
+        data_cb(data_cb),
+        receive_loop(NULL),
+        idle_cv(&lock),
+        scheduled(false),
+        paused(false),
+        removed(false) {}
+
+  const int id;
+  const int socket;
+  const DataCB data_cb;
+  ReceiveLoop* receive_loop;
+
+  base::Lock lock;
+  // Signaled when |scheduled| becomes false.
+  base::ConditionVariable idle_cv;
+  // Protected by |lock|.
+  std::vector<uint8_t> queue;
+  bool scheduled;  // ServiceChannel() is posted or running.
+  bool paused;
+  bool removed;
+  ChannelStats stats;
+
+  // Data passed to |data_cb|. Only used by ServiceChannel(), which never runs
+  // concurrently for a channel.
+  std::vector<uint8_t> service_buffer;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Channel);
+};
+
+/// Waits for the sockets of its channels with epoll on a dedicated thread,
+/// and receives from the readable ones.
+class LiveIngestReactor::ReceiveLoop {
+ public:
+  explicit ReceiveLoop(LiveIngestReactor* reactor);
+  ~ReceiveLoop();
+
+  bool AddChannel(Channel* channel);
+  // No data is received for |channel| once this method returns.
+  void RemoveChannel(Channel* channel);
+
+ private:
+  void Run();
+  void ReceiveFromChannel(Channel* channel);
+
+  LiveIngestReactor* const reactor_;
+  int epoll_fd_;
+  // Written to stop the thread.
+  int wakeup_fd_;
+  scoped_ptr<ClosureThread> thread_;
+
+  // Held by the thread while it receives, so that RemoveChannel() can wait
+  // for it to be done with a channel.
+  base::Lock lock_;
+  // Protected by |lock_|.
+  std::map<int, Channel*> channels_;
+
+  // Only used by the thread.
+  std::vector<uint8_t> batch_buffer_;
+  std::vector<uint8_t> control_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReceiveLoop);
+};
+
+LiveIngestReactor::ReceiveLoop::ReceiveLoop(LiveIngestReactor* reactor)
+    : reactor_(reactor), epoll_fd_(-1), wakeup_fd_(-1) {
+#if defined(OS_LINUX)
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  PCHECK(epoll_fd_ >= 0) << "Failed to create epoll instance.";
+  wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  PCHECK(wakeup_fd_ >= 0) << "Failed to create eventfd.";
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u64 = kWakeupEventId;
+  PCHECK(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) == 0);
+
+  thread_.reset(new ClosureThread(
+      "LiveIngestReceive",
+      base::Bind(&ReceiveLoop::Run, base::Unretained(this))));
+  thread_->Start();
+#endif
+}
+
+LiveIngestReactor::ReceiveLoop::~ReceiveLoop() {
+  DCHECK(channels_.empty());
+#if defined(OS_LINUX)
+  const uint64_t value = 1;
+  PCHECK(write(wakeup_fd_, &value, sizeof(value)) ==
+         static_cast<ssize_t>(sizeof(value)));
+  // ClosureThread joins on destruction.
+  thread_.reset();
+  close(wakeup_fd_);
+  close(epoll_fd_);
+#endif
+}
+
+bool LiveIngestReactor::ReceiveLoop::AddChannel(Channel* channel) {
+#if defined(OS_LINUX)
+  base::AutoLock auto_lock(lock_);
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u64 = channel->id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, channel->socket, &event) != 0) {
+    PLOG(ERROR) << "Failed to add socket to epoll instance.";
+    return false;
+  }
+  channels_[channel->id] = channel;
+  return true;
+#else
+  NOTIMPLEMENTED();
+  return false;
+#endif
+}
+
+void LiveIngestReactor::ReceiveLoop::RemoveChannel(Channel* channel) {
+#if defined(OS_LINUX)
+  base::AutoLock auto_lock(lock_);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, channel->socket, NULL) != 0)
+    PLOG(WARNING) << "Failed to remove socket from epoll instance.";
+  // Events already returned by epoll_wait for this channel are ignored, as
+  // it is no longer found.
+  channels_.erase(channel->id);
+#endif
+}
+
+void LiveIngestReactor::ReceiveLoop::Run() {
+#if defined(OS_LINUX)
+  batch_buffer_.resize(kReceiveBatchSize * kMaxDatagramSize);
+  control_buffer_.resize(kReceiveBatchSize * CMSG_SPACE(sizeof(uint32_t)));
+
+  struct epoll_event events[kMaxEvents];
+  while (true) {
+    const int num_events = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+    if (num_events < 0) {
+      if (errno == EINTR)
+        continue;
+      PLOG(ERROR) << "epoll_wait failed.";
+      return;
+    }
+
+    base::AutoLock auto_lock(lock_);
+    for (int i = 0; i < num_events; ++i) {
+      if (events[i].data.u64 == kWakeupEventId)
+        return;
+      std::map<int, Channel*>::iterator it =
+          channels_.find(static_cast<int>(events[i].data.u64));
+      if (it != channels_.end())
+        ReceiveFromChannel(it->second);
+    }
+  }
+#endif
+}
+
+void LiveIngestReactor::ReceiveLoop::ReceiveFromChannel(Channel* channel) {
+#if defined(OS_LINUX)
+  const size_t kControlSize = CMSG_SPACE(sizeof(uint32_t));
+  struct mmsghdr messages[kReceiveBatchSize];
+  struct iovec iovecs[kReceiveBatchSize];
+
+  for (size_t batch = 0; batch < kMaxBatchesPerWakeup; ++batch) {
+    for (size_t i = 0; i < kReceiveBatchSize; ++i) {
+      iovecs[i].iov_base = &batch_buffer_[i * kMaxDatagramSize];
+      iovecs[i].iov_len = kMaxDatagramSize;
+      memset(&messages[i], 0, sizeof(messages[i]));
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_control = &control_buffer_[i * kControlSize];
+      messages[i].msg_hdr.msg_controllen = kControlSize;
+    }
+    const int num_messages = recvmmsg(
+        channel->socket, messages, kReceiveBatchSize, MSG_DONTWAIT, NULL);
+    if (num_messages < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+        PLOG(ERROR) << "Failed to receive on channel " << channel->id;
+      return;
+    }
+
+    for (int i = 0; i < num_messages; ++i) {
+      // Total number of datagrams dropped on the socket so far, if reported
+      // with this datagram.
+      uint32_t total_datagrams_dropped = 0;
+#if defined(SO_RXQ_OVFL)
+      struct msghdr* header = &messages[i].msg_hdr;
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(header); cmsg != NULL;
+           cmsg = CMSG_NXTHDR(header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SO_RXQ_OVFL) {
+          memcpy(&total_datagrams_dropped, CMSG_DATA(cmsg),
+                 sizeof(total_datagrams_dropped));
+        }
+      }
+#endif
+      reactor_->OnDatagramReceived(channel,
+                                   &batch_buffer_[i * kMaxDatagramSize],
+                                   messages[i].msg_len,
+                                   total_datagrams_dropped);
+    }
+    // The socket is drained.
+    if (static_cast<size_t>(num_messages) < kReceiveBatchSize)
+      return;
+  }
+#endif
+}
+
+LiveIngestReactor::ChannelStats::ChannelStats()
+    : datagrams_received(0),
+      bytes_received(0),
+      datagrams_dropped(0),
+      overruns(0) {}
+
+LiveIngestReactor::LiveIngestReactor(size_t num_receive_threads,
+                                     size_t num_worker_threads)
+    : worker_pool_(new WorkerPool("LiveIngestWorker", num_worker_threads)),
+      next_channel_id_(0),
+      next_receive_loop_(0) {
+  DCHECK_GT(num_receive_threads, 0u);
+  for (size_t i = 0; i < num_receive_threads; ++i)
+    receive_loops_.push_back(new ReceiveLoop(this));
+}
+
+LiveIngestReactor::~LiveIngestReactor() {
+  std::vector<int> channel_ids;
+  {
+    base::AutoLock auto_lock(lock_);
+    for (std::map<int, Channel*>::const_iterator it = channels_.begin();
+         it != channels_.end();
+         ++it) {
+      channel_ids.push_back(it->first);
+    }
+  }
+  for (size_t i = 0; i < channel_ids.size(); ++i)
+    RemoveChannel(channel_ids[i]);
+
+  STLDeleteElements(&receive_loops_);
+  worker_pool_.reset();
+}
+
+Status LiveIngestReactor::AddChannel(const std::string& address_and_port,
+                                     const DataCB& data_cb,
+                                     int* channel_id) {
+  DCHECK(channel_id);
+
+#if defined(OS_LINUX)
+  const int socket = UdpFile::OpenSocket(address_and_port);
+  if (socket < 0) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot open UDP stream " + address_and_port);
+  }
+  // The sockets are drained until they would block.
+  const int flags = fcntl(socket, F_GETFL, 0);
+  if (flags < 0 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+    close(socket);
+    return Status(error::FILE_FAILURE,
+                  "Cannot make UDP socket non-blocking for " +
+                      address_and_port);
+  }
+
+  base::AutoLock auto_lock(lock_);
+  Channel* channel = new Channel(next_channel_id_, socket, data_cb);
+  channel->receive_loop =
+      receive_loops_[next_receive_loop_ % receive_loops_.size()];
+  if (!channel->receive_loop->AddChannel(channel)) {
+    close(socket);
+    delete channel;
+    return Status(error::FILE_FAILURE,
+                  "Cannot receive UDP stream " + address_and_port);
+  }
+  ++next_receive_loop_;
+  channels_[next_channel_id_] = channel;
+  *channel_id = next_channel_id_++;
+  return Status::OK;
+#else
+  return Status(error::UNIMPLEMENTED,
+                "Live ingest reactor is only supported on Linux.");
+#endif
+}
+
+void LiveIngestReactor::RemoveChannel(int channel_id) {
+  Channel* channel = DetachChannel(channel_id);
+  if (channel)
+    DeleteChannel(channel);
+}
+
+void LiveIngestReactor::CloseChannel(int channel_id,
+                                     const base::Closure& closed_cb) {
+  Channel* channel = DetachChannel(channel_id);
+  if (!channel)
+    return;
+  // A ServiceChannel() task already posted for the channel is ahead of this
+  // one, so this one rarely has to wait.
+  worker_pool_->PostTask(base::Bind(&LiveIngestReactor::FinishCloseChannel,
+                                    base::Unretained(this),
+                                    channel,
+                                    closed_cb));
+}
+
+void LiveIngestReactor::PauseChannel(int channel_id) {
+  base::AutoLock auto_lock(lock_);
+  Channel* channel = FindChannel(channel_id);
+  if (!channel)
+    return;
+  base::AutoLock channel_auto_lock(channel->lock);
+  channel->paused = true;
+}
+
+void LiveIngestReactor::ResumeChannel(int channel_id) {
+  base::AutoLock auto_lock(lock_);
+  Channel* channel = FindChannel(channel_id);
+  if (!channel)
+    return;
+  base::AutoLock channel_auto_lock(channel->lock);
+  if (!channel->paused)
+    return;
+  channel->paused = false;
+  if (!channel->scheduled && !channel->queue.empty()) {
+    channel->scheduled = true;
+    worker_pool_->PostTask(base::Bind(&LiveIngestReactor::ServiceChannel,
+                                      base::Unretained(this),
+                                      channel));
+  }
+}
+
+bool LiveIngestReactor::GetChannelStats(int channel_id, ChannelStats* stats) {
+  DCHECK(stats);
+  base::AutoLock auto_lock(lock_);
+  Channel* channel = FindChannel(channel_id);
+  if (!channel)
+    return false;
+  base::AutoLock channel_auto_lock(channel->lock);
+  *stats = channel->stats;
+  return true;
+}
+
+LiveIngestReactor::Channel* LiveIngestReactor::FindChannel(int channel_id) {
+  lock_.AssertAcquired();
+  std::map<int, Channel*>::iterator it = channels_.find(channel_id);
+  return it == channels_.end() ? NULL : it->second;
+}
+
+LiveIngestReactor::Channel* LiveIngestReactor::DetachChannel(int channel_id) {
+  Channel* channel = NULL;
+  {
+    base::AutoLock auto_lock(lock_);
+    channel = FindChannel(channel_id);
+    if (!channel) {
+      LOG(WARNING) << "Unknown live ingest channel " << channel_id;
+      return NULL;
+    }
+    channels_.erase(channel_id);
+  }
+
+  channel->receive_loop->RemoveChannel(channel);
+  base::AutoLock auto_lock(channel->lock);
+  channel->removed = true;
+  return channel;
+}
+
+void LiveIngestReactor::DeleteChannel(Channel* channel) {
+  {
+    base::AutoLock auto_lock(channel->lock);
+    DCHECK(channel->removed);
+    while (channel->scheduled)
+      channel->idle_cv.Wait();
+  }
+  close(channel->socket);
+  delete channel;
+}
+
+void LiveIngestReactor::FinishCloseChannel(Channel* channel,
+                                           const base::Closure& closed_cb) {
+  DeleteChannel(channel);
+  closed_cb.Run();
+}
+
+void LiveIngestReactor::OnDatagramReceived(Channel* channel,
+                                           const uint8_t* data,
+                                           size_t size,
+                                           uint32_t total_datagrams_dropped) {
+  base::AutoLock auto_lock(channel->lock);
+  ChannelStats& stats = channel->stats;
+  ++stats.datagrams_received;
+  stats.bytes_received += size;
+  stats.datagrams_dropped =
+      std::max<uint64_t>(stats.datagrams_dropped, total_datagrams_dropped);
+
+  if (channel->queue.size() + size > kMaxQueuedBytesPerChannel) {
+    if (stats.overruns++ == 0) {
+      LOG(WARNING) << "Live ingest channel " << channel->id
+                   << " does not keep up, discarding datagrams.";
+    }
+    return;
+  }
+  channel->queue.insert(channel->queue.end(), data, data + size);
+
+  if (!channel->scheduled && !channel->paused && !channel->removed) {
+    channel->scheduled = true;
+    worker_pool_->PostTask(base::Bind(&LiveIngestReactor::ServiceChannel,
+                                      base::Unretained(this),
+                                      channel));
+  }
+}
+
+void LiveIngestReactor::ServiceChannel(Channel* channel) {
+  {
+    base::AutoLock auto_lock(channel->lock);
+    DCHECK(channel->scheduled);
+    if (channel->paused || channel->removed || channel->queue.empty()) {
+      channel->scheduled = false;
+      channel->idle_cv.Broadcast();
+      return;
+    }
+    // The buffers are swapped so that their memory is reused.
+    channel->service_buffer.clear();
+    channel->service_buffer.swap(channel->queue);
+  }
+
+  channel->data_cb.Run(&channel->service_buffer[0],
+                       channel->service_buffer.size());
+
+  base::AutoLock auto_lock(channel->lock);
+  if (channel->paused || channel->removed || channel->queue.empty()) {
+    channel->scheduled = false;
+    channel->idle_cv.Broadcast();
+    return;
+  }
+  // More data was received in the meantime. It is handled in a new task
+  // rather than in a loop, so that the other channels get their turn on the
+  // worker threads.
+  worker_pool_->PostTask(base::Bind(&LiveIngestReactor::ServiceChannel,
+                                    base::Unretained(this),
+                                    channel));
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,152 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_LIVE_INGEST_REACTOR_H_
+#define MEDIA_BASE_LIVE_INGEST_REACTOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "packager/base/callback.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/base/status.h"
+
+namespace edash_packager {
+namespace media {
+
+class WorkerPool;
+
+/// Receives many UDP live channels with a fixed number of threads, instead
+/// of a thread per channel: a few receive threads wait for the sockets of all
+/// the channels with epoll and drain them in batches, and the received data
+/// of each channel is handed to its callback on a shared worker pool.
+///
+/// The callbacks of a channel are never run concurrently, and get the data
+/// in the order it was received, but may run on different worker threads.
+/// Data received while the callback of a channel runs, or while the channel
+/// is paused, is queued, up to a limit beyond which datagrams are discarded.
+///
+/// Typically, the callback of each channel feeds its own
+/// mp2t::Mp2tMediaParser, so that the parsing of all the channels is spread
+/// over the worker threads. See Demuxer::SetLiveIngestReactor().
+///
+/// Only supported on Linux.
+///
+/// Thread Safety: All the methods may be called from any thread, including
+/// from the channel callbacks, except the destructor and RemoveChannel().
+/// CloseChannel() may also be called from the callback of the channel being
+/// closed.
+class LiveIngestReactor {
+ public:
+  /// Called on a worker thread with data received on a channel.
+  typedef base::Callback<void(const uint8_t* data, size_t size)> DataCB;
+
+  /// Receive statistics of a channel.
+  struct ChannelStats {
+    ChannelStats();
+
+    /// Number of datagrams received from the socket.
+    uint64_t datagrams_received;
+    /// Number of payload bytes received from the socket.
+    uint64_t bytes_received;
+    /// Number of datagrams dropped by the kernel because the socket receive
+    /// buffer was full.
+    uint64_t datagrams_dropped;
+    /// Number of datagrams discarded because the data queued for the channel
+    /// reached its limit, i.e. the callback did not keep up.
+    uint64_t overruns;
+  };
+
+  /// Create the reactor and start its threads.
+  /// @param num_receive_threads is the number of threads receiving from the
+  ///        sockets. Channels are assigned to them in turn. Should not be 0.
+  /// @param num_worker_threads is the number of threads running the channel
+  ///        callbacks. Should not be 0.
+  LiveIngestReactor(size_t num_receive_threads, size_t num_worker_threads);
+
+  /// Remove the remaining channels and stop the threads.
+  ~LiveIngestReactor();
+
+  /// Open a channel and start receiving on it.
+  /// @param address_and_port is the address of the UDP stream, of the form
+  ///        "<ip_address>:<port>". Multicast groups are joined as UdpFile
+  ///        does.
+  /// @param data_cb is the callback run with the received data.
+  /// @param[out] channel_id is set to the identifier of the new channel.
+  /// @return OK on success, an error status otherwise.
+  Status AddChannel(const std::string& address_and_port,
+                    const DataCB& data_cb,
+                    int* channel_id);
+
+  /// Close a channel. Blocks until its callback, if running, returns; the
+  /// callback is not run any more once this method returns. Should not be
+  /// called from the callback of the channel.
+  void RemoveChannel(int channel_id);
+
+  /// Close a channel without waiting for its callback to return. The callback
+  /// is not run any more once this method returns, except for a call already
+  /// running.
+  /// @param closed_cb is run on a worker thread once that call, if any, has
+  ///        returned, so that the caller can release what the callback uses.
+  ///        It is run before the reactor is destroyed.
+  void CloseChannel(int channel_id, const base::Closure& closed_cb);
+
+  /// Stop running the callback of a channel, after the current call if it
+  /// is running. The data received in the meantime is queued.
+  void PauseChannel(int channel_id);
+
+  /// Run the callback of a paused channel again, starting with the queued
+  /// data.
+  void ResumeChannel(int channel_id);
+
+  /// Get the receive statistics of a channel.
+  /// @return false if there is no such channel.
+  bool GetChannelStats(int channel_id, ChannelStats* stats);
+
+ private:
+  struct Channel;
+  class ReceiveLoop;
+
+  // Finds a channel. Returns NULL if there is no such channel.
+  Channel* FindChannel(int channel_id);
+  // Stops receiving on a channel and scheduling its callback, and forgets it.
+  // Returns NULL if there is no such channel.
+  Channel* DetachChannel(int channel_id);
+  // Waits for the running callback of a detached |channel|, if any, and
+  // deletes it.
+  void DeleteChannel(Channel* channel);
+  // Deletes a channel closed by CloseChannel(). Called on the worker threads.
+  void FinishCloseChannel(Channel* channel, const base::Closure& closed_cb);
+  // Appends a datagram received on |channel|, and schedules its callback if
+  // needed. Called on the receive threads.
+  void OnDatagramReceived(Channel* channel,
+                          const uint8_t* data,
+                          size_t size,
+                          uint32_t total_datagrams_dropped);
+  // Runs the callback of |channel| with the data queued so far. Called on the
+  // worker threads.
+  void ServiceChannel(Channel* channel);
+
+  std::vector<ReceiveLoop*> receive_loops_;
+  scoped_ptr<WorkerPool> worker_pool_;
+
+  base::Lock lock_;
+  // Protected by |lock_|.
+  std::map<int, Channel*> channels_;
+  int next_channel_id_;
+  size_t next_receive_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(LiveIngestReactor);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_BASE_LIVE_INGEST_REACTOR_H_
@@ -0,0 +1,295 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/live_ingest_reactor.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+const size_t kDatagramSize = 7 * 188;
+const size_t kNumChannels = 4;
+const int kReceiveTimeoutInSeconds = 10;
+
+// Collects the data received on a channel.
+class DataCollector {
+ public:
+  DataCollector() {}
+
+  void OnData(const uint8_t* data, size_t size) {
+    base::AutoLock auto_lock(lock_);
+    data_.append(reinterpret_cast<const char*>(data), size);
+  }
+
+  size_t size() {
+    base::AutoLock auto_lock(lock_);
+    return data_.size();
+  }
+
+  std::string data() {
+    base::AutoLock auto_lock(lock_);
+    return data_;
+  }
+
+ private:
+  base::Lock lock_;
+  std::string data_;
+
+  DISALLOW_COPY_AND_ASSIGN(DataCollector);
+};
+
+// Closes its channel from the channel callback.
+class ChannelCloser {
+ public:
+  explicit ChannelCloser(LiveIngestReactor* reactor)
+      : reactor_(reactor),
+        channel_id_(-1),
+        num_calls_(0),
+        closed_(true, false) {}
+
+  void set_channel_id(int channel_id) {
+    base::AutoLock auto_lock(lock_);
+    channel_id_ = channel_id;
+  }
+
+  void OnData(const uint8_t* data, size_t size) {
+    base::AutoLock auto_lock(lock_);
+    ++num_calls_;
+    reactor_->CloseChannel(channel_id_,
+                           base::Bind(&base::WaitableEvent::Signal,
+                                      base::Unretained(&closed_)));
+  }
+
+  bool WaitForClosed() {
+    return closed_.TimedWait(
+        base::TimeDelta::FromSeconds(kReceiveTimeoutInSeconds));
+  }
+
+  int num_calls() {
+    base::AutoLock auto_lock(lock_);
+    return num_calls_;
+  }
+
+ private:
+  LiveIngestReactor* reactor_;
+  base::Lock lock_;
+  int channel_id_;
+  int num_calls_;
+  base::WaitableEvent closed_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChannelCloser);
+};
+
+}  // namespace
+
+class LiveIngestReactorTest : public testing::Test {
+ public:
+  LiveIngestReactorTest() : send_socket_(-1) {}
+
+ protected:
+  virtual void SetUp() OVERRIDE {
+    send_socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, send_socket_);
+    reactor_.reset(new LiveIngestReactor(2, 2));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    reactor_.reset();
+    if (send_socket_ != -1)
+      close(send_socket_);
+  }
+
+  // Finds a free loopback port by binding to port 0.
+  void GetFreeAddress(struct sockaddr_in* address) {
+    bzero(address, sizeof(*address));
+    address->sin_family = AF_INET;
+    address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int probe_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, probe_socket);
+    socklen_t address_length = sizeof(*address);
+    ASSERT_EQ(0, bind(probe_socket,
+                      reinterpret_cast<struct sockaddr*>(address),
+                      sizeof(*address)));
+    ASSERT_EQ(0, getsockname(probe_socket,
+                             reinterpret_cast<struct sockaddr*>(address),
+                             &address_length));
+    close(probe_socket);
+  }
+
+  void AddChannel(DataCollector* collector,
+                  struct sockaddr_in* address,
+                  int* channel_id) {
+    GetFreeAddress(address);
+    const std::string address_and_port =
+        "127.0.0.1:" + base::UintToString(ntohs(address->sin_port));
+    ASSERT_OK(reactor_->AddChannel(
+        address_and_port,
+        base::Bind(&DataCollector::OnData, base::Unretained(collector)),
+        channel_id));
+  }
+
+  // Sends |num_datagrams| datagrams, the bytes of each datagram following
+  // the bytes of the previous one, starting with |seed|.
+  void SendDatagrams(const struct sockaddr_in& address,
+                     size_t num_datagrams,
+                     uint8_t seed) {
+    std::string datagram(kDatagramSize, 0);
+    for (size_t i = 0; i < num_datagrams; ++i) {
+      for (size_t j = 0; j < kDatagramSize; ++j)
+        datagram[j] = (seed + i * kDatagramSize + j) % 251;
+      ASSERT_EQ(static_cast<ssize_t>(kDatagramSize),
+                sendto(send_socket_, datagram.data(), datagram.size(), 0,
+                       reinterpret_cast<const struct sockaddr*>(&address),
+                       sizeof(address)));
+    }
+  }
+
+  // Waits until |collector| has received |size| bytes.
+  bool WaitForData(DataCollector* collector, size_t size) {
+    const base::TimeTicks deadline =
+        base::TimeTicks::Now() +
+        base::TimeDelta::FromSeconds(kReceiveTimeoutInSeconds);
+    while (base::TimeTicks::Now() < deadline) {
+      if (collector->size() >= size)
+        return true;
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+    }
+    return false;
+  }
+
+  // Waits until |num_datagrams| datagrams have been received on a channel.
+  bool WaitForDatagrams(int channel_id, uint64_t num_datagrams) {
+    const base::TimeTicks deadline =
+        base::TimeTicks::Now() +
+        base::TimeDelta::FromSeconds(kReceiveTimeoutInSeconds);
+    while (base::TimeTicks::Now() < deadline) {
+      LiveIngestReactor::ChannelStats stats;
+      if (!reactor_->GetChannelStats(channel_id, &stats))
+        return false;
+      if (stats.datagrams_received >= num_datagrams)
+        return true;
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+    }
+    return false;
+  }
+
+  void CheckData(const std::string& data, uint8_t seed) {
+    for (size_t i = 0; i < data.size(); ++i)
+      ASSERT_EQ(static_cast<char>((seed + i) % 251), data[i]) << "at " << i;
+  }
+
+  int send_socket_;
+  scoped_ptr<LiveIngestReactor> reactor_;
+};
+
+TEST_F(LiveIngestReactorTest, MultipleChannels) {
+  DataCollector collectors[kNumChannels];
+  struct sockaddr_in addresses[kNumChannels];
+  int channel_ids[kNumChannels];
+  for (size_t i = 0; i < kNumChannels; ++i)
+    AddChannel(&collectors[i], &addresses[i], &channel_ids[i]);
+
+  const size_t kNumDatagrams = 50;
+  for (size_t i = 0; i < kNumChannels; ++i)
+    SendDatagrams(addresses[i], kNumDatagrams, i);
+
+  for (size_t i = 0; i < kNumChannels; ++i) {
+    ASSERT_TRUE(WaitForData(&collectors[i], kNumDatagrams * kDatagramSize));
+    const std::string data = collectors[i].data();
+    ASSERT_EQ(kNumDatagrams * kDatagramSize, data.size());
+    CheckData(data, i);
+
+    LiveIngestReactor::ChannelStats stats;
+    ASSERT_TRUE(reactor_->GetChannelStats(channel_ids[i], &stats));
+    EXPECT_EQ(kNumDatagrams, stats.datagrams_received);
+    EXPECT_EQ(kNumDatagrams * kDatagramSize, stats.bytes_received);
+    EXPECT_EQ(0u, stats.overruns);
+  }
+}
+
+TEST_F(LiveIngestReactorTest, PauseAndResume) {
+  DataCollector collector;
+  struct sockaddr_in address;
+  int channel_id;
+  AddChannel(&collector, &address, &channel_id);
+
+  reactor_->PauseChannel(channel_id);
+  const size_t kNumDatagrams = 20;
+  SendDatagrams(address, kNumDatagrams, 0);
+  ASSERT_TRUE(WaitForDatagrams(channel_id, kNumDatagrams));
+  // The data is queued while the channel is paused.
+  EXPECT_EQ(0u, collector.size());
+
+  reactor_->ResumeChannel(channel_id);
+  ASSERT_TRUE(WaitForData(&collector, kNumDatagrams * kDatagramSize));
+  CheckData(collector.data(), 0);
+}
+
+TEST_F(LiveIngestReactorTest, RemoveChannel) {
+  DataCollector collector;
+  struct sockaddr_in address;
+  int channel_id;
+  AddChannel(&collector, &address, &channel_id);
+
+  SendDatagrams(address, 10, 0);
+  ASSERT_TRUE(WaitForData(&collector, 10 * kDatagramSize));
+
+  reactor_->RemoveChannel(channel_id);
+  LiveIngestReactor::ChannelStats stats;
+  EXPECT_FALSE(reactor_->GetChannelStats(channel_id, &stats));
+}
+
+TEST_F(LiveIngestReactorTest, CloseChannelFromCallback) {
+  ChannelCloser closer(reactor_.get());
+  struct sockaddr_in address;
+  GetFreeAddress(&address);
+  int channel_id;
+  ASSERT_OK(reactor_->AddChannel(
+      "127.0.0.1:" + base::UintToString(ntohs(address.sin_port)),
+      base::Bind(&ChannelCloser::OnData, base::Unretained(&closer)),
+      &channel_id));
+  closer.set_channel_id(channel_id);
+
+  SendDatagrams(address, 10, 0);
+  ASSERT_TRUE(closer.WaitForClosed());
+  // The callback is not run any more once the channel is closed.
+  SendDatagrams(address, 10, 0);
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(100));
+  EXPECT_EQ(1, closer.num_calls());
+
+  LiveIngestReactor::ChannelStats stats;
+  EXPECT_FALSE(reactor_->GetChannelStats(channel_id, &stats));
+}
+
+TEST_F(LiveIngestReactorTest, InvalidAddress) {
+  DataCollector collector;
+  int channel_id;
+  EXPECT_FALSE(
+      reactor_->AddChannel(
+                   "127.0.0:1234",
+                   base::Bind(&DataCollector::OnData,
+                              base::Unretained(&collector)),
+                   &channel_id).ok());
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -38,11 +38,15 @@
         'decryptor_source.h',
         'http_key_fetcher.cc',
         'http_key_fetcher.h',
+        'job_scheduler.cc',
+        'job_scheduler.h',
         'key_fetcher.cc',
         'key_fetcher.h',
         'key_source.cc',
         'key_source.h',
         'limits.h',
+        'live_ingest_reactor.cc',
+        'live_ingest_reactor.h',
         'media_parser.h',
         'media_sample.cc',
         'media_sample.h',
@@ -58,7 +62,11 @@
         'network_util.h',
         'offset_byte_queue.cc',
         'offset_byte_queue.h',
+        'pipeline_stats.cc',
+        'pipeline_stats.h',
         'producer_consumer_queue.h',
+        'read_ahead_reader.cc',
+        'read_ahead_reader.h',
         'request_signer.cc',
         'request_signer.h',
         'rsa_key.cc',
@@ -73,6 +81,8 @@
         'video_stream_info.h',
         'widevine_key_source.cc',
         'widevine_key_source.h',
+        'worker_pool.cc',
+        'worker_pool.h',
       ],
       'dependencies': [
         '../../base/base.gyp:base',
@@ -91,9 +101,15 @@
         'closure_thread_unittest.cc',
         'container_names_unittest.cc',
         'http_key_fetcher_unittest.cc',
+        'job_scheduler_unittest.cc',
+        'live_ingest_reactor_unittest.cc',
+        'media_sample_unittest.cc',
+        'muxer_unittest.cc',
         'muxer_util_unittest.cc',
         'offset_byte_queue_unittest.cc',
+        'pipeline_stats_unittest.cc',
         'producer_consumer_queue_unittest.cc',
+        'read_ahead_reader_unittest.cc',
         'rsa_key_unittest.cc',
         'status_test_util_unittest.cc',
         'status_unittest.cc',
@@ -103,6 +119,7 @@
         'test/rsa_test_data.h',   # For rsa_key_unittest
         'test/status_test_util.h',
         'widevine_key_source_unittest.cc',
+        'worker_pool_unittest.cc',
       ],
       'dependencies': [
         '../../testing/gtest.gyp:gtest',
@@ -20,11 +20,12 @@ namespace media {
 
 class KeySource;
 class MediaSample;
+class StageStats;
 class StreamInfo;
 
 class MediaParser {
  public:
-  MediaParser() {}
+  MediaParser() : decryption_stats_(NULL) {}
   virtual ~MediaParser() {}
 
   /// Called upon completion of parser initialization.
@@ -61,7 +62,20 @@ class MediaParser {
   /// @return true if successful.
   virtual bool Parse(const uint8_t* buf, int size) = 0;
 
+  /// Record the decryption of the samples, if the parser decrypts them.
+  /// @param decryption_stats is the StageStats of the decryption. The caller
+  ///        retains ownership. It should outlive the parser.
+  void set_decryption_stats(StageStats* decryption_stats) {
+    decryption_stats_ = decryption_stats;
+  }
+
+ protected:
+  /// @return The StageStats of the decryption, NULL if not recorded.
+  StageStats* decryption_stats() { return decryption_stats_; }
+
  private:
+  StageStats* decryption_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaParser);
 };
 
@@ -19,7 +19,12 @@ MediaSample::MediaSample(const uint8_t* data,
                          const uint8_t* side_data,
                          size_t side_data_size,
                          bool is_key_frame)
-    : dts_(0), pts_(0), duration_(0), is_key_frame_(is_key_frame) {
+    : dts_(0),
+      pts_(0),
+      duration_(0),
+      is_key_frame_(is_key_frame),
+      shared_data_offset_(0),
+      shared_data_size_(0) {
   if (!data) {
     CHECK_EQ(size, 0u);
     CHECK(!side_data);
@@ -33,7 +38,9 @@ MediaSample::MediaSample(const uint8_t* data,
 
 MediaSample::MediaSample() : dts_(0), pts_(0),
                              duration_(0),
-                             is_key_frame_(false) {}
+                             is_key_frame_(false),
+                             shared_data_offset_(0),
+                             shared_data_size_(0) {}
 
 MediaSample::~MediaSample() {}
 
@@ -59,6 +66,32 @@ scoped_refptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
       data, data_size, side_data, side_data_size, is_key_frame));
 }
 
+// static
+scoped_refptr<MediaSample> MediaSample::FromSharedBuffer(
+    const scoped_refptr<base::RefCountedBytes>& buffer,
+    size_t offset,
+    size_t size,
+    bool is_key_frame) {
+  CHECK(buffer);
+  CHECK_LE(offset + size, buffer->size());
+  MediaSample* media_sample = new MediaSample();
+  media_sample->is_key_frame_ = is_key_frame;
+  media_sample->shared_data_ = buffer;
+  media_sample->shared_data_offset_ = offset;
+  media_sample->shared_data_size_ = size;
+  return make_scoped_refptr(media_sample);
+}
+
+// static
+scoped_refptr<MediaSample> MediaSample::CreateWithSize(size_t size,
+                                                       bool is_key_frame) {
+  CHECK_GT(size, 0u);
+  MediaSample* media_sample = new MediaSample();
+  media_sample->is_key_frame_ = is_key_frame;
+  media_sample->data_.resize(size);
+  return make_scoped_refptr(media_sample);
+}
+
 // static
 scoped_refptr<MediaSample> MediaSample::CreateEmptyMediaSample() {
   MediaSample* media_sample = new MediaSample();
@@ -70,6 +103,19 @@ scoped_refptr<MediaSample> MediaSample::CreateEOSBuffer() {
   return make_scoped_refptr(new MediaSample(NULL, 0, NULL, 0, false));
 }
 
+uint8_t* MediaSample::writable_data() {
+  DCHECK(!end_of_stream());
+  if (shared_data_) {
+    // The buffer can be modified in place if nothing else references it.
+    if (shared_data_->HasOneRef())
+      return &shared_data_->data()[shared_data_offset_];
+    const uint8_t* shared_data = shared_data_->front() + shared_data_offset_;
+    data_.assign(shared_data, shared_data + shared_data_size_);
+    shared_data_ = NULL;
+  }
+  return &data_[0];
+}
+
 std::string MediaSample::ToString() const {
   if (end_of_stream())
     return "End of stream sample\n";
@@ -80,7 +126,7 @@ std::string MediaSample::ToString() const {
       pts_,
       duration_,
       is_key_frame_ ? "true" : "false",
-      data_.size(),
+      data_size(),
       side_data_.size());
 }
 
@@ -13,6 +13,7 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/memory/ref_counted.h"
+#include "packager/base/memory/ref_counted_memory.h"
 #include "packager/base/memory/scoped_ptr.h"
 
 namespace edash_packager {
@@ -46,6 +47,29 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
                                              size_t side_data_size,
                                              bool is_key_frame);
 
+  /// Create a MediaSample object referencing a slice of a shared buffer. The
+  /// data is not copied: the sample keeps a reference to @a buffer, which
+  /// must not be modified afterwards. The slice is copied on the first call
+  /// to writable_data(), unless the sample holds the only reference.
+  /// @param buffer contains the sample data. Must not be NULL.
+  /// @param offset is the offset of the sample data in @a buffer.
+  /// @param size indicates sample size in bytes. The slice should not go past
+  ///        the end of @a buffer.
+  /// @param is_key_frame indicates whether the sample is a key frame.
+  static scoped_refptr<MediaSample> FromSharedBuffer(
+      const scoped_refptr<base::RefCountedBytes>& buffer,
+      size_t offset,
+      size_t size,
+      bool is_key_frame);
+
+  /// Create a MediaSample object with a buffer of @a size bytes, to be
+  /// filled through writable_data(). Lets producers write the sample data in
+  /// place instead of copying it from a temporary buffer.
+  /// @param size indicates sample size in bytes. Must not be 0.
+  /// @param is_key_frame indicates whether the sample is a key frame.
+  static scoped_refptr<MediaSample> CreateWithSize(size_t size,
+                                                   bool is_key_frame);
+
   /// Create a MediaSample object with default members.
   static scoped_refptr<MediaSample> CreateEmptyMediaSample();
 
@@ -85,17 +109,17 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
 
   const uint8_t* data() const {
     DCHECK(!end_of_stream());
-    return &data_[0];
+    return shared_data_ ? shared_data_->front() + shared_data_offset_
+                        : &data_[0];
   }
 
-  uint8_t* writable_data() {
-    DCHECK(!end_of_stream());
-    return &data_[0];
-  }
+  /// @return a pointer to the sample data that can be modified. A sample
+  ///         referencing a shared buffer gets its own copy of the data first.
+  uint8_t* writable_data();
 
   size_t data_size() const {
     DCHECK(!end_of_stream());
-    return data_.size();
+    return shared_data_ ? shared_data_size_ : data_.size();
   }
 
   const uint8_t* side_data() const {
@@ -110,6 +134,7 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
 
   void set_data(const uint8_t* data, const size_t data_size) {
     data_.assign(data, data + data_size);
+    shared_data_ = NULL;
   }
 
   void set_is_key_frame(bool value) {
@@ -117,7 +142,9 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
   }
 
   // If there's no data in this buffer, it represents end of stream.
-  bool end_of_stream() const { return data_.size() == 0; }
+  bool end_of_stream() const {
+    return shared_data_ ? shared_data_size_ == 0 : data_.size() == 0;
+  }
 
   /// @return a human-readable string describing |*this|.
   std::string ToString() const;
@@ -143,8 +170,13 @@ class MediaSample : public base::RefCountedThreadSafe<MediaSample> {
   int64_t duration_;
   bool is_key_frame_;
 
-  // Main buffer data.
+  // Main buffer data. Not used if |shared_data_| is set.
   std::vector<uint8_t> data_;
+  // Shared buffer containing the main data at |shared_data_offset_|. Set if
+  // the sample was created with FromSharedBuffer and not yet modified.
+  scoped_refptr<base::RefCountedBytes> shared_data_;
+  size_t shared_data_offset_;
+  size_t shared_data_size_;
   // Contain additional buffers to complete the main one. Needed by WebM
   // http://www.matroska.org/technical/specs/index.html BlockAdditional[A5].
   // Not used by mp4 and other containers.
@@ -0,0 +1,80 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "packager/media/base/media_sample.h"
+
+namespace {
+
+const uint8_t kBufferData[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+const size_t kSliceOffset = 2;
+const size_t kSliceSize = 4;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class MediaSampleTest : public ::testing::Test {
+ public:
+  MediaSampleTest()
+      : buffer_(new base::RefCountedBytes(std::vector<uint8_t>(
+            kBufferData, kBufferData + arraysize(kBufferData)))) {}
+
+ protected:
+  scoped_refptr<base::RefCountedBytes> buffer_;
+};
+
+TEST_F(MediaSampleTest, FromSharedBufferDoesNotCopy) {
+  scoped_refptr<MediaSample> sample = MediaSample::FromSharedBuffer(
+      buffer_, kSliceOffset, kSliceSize, true);
+  EXPECT_FALSE(sample->end_of_stream());
+  EXPECT_TRUE(sample->is_key_frame());
+  EXPECT_EQ(buffer_->front() + kSliceOffset, sample->data());
+  EXPECT_EQ(kSliceSize, sample->data_size());
+}
+
+TEST_F(MediaSampleTest, WritableDataCopiesSharedBuffer) {
+  scoped_refptr<MediaSample> sample = MediaSample::FromSharedBuffer(
+      buffer_, kSliceOffset, kSliceSize, true);
+  uint8_t* data = sample->writable_data();
+  ASSERT_NE(buffer_->front() + kSliceOffset, data);
+  data[0] = 0xFF;
+
+  // The shared buffer is not modified.
+  EXPECT_EQ(kBufferData[kSliceOffset], buffer_->front()[kSliceOffset]);
+  EXPECT_EQ(0xFF, sample->data()[0]);
+  EXPECT_EQ(std::vector<uint8_t>(kBufferData + kSliceOffset + 1,
+                                 kBufferData + kSliceOffset + kSliceSize),
+            std::vector<uint8_t>(sample->data() + 1,
+                                 sample->data() + kSliceSize));
+}
+
+TEST_F(MediaSampleTest, WritableDataOfUnsharedBuffer) {
+  scoped_refptr<MediaSample> sample = MediaSample::FromSharedBuffer(
+      buffer_, kSliceOffset, kSliceSize, true);
+  const uint8_t* shared_data = buffer_->front() + kSliceOffset;
+  // Drop the only other reference.
+  buffer_ = NULL;
+  EXPECT_EQ(shared_data, sample->writable_data());
+}
+
+TEST_F(MediaSampleTest, CreateWithSize) {
+  scoped_refptr<MediaSample> sample =
+      MediaSample::CreateWithSize(kSliceSize, false);
+  EXPECT_FALSE(sample->end_of_stream());
+  EXPECT_FALSE(sample->is_key_frame());
+  ASSERT_EQ(kSliceSize, sample->data_size());
+  memcpy(sample->writable_data(), kBufferData, kSliceSize);
+  EXPECT_EQ(sample->writable_data(), sample->data());
+  EXPECT_EQ(std::vector<uint8_t>(kBufferData, kBufferData + kSliceSize),
+            std::vector<uint8_t>(sample->data(), sample->data() + kSliceSize));
+}
+
+}  // namespace media
+}  // namespace edash_packager
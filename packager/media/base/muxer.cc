@@ -6,6 +6,9 @@
 
 #include "packager/media/base/muxer.h"
 
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/closure_thread.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/media_stream.h"
 
@@ -20,9 +23,14 @@ Muxer::Muxer(const MuxerOptions& options)
       clear_lead_in_seconds_(0),
       crypto_period_duration_in_seconds_(0),
       muxer_listener_(NULL),
-      clock_(NULL) {}
+      clock_(NULL),
+      pipeline_stats_(NULL) {}
 
-Muxer::~Muxer() {}
+Muxer::~Muxer() {
+  // The muxer thread calls into the derived class, so it has to be stopped
+  // before destruction.
+  DCHECK(!pipeline_thread_);
+}
 
 void Muxer::SetKeySource(KeySource* encryption_key_source,
                          uint32_t max_sd_pixels,
@@ -35,6 +43,12 @@ void Muxer::SetKeySource(KeySource* encryption_key_source,
   crypto_period_duration_in_seconds_ = crypto_period_duration_in_seconds;
 }
 
+void Muxer::SetPipelineStats(PipelineStats* pipeline_stats) {
+  DCHECK(pipeline_stats);
+  DCHECK(!initialized_);
+  pipeline_stats_ = pipeline_stats;
+}
+
 void Muxer::AddStream(MediaStream* stream) {
   DCHECK(stream);
   stream->Connect(this);
@@ -72,12 +86,67 @@ Status Muxer::Run() {
   return status.error_code() == error::END_OF_STREAM ? Finalize() : status;
 }
 
+void Muxer::StartPipeline(size_t max_queued_samples) {
+  DCHECK_GT(max_queued_samples, 0u);
+  DCHECK(!pipeline_thread_);
+  {
+    base::AutoLock scoped_lock(sample_queue_lock_);
+    sample_queue_.reset(
+        new ProducerConsumerQueue<QueuedSample>(max_queued_samples));
+    if (cancelled_.IsSet())
+      sample_queue_->Stop();
+  }
+  pipeline_thread_.reset(new ClosureThread(
+      "MuxerThread", base::Bind(&Muxer::PipelineLoop, base::Unretained(this))));
+  pipeline_thread_->Start();
+}
+
+Status Muxer::StopPipeline() {
+  if (!pipeline_thread_)
+    return Status::OK;
+  // Pending samples are still consumed before the muxer thread exits.
+  sample_queue_->Stop();
+  pipeline_thread_->Join();
+  pipeline_thread_.reset();
+  {
+    base::AutoLock scoped_lock(sample_queue_lock_);
+    sample_queue_.reset();
+  }
+  if (cancelled_.IsSet() && pipeline_status_.ok())
+    return Status(error::CANCELLED, "Muxer pipeline cancelled.");
+  return pipeline_status_;
+}
+
+void Muxer::Cancel() {
+  base::AutoLock scoped_lock(sample_queue_lock_);
+  cancelled_.Set();
+  if (sample_queue_)
+    sample_queue_->Stop();
+}
+
 void Muxer::SetMuxerListener(media::event::MuxerListener* muxer_listener) {
   muxer_listener_ = muxer_listener;
 }
 
 Status Muxer::AddSample(const MediaStream* stream,
                         scoped_refptr<MediaSample> sample) {
+  if (!sample_queue_)
+    return MuxSample(stream, sample);
+
+  Status status =
+      sample_queue_->Push(QueuedSample(stream, sample), kInfiniteTimeout);
+  if (status.error_code() == error::STOPPED) {
+    if (cancelled_.IsSet())
+      return Status(error::CANCELLED, "Muxer pipeline cancelled.");
+    // Otherwise the queue is stopped by the muxer thread on failure.
+    if (!pipeline_status_.ok())
+      return pipeline_status_;
+  }
+  return status;
+}
+
+Status Muxer::MuxSample(const MediaStream* stream,
+                        scoped_refptr<MediaSample> sample) {
   DCHECK(std::find(streams_.begin(), streams_.end(), stream) != streams_.end());
 
   if (!initialized_) {
@@ -95,5 +164,22 @@ Status Muxer::AddSample(const MediaStream* stream,
   return DoAddSample(stream, sample);
 }
 
+void Muxer::PipelineLoop() {
+  QueuedSample queued_sample;
+  while (sample_queue_->Pop(&queued_sample, kInfiniteTimeout).ok()) {
+    // The queued samples are dropped on cancellation.
+    if (cancelled_.IsSet())
+      return;
+    Status status = MuxSample(queued_sample.first, queued_sample.second);
+    if (!status.ok()) {
+      LOG(ERROR) << "Muxer thread failed: " << status.ToString();
+      pipeline_status_ = status;
+      // Unblock the demuxer and reject further samples.
+      sample_queue_->Stop();
+      return;
+    }
+  }
+}
+
 }  // namespace media
 }  // namespace edash_packager
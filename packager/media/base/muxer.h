@@ -9,20 +9,26 @@
 #ifndef MEDIA_BASE_MUXER_H_
 #define MEDIA_BASE_MUXER_H_
 
+#include <utility>
 #include <vector>
 
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/cancellation_flag.h"
+#include "packager/base/synchronization/lock.h"
 #include "packager/base/time/clock.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/base/producer_consumer_queue.h"
 #include "packager/media/base/status.h"
 
 namespace edash_packager {
 namespace media {
 
+class ClosureThread;
 class KeySource;
 class MediaSample;
 class MediaStream;
+class PipelineStats;
 
 namespace event {
 class MuxerListener;
@@ -51,12 +57,39 @@ class Muxer {
                     double clear_lead_in_seconds,
                     double crypto_period_duration_in_seconds);
 
+  /// Record the fragmentation, segmentation, encryption and write stats of
+  /// the output, under the output file name. Should be called before any
+  /// sample is added.
+  /// @param pipeline_stats is the collector of the stats. The caller retains
+  ///        ownership. It should outlive the muxer.
+  void SetPipelineStats(PipelineStats* pipeline_stats);
+
   /// Add video/audio stream.
   void AddStream(MediaStream* stream);
 
   /// Drive the remuxing from muxer side (pull).
   Status Run();
 
+  /// Mux on a dedicated thread. Samples pushed to the muxer are put in a
+  /// bounded queue and consumed by the muxer thread, so demuxing and muxing
+  /// of several outputs can proceed in parallel. Pushing blocks while the
+  /// queue is full, which limits the number of samples held in memory.
+  /// Should be called before any sample is pushed to the muxer. Only applies
+  /// to push mode, i.e. when the remuxing is driven by Demuxer::Run.
+  /// @param max_queued_samples is the capacity of the queue. Should not be 0.
+  void StartPipeline(size_t max_queued_samples);
+
+  /// Wait for the muxer thread to consume the queued samples and exit. Should
+  /// be called once the demuxer stops pushing samples. No-op if StartPipeline
+  /// was not called.
+  /// @return the status of the muxer thread.
+  Status StopPipeline();
+
+  /// Stop the muxer thread without consuming the queued samples, and make
+  /// the pending and following pushes return CANCELLED. Unblocks a demuxer
+  /// waiting for room in the queue. Can be called from any thread.
+  void Cancel();
+
   /// Set a MuxerListener event handler for this object.
   /// @param muxer_listener should not be NULL.
   void SetMuxerListener(event::MuxerListener* muxer_listener);
@@ -85,14 +118,26 @@ class Muxer {
   }
   event::MuxerListener* muxer_listener() { return muxer_listener_; }
   base::Clock* clock() { return clock_; }
+  /// @return The collector of the stats, NULL if not recorded.
+  PipelineStats* pipeline_stats() { return pipeline_stats_; }
 
  private:
   friend class MediaStream;  // Needed to access AddSample.
 
-  // Add new media sample.
+  typedef std::pair<const MediaStream*, scoped_refptr<MediaSample> >
+      QueuedSample;
+
+  // Add new media sample. Queues the sample if the pipeline is running.
   Status AddSample(const MediaStream* stream,
                    scoped_refptr<MediaSample> sample);
 
+  // Mux the sample in the calling thread.
+  Status MuxSample(const MediaStream* stream,
+                   scoped_refptr<MediaSample> sample);
+
+  // Muxer thread body. Consumes samples from |sample_queue_|.
+  void PipelineLoop();
+
   // Initialize the muxer.
   virtual Status Initialize() = 0;
 
@@ -114,6 +159,18 @@ class Muxer {
   event::MuxerListener* muxer_listener_;
   // An external injected clock, can be NULL.
   base::Clock* clock_;
+  // Can be NULL.
+  PipelineStats* pipeline_stats_;
+
+  // Used only if the pipeline is started. The assignments of |sample_queue_|
+  // are protected by |sample_queue_lock_| as Cancel() uses it.
+  scoped_ptr<ProducerConsumerQueue<QueuedSample> > sample_queue_;
+  base::Lock sample_queue_lock_;
+  base::CancellationFlag cancelled_;
+  scoped_ptr<ClosureThread> pipeline_thread_;
+  // Written by the muxer thread before |sample_queue_| is stopped; read by
+  // other threads only after observing the stop.
+  Status pipeline_status_;
 
   DISALLOW_COPY_AND_ASSIGN(Muxer);
 };
@@ -16,7 +16,8 @@ MuxerOptions::MuxerOptions()
       segment_sap_aligned(false),
       fragment_sap_aligned(false),
       num_subsegments_per_sidx(0),
-      bandwidth(0) {}
+      bandwidth(0),
+      encryption_worker_pool(NULL) {}
 MuxerOptions::~MuxerOptions() {}
 
 }  // namespace media
@@ -14,6 +14,8 @@
 namespace edash_packager {
 namespace media {
 
+class WorkerPool;
+
 /// This structure contains the list of configuration options for Muxer.
 struct MuxerOptions {
   MuxerOptions();
@@ -66,6 +68,13 @@ struct MuxerOptions {
   /// User-specified bit rate for the media stream. If zero, the muxer will
   /// attempt to estimate.
   uint32_t bandwidth;
+
+  /// Threads encrypting the samples of a fragment in parallel. The pool is
+  /// meant to be shared by all the muxers, so that the number of encryption
+  /// threads does not grow with the number of outputs. Not owned; it should
+  /// outlive the muxer. If NULL, samples are encrypted one by one as they are
+  /// added.
+  WorkerPool* encryption_worker_pool;
 };
 
 }  // namespace media
@@ -0,0 +1,157 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/demuxer.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/media_stream.h"
+#include "packager/media/base/muxer.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/base/test/status_test_util.h"
+
+namespace {
+
+const size_t kMaxQueuedSamples = 2;
+const int kNumSamples = 100;
+const int kFailingSampleIndex = 5;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+// Muxer counting the samples it receives. Fails on |fail_at| sample if it is
+// non-negative.
+class FakeMuxer : public Muxer {
+ public:
+  explicit FakeMuxer(int fail_at)
+      : Muxer(MuxerOptions()),
+        fail_at_(fail_at),
+        num_samples_(0),
+        finalized_(false),
+        unblock_event_(NULL) {}
+  virtual ~FakeMuxer() {}
+
+  int num_samples() const { return num_samples_; }
+  bool finalized() const { return finalized_; }
+
+  // Make every sample wait for |unblock_event| to be signaled.
+  void set_unblock_event(base::WaitableEvent* unblock_event) {
+    unblock_event_ = unblock_event;
+  }
+
+ private:
+  virtual Status Initialize() OVERRIDE { return Status::OK; }
+  virtual Status Finalize() OVERRIDE {
+    finalized_ = true;
+    return Status::OK;
+  }
+  virtual Status DoAddSample(const MediaStream* stream,
+                             scoped_refptr<MediaSample> sample) OVERRIDE {
+    if (unblock_event_)
+      unblock_event_->Wait();
+    if (num_samples_ == fail_at_)
+      return Status(error::MUXER_FAILURE, "Injected failure.");
+    ++num_samples_;
+    return Status::OK;
+  }
+
+  int fail_at_;
+  int num_samples_;
+  bool finalized_;
+  base::WaitableEvent* unblock_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeMuxer);
+};
+
+}  // namespace
+
+class MuxerPipelineTest : public ::testing::Test {
+ public:
+  MuxerPipelineTest()
+      : demuxer_(""),
+        stream_(scoped_refptr<StreamInfo>(), &demuxer_) {}
+
+  // Push samples until a push fails, and return its status in |status|.
+  void PushUntilFailure(Status* status) {
+    do {
+      *status = stream_.PushSample(MediaSample::CreateEmptyMediaSample());
+    } while (status->ok());
+  }
+
+ protected:
+  Demuxer demuxer_;
+  MediaStream stream_;
+};
+
+TEST_F(MuxerPipelineTest, ConsumesAllSamples) {
+  FakeMuxer muxer(-1);
+  muxer.AddStream(&stream_);
+  muxer.StartPipeline(kMaxQueuedSamples);
+  ASSERT_OK(stream_.Start(MediaStream::kPush));
+
+  for (int i = 0; i < kNumSamples; ++i)
+    ASSERT_OK(stream_.PushSample(MediaSample::CreateEmptyMediaSample()));
+  ASSERT_OK(stream_.PushSample(MediaSample::CreateEOSBuffer()));
+
+  ASSERT_OK(muxer.StopPipeline());
+  EXPECT_EQ(kNumSamples, muxer.num_samples());
+  EXPECT_TRUE(muxer.finalized());
+}
+
+TEST_F(MuxerPipelineTest, PropagatesMuxerFailure) {
+  FakeMuxer muxer(kFailingSampleIndex);
+  muxer.AddStream(&stream_);
+  muxer.StartPipeline(kMaxQueuedSamples);
+  ASSERT_OK(stream_.Start(MediaStream::kPush));
+
+  Status status;
+  for (int i = 0; i < kNumSamples && status.ok(); ++i)
+    status = stream_.PushSample(MediaSample::CreateEmptyMediaSample());
+  EXPECT_EQ(error::MUXER_FAILURE, status.error_code());
+
+  EXPECT_EQ(error::MUXER_FAILURE, muxer.StopPipeline().error_code());
+  EXPECT_EQ(kFailingSampleIndex, muxer.num_samples());
+  EXPECT_FALSE(muxer.finalized());
+}
+
+// Cancel() unblocks a push waiting for room in the queue while the muxer
+// thread is stuck.
+TEST_F(MuxerPipelineTest, CancelUnblocksPush) {
+  const bool kManualReset = true;
+  const bool kInitiallySignaled = false;
+  base::WaitableEvent unblock_event(kManualReset, kInitiallySignaled);
+  FakeMuxer muxer(-1);
+  muxer.set_unblock_event(&unblock_event);
+  muxer.AddStream(&stream_);
+  muxer.StartPipeline(kMaxQueuedSamples);
+  ASSERT_OK(stream_.Start(MediaStream::kPush));
+
+  Status push_status;
+  ClosureThread push_thread(
+      "PushThread",
+      base::Bind(&MuxerPipelineTest::PushUntilFailure,
+                 base::Unretained(this),
+                 &push_status));
+  push_thread.Start();
+  muxer.Cancel();
+  push_thread.Join();
+  EXPECT_EQ(error::CANCELLED, push_status.error_code());
+
+  unblock_event.Signal();
+  EXPECT_EQ(error::CANCELLED, muxer.StopPipeline().error_code());
+  EXPECT_FALSE(muxer.finalized());
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,113 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/pipeline_stats.h"
+
+#include "packager/base/json/json_writer.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/values.h"
+
+namespace edash_packager {
+namespace media {
+
+const char kReadStage[] = "read";
+const char kParseStage[] = "parse";
+const char kDecryptStage[] = "decrypt";
+const char kEncryptStage[] = "encrypt";
+const char kFragmentStage[] = "fragment";
+const char kSegmentStage[] = "segment";
+const char kWriteStage[] = "write";
+
+StageStats::StageStats() : count_(0), bytes_(0) {}
+StageStats::~StageStats() {}
+
+void StageStats::Add(int64_t count, int64_t bytes, base::TimeDelta time) {
+  base::AutoLock auto_lock(lock_);
+  count_ += count;
+  bytes_ += bytes;
+  time_ += time;
+}
+
+int64_t StageStats::count() const {
+  base::AutoLock auto_lock(lock_);
+  return count_;
+}
+
+int64_t StageStats::bytes() const {
+  base::AutoLock auto_lock(lock_);
+  return bytes_;
+}
+
+base::TimeDelta StageStats::time() const {
+  base::AutoLock auto_lock(lock_);
+  return time_;
+}
+
+ScopedStageTimer::ScopedStageTimer(StageStats* stats)
+    : stats_(stats), count_(0), bytes_(0) {
+  if (stats_)
+    start_ = base::TimeTicks::Now();
+}
+
+ScopedStageTimer::~ScopedStageTimer() {
+  if (stats_)
+    stats_->Add(count_, bytes_, base::TimeTicks::Now() - start_);
+}
+
+PipelineStats::PipelineStats() : start_(base::TimeTicks::Now()) {}
+
+PipelineStats::~PipelineStats() { STLDeleteValues(&stage_stats_); }
+
+StageStats* PipelineStats::GetStageStats(const std::string& stream,
+                                         const std::string& stage) {
+  base::AutoLock auto_lock(lock_);
+  StageStats*& stats = stage_stats_[StageKey(stream, stage)];
+  if (!stats)
+    stats = new StageStats();
+  return stats;
+}
+
+std::string PipelineStats::ToJson() const {
+  base::DictionaryValue report;
+  report.SetDouble("elapsed_seconds",
+                   (base::TimeTicks::Now() - start_).InSecondsF());
+  base::ListValue* streams = new base::ListValue();
+  report.Set("streams", streams);
+
+  base::AutoLock auto_lock(lock_);
+  // |stage_stats_| is sorted by stream, so the stages of a stream are
+  // adjacent.
+  base::DictionaryValue* stages = NULL;
+  const std::string* stream_name = NULL;
+  for (std::map<StageKey, StageStats*>::const_iterator it =
+           stage_stats_.begin();
+       it != stage_stats_.end();
+       ++it) {
+    if (!stream_name || *stream_name != it->first.first) {
+      stream_name = &it->first.first;
+      base::DictionaryValue* stream = new base::DictionaryValue();
+      streams->Append(stream);
+      stream->SetString("name", *stream_name);
+      stages = new base::DictionaryValue();
+      stream->Set("stages", stages);
+    }
+    // Counters are reported as doubles, as base::Value has no 64-bit
+    // integers.
+    scoped_ptr<base::DictionaryValue> stage(new base::DictionaryValue());
+    stage->SetDouble("count", static_cast<double>(it->second->count()));
+    stage->SetDouble("bytes", static_cast<double>(it->second->bytes()));
+    stage->SetDouble("seconds", it->second->time().InSecondsF());
+    stages->Set(it->first.second, stage.release());
+  }
+
+  std::string json;
+  base::JSONWriter::Write(&report, &json);
+  return json;
+}
+
+}  // namespace media
+}  // namespace edash_packager
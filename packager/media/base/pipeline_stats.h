@@ -0,0 +1,122 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_PIPELINE_STATS_H_
+#define MEDIA_BASE_PIPELINE_STATS_H_
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
+
+namespace edash_packager {
+namespace media {
+
+/// @name Names of the stages of the packaging pipeline.
+/// Stages may be nested, e.g. kParseStage includes kDecryptStage.
+/// @{
+/// Input reads. Counts reads and bytes read.
+extern const char kReadStage[];
+/// Input parsing. Counts samples emitted and their bytes.
+extern const char kParseStage[];
+/// Sample decryption. Counts samples and bytes decrypted.
+extern const char kDecryptStage[];
+/// Sample encryption. Counts samples and bytes encrypted.
+extern const char kEncryptStage[];
+/// Fragment generation. Counts fragments and their bytes.
+extern const char kFragmentStage[];
+/// Segment finalization, including its writes. Counts segments and their
+/// bytes.
+extern const char kSegmentStage[];
+/// Output writes. Counts writes and bytes written.
+extern const char kWriteStage[];
+/// @}
+
+/// Counters of one stage of the pipeline, for one stream.
+///
+/// Thread Safety: All the methods can be called from any thread.
+class StageStats {
+ public:
+  StageStats();
+  ~StageStats();
+
+  /// Record the processing of @a count items, of @a bytes bytes in total,
+  /// which took @a time.
+  void Add(int64_t count, int64_t bytes, base::TimeDelta time);
+
+  int64_t count() const;
+  int64_t bytes() const;
+  base::TimeDelta time() const;
+
+ private:
+  mutable base::Lock lock_;
+  int64_t count_;
+  int64_t bytes_;
+  base::TimeDelta time_;
+
+  DISALLOW_COPY_AND_ASSIGN(StageStats);
+};
+
+/// Records the time elapsed between its construction and its destruction,
+/// with the items and bytes set in between, into a StageStats. Does nothing,
+/// not even reading the clock, if the StageStats is NULL, so that stages can
+/// be instrumented unconditionally.
+class ScopedStageTimer {
+ public:
+  /// @param stats is the StageStats updated on destruction. Can be NULL.
+  explicit ScopedStageTimer(StageStats* stats);
+  ~ScopedStageTimer();
+
+  void set_count(int64_t count) { count_ = count; }
+  void set_bytes(int64_t bytes) { bytes_ = bytes; }
+
+ private:
+  StageStats* stats_;
+  base::TimeTicks start_;
+  int64_t count_;
+  int64_t bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedStageTimer);
+};
+
+/// Collects the StageStats of all the streams of a packaging job, keyed by
+/// stream and stage, and reports them. Streams are named after their input
+/// file on the demuxer side and after their output file on the muxer side.
+///
+/// Thread Safety: All the methods can be called from any thread.
+class PipelineStats {
+ public:
+  PipelineStats();
+  ~PipelineStats();
+
+  /// @return The StageStats of @a stage for @a stream, created on the first
+  ///         call. Owned by the PipelineStats, valid until its destruction.
+  StageStats* GetStageStats(const std::string& stream,
+                            const std::string& stage);
+
+  /// @return A JSON report of the stats collected so far, in the form
+  ///         {"elapsed_seconds": <time since creation>, "streams": [{"name":
+  ///         <stream>, "stages": {<stage>: {"count": <count>, "bytes":
+  ///         <bytes>, "seconds": <time>}, ...}}, ...]}.
+  std::string ToJson() const;
+
+ private:
+  typedef std::pair<std::string, std::string> StageKey;
+
+  const base::TimeTicks start_;
+  mutable base::Lock lock_;
+  // Protected by |lock_|.
+  std::map<StageKey, StageStats*> stage_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(PipelineStats);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_BASE_PIPELINE_STATS_H_
@@ -0,0 +1,104 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/json/json_reader.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/values.h"
+#include "packager/media/base/pipeline_stats.h"
+
+namespace {
+
+const char kInput[] = "input.mp4";
+const char kOutput[] = "output.mp4";
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+TEST(PipelineStatsTest, StageStatsAdd) {
+  StageStats stats;
+  stats.Add(1, 100, base::TimeDelta::FromMilliseconds(10));
+  stats.Add(2, 50, base::TimeDelta::FromMilliseconds(5));
+  EXPECT_EQ(3, stats.count());
+  EXPECT_EQ(150, stats.bytes());
+  EXPECT_EQ(15, stats.time().InMilliseconds());
+}
+
+TEST(PipelineStatsTest, ScopedStageTimer) {
+  StageStats stats;
+  {
+    ScopedStageTimer timer(&stats);
+    timer.set_count(1);
+    timer.set_bytes(10);
+  }
+  EXPECT_EQ(1, stats.count());
+  EXPECT_EQ(10, stats.bytes());
+  EXPECT_LE(0, stats.time().InMicroseconds());
+
+  // A timer without stats is a no-op.
+  ScopedStageTimer timer(NULL);
+  timer.set_count(1);
+}
+
+TEST(PipelineStatsTest, GetStageStatsReturnsSameStats) {
+  PipelineStats pipeline_stats;
+  StageStats* read_stats = pipeline_stats.GetStageStats(kInput, kReadStage);
+  EXPECT_EQ(read_stats, pipeline_stats.GetStageStats(kInput, kReadStage));
+  EXPECT_NE(read_stats, pipeline_stats.GetStageStats(kInput, kParseStage));
+  EXPECT_NE(read_stats, pipeline_stats.GetStageStats(kOutput, kReadStage));
+}
+
+TEST(PipelineStatsTest, ToJson) {
+  PipelineStats pipeline_stats;
+  pipeline_stats.GetStageStats(kInput, kReadStage)
+      ->Add(2, 1000, base::TimeDelta::FromMilliseconds(500));
+  pipeline_stats.GetStageStats(kInput, kParseStage)
+      ->Add(10, 900, base::TimeDelta::FromMilliseconds(250));
+  pipeline_stats.GetStageStats(kOutput, kWriteStage)
+      ->Add(1, 800, base::TimeDelta());
+
+  scoped_ptr<base::Value> root(
+      base::JSONReader::Read(pipeline_stats.ToJson()));
+  ASSERT_TRUE(root);
+  base::DictionaryValue* report = NULL;
+  ASSERT_TRUE(root->GetAsDictionary(&report));
+  double elapsed_seconds = -1;
+  EXPECT_TRUE(report->GetDouble("elapsed_seconds", &elapsed_seconds));
+  EXPECT_LE(0, elapsed_seconds);
+
+  base::ListValue* streams = NULL;
+  ASSERT_TRUE(report->GetList("streams", &streams));
+  ASSERT_EQ(2u, streams->GetSize());
+
+  // Stream names contain dots, which are not expanded as paths.
+  base::DictionaryValue* stream = NULL;
+  ASSERT_TRUE(streams->GetDictionary(0, &stream));
+  std::string name;
+  EXPECT_TRUE(stream->GetString("name", &name));
+  EXPECT_EQ(kInput, name);
+  double value = 0;
+  EXPECT_TRUE(stream->GetDouble("stages.read.count", &value));
+  EXPECT_EQ(2, value);
+  EXPECT_TRUE(stream->GetDouble("stages.read.bytes", &value));
+  EXPECT_EQ(1000, value);
+  EXPECT_TRUE(stream->GetDouble("stages.read.seconds", &value));
+  EXPECT_DOUBLE_EQ(0.5, value);
+  EXPECT_TRUE(stream->GetDouble("stages.parse.count", &value));
+  EXPECT_EQ(10, value);
+
+  ASSERT_TRUE(streams->GetDictionary(1, &stream));
+  EXPECT_TRUE(stream->GetString("name", &name));
+  EXPECT_EQ(kOutput, name);
+  EXPECT_TRUE(stream->GetDouble("stages.write.bytes", &value));
+  EXPECT_EQ(800, value);
+  EXPECT_FALSE(stream->HasKey("stages.read"));
+}
+
+}  // namespace media
+}  // namespace edash_packager
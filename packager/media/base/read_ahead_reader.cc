@@ -0,0 +1,97 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/read_ahead_reader.h"
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/file/file.h"
+
+namespace edash_packager {
+namespace media {
+
+ReadAheadReader::ReadAheadReader(File* file,
+                                 size_t num_buffers,
+                                 size_t buffer_size)
+    : file_(file),
+      buffer_size_(buffer_size),
+      free_buffers_(num_buffers),
+      filled_buffers_(num_buffers),
+      current_buffer_(NULL) {
+  DCHECK(file);
+  DCHECK_GE(num_buffers, 2u);
+  DCHECK_GT(buffer_size, 0u);
+  for (size_t i = 0; i < num_buffers; ++i) {
+    Buffer* buffer = new Buffer;
+    buffer->data.reset(new uint8_t[buffer_size]);
+    buffer->size = 0;
+    buffers_.push_back(buffer);
+  }
+}
+
+ReadAheadReader::~ReadAheadReader() {
+  free_buffers_.Stop();
+  filled_buffers_.Stop();
+  // ClosureThread joins on destruction.
+  thread_.reset();
+  STLDeleteElements(&buffers_);
+}
+
+void ReadAheadReader::Start() {
+  DCHECK(!thread_);
+  for (size_t i = 0; i < buffers_.size(); ++i) {
+    Status status = free_buffers_.Push(buffers_[i], kInfiniteTimeout);
+    DCHECK(status.ok()) << status.ToString();
+  }
+  thread_.reset(new ClosureThread(
+      "ReadAheadReader",
+      base::Bind(&ReadAheadReader::ReadLoop, base::Unretained(this))));
+  thread_->Start();
+}
+
+int64_t ReadAheadReader::Read(const uint8_t** data) {
+  DCHECK(thread_);
+  DCHECK(data);
+
+  if (current_buffer_) {
+    // Do not recycle the final buffer: the reader thread has exited and the
+    // end-of-file or error result is returned again on subsequent calls.
+    if (current_buffer_->size <= 0)
+      return current_buffer_->size;
+    Status status = free_buffers_.Push(current_buffer_, kInfiniteTimeout);
+    DCHECK(status.ok()) << status.ToString();
+    current_buffer_ = NULL;
+  }
+
+  Buffer* buffer = NULL;
+  Status status = filled_buffers_.Pop(&buffer, kInfiniteTimeout);
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to get read-ahead buffer: " << status.ToString();
+    return -1;
+  }
+  current_buffer_ = buffer;
+  *data = buffer->data.get();
+  return buffer->size;
+}
+
+void ReadAheadReader::ReadLoop() {
+  Buffer* buffer = NULL;
+  while (free_buffers_.Pop(&buffer, kInfiniteTimeout).ok()) {
+    buffer->size = file_->Read(buffer->data.get(), buffer_size_);
+    if (buffer->size <= 0)
+      buffer->size = file_->Eof() ? 0 : -1;
+    if (!filled_buffers_.Push(buffer, kInfiniteTimeout).ok() ||
+        buffer->size <= 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace media
+}  // namespace edash_packager
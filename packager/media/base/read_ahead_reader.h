@@ -0,0 +1,79 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_READ_AHEAD_READER_H_
+#define MEDIA_BASE_READ_AHEAD_READER_H_
+
+#include <vector>
+
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/producer_consumer_queue.h"
+
+namespace edash_packager {
+namespace media {
+
+class ClosureThread;
+class File;
+
+/// Reads a file sequentially on a separate thread, filling a fixed set of
+/// buffers ahead of the consumer, so reading the next chunk of the file
+/// overlaps with processing the current one.
+///
+/// Thread Safety: Start and Read should be called from the same thread. The
+/// file must not be accessed by anyone else while the reader is alive.
+class ReadAheadReader {
+ public:
+  /// @param file is the file to read from. It is not owned and must outlive
+  ///        the reader.
+  /// @param num_buffers is the number of buffers. Should be at least 2: one
+  ///        held by the consumer and the rest filled ahead of it.
+  /// @param buffer_size is the size of each buffer, i.e. the maximum number
+  ///        of bytes requested from the file per read.
+  ReadAheadReader(File* file, size_t num_buffers, size_t buffer_size);
+
+  /// Stop the reader thread if it is running.
+  ~ReadAheadReader();
+
+  /// Start reading ahead from the current position of the file.
+  void Start();
+
+  /// Get the next chunk of the file. The previous chunk returned is released
+  /// and must not be accessed after this call.
+  /// @param[out] data points to the data read on success. It stays valid
+  ///             until the next call to Read or the destruction of the
+  ///             reader.
+  /// @return The number of bytes read on success, 0 at the end of the file,
+  ///         or a negative value on read failure.
+  int64_t Read(const uint8_t** data);
+
+ private:
+  struct Buffer {
+    scoped_ptr<uint8_t[]> data;
+    // Bytes read into |data|, 0 at the end of the file, negative on failure.
+    int64_t size;
+  };
+
+  // Body of the reader thread.
+  void ReadLoop();
+
+  File* const file_;
+  const size_t buffer_size_;
+  std::vector<Buffer*> buffers_;
+  // Buffers available to the reader thread.
+  ProducerConsumerQueue<Buffer*> free_buffers_;
+  // Buffers filled by the reader thread, in file order.
+  ProducerConsumerQueue<Buffer*> filled_buffers_;
+  // Buffer whose data was last returned by Read().
+  Buffer* current_buffer_;
+  scoped_ptr<ClosureThread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadAheadReader);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_BASE_READ_AHEAD_READER_H_
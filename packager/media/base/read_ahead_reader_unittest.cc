@@ -0,0 +1,86 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/file_util.h"
+#include "packager/media/base/read_ahead_reader.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/file_closer.h"
+
+namespace {
+const int kDataSize = 10000;
+const size_t kNumBuffers = 3;
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class ReadAheadReaderTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    data_.resize(kDataSize);
+    for (int i = 0; i < kDataSize; ++i)
+      data_[i] = i % 251;
+
+    ASSERT_TRUE(base::CreateTemporaryFile(&test_file_path_));
+    ASSERT_EQ(kDataSize,
+              file_util::WriteFile(test_file_path_, data_.data(), kDataSize));
+    file_.reset(File::Open(test_file_path_.value().c_str(), "r"));
+    ASSERT_TRUE(file_);
+  }
+
+  virtual void TearDown() {
+    file_.reset();
+    base::DeleteFile(test_file_path_, false);
+  }
+
+  // Read the whole file through a ReadAheadReader.
+  std::string ReadAll(size_t buffer_size) {
+    ReadAheadReader reader(file_.get(), kNumBuffers, buffer_size);
+    reader.Start();
+
+    std::string result;
+    const uint8_t* data = NULL;
+    int64_t size = 0;
+    while ((size = reader.Read(&data)) > 0) {
+      EXPECT_LE(static_cast<size_t>(size), buffer_size);
+      result.append(reinterpret_cast<const char*>(data), size);
+    }
+    EXPECT_EQ(0, size);
+    // End of file is sticky.
+    EXPECT_EQ(0, reader.Read(&data));
+    return result;
+  }
+
+  std::string data_;
+  base::FilePath test_file_path_;
+  scoped_ptr<File, FileCloser> file_;
+};
+
+TEST_F(ReadAheadReaderTest, ReadSmallBuffers) {
+  EXPECT_EQ(data_, ReadAll(100));
+}
+
+TEST_F(ReadAheadReaderTest, ReadUnalignedBuffers) {
+  EXPECT_EQ(data_, ReadAll(777));
+}
+
+TEST_F(ReadAheadReaderTest, ReadBufferLargerThanFile) {
+  EXPECT_EQ(data_, ReadAll(kDataSize * 2));
+}
+
+TEST_F(ReadAheadReaderTest, DestroyBeforeEndOfFile) {
+  ReadAheadReader reader(file_.get(), kNumBuffers, 10);
+  reader.Start();
+  const uint8_t* data = NULL;
+  ASSERT_EQ(10, reader.Read(&data));
+  EXPECT_EQ(0, memcmp(data_.data(), data, 10));
+  // The reader thread is blocked on a full queue and must be stopped cleanly.
+}
+
+}  // namespace media
+}  // namespace edash_packager
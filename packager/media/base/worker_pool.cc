@@ -0,0 +1,64 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/worker_pool.h"
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/stl_util.h"
+#include "packager/media/base/closure_thread.h"
+
+namespace edash_packager {
+namespace media {
+
+WorkerPool::WorkerPool(const std::string& name_prefix, size_t num_threads)
+    : tasks_(kUnlimitedCapacity), idle_cv_(&lock_), num_pending_tasks_(0) {
+  DCHECK_GT(num_threads, 0u);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.push_back(new ClosureThread(
+        name_prefix,
+        base::Bind(&WorkerPool::RunTasks, base::Unretained(this))));
+    threads_.back()->Start();
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  // Pending tasks still run before the threads exit.
+  tasks_.Stop();
+  // ClosureThread joins on destruction.
+  STLDeleteElements(&threads_);
+}
+
+void WorkerPool::PostTask(const base::Closure& task) {
+  {
+    base::AutoLock auto_lock(lock_);
+    ++num_pending_tasks_;
+  }
+  Status status = tasks_.Push(task, kInfiniteTimeout);
+  DCHECK(status.ok()) << status.ToString();
+}
+
+void WorkerPool::WaitForIdle() {
+  base::AutoLock auto_lock(lock_);
+  while (num_pending_tasks_ > 0)
+    idle_cv_.Wait();
+}
+
+void WorkerPool::RunTasks() {
+  base::Closure task;
+  while (tasks_.Pop(&task, kInfiniteTimeout).ok()) {
+    task.Run();
+    task.Reset();
+
+    base::AutoLock auto_lock(lock_);
+    DCHECK_GT(num_pending_tasks_, 0u);
+    if (--num_pending_tasks_ == 0)
+      idle_cv_.Broadcast();
+  }
+}
+
+}  // namespace media
+}  // namespace edash_packager
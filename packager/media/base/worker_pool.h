@@ -0,0 +1,66 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_BASE_WORKER_POOL_H_
+#define MEDIA_BASE_WORKER_POOL_H_
+
+#include <string>
+#include <vector>
+
+#include "packager/base/callback.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/base/producer_consumer_queue.h"
+
+namespace edash_packager {
+namespace media {
+
+class ClosureThread;
+
+/// A fixed number of threads running the tasks posted to the pool, in the
+/// order they are posted.
+///
+/// Thread Safety: PostTask may be called from any thread. WaitForIdle and the
+/// destructor should be called from the creating thread.
+class WorkerPool {
+ public:
+  /// Create the pool and start its threads.
+  /// @param name_prefix is the name prefix of the threads.
+  /// @param num_threads is the number of threads. Should not be 0.
+  WorkerPool(const std::string& name_prefix, size_t num_threads);
+
+  /// Wait for the posted tasks to complete and stop the threads.
+  ~WorkerPool();
+
+  /// Post a task to be run by one of the threads.
+  /// @param task is the task to run.
+  void PostTask(const base::Closure& task);
+
+  /// Block until all the posted tasks have completed.
+  void WaitForIdle();
+
+  size_t num_threads() const { return threads_.size(); }
+
+ private:
+  // Body of the threads. Runs tasks until |tasks_| is stopped and drained.
+  void RunTasks();
+
+  ProducerConsumerQueue<base::Closure> tasks_;
+  std::vector<ClosureThread*> threads_;
+
+  base::Lock lock_;
+  // Signaled when |num_pending_tasks_| drops to 0.
+  base::ConditionVariable idle_cv_;
+  // Number of tasks posted but not yet completed. Protected by |lock_|.
+  size_t num_pending_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_BASE_WORKER_POOL_H_
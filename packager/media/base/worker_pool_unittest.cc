@@ -0,0 +1,67 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/atomic_sequence_num.h"
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/worker_pool.h"
+
+namespace {
+
+const char kThreadNamePrefix[] = "TestWorkerPool";
+const size_t kNumThreads = 4;
+const int kNumTasks = 100;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class WorkerPoolTest : public ::testing::Test {
+ public:
+  WorkerPoolTest() : task_run_counts_(kNumTasks, 0) {}
+
+  void Task(int index) {
+    ++task_run_counts_[index];
+    task_counter_.GetNext();
+  }
+
+ protected:
+  // Each task updates its own entry, so no locking is needed.
+  std::vector<int> task_run_counts_;
+  base::AtomicSequenceNumber task_counter_;
+};
+
+TEST_F(WorkerPoolTest, WaitForIdle) {
+  WorkerPool pool(kThreadNamePrefix, kNumThreads);
+  EXPECT_EQ(kNumThreads, pool.num_threads());
+  // Waiting on an idle pool returns immediately.
+  pool.WaitForIdle();
+
+  for (int i = 0; i < kNumTasks; ++i)
+    pool.PostTask(base::Bind(&WorkerPoolTest::Task, base::Unretained(this), i));
+  pool.WaitForIdle();
+
+  EXPECT_EQ(kNumTasks, task_counter_.GetNext());
+  for (int i = 0; i < kNumTasks; ++i)
+    EXPECT_EQ(1, task_run_counts_[i]) << "Task " << i;
+}
+
+TEST_F(WorkerPoolTest, DestructorRunsPendingTasks) {
+  {
+    WorkerPool pool(kThreadNamePrefix, kNumThreads);
+    for (int i = 0; i < kNumTasks; ++i) {
+      pool.PostTask(
+          base::Bind(&WorkerPoolTest::Task, base::Unretained(this), i));
+    }
+  }
+  EXPECT_EQ(kNumTasks, task_counter_.GetNext());
+}
+
+}  // namespace media
+}  // namespace edash_packager
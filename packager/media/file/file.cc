@@ -6,9 +6,18 @@
 
 #include "packager/media/file/file.h"
 
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
 #include "packager/base/logging.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/file/local_file.h"
+#include "packager/media/file/memory_mapped_file.h"
 #include "packager/media/file/udp_file.h"
 #include "packager/base/strings/string_util.h"
 
@@ -17,6 +26,7 @@ namespace media {
 
 const char* kLocalFilePrefix = "file://";
 const char* kUdpFilePrefix = "udp://";
+const char* kMemoryMappedFilePrefix = "mmap://";
 
 typedef File* (*FileFactoryFunction)(const char* file_name, const char* mode);
 
@@ -38,9 +48,19 @@ static File* CreateUdpFile(const char* file_name, const char* mode) {
   return new UdpFile(file_name);
 }
 
+static File* CreateMemoryMappedFile(const char* file_name, const char* mode) {
+  if (base::strcasecmp(mode, "r")) {
+    NOTIMPLEMENTED() << "MemoryMappedFile only supports read mode.";
+    return NULL;
+  }
+  return new MemoryMappedFile(file_name);
+}
+
 static const SupportedTypeInfo kSupportedTypeInfo[] = {
     { kLocalFilePrefix, strlen(kLocalFilePrefix), &CreateLocalFile },
     { kUdpFilePrefix, strlen(kUdpFilePrefix), &CreateUdpFile },
+    { kMemoryMappedFilePrefix, strlen(kMemoryMappedFilePrefix),
+      &CreateMemoryMappedFile },
 };
 
 File* File::Create(const char* file_name, const char* mode) {
@@ -93,5 +113,84 @@ bool File::ReadFileToString(const char* file_name, std::string* contents) {
   return len == 0;
 }
 
+// Copy |source| to |destination| with sendfile(2), which does not bring the
+// data into user space. Returns false if the kernel copy is not possible, in
+// which case the file positions are left untouched. Otherwise |bytes_copied|
+// is set to the number of bytes copied, or a value < 0 on error.
+static bool KernelCopyFile(File* source,
+                           int source_fd,
+                           File* destination,
+                           int destination_fd,
+                           int64_t* bytes_copied) {
+#if defined(__linux__)
+  uint64_t source_position;
+  uint64_t destination_position;
+  const int64_t source_size = source->Size();
+  if (source_size < 0 || !source->Tell(&source_position) ||
+      !destination->Flush() || !destination->Tell(&destination_position)) {
+    return false;
+  }
+  // sendfile writes at the offset of |destination_fd|, which may differ from
+  // the buffered position.
+  if (lseek(destination_fd, destination_position, SEEK_SET) < 0)
+    return false;
+
+  const int64_t kMaxChunkSize = std::numeric_limits<int32_t>::max();
+  off_t offset = source_position;
+  while (offset < source_size) {
+    ssize_t size = sendfile(
+        destination_fd, source_fd, &offset,
+        std::min<int64_t>(source_size - offset, kMaxChunkSize));
+    if (size < 0 && offset == static_cast<off_t>(source_position)) {
+      // Not supported for this pair of files.
+      return false;
+    }
+    if (size <= 0) {
+      PLOG(ERROR) << "Failed to copy " << source->file_name() << " to "
+                  << destination->file_name();
+      *bytes_copied = -1;
+      return true;
+    }
+  }
+
+  // Sync the buffered positions with the descriptors.
+  const int64_t size_copied = offset - source_position;
+  if (!source->Seek(source_position + size_copied) ||
+      !destination->Seek(destination_position + size_copied)) {
+    *bytes_copied = -1;
+    return true;
+  }
+  *bytes_copied = size_copied;
+  return true;
+#else
+  return false;
+#endif
+}
+
+int64_t File::CopyFile(File* source, File* destination) {
+  DCHECK(source);
+  DCHECK(destination);
+
+  const int source_fd = source->GetFileDescriptor();
+  const int destination_fd = destination->GetFileDescriptor();
+  int64_t bytes_copied = 0;
+  if (source_fd >= 0 && destination_fd >= 0 &&
+      KernelCopyFile(
+          source, source_fd, destination, destination_fd, &bytes_copied)) {
+    return bytes_copied;
+  }
+
+  const size_t kBufferSize = 0x40000;  // 256KB.
+  scoped_ptr<uint8_t[]> buf(new uint8_t[kBufferSize]);
+
+  int64_t size;
+  while ((size = source->Read(buf.get(), kBufferSize)) > 0) {
+    if (destination->Write(buf.get(), size) != size)
+      return -1;
+    bytes_copied += size;
+  }
+  return size == 0 ? bytes_copied : -1;
+}
+
 }  // namespace media
 }  // namespace edash_packager
@@ -18,6 +18,8 @@
         'file_closer.h',
         'local_file.cc',
         'local_file.h',
+        'memory_mapped_file.cc',
+        'memory_mapped_file.h',
         'udp_file.cc',
         'udp_file.h',
       ],
@@ -31,10 +33,12 @@
       'type': '<(gtest_target_type)',
       'sources': [
         'file_unittest.cc',
+        'udp_file_unittest.cc',
       ],
       'dependencies': [
         '../../testing/gtest.gyp:gtest',
         '../../testing/gtest.gyp:gtest_main',
+        '../../third_party/gflags/gflags.gyp:gflags',
         'file',
       ],
     },
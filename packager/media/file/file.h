@@ -17,6 +17,8 @@ namespace edash_packager {
 namespace media {
 
 extern const char* kLocalFilePrefix;
+extern const char* kUdpFilePrefix;
+extern const char* kMemoryMappedFilePrefix;
 
 /// Define an abstract file interface.
 class File {
@@ -64,6 +66,37 @@ class File {
   /// @return true if the file reaches eof, false otherwise.
   virtual bool Eof() = 0;
 
+  /// Seek to the specified position in the file.
+  /// @param position is the position to seek to.
+  /// @return true on success, false otherwise. Files that are not seekable,
+  ///         e.g. network streams, always return false.
+  virtual bool Seek(uint64_t position) = 0;
+
+  /// Get the current file position.
+  /// @param[out] position is filled with the current file position on success.
+  /// @return true on success, false otherwise.
+  virtual bool Tell(uint64_t* position) = 0;
+
+  /// @return true if the file supports ReadView(), false otherwise.
+  virtual bool SupportsReadView() { return false; }
+
+  /// Read data without copying it, if SupportsReadView() returns true.
+  /// @param[out] data is set to point to the data read. The data stays valid
+  ///             until the file is closed.
+  /// @param length indicates the maximum number of bytes to be read.
+  /// @return Number of bytes read, or a value < 0 on error or if the file
+  ///         does not support it. Zero on end-of-file, or if 'length' is zero.
+  virtual int64_t ReadView(const uint8_t** data, uint64_t length) {
+    return -1;
+  }
+
+  /// Make the pending and following reads fail as soon as possible. Used to
+  /// interrupt the reads of live streams, which can block indefinitely. Can
+  /// be called from any thread while another thread uses the file, but not
+  /// once the file is closed. Does nothing by default, as the reads of
+  /// other files do not block indefinitely.
+  virtual void Cancel() {}
+
   /// @return The file name.
   const std::string& file_name() const { return file_name_; }
 
@@ -81,6 +114,15 @@ class File {
   /// @return true on success, false otherwise.
   static bool ReadFileToString(const char* file_name, std::string* contents);
 
+  /// Copy the remaining contents of a file to the current position of another
+  /// file. If both files are backed by file descriptors, the data is copied
+  /// by the kernel without going through user space; otherwise it is read
+  /// and written in chunks.
+  /// @param source is the file to copy from. It is read until end-of-file.
+  /// @param destination is the file to copy to.
+  /// @return Number of bytes copied, or a value < 0 on error.
+  static int64_t CopyFile(File* source, File* destination);
+
  protected:
   explicit File(const std::string& file_name) : file_name_(file_name) {}
   /// Do *not* call the destructor directly (with the "delete" keyword)
@@ -90,6 +132,10 @@ class File {
   /// Internal open. Should not be used directly.
   virtual bool Open() = 0;
 
+  /// @return The file descriptor backing this file, or -1 if there is none.
+  ///         Buffered data should be flushed before using the descriptor.
+  virtual int GetFileDescriptor() { return -1; }
+
  private:
   // This is a file factory method, it creates a proper file, e.g.
   // LocalFile, MemFile based on prefix.
@@ -97,6 +97,65 @@ TEST_F(LocalFileTest, Read_And_Eof) {
   EXPECT_EQ(data_, read_data);
 }
 
+TEST_F(LocalFileTest, SeekAndTell) {
+  ASSERT_EQ(kDataSize,
+            file_util::WriteFile(test_file_path_, data_.data(), kDataSize));
+
+  File* file = File::Open(local_file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+
+  uint64_t position;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(0u, position);
+
+  // Read to the end, then seek back into the middle of the file.
+  std::string read_data(kDataSize, 0);
+  EXPECT_EQ(kDataSize, file->Read(&read_data[0], kDataSize));
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(static_cast<uint64_t>(kDataSize), position);
+
+  const int kSeekPosition = kDataSize / 4;
+  ASSERT_TRUE(file->Seek(kSeekPosition));
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(static_cast<uint64_t>(kSeekPosition), position);
+  EXPECT_FALSE(file->Eof());
+
+  const int kReadBytes = kDataSize / 2;
+  EXPECT_EQ(kReadBytes, file->Read(&read_data[0], kReadBytes));
+  EXPECT_EQ(data_.substr(kSeekPosition, kReadBytes),
+            read_data.substr(0, kReadBytes));
+  EXPECT_TRUE(file->Close());
+}
+
+TEST_F(LocalFileTest, CopyFile) {
+  ASSERT_EQ(kDataSize,
+            file_util::WriteFile(test_file_path_, data_.data(), kDataSize));
+  const std::string kHeader = "header";
+  const char kCopyFileName[] = "/tmp/local_file_copy_test";
+
+  File* source = File::Open(local_file_name_.c_str(), "r");
+  ASSERT_TRUE(source != NULL);
+  File* destination = File::Open(kCopyFileName, "w");
+  ASSERT_TRUE(destination != NULL);
+
+  // Data written before and after the copy should stay in order.
+  const int kSkippedBytes = kDataSize / 4;
+  std::string read_data(kSkippedBytes, 0);
+  EXPECT_EQ(kSkippedBytes, source->Read(&read_data[0], kSkippedBytes));
+  EXPECT_EQ(static_cast<int64_t>(kHeader.size()),
+            destination->Write(kHeader.data(), kHeader.size()));
+  EXPECT_EQ(kDataSize - kSkippedBytes, File::CopyFile(source, destination));
+  EXPECT_EQ(static_cast<int64_t>(kHeader.size()),
+            destination->Write(kHeader.data(), kHeader.size()));
+  EXPECT_TRUE(source->Close());
+  EXPECT_TRUE(destination->Close());
+
+  std::string copied_data;
+  ASSERT_TRUE(File::ReadFileToString(kCopyFileName, &copied_data));
+  EXPECT_EQ(kHeader + data_.substr(kSkippedBytes) + kHeader, copied_data);
+  base::DeleteFile(base::FilePath(kCopyFileName), false);
+}
+
 TEST_F(LocalFileTest, WriteRead) {
   // Write file using File API, using file name directly (without prefix).
   File* file = File::Open(kTestLocalFileName, "w");
@@ -118,5 +177,58 @@ TEST_F(LocalFileTest, WriteRead) {
   EXPECT_EQ(data_, read_data);
 }
 
+TEST_F(LocalFileTest, MemoryMappedRead) {
+  ASSERT_EQ(kDataSize,
+            file_util::WriteFile(test_file_path_, data_.data(), kDataSize));
+  const std::string memory_mapped_file_name =
+      std::string(kMemoryMappedFilePrefix) + kTestLocalFileName;
+
+  EXPECT_TRUE(File::Open(memory_mapped_file_name.c_str(), "w") == NULL);
+  File* file = File::Open(memory_mapped_file_name.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_EQ(kDataSize, file->Size());
+  ASSERT_TRUE(file->SupportsReadView());
+
+  // Read the first half by copy and the rest through views.
+  const int kFirstReadBytes = kDataSize / 2;
+  std::string read_data(kFirstReadBytes, 0);
+  EXPECT_EQ(kFirstReadBytes, file->Read(&read_data[0], kFirstReadBytes));
+  EXPECT_FALSE(file->Eof());
+
+  const uint8_t* view = NULL;
+  const int kViewSize = 100;
+  int64_t size;
+  while ((size = file->ReadView(&view, kViewSize)) > 0) {
+    EXPECT_LE(size, kViewSize);
+    read_data.append(reinterpret_cast<const char*>(view), size);
+  }
+  EXPECT_EQ(0, size);
+  EXPECT_TRUE(file->Eof());
+  EXPECT_EQ(data_, read_data);
+
+  // Seek back and read again.
+  const int kSeekPosition = kDataSize / 4;
+  ASSERT_TRUE(file->Seek(kSeekPosition));
+  uint64_t position;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(static_cast<uint64_t>(kSeekPosition), position);
+  EXPECT_EQ(kViewSize, file->ReadView(&view, kViewSize));
+  EXPECT_EQ(data_.substr(kSeekPosition, kViewSize),
+            std::string(reinterpret_cast<const char*>(view), kViewSize));
+  EXPECT_FALSE(file->Seek(kDataSize + 1));
+  EXPECT_TRUE(file->Close());
+}
+
+TEST_F(LocalFileTest, ReadViewNotSupported) {
+  ASSERT_EQ(kDataSize,
+            file_util::WriteFile(test_file_path_, data_.data(), kDataSize));
+  File* file = File::Open(local_file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_FALSE(file->SupportsReadView());
+  const uint8_t* view = NULL;
+  EXPECT_GT(0, file->ReadView(&view, kDataSize));
+  EXPECT_TRUE(file->Close());
+}
+
 }  // namespace media
 }  // namespace edash_packager
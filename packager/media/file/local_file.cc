@@ -64,6 +64,22 @@ bool LocalFile::Eof() {
   return static_cast<bool>(feof(internal_file_));
 }
 
+bool LocalFile::Seek(uint64_t position) {
+  DCHECK(internal_file_ != NULL);
+  return fseeko(internal_file_, position, SEEK_SET) >= 0;
+}
+
+bool LocalFile::Tell(uint64_t* position) {
+  DCHECK(internal_file_ != NULL);
+  DCHECK(position);
+
+  off_t offset = ftello(internal_file_);
+  if (offset < 0)
+    return false;
+  *position = offset;
+  return true;
+}
+
 LocalFile::~LocalFile() {}
 
 bool LocalFile::Open() {
@@ -72,5 +88,10 @@ bool LocalFile::Open() {
   return (internal_file_ != NULL);
 }
 
+int LocalFile::GetFileDescriptor() {
+  DCHECK(internal_file_ != NULL);
+  return fileno(internal_file_);
+}
+
 }  // namespace media
 }  // namespace edash_packager
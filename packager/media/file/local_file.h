@@ -33,12 +33,15 @@ class LocalFile : public File {
   virtual int64_t Size() OVERRIDE;
   virtual bool Flush() OVERRIDE;
   virtual bool Eof() OVERRIDE;
+  virtual bool Seek(uint64_t position) OVERRIDE;
+  virtual bool Tell(uint64_t* position) OVERRIDE;
   /// @}
 
  protected:
   virtual ~LocalFile();
 
   virtual bool Open() OVERRIDE;
+  virtual int GetFileDescriptor() OVERRIDE;
 
  private:
   std::string file_mode_;
@@ -0,0 +1,160 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/file/memory_mapped_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+
+namespace {
+// Size of the range ahead of the file position the kernel is advised to
+// prefetch. The advice is renewed when half of it has been consumed.
+const uint64_t kWillNeedSize = 0x800000;  // 8MB.
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+MemoryMappedFile::MemoryMappedFile(const char* file_name)
+    : File(file_name),
+      fd_(-1),
+      data_(NULL),
+      size_(0),
+      position_(0),
+      will_need_end_(0) {}
+
+bool MemoryMappedFile::Close() {
+  bool result = true;
+  if (data_) {
+    if (munmap(data_, size_) != 0) {
+      PLOG(ERROR) << "Failed to unmap " << file_name();
+      result = false;
+    }
+    data_ = NULL;
+  }
+  if (fd_ >= 0) {
+    if (close(fd_) != 0)
+      result = false;
+    fd_ = -1;
+  }
+  delete this;
+  return result;
+}
+
+int64_t MemoryMappedFile::Read(void* buffer, uint64_t length) {
+  DCHECK(buffer != NULL);
+  const uint8_t* data = NULL;
+  int64_t size = ReadView(&data, length);
+  if (size > 0)
+    memcpy(buffer, data, size);
+  return size;
+}
+
+int64_t MemoryMappedFile::Write(const void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "MemoryMappedFile is read only.";
+  return -1;
+}
+
+int64_t MemoryMappedFile::Size() {
+  return size_;
+}
+
+bool MemoryMappedFile::Flush() {
+  return true;
+}
+
+bool MemoryMappedFile::Eof() {
+  return position_ >= size_;
+}
+
+bool MemoryMappedFile::Seek(uint64_t position) {
+  if (position > size_)
+    return false;
+  position_ = position;
+  // Seeking breaks the sequential pattern; restart prefetching from here.
+  will_need_end_ = position_;
+  return true;
+}
+
+bool MemoryMappedFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_;
+  return true;
+}
+
+bool MemoryMappedFile::SupportsReadView() {
+  return true;
+}
+
+int64_t MemoryMappedFile::ReadView(const uint8_t** data, uint64_t length) {
+  DCHECK(data);
+  *data = data_ + position_;
+  return Advance(length);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+  // Release the resources if Open() failed half way.
+  if (data_)
+    munmap(data_, size_);
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool MemoryMappedFile::Open() {
+  fd_ = open(file_name().c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    PLOG(ERROR) << "Cannot open " << file_name();
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0) {
+    PLOG(ERROR) << "Cannot get the size of " << file_name();
+    return false;
+  }
+  size_ = file_stat.st_size;
+  // Zero-length mappings are not allowed; an empty file is simply at EOF.
+  if (size_ == 0)
+    return true;
+
+  void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (data == MAP_FAILED) {
+    PLOG(ERROR) << "Cannot map " << file_name();
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(data);
+  if (madvise(data_, size_, MADV_SEQUENTIAL) != 0)
+    PLOG(WARNING) << "madvise(MADV_SEQUENTIAL) failed for " << file_name();
+  return true;
+}
+
+uint64_t MemoryMappedFile::Advance(uint64_t length) {
+  DCHECK_LE(position_, size_);
+  length = std::min(length, size_ - position_);
+  position_ += length;
+
+  // Keep the kernel reading ahead of the position.
+  if (will_need_end_ < size_ &&
+      will_need_end_ < position_ + kWillNeedSize / 2) {
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    const uint64_t begin =
+        std::max(will_need_end_, position_) / page_size * page_size;
+    const uint64_t end = std::min(size_, position_ + kWillNeedSize);
+    if (madvise(data_ + begin, end - begin, MADV_WILLNEED) != 0)
+      PLOG(WARNING) << "madvise(MADV_WILLNEED) failed for " << file_name();
+    will_need_end_ = end;
+  }
+  return length;
+}
+
+}  // namespace media
+}  // namespace edash_packager
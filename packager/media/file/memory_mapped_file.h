@@ -0,0 +1,64 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_FILE_MEMORY_MAPPED_FILE_H_
+#define MEDIA_FILE_MEMORY_MAPPED_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/base/compiler_specific.h"
+#include "packager/media/file/file.h"
+
+namespace edash_packager {
+namespace media {
+
+/// Implements MemoryMappedFile, which reads a local file through a read-only
+/// memory mapping. Data can be read without copying through ReadView().
+class MemoryMappedFile : public File {
+ public:
+  /// @param file_name C string containing the name of the file to be accessed.
+  explicit MemoryMappedFile(const char* file_name);
+
+  /// @name File implementation overrides.
+  /// @{
+  virtual bool Close() OVERRIDE;
+  virtual int64_t Read(void* buffer, uint64_t length) OVERRIDE;
+  virtual int64_t Write(const void* buffer, uint64_t length) OVERRIDE;
+  virtual int64_t Size() OVERRIDE;
+  virtual bool Flush() OVERRIDE;
+  virtual bool Eof() OVERRIDE;
+  virtual bool Seek(uint64_t position) OVERRIDE;
+  virtual bool Tell(uint64_t* position) OVERRIDE;
+  virtual bool SupportsReadView() OVERRIDE;
+  virtual int64_t ReadView(const uint8_t** data, uint64_t length) OVERRIDE;
+  /// @}
+
+ protected:
+  virtual ~MemoryMappedFile();
+
+  virtual bool Open() OVERRIDE;
+
+ private:
+  // Advance the file position by up to |length| bytes. Returns the number of
+  // bytes skipped.
+  uint64_t Advance(uint64_t length);
+
+  int fd_;
+  uint8_t* data_;
+  uint64_t size_;
+  uint64_t position_;
+  // End of the range the kernel has been advised to prefetch.
+  uint64_t will_need_end_;
+
+  DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_FILE_MEMORY_MAPPED_FILE_H_
@@ -9,11 +9,15 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <gflags/gflags.h>
+#include <string.h>
 #include <strings.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
@@ -24,6 +28,15 @@ DEFINE_string(udp_interface_address,
               "0.0.0.0",
               "IP address of the interface over which to receive UDP unicast"
               " or multicast streams");
+DEFINE_int32(udp_receive_buffer_size,
+             0,
+             "Size in bytes of the kernel receive buffer (SO_RCVBUF) of UDP"
+             " sockets. Use the system default if 0. On Linux, the size is"
+             " capped by net.core.rmem_max.");
+DEFINE_int32(udp_ring_buffer_size,
+             16 * 1024 * 1024,
+             "Size in bytes of the buffer between the UDP receive thread and"
+             " the reader. Rounded up to a power of two.");
 
 namespace edash_packager {
 namespace media {
@@ -32,6 +45,31 @@ namespace {
 
 const int kInvalidSocket(-1);
 
+// Largest UDP payload over IPv4.
+const size_t kMaxDatagramSize = 65507;
+// Number of datagrams received per recvmmsg call.
+const size_t kReceiveBatchSize = 32;
+// Period at which the receive thread checks whether it should stop.
+const int kReceiveTimeoutInMilliseconds = 100;
+// Minimum interval between two logs of drops or overruns.
+const int kLossLogIntervalInSeconds = 10;
+
+size_t RoundUpToPowerOfTwo(size_t size) {
+  size_t result = 1;
+  while (result < size)
+    result <<= 1;
+  return result;
+}
+
+void AddToCounter(base::subtle::AtomicWord* counter, uint64_t value) {
+  base::subtle::NoBarrier_AtomicIncrement(
+      counter, static_cast<base::subtle::AtomicWord>(value));
+}
+
+uint64_t GetCounter(const base::subtle::AtomicWord* counter) {
+  return static_cast<uintptr_t>(base::subtle::NoBarrier_Load(counter));
+}
+
 bool StringToIpv4Address(const std::string& addr_in, uint32_t* addr_out) {
   DCHECK(addr_out);
 
@@ -81,14 +119,37 @@ bool IsIpv4MulticastAddress(uint32_t addr) {
 
 }  // anonymous namespace
 
+UdpFile::Stats::Stats()
+    : datagrams_received(0),
+      bytes_received(0),
+      datagrams_dropped(0),
+      ring_overruns(0) {}
+
 UdpFile::UdpFile(const char* file_name) :
     File(file_name),
-    socket_(kInvalidSocket) {}
-
-UdpFile::~UdpFile() {}
+    socket_(kInvalidSocket),
+    ring_size_(0),
+    ring_write_pos_(0),
+    ring_read_pos_(0),
+    data_available_(false, false),
+    cancelled_(0),
+    stop_receiving_(0),
+    receive_thread_done_(0),
+    datagrams_received_(0),
+    bytes_received_(0),
+    datagrams_dropped_(0),
+    ring_overruns_(0),
+    logged_datagrams_dropped_(0),
+    logged_ring_overruns_(0) {}
+
+UdpFile::~UdpFile() {
+  StopReceiving();
+}
 
 bool UdpFile::Close() {
+  StopReceiving();
   if (socket_ != kInvalidSocket) {
+    LogLosses(true);
     close(socket_);
     socket_ = kInvalidSocket;
   }
@@ -98,18 +159,39 @@ bool UdpFile::Close() {
 
 int64_t UdpFile::Read(void* buffer, uint64_t length) {
   DCHECK(buffer);
-  DCHECK_GE(length, 65535u)
-      << "Buffer may be too small to read entire datagram.";
 
   if (socket_ == kInvalidSocket)
     return -1;
 
-  int64_t result;
-  do {
-    result = recvfrom(socket_, buffer, length, 0, NULL, 0);
-  } while ((result == -1) && (errno == EINTR));
-
-  return result;
+  while (true) {
+    if (base::subtle::Acquire_Load(&cancelled_))
+      return -1;
+    const size_t write_pos =
+        base::subtle::Acquire_Load(&ring_write_pos_);
+    const size_t read_pos = base::subtle::NoBarrier_Load(&ring_read_pos_);
+    const size_t available = write_pos - read_pos;
+    if (available > 0) {
+      const size_t size =
+          static_cast<size_t>(std::min<uint64_t>(available, length));
+      const size_t offset = read_pos & (ring_size_ - 1);
+      const size_t first_part = std::min(size, ring_size_ - offset);
+      uint8_t* output = reinterpret_cast<uint8_t*>(buffer);
+      memcpy(output, &ring_[offset], first_part);
+      memcpy(output + first_part, &ring_[0], size - first_part);
+      base::subtle::Release_Store(&ring_read_pos_, read_pos + size);
+      return size;
+    }
+    // The ring is checked again after the receive thread exits, as it may
+    // have written data in between.
+    if (base::subtle::Acquire_Load(&receive_thread_done_)) {
+      if (base::subtle::Acquire_Load(&ring_write_pos_) ==
+          base::subtle::NoBarrier_Load(&ring_read_pos_)) {
+        return -1;
+      }
+      continue;
+    }
+    data_available_.Wait();
+  }
 }
 
 int64_t UdpFile::Write(const void* buffer, uint64_t length) {
@@ -133,6 +215,155 @@ bool UdpFile::Eof() {
   return socket_ == kInvalidSocket;
 }
 
+bool UdpFile::Seek(uint64_t position) {
+  // UDP streams are not seekable.
+  return false;
+}
+
+bool UdpFile::Tell(uint64_t* position) {
+  return false;
+}
+
+void UdpFile::Cancel() {
+  base::subtle::Release_Store(&cancelled_, 1);
+  // The receive thread exits within the receive timeout. It is joined by
+  // Close().
+  base::subtle::Release_Store(&stop_receiving_, 1);
+  data_available_.Signal();
+}
+
+UdpFile::Stats UdpFile::GetStats() const {
+  Stats stats;
+  stats.datagrams_received = GetCounter(&datagrams_received_);
+  stats.bytes_received = GetCounter(&bytes_received_);
+  stats.datagrams_dropped = GetCounter(&datagrams_dropped_);
+  stats.ring_overruns = GetCounter(&ring_overruns_);
+  return stats;
+}
+
+bool UdpFile::WriteToRing(const uint8_t* data, size_t size) {
+  const size_t write_pos = base::subtle::NoBarrier_Load(&ring_write_pos_);
+  const size_t read_pos = base::subtle::Acquire_Load(&ring_read_pos_);
+  if (ring_size_ - (write_pos - read_pos) < size)
+    return false;
+  const size_t offset = write_pos & (ring_size_ - 1);
+  const size_t first_part = std::min(size, ring_size_ - offset);
+  memcpy(&ring_[offset], data, first_part);
+  memcpy(&ring_[0], data + first_part, size - first_part);
+  base::subtle::Release_Store(&ring_write_pos_, write_pos + size);
+  return true;
+}
+
+void UdpFile::LogLosses(bool force) {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  if (!force && !last_loss_log_time_.is_null() &&
+      now - last_loss_log_time_ <
+          base::TimeDelta::FromSeconds(kLossLogIntervalInSeconds)) {
+    return;
+  }
+  const Stats stats = GetStats();
+  if (stats.datagrams_dropped == logged_datagrams_dropped_ &&
+      stats.ring_overruns == logged_ring_overruns_) {
+    return;
+  }
+  LOG(WARNING) << "UDP stream " << file_name() << ": "
+               << stats.datagrams_dropped - logged_datagrams_dropped_
+               << " datagrams dropped by the kernel (increase"
+                  " --udp_receive_buffer_size), "
+               << stats.ring_overruns - logged_ring_overruns_
+               << " datagrams discarded on ring buffer overrun (increase"
+                  " --udp_ring_buffer_size). Total received: "
+               << stats.datagrams_received << " datagrams.";
+  logged_datagrams_dropped_ = stats.datagrams_dropped;
+  logged_ring_overruns_ = stats.ring_overruns;
+  last_loss_log_time_ = now;
+}
+
+void UdpFile::StopReceiving() {
+  if (!receive_thread_)
+    return;
+  base::subtle::Release_Store(&stop_receiving_, 1);
+  receive_thread_->Join();
+  receive_thread_.reset();
+}
+
+void UdpFile::Run() {
+#if defined(OS_LINUX)
+  // Datagrams are received in batches into a scratch buffer, then copied to
+  // the ring, since their sizes are not known in advance.
+  std::vector<uint8_t> batch_buffer(kReceiveBatchSize * kMaxDatagramSize);
+  struct mmsghdr messages[kReceiveBatchSize];
+  struct iovec iovecs[kReceiveBatchSize];
+  // Room for the SO_RXQ_OVFL drop counter of each datagram.
+  const size_t kControlSize = CMSG_SPACE(sizeof(uint32_t));
+  std::vector<uint8_t> control_buffer(kReceiveBatchSize * kControlSize);
+#else
+  std::vector<uint8_t> batch_buffer(kMaxDatagramSize);
+#endif
+
+  while (!base::subtle::Acquire_Load(&stop_receiving_)) {
+#if defined(OS_LINUX)
+    for (size_t i = 0; i < kReceiveBatchSize; ++i) {
+      iovecs[i].iov_base = &batch_buffer[i * kMaxDatagramSize];
+      iovecs[i].iov_len = kMaxDatagramSize;
+      memset(&messages[i], 0, sizeof(messages[i]));
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_control = &control_buffer[i * kControlSize];
+      messages[i].msg_hdr.msg_controllen = kControlSize;
+    }
+    // Blocks until at least one datagram is available, or the receive
+    // timeout expires.
+    const int num_messages = recvmmsg(
+        socket_, messages, kReceiveBatchSize, MSG_WAITFORONE, NULL);
+#else
+    int64_t result = recvfrom(
+        socket_, &batch_buffer[0], batch_buffer.size(), 0, NULL, 0);
+    const int num_messages = result < 0 ? -1 : 1;
+#endif
+    if (num_messages < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+        continue;
+      PLOG(ERROR) << "Failed to receive from UDP stream " << file_name();
+      break;
+    }
+
+    for (int i = 0; i < num_messages; ++i) {
+#if defined(OS_LINUX)
+      const uint8_t* data = &batch_buffer[i * kMaxDatagramSize];
+      const size_t size = messages[i].msg_len;
+      struct msghdr* header = &messages[i].msg_hdr;
+      for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(header); cmsg != NULL;
+           cmsg = CMSG_NXTHDR(header, cmsg)) {
+#if defined(SO_RXQ_OVFL)
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SO_RXQ_OVFL) {
+          // Total number of datagrams dropped on this socket so far.
+          uint32_t dropped = 0;
+          memcpy(&dropped, CMSG_DATA(cmsg), sizeof(dropped));
+          base::subtle::NoBarrier_Store(
+              &datagrams_dropped_,
+              static_cast<base::subtle::AtomicWord>(dropped));
+        }
+#endif
+      }
+#else
+      const uint8_t* data = &batch_buffer[0];
+      const size_t size = result;
+#endif
+      AddToCounter(&datagrams_received_, 1);
+      AddToCounter(&bytes_received_, size);
+      if (!WriteToRing(data, size))
+        AddToCounter(&ring_overruns_, 1);
+    }
+    data_available_.Signal();
+    LogLosses(false);
+  }
+
+  base::subtle::Release_Store(&receive_thread_done_, 1);
+  data_available_.Signal();
+}
+
 class ScopedSocket {
  public:
   explicit ScopedSocket(int sock_fd)
@@ -157,23 +388,21 @@ class ScopedSocket {
   DISALLOW_COPY_AND_ASSIGN(ScopedSocket);
 };
 
-bool UdpFile::Open() {
-  DCHECK_EQ(kInvalidSocket, socket_);
-
+int UdpFile::OpenSocket(const std::string& address_and_port) {
   // TODO(tinskip): Support IPv6 addresses.
   uint32_t dest_addr;
   uint16_t dest_port;
-  if (!StringToIpv4AddressAndPort(file_name(),
+  if (!StringToIpv4AddressAndPort(address_and_port,
                                   &dest_addr,
                                   &dest_port)) {
     LOG(ERROR) << "Malformed IPv4 address:port UDP stream specifier.";
-    return false;
+    return kInvalidSocket;
   }
 
   ScopedSocket new_socket(socket(AF_INET, SOCK_DGRAM, 0));
   if (new_socket.get() == kInvalidSocket) {
     LOG(ERROR) << "Could not allocate socket.";
-    return false;
+    return kInvalidSocket;
   }
 
   struct sockaddr_in local_sock_addr;
@@ -185,14 +414,14 @@ bool UdpFile::Open() {
            reinterpret_cast<struct sockaddr*>(&local_sock_addr),
            sizeof(local_sock_addr))) {
     LOG(ERROR) << "Could not bind UDP socket";
-    return false;
+    return kInvalidSocket;
   }
 
   if (IsIpv4MulticastAddress(dest_addr)) {
     uint32_t if_addr;
     if (!StringToIpv4Address(FLAGS_udp_interface_address, &if_addr)) {
       LOG(ERROR) << "Malformed IPv4 address for interface.";
-      return false;
+      return kInvalidSocket;
     }
     struct ip_mreq multicast_group;
     multicast_group.imr_multiaddr.s_addr = htonl(dest_addr);
@@ -203,11 +432,84 @@ bool UdpFile::Open() {
                    &multicast_group,
                    sizeof(multicast_group)) < 0) {
       LOG(ERROR) << "Failed to join multicast group.";
-      return false;
+      return kInvalidSocket;
+    }
+  }
+
+  if (FLAGS_udp_receive_buffer_size > 0) {
+    const int receive_buffer_size = FLAGS_udp_receive_buffer_size;
+    if (setsockopt(new_socket.get(),
+                   SOL_SOCKET,
+                   SO_RCVBUF,
+                   &receive_buffer_size,
+                   sizeof(receive_buffer_size)) < 0) {
+      LOG(ERROR) << "Failed to set the UDP socket receive buffer size.";
+      return kInvalidSocket;
+    }
+    // The kernel silently caps the size. Linux reports twice the usable
+    // size, to account for its bookkeeping overhead.
+    int actual_size = 0;
+    socklen_t actual_size_length = sizeof(actual_size);
+    if (getsockopt(new_socket.get(),
+                   SOL_SOCKET,
+                   SO_RCVBUF,
+                   &actual_size,
+                   &actual_size_length) == 0) {
+#if defined(OS_LINUX)
+      actual_size /= 2;
+#endif
+      LOG_IF(WARNING, actual_size < receive_buffer_size)
+          << "UDP socket receive buffer size limited to " << actual_size
+          << " bytes instead of " << receive_buffer_size
+          << ". Raise the system limit (net.core.rmem_max on Linux).";
     }
   }
 
+#if defined(SO_RXQ_OVFL)
+  // Have the kernel report the number of datagrams it dropped.
+  const int enable = 1;
+  if (setsockopt(new_socket.get(),
+                 SOL_SOCKET,
+                 SO_RXQ_OVFL,
+                 &enable,
+                 sizeof(enable)) < 0) {
+    LOG(WARNING) << "Drops of UDP datagrams by the kernel cannot be counted.";
+  }
+#endif
+
+  return new_socket.release();
+}
+
+bool UdpFile::Open() {
+  DCHECK_EQ(kInvalidSocket, socket_);
+
+  ScopedSocket new_socket(OpenSocket(file_name()));
+  if (new_socket.get() == kInvalidSocket)
+    return false;
+
+  // The receive thread wakes up periodically to check whether it should
+  // stop.
+  struct timeval receive_timeout;
+  receive_timeout.tv_sec = 0;
+  receive_timeout.tv_usec = kReceiveTimeoutInMilliseconds * 1000;
+  if (setsockopt(new_socket.get(),
+                 SOL_SOCKET,
+                 SO_RCVTIMEO,
+                 &receive_timeout,
+                 sizeof(receive_timeout)) < 0) {
+    LOG(ERROR) << "Failed to set the UDP socket receive timeout.";
+    return false;
+  }
+
+  ring_size_ = RoundUpToPowerOfTwo(
+      std::max(static_cast<size_t>(std::max(FLAGS_udp_ring_buffer_size, 0)),
+               2 * kMaxDatagramSize));
+  ring_.reset(new uint8_t[ring_size_]);
+
   socket_ = new_socket.release();
+  receive_thread_.reset(
+      new base::DelegateSimpleThread(this, "UdpFileReceiveThread"));
+  receive_thread_->Start();
   return true;
 }
 
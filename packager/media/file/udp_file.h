@@ -11,15 +11,40 @@
 
 #include <string>
 
+#include "packager/base/atomicops.h"
 #include "packager/base/compiler_specific.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/base/time/time.h"
 #include "packager/media/file/file.h"
 
 namespace edash_packager {
 namespace media {
 
 /// Implements UdpFile, which receives UDP unicast and multicast streams.
-class UdpFile : public File {
+/// Datagrams are received in batches on a dedicated thread, into a ring
+/// buffer which Read() drains, so that the socket keeps being emptied while
+/// the reader is busy. Read() returns the received payload as a byte stream,
+/// datagram boundaries are not preserved.
+class UdpFile : public File, public base::DelegateSimpleThread::Delegate {
  public:
+  /// Receive statistics.
+  struct Stats {
+    Stats();
+
+    /// Number of datagrams received from the socket.
+    uint64_t datagrams_received;
+    /// Number of payload bytes received from the socket.
+    uint64_t bytes_received;
+    /// Number of datagrams dropped by the kernel because the socket receive
+    /// buffer was full. Only reported on Linux.
+    uint64_t datagrams_dropped;
+    /// Number of datagrams discarded because the ring buffer was full, i.e.
+    /// the reader did not keep up.
+    uint64_t ring_overruns;
+  };
+
   /// @param file_name C string containing the address of the stream to receive.
   ///        It should be of the form "<ip_address>:<port>".
   explicit UdpFile(const char* address_and_port);
@@ -32,16 +57,67 @@ class UdpFile : public File {
   virtual int64_t Size() OVERRIDE;
   virtual bool Flush() OVERRIDE;
   virtual bool Eof() OVERRIDE;
+  virtual bool Seek(uint64_t position) OVERRIDE;
+  virtual bool Tell(uint64_t* position) OVERRIDE;
+  virtual void Cancel() OVERRIDE;
   /// @}
 
+  /// @return The receive statistics so far. Can be called from any thread.
+  Stats GetStats() const;
+
+  /// Open a socket receiving a UDP stream, bound to its port and joined to
+  /// its multicast group if the address is a multicast address. The receive
+  /// buffer size is set from --udp_receive_buffer_size.
+  /// @param address_and_port is of the form "<ip_address>:<port>".
+  /// @return The socket on success, -1 otherwise.
+  static int OpenSocket(const std::string& address_and_port);
+
  protected:
   virtual ~UdpFile();
 
   virtual bool Open() OVERRIDE;
 
  private:
+  // base::DelegateSimpleThread::Delegate implementation. Receive loop.
+  virtual void Run() OVERRIDE;
+
+  // Appends a datagram to the ring buffer. Called on the receive thread.
+  // Returns false if there is not enough room for the whole datagram, in
+  // which case nothing is written.
+  bool WriteToRing(const uint8_t* data, size_t size);
+  // Logs the drops and overruns, at most once per interval.
+  void LogLosses(bool force);
+  // Stops and joins the receive thread.
+  void StopReceiving();
+
   int socket_;
 
+  // Single producer, single consumer ring buffer. The positions only grow
+  // (modulo the word size) and each one is only written by one side: the
+  // write position by the receive thread and the read position by Read().
+  scoped_ptr<uint8_t[]> ring_;
+  size_t ring_size_;  // Power of two.
+  base::subtle::AtomicWord ring_write_pos_;
+  base::subtle::AtomicWord ring_read_pos_;
+  // Signaled by the receive thread after each batch, and when it exits, and
+  // by Cancel().
+  base::WaitableEvent data_available_;
+
+  base::subtle::Atomic32 cancelled_;
+  base::subtle::Atomic32 stop_receiving_;
+  base::subtle::Atomic32 receive_thread_done_;
+  scoped_ptr<base::DelegateSimpleThread> receive_thread_;
+
+  // Counters, only written by the receive thread.
+  base::subtle::AtomicWord datagrams_received_;
+  base::subtle::AtomicWord bytes_received_;
+  base::subtle::AtomicWord datagrams_dropped_;
+  base::subtle::AtomicWord ring_overruns_;
+  // Values last logged by LogLosses(), and when.
+  uint64_t logged_datagrams_dropped_;
+  uint64_t logged_ring_overruns_;
+  base::TimeTicks last_loss_log_time_;
+
   DISALLOW_COPY_AND_ASSIGN(UdpFile);
 };
 
@@ -0,0 +1,208 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <arpa/inet.h>
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/base/threading/simple_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/udp_file.h"
+
+DECLARE_int32(udp_receive_buffer_size);
+DECLARE_int32(udp_ring_buffer_size);
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+const size_t kDatagramSize = 7 * 188;
+const int kReceiveTimeoutInSeconds = 10;
+const int kBlockedReadDelayInMilliseconds = 200;
+
+// Reads once from a file on its own thread.
+class ReaderThreadDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit ReaderThreadDelegate(File* file) : file_(file), result_(0) {}
+  virtual ~ReaderThreadDelegate() {}
+
+  virtual void Run() OVERRIDE {
+    char buffer[kDatagramSize];
+    result_ = file_->Read(buffer, sizeof(buffer));
+  }
+
+  int64_t result() const { return result_; }
+
+ private:
+  File* file_;
+  int64_t result_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReaderThreadDelegate);
+};
+}  // namespace
+
+class UdpFileTest : public testing::Test {
+ public:
+  UdpFileTest() : send_socket_(-1) {}
+
+ protected:
+  virtual void SetUp() OVERRIDE {
+    send_socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, send_socket_);
+
+    // Find a free port by binding to port 0.
+    bzero(&address_, sizeof(address_));
+    address_.sin_family = AF_INET;
+    address_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const int probe_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(-1, probe_socket);
+    socklen_t address_length = sizeof(address_);
+    ASSERT_EQ(0, bind(probe_socket,
+                      reinterpret_cast<struct sockaddr*>(&address_),
+                      sizeof(address_)));
+    ASSERT_EQ(0, getsockname(probe_socket,
+                             reinterpret_cast<struct sockaddr*>(&address_),
+                             &address_length));
+    close(probe_socket);
+
+    file_name_ = std::string(kUdpFilePrefix) + "127.0.0.1:" +
+                 base::UintToString(ntohs(address_.sin_port));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    if (send_socket_ != -1)
+      close(send_socket_);
+  }
+
+  // Sends |num_datagrams| datagrams, the bytes of each datagram following
+  // the bytes of the previous one.
+  void SendDatagrams(size_t num_datagrams) {
+    std::string datagram(kDatagramSize, 0);
+    for (size_t i = 0; i < num_datagrams; ++i) {
+      for (size_t j = 0; j < kDatagramSize; ++j)
+        datagram[j] = (i * kDatagramSize + j) % 251;
+      ASSERT_EQ(static_cast<ssize_t>(kDatagramSize),
+                sendto(send_socket_, datagram.data(), datagram.size(), 0,
+                       reinterpret_cast<struct sockaddr*>(&address_),
+                       sizeof(address_)));
+    }
+  }
+
+  // Waits until |num_datagrams| datagrams have been received or dropped.
+  bool WaitForDatagrams(UdpFile* file, uint64_t num_datagrams) {
+    const base::TimeTicks deadline =
+        base::TimeTicks::Now() +
+        base::TimeDelta::FromSeconds(kReceiveTimeoutInSeconds);
+    while (base::TimeTicks::Now() < deadline) {
+      const UdpFile::Stats stats = file->GetStats();
+      if (stats.datagrams_received + stats.datagrams_dropped >= num_datagrams)
+        return true;
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+    }
+    return false;
+  }
+
+  int send_socket_;
+  struct sockaddr_in address_;
+  std::string file_name_;
+};
+
+TEST_F(UdpFileTest, Read) {
+  File* file = File::Open(file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  UdpFile* udp_file = static_cast<UdpFile*>(file);
+
+  const size_t kNumDatagrams = 20;
+  SendDatagrams(kNumDatagrams);
+  ASSERT_TRUE(WaitForDatagrams(udp_file, kNumDatagrams));
+
+  // Datagram boundaries are not preserved, the bytes are read in order.
+  std::string read_data;
+  const size_t kReadSize = 1000;
+  std::string buffer(kReadSize, 0);
+  while (read_data.size() < kNumDatagrams * kDatagramSize) {
+    const int64_t size = file->Read(&buffer[0], kReadSize);
+    ASSERT_GT(size, 0);
+    read_data.append(buffer, 0, size);
+  }
+  ASSERT_EQ(kNumDatagrams * kDatagramSize, read_data.size());
+  for (size_t i = 0; i < read_data.size(); ++i)
+    ASSERT_EQ(static_cast<char>(i % 251), read_data[i]) << "at " << i;
+
+  const UdpFile::Stats stats = udp_file->GetStats();
+  EXPECT_EQ(kNumDatagrams, stats.datagrams_received);
+  EXPECT_EQ(kNumDatagrams * kDatagramSize, stats.bytes_received);
+  EXPECT_EQ(0u, stats.ring_overruns);
+  EXPECT_TRUE(file->Close());
+}
+
+TEST_F(UdpFileTest, RingOverrun) {
+  const int kRingBufferSize = 256 * 1024;
+  const int kReceiveBufferSize = 4 * 1024 * 1024;
+  const int saved_ring_buffer_size = FLAGS_udp_ring_buffer_size;
+  const int saved_receive_buffer_size = FLAGS_udp_receive_buffer_size;
+  FLAGS_udp_ring_buffer_size = kRingBufferSize;
+  FLAGS_udp_receive_buffer_size = kReceiveBufferSize;
+  File* file = File::Open(file_name_.c_str(), "r");
+  FLAGS_udp_ring_buffer_size = saved_ring_buffer_size;
+  FLAGS_udp_receive_buffer_size = saved_receive_buffer_size;
+  ASSERT_TRUE(file != NULL);
+  UdpFile* udp_file = static_cast<UdpFile*>(file);
+
+  // Twice the ring buffer size, without reading.
+  const size_t kNumDatagrams = 2 * kRingBufferSize / kDatagramSize;
+  SendDatagrams(kNumDatagrams);
+  ASSERT_TRUE(WaitForDatagrams(udp_file, kNumDatagrams));
+
+  const UdpFile::Stats stats = udp_file->GetStats();
+  EXPECT_GT(stats.ring_overruns, 0u);
+  EXPECT_LE(stats.ring_overruns, stats.datagrams_received);
+
+  // Only whole datagrams are kept in the ring buffer.
+  const size_t kept_size =
+      (stats.datagrams_received - stats.ring_overruns) * kDatagramSize;
+  std::string buffer(kept_size, 0);
+  size_t read_size = 0;
+  while (read_size < kept_size) {
+    const int64_t size = file->Read(&buffer[read_size], kept_size - read_size);
+    ASSERT_GT(size, 0);
+    read_size += size;
+  }
+  EXPECT_EQ(0, buffer[0]);
+  EXPECT_TRUE(file->Close());
+}
+
+// Cancel() makes a read blocked on a silent stream fail, as well as the
+// following reads.
+TEST_F(UdpFileTest, CancelBlockedRead) {
+  File* file = File::Open(file_name_.c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+
+  ReaderThreadDelegate reader(file);
+  base::DelegateSimpleThread reader_thread(&reader, "UdpFileReader");
+  reader_thread.Start();
+  // Nothing is sent: let the read block.
+  base::PlatformThread::Sleep(
+      base::TimeDelta::FromMilliseconds(kBlockedReadDelayInMilliseconds));
+  file->Cancel();
+  reader_thread.Join();
+  EXPECT_LT(reader.result(), 0);
+
+  char buffer[kDatagramSize];
+  EXPECT_LT(file->Read(buffer, sizeof(buffer)), 0);
+  EXPECT_TRUE(file->Close());
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -19,6 +19,8 @@
         'h264_byte_to_unit_stream_converter.h',
         'h264_parser.cc',
         'h264_parser.h',
+        'start_code_scanner.cc',
+        'start_code_scanner.h',
       ],
       'dependencies': [
         '../../base/base.gyp:base',
@@ -31,6 +33,7 @@
         'h264_bit_reader_unittest.cc',
         'h264_byte_to_unit_stream_converter_unittest.cc',
         'h264_parser_unittest.cc',
+        'start_code_scanner_unittest.cc',
       ],
       'dependencies': [
         '../../media/base/media_base.gyp:base',
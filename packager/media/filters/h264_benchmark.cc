@@ -0,0 +1,177 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/filters/h264_byte_to_unit_stream_converter.h"
+#include "packager/media/filters/h264_parser.h"
+#include "packager/media/filters/start_code_scanner.h"
+#include "packager/media/test/benchmark_util.h"
+
+namespace {
+
+const uint8_t kStartCode[] = {0x00, 0x00, 0x00, 0x01};
+// nal_ref_idc = 1, nal_unit_type = 1 (coded slice of a non-IDR picture).
+const uint8_t kSliceNaluHeader = 0x21;
+const size_t kNaluPayloadSize = 16 * 1024;
+const size_t kNumNalus = 64;
+
+// The byte by byte loop H264Parser::FindStartCode used to run, as a point of
+// comparison for the start code scanners.
+size_t FindStartCodePrefixByteByByte(const uint8_t* data, size_t size) {
+  for (size_t pos = 0; pos + 3 <= size; ++pos) {
+    if (data[pos] == 0x00 && data[pos + 1] == 0x00 && data[pos + 2] == 0x01)
+      return pos;
+  }
+  return size;
+}
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+class H264Benchmark : public ::testing::Test {
+ public:
+  H264Benchmark() {
+    // Annex-B stream of slices. The payload has no zero byte, thus no start
+    // code emulation; the scanners have to go over every byte.
+    std::vector<uint8_t> payload = GenerateSyntheticData(kNaluPayloadSize);
+    for (size_t i = 0; i < payload.size(); ++i) {
+      if (payload[i] == 0)
+        payload[i] = 1;
+    }
+    for (size_t i = 0; i < kNumNalus; ++i) {
+      byte_stream_.insert(byte_stream_.end(), kStartCode,
+                          kStartCode + arraysize(kStartCode));
+      byte_stream_.push_back(kSliceNaluHeader);
+      byte_stream_.insert(byte_stream_.end(), payload.begin(), payload.end());
+    }
+  }
+
+  void FindStartCodes() {
+    const uint8_t* data = &byte_stream_[0];
+    off_t size = byte_stream_.size();
+    size_t num_start_codes = 0;
+    off_t offset = 0;
+    off_t start_code_size = 0;
+    while (H264Parser::FindStartCode(data, size, &offset, &start_code_size)) {
+      ++num_start_codes;
+      data += offset + start_code_size;
+      size -= offset + start_code_size;
+    }
+    ASSERT_EQ(kNumNalus, num_start_codes);
+  }
+
+  typedef size_t (*StartCodePrefixFinder)(const uint8_t* data, size_t size);
+
+  void FindStartCodePrefixes(StartCodePrefixFinder finder) {
+    const uint8_t* data = &byte_stream_[0];
+    size_t size = byte_stream_.size();
+    size_t num_start_codes = 0;
+    while (true) {
+      const size_t offset = finder(data, size);
+      if (offset == size)
+        break;
+      ++num_start_codes;
+      data += offset + 3;
+      size -= offset + 3;
+    }
+    ASSERT_EQ(kNumNalus, num_start_codes);
+  }
+
+  void AdvanceToNextNalus() {
+    H264Parser parser;
+    parser.SetStream(&byte_stream_[0], byte_stream_.size());
+    size_t num_nalus = 0;
+    H264NALU nalu;
+    while (parser.AdvanceToNextNALU(&nalu) == H264Parser::kOk)
+      ++num_nalus;
+    ASSERT_EQ(kNumNalus, num_nalus);
+  }
+
+  void ConvertByteStream() {
+    ASSERT_TRUE(converter_.ConvertByteStreamToNalUnitStream(
+        &byte_stream_[0], byte_stream_.size(), &unit_stream_));
+  }
+
+  // Converts the NAL units located by H264Parser beforehand, as
+  // EsParserH264 does.
+  void ConvertNalus() {
+    const size_t size = H264ByteToUnitStreamConverter::GetNalUnitStreamSize(
+        &nalus_[0], nalus_.size());
+    unit_stream_.resize(size);
+    converter_.ConvertNalusToNalUnitStream(
+        &nalus_[0], nalus_.size(), &unit_stream_[0]);
+  }
+
+ protected:
+  std::vector<uint8_t> byte_stream_;
+  std::vector<uint8_t> unit_stream_;
+  std::vector<H264NALU> nalus_;
+  H264ByteToUnitStreamConverter converter_;
+};
+
+TEST_F(H264Benchmark, FindStartCode) {
+  RunThroughputBenchmark(
+      "H264ParserFindStartCode",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::FindStartCodes, base::Unretained(this)));
+}
+
+TEST_F(H264Benchmark, FindStartCodePrefix) {
+  RunThroughputBenchmark(
+      "StartCodePrefixByteByByte",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::FindStartCodePrefixes,
+                 base::Unretained(this),
+                 &FindStartCodePrefixByteByByte));
+  RunThroughputBenchmark(
+      "StartCodePrefixScalar",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::FindStartCodePrefixes,
+                 base::Unretained(this),
+                 &FindStartCodePrefixScalar));
+  RunThroughputBenchmark(
+      "StartCodePrefix",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::FindStartCodePrefixes,
+                 base::Unretained(this),
+                 &FindStartCodePrefix));
+}
+
+TEST_F(H264Benchmark, AdvanceToNextNALU) {
+  RunThroughputBenchmark(
+      "H264ParserAdvanceToNextNALU",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::AdvanceToNextNalus, base::Unretained(this)));
+}
+
+TEST_F(H264Benchmark, ConvertByteStreamToNalUnitStream) {
+  RunThroughputBenchmark(
+      "H264ByteToUnitStreamConverter",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::ConvertByteStream, base::Unretained(this)));
+}
+
+TEST_F(H264Benchmark, ConvertNalusToNalUnitStream) {
+  H264Parser parser;
+  parser.SetStream(&byte_stream_[0], byte_stream_.size());
+  H264NALU nalu;
+  while (parser.AdvanceToNextNALU(&nalu) == H264Parser::kOk)
+    nalus_.push_back(nalu);
+  ASSERT_EQ(kNumNalus, nalus_.size());
+
+  RunThroughputBenchmark(
+      "H264ConvertNalusToNalUnitStream",
+      byte_stream_.size(),
+      base::Bind(&H264Benchmark::ConvertNalus, base::Unretained(this)));
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -6,6 +6,8 @@
 
 #include "packager/media/filters/h264_byte_to_unit_stream_converter.h"
 
+#include <string.h>
+
 #include "packager/base/logging.h"
 #include "packager/media/base/buffer_writer.h"
 #include "packager/media/filters/h264_parser.h"
@@ -17,6 +19,14 @@ namespace {
 // Additional space to reserve for output frame. This value ought to be enough
 // to acommodate frames consisting of 100 NAL units with 3-byte start codes.
 const size_t kStreamConversionOverhead = 100;
+
+// Returns whether a NAL unit of type |nalu_type| is kept in the converted
+// frame. SPS and PPS NAL units go to the decoder configuration record instead,
+// and AUD NAL units are dropped.
+bool IsCopiedToUnitStream(int nalu_type) {
+  return nalu_type != H264NALU::kSPS && nalu_type != H264NALU::kPPS &&
+         nalu_type != H264NALU::kAUD;
+}
 }
 
 H264ByteToUnitStreamConverter::H264ByteToUnitStreamConverter() {}
@@ -30,7 +40,10 @@ bool H264ByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
   DCHECK(input_frame);
   DCHECK(output_frame);
 
-  BufferWriter output_buffer(input_frame_size + kStreamConversionOverhead);
+  // The NAL units are appended to |output_frame| directly rather than to a
+  // BufferWriter, which would need to copy them out again.
+  output_frame->clear();
+  output_frame->reserve(input_frame_size + kStreamConversionOverhead);
 
   const uint8_t* input_ptr(input_frame);
   const uint8_t* input_end(input_ptr + input_frame_size);
@@ -48,7 +61,7 @@ bool H264ByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
       }
       first_nalu = false;
     } else {
-      ProcessNalu(input_ptr, next_start_code_offset, &output_buffer);
+      ProcessNalu(input_ptr, next_start_code_offset, output_frame);
     }
     input_ptr += next_start_code_offset + next_start_code_size;
   }
@@ -57,43 +70,92 @@ bool H264ByteToUnitStreamConverter::ConvertByteStreamToNalUnitStream(
     LOG(ERROR) << "H.264 byte stream frame did not contain start codes.";
     return false;
   } else {
-    ProcessNalu(input_ptr, input_end - input_ptr, &output_buffer);
+    ProcessNalu(input_ptr, input_end - input_ptr, output_frame);
   }
 
-  output_buffer.SwapBuffer(output_frame);
   return true;
 }
 
-void H264ByteToUnitStreamConverter::ProcessNalu(const uint8_t* nalu_ptr,
-                                                size_t nalu_size,
-                                                BufferWriter* output_buffer) {
+void H264ByteToUnitStreamConverter::ProcessNalu(
+    const uint8_t* nalu_ptr,
+    size_t nalu_size,
+    std::vector<uint8_t>* output_frame) {
   DCHECK(nalu_ptr);
-  DCHECK(output_buffer);
+  DCHECK(output_frame);
 
   if (!nalu_size)
     return;  // Edge case.
 
-  uint8_t nalu_type = *nalu_ptr & 0x0f;
+  const int nalu_type = *nalu_ptr & 0x1f;
+  RecordParameterSet(nalu_type, nalu_ptr, nalu_size);
+  if (!IsCopiedToUnitStream(nalu_type))
+    return;
+
+  // Append 4-byte big-endian length and NAL unit data to the frame.
+  const uint32_t length = static_cast<uint32_t>(nalu_size);
+  const uint8_t length_bytes[kUnitStreamNaluLengthSize] = {
+      static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+      static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+  output_frame->insert(output_frame->end(), length_bytes,
+                       length_bytes + sizeof(length_bytes));
+  output_frame->insert(output_frame->end(), nalu_ptr, nalu_ptr + nalu_size);
+}
+
+// static
+size_t H264ByteToUnitStreamConverter::GetNalUnitStreamSize(
+    const H264NALU* nalus,
+    size_t num_nalus) {
+  size_t size = 0;
+  for (size_t i = 0; i < num_nalus; ++i) {
+    if (nalus[i].size > 0 && IsCopiedToUnitStream(nalus[i].nal_unit_type))
+      size += kUnitStreamNaluLengthSize + nalus[i].size;
+  }
+  return size;
+}
+
+void H264ByteToUnitStreamConverter::ConvertNalusToNalUnitStream(
+    const H264NALU* nalus,
+    size_t num_nalus,
+    uint8_t* output_frame) {
+  DCHECK(nalus || num_nalus == 0);
+  DCHECK(output_frame || GetNalUnitStreamSize(nalus, num_nalus) == 0);
+
+  uint8_t* output_ptr = output_frame;
+  for (size_t i = 0; i < num_nalus; ++i) {
+    const H264NALU& nalu = nalus[i];
+    if (nalu.size <= 0)
+      continue;
+    RecordParameterSet(nalu.nal_unit_type, nalu.data, nalu.size);
+    if (!IsCopiedToUnitStream(nalu.nal_unit_type))
+      continue;
+
+    // 4-byte big-endian length, then the NAL unit data.
+    const uint32_t nalu_size = static_cast<uint32_t>(nalu.size);
+    output_ptr[0] = static_cast<uint8_t>(nalu_size >> 24);
+    output_ptr[1] = static_cast<uint8_t>(nalu_size >> 16);
+    output_ptr[2] = static_cast<uint8_t>(nalu_size >> 8);
+    output_ptr[3] = static_cast<uint8_t>(nalu_size);
+    output_ptr += kUnitStreamNaluLengthSize;
+    memcpy(output_ptr, nalu.data, nalu_size);
+    output_ptr += nalu_size;
+  }
+}
+
+void H264ByteToUnitStreamConverter::RecordParameterSet(int nalu_type,
+                                                       const uint8_t* nalu_ptr,
+                                                       size_t nalu_size) {
   switch (nalu_type) {
     case H264NALU::kSPS:
       // Grab SPS NALU.
       last_sps_.assign(nalu_ptr, nalu_ptr + nalu_size);
-      return;
+      break;
     case H264NALU::kPPS:
       // Grab PPS NALU.
       last_pps_.assign(nalu_ptr, nalu_ptr + nalu_size);
-      return;
-    case H264NALU::kAUD:
-      // Ignore AUD NALU.
-      return;
+      break;
     default:
-      // Copy all other NALUs.
       break;
   }
-
-  // Append 4-byte length and NAL unit data to the buffer.
-  output_buffer->AppendInt(static_cast<uint32_t>(nalu_size));
-  output_buffer->AppendArray(nalu_ptr, nalu_size);
 }
 
 bool H264ByteToUnitStreamConverter::GetAVCDecoderConfigurationRecord(
@@ -15,7 +15,7 @@
 namespace edash_packager {
 namespace media {
 
-class BufferWriter;
+struct H264NALU;
 
 /// Class which converts H.264 byte streams (as specified in ISO/IEC 14496-10
 /// Annex B) into H.264 NAL unit streams (as specified in ISO/IEC 14496-15).
@@ -38,6 +38,23 @@ class H264ByteToUnitStreamConverter {
                                         size_t input_frame_size,
                                         std::vector<uint8_t>* output_frame);
 
+  /// Computes the size of an access unit once converted to NAL unit stream
+  /// format, from the NAL units H264Parser located in it.
+  /// @param nalus points to the NAL units of the access unit, in order.
+  /// @param num_nalus is the number of NAL units.
+  /// @return The size of the converted access unit, in bytes.
+  static size_t GetNalUnitStreamSize(const H264NALU* nalus, size_t num_nalus);
+
+  /// Converts an access unit to NAL unit stream format, from the NAL units
+  /// H264Parser located in it, without scanning the data again.
+  /// @param nalus points to the NAL units of the access unit, in order.
+  /// @param num_nalus is the number of NAL units.
+  /// @param output_frame points to a buffer of the size returned by
+  ///        GetNalUnitStreamSize(), which receives the converted access unit.
+  void ConvertNalusToNalUnitStream(const H264NALU* nalus,
+                                   size_t num_nalus,
+                                   uint8_t* output_frame);
+
   /// Synthesizes an AVCDecoderConfigurationRecord from the SPS and PPS NAL
   /// units extracted from the AVC byte stream.
   /// @param decoder_config is a pointer to a vector, which on successful
@@ -48,7 +65,11 @@ class H264ByteToUnitStreamConverter {
  private:
   void ProcessNalu(const uint8_t* nalu_ptr,
                    size_t nalu_size,
-                   BufferWriter* output_buffer);
+                   std::vector<uint8_t>* output_frame);
+  // Keeps a copy of the NAL unit if it is an SPS or a PPS.
+  void RecordParameterSet(int nalu_type,
+                          const uint8_t* nalu_ptr,
+                          size_t nalu_size);
 
   std::vector<uint8_t> last_sps_;
   std::vector<uint8_t> last_pps_;
@@ -9,6 +9,7 @@
 
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/media/filters/h264_byte_to_unit_stream_converter.h"
+#include "packager/media/filters/h264_parser.h"
 #include "packager/media/test/test_data_util.h"
 
 namespace {
@@ -44,6 +45,40 @@ TEST(H264ByteToUnitStreamConverter, ConversionSuccess) {
   EXPECT_EQ(expected_decoder_config, decoder_config);
 }
 
+TEST(H264ByteToUnitStreamConverter, ConvertNalusToNalUnitStream) {
+  std::vector<uint8_t> input_frame =
+      ReadTestDataFile("avc-byte-stream-frame.h264");
+  ASSERT_FALSE(input_frame.empty());
+
+  std::vector<uint8_t> expected_output_frame =
+      ReadTestDataFile("avc-unit-stream-frame.h264");
+  ASSERT_FALSE(expected_output_frame.empty());
+
+  H264Parser parser;
+  parser.SetStream(input_frame.data(), input_frame.size());
+  std::vector<H264NALU> nalus;
+  H264NALU nalu;
+  while (parser.AdvanceToNextNALU(&nalu) == H264Parser::kOk)
+    nalus.push_back(nalu);
+  ASSERT_FALSE(nalus.empty());
+
+  ASSERT_EQ(expected_output_frame.size(),
+            H264ByteToUnitStreamConverter::GetNalUnitStreamSize(
+                &nalus[0], nalus.size()));
+  H264ByteToUnitStreamConverter converter;
+  std::vector<uint8_t> output_frame(expected_output_frame.size());
+  converter.ConvertNalusToNalUnitStream(&nalus[0], nalus.size(),
+                                        &output_frame[0]);
+  EXPECT_EQ(expected_output_frame, output_frame);
+
+  std::vector<uint8_t> expected_decoder_config;
+  ASSERT_TRUE(base::HexStringToBytes(kExpectedConfigRecord,
+                                     &expected_decoder_config));
+  std::vector<uint8_t> decoder_config;
+  ASSERT_TRUE(converter.GetAVCDecoderConfigurationRecord(&decoder_config));
+  EXPECT_EQ(expected_decoder_config, decoder_config);
+}
+
 TEST(H264ByteToUnitStreamConverter, ConversionFailure) {
   std::vector<uint8_t> input_frame(100, 0);
 
@@ -271,6 +271,7 @@ class H264Parser {
   // If no start code is found, offset is pointing to the first unprocessed byte
   // (i.e. the first byte that was not considered as a possible start of a start
   // code) and |*start_code_size| is set to 0.
+  // The data is scanned with FindStartCodePrefix(), vectorized when possible.
   // Preconditions:
   // - |data_size| >= 0
   // Postconditions:
@@ -0,0 +1,89 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/filters/start_code_scanner.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+// Size of the start code prefix, i.e. 00 00 01.
+const size_t kPrefixSize = 3;
+
+#if defined(__SSE2__)
+// Number of positions tested per step.
+const size_t kSimdWidth = 16;
+
+int CountTrailingZeros(unsigned int value) {
+#if defined(__GNUC__)
+  return __builtin_ctz(value);
+#else
+  int count = 0;
+  while (!(value & 1)) {
+    value >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+#endif  // defined(__SSE2__)
+
+}  // namespace
+
+size_t FindStartCodePrefixScalar(const uint8_t* data, size_t size) {
+  size_t pos = 0;
+  while (pos + kPrefixSize <= size) {
+    const uint8_t third = data[pos + 2];
+    if (third > 1) {
+      // The prefix cannot start at |pos|, |pos| + 1 or |pos| + 2, which all
+      // need a 0 or 1 in this position.
+      pos += 3;
+    } else if (third == 1) {
+      if (data[pos] == 0 && data[pos + 1] == 0)
+        return pos;
+      // A prefix starting at |pos| + 1 or |pos| + 2 needs a 0 here.
+      pos += 3;
+    } else {
+      ++pos;
+    }
+  }
+  return size;
+}
+
+size_t FindStartCodePrefix(const uint8_t* data, size_t size) {
+  size_t pos = 0;
+#if defined(__SSE2__)
+  // Each step tests whether the prefix starts at any of the next 16
+  // positions, with three overlapping loads.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  while (pos + kSimdWidth + kPrefixSize - 1 <= size) {
+    const __m128i first = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + pos));
+    const __m128i second = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + pos + 1));
+    const __m128i third = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + pos + 2));
+    const __m128i match =
+        _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(first, zero),
+                                    _mm_cmpeq_epi8(second, zero)),
+                      _mm_cmpeq_epi8(third, one));
+    const unsigned int mask = _mm_movemask_epi8(match);
+    if (mask)
+      return pos + CountTrailingZeros(mask);
+    pos += kSimdWidth;
+  }
+#endif
+  return pos + FindStartCodePrefixScalar(data + pos, size - pos);
+}
+
+}  // namespace media
+}  // namespace edash_packager
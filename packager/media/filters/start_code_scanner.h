@@ -0,0 +1,32 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef MEDIA_FILTERS_START_CODE_SCANNER_H_
+#define MEDIA_FILTERS_START_CODE_SCANNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace edash_packager {
+namespace media {
+
+/// Find the first Annex B start code prefix (00 00 01) in a buffer.
+/// Uses SSE2 when available, testing 16 positions per step, and otherwise a
+/// scalar loop which skips up to 3 bytes per step.
+/// @param data points to the buffer to scan.
+/// @param size is the size of the buffer, in bytes.
+/// @return The offset of the first byte of the first 00 00 01 sequence which
+///         lies entirely in the buffer, or @a size if there is none.
+size_t FindStartCodePrefix(const uint8_t* data, size_t size);
+
+/// Scalar version of FindStartCodePrefix(), used as the fallback when SIMD
+/// is not available. Exposed for tests and benchmarks.
+size_t FindStartCodePrefixScalar(const uint8_t* data, size_t size);
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_FILTERS_START_CODE_SCANNER_H_
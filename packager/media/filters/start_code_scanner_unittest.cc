@@ -0,0 +1,71 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "packager/media/filters/start_code_scanner.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+// Reference implementation, testing every position.
+size_t FindStartCodePrefixByteByByte(const uint8_t* data, size_t size) {
+  for (size_t pos = 0; pos + 3 <= size; ++pos) {
+    if (data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1)
+      return pos;
+  }
+  return size;
+}
+
+}  // namespace
+
+TEST(StartCodeScannerTest, NoStartCode) {
+  std::vector<uint8_t> data(100, 0x42);
+  EXPECT_EQ(100u, FindStartCodePrefix(&data[0], data.size()));
+  EXPECT_EQ(100u, FindStartCodePrefixScalar(&data[0], data.size()));
+  EXPECT_EQ(0u, FindStartCodePrefix(&data[0], 0));
+}
+
+TEST(StartCodeScannerTest, StartCodeAtEveryOffset) {
+  const size_t kSize = 64;
+  for (size_t offset = 0; offset + 3 <= kSize; ++offset) {
+    std::vector<uint8_t> data(kSize, 0x42);
+    data[offset + 2] = 1;
+    data[offset] = data[offset + 1] = 0;
+    EXPECT_EQ(offset, FindStartCodePrefix(&data[0], kSize));
+    EXPECT_EQ(offset, FindStartCodePrefixScalar(&data[0], kSize));
+    // Truncated start code at the end of the buffer.
+    EXPECT_EQ(offset + 2,
+              FindStartCodePrefix(&data[0], offset + 2));
+  }
+}
+
+TEST(StartCodeScannerTest, MatchesByteByByteScan) {
+  // Data with many zeros and ones, to exercise partial matches.
+  srand(1);
+  for (int i = 0; i < 10000; ++i) {
+    std::vector<uint8_t> data(rand() % 100 + 1);
+    for (size_t j = 0; j < data.size(); ++j) {
+      const int value = rand() % 8;
+      data[j] = value < 3 ? 0 : (value < 5 ? 1 : rand() % 256);
+    }
+    for (size_t start = 0; start < data.size(); ++start) {
+      const size_t size = data.size() - start;
+      const size_t expected =
+          FindStartCodePrefixByteByByte(&data[start], size);
+      ASSERT_EQ(expected, FindStartCodePrefix(&data[start], size));
+      ASSERT_EQ(expected, FindStartCodePrefixScalar(&data[start], size));
+    }
+  }
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -27,7 +27,9 @@ class EsParser {
   EsParser(uint32_t pid) : pid_(pid) {}
   virtual ~EsParser() {}
 
-  // ES parsing.
+  // ES parsing. |buf| is only valid for the duration of the call and holds
+  // a piece of the ES payload of a PES packet, not necessarily all of it.
+  // |pts| and |dts| apply to the first byte of |buf|.
   // Should use kNoTimestamp when a timestamp is not valid.
   virtual bool Parse(const uint8_t* buf,
                      int size,
@@ -37,6 +39,11 @@ class EsParser {
   // Flush any pending buffer.
   virtual void Flush() = 0;
 
+  // Discard the ES bytes which have not been emitted yet, because the PES
+  // packet they came from was cut short. The incomplete access unit is
+  // dropped instead of being spliced with the next PES packet.
+  virtual void DiscardPending() = 0;
+
   // Reset the state of the ES parser.
   virtual void Reset() = 0;
 
@@ -184,6 +184,14 @@ bool EsParserAdts::Parse(const uint8_t* buf,
 void EsParserAdts::Flush() {
 }
 
+void EsParserAdts::DiscardPending() {
+  // Complete frames are emitted as soon as they are received, so only the
+  // partial frame is left in the ES buffer.
+  DVLOG(1) << "EsParserAdts::DiscardPending";
+  es_byte_queue_.Reset();
+  pts_list_.clear();
+}
+
 void EsParserAdts::Reset() {
   es_byte_queue_.Reset();
   pts_list_.clear();
@@ -36,6 +36,7 @@ class EsParserAdts : public EsParser {
                      int64_t pts,
                      int64_t dts) OVERRIDE;
   virtual void Flush() OVERRIDE;
+  virtual void DiscardPending() OVERRIDE;
   virtual void Reset() OVERRIDE;
 
  private:
@@ -51,16 +51,12 @@ bool EsParserH264::Parse(const uint8_t* buf,
                          int size,
                          int64_t pts,
                          int64_t dts) {
-  // Note: Parse is invoked each time a PES packet has been reassembled.
-  // Unfortunately, a PES packet does not necessarily map
-  // to an h264 access unit, although the HLS recommendation is to use one PES
-  // for each access unit (but this is just a recommendation and some streams
-  // do not comply with this recommendation).
-
-  // HLS recommendation: "In AVC video, you should have both a DTS and a
-  // PTS in each PES header".
-  // However, some streams do not comply with this recommendation.
-  DVLOG_IF(1, pts == kNoTimestamp) << "Each video PES should have a PTS";
+  // Note: Parse is invoked with the ES payload of each TS packet, |pts| and
+  // |dts| being only set for the first payload of a PES packet.
+  // A PES packet does not necessarily map to an h264 access unit either,
+  // although the HLS recommendation is to use one PES for each access unit
+  // (but this is just a recommendation and some streams do not comply with
+  // this recommendation).
   if (pts != kNoTimestamp) {
     TimingDesc timing_desc;
     timing_desc.pts = pts;
@@ -96,6 +92,16 @@ void EsParserH264::Flush() {
   }
 }
 
+void EsParserH264::DiscardPending() {
+  // Only the access unit being received is left in the ES queue: the
+  // previous ones were emitted once their following AUD was found.
+  DVLOG(1) << "EsParserH264::DiscardPending";
+  current_access_unit_pos_ = es_queue_->tail();
+  next_access_unit_pos_ = current_access_unit_pos_;
+  es_queue_->Trim(current_access_unit_pos_);
+  timing_desc_list_.clear();
+}
+
 void EsParserH264::Reset() {
   DVLOG(1) << "EsParserH264::Reset";
   es_queue_.reset(new media::OffsetByteQueue());
@@ -181,6 +187,8 @@ bool EsParserH264::ParseInternal() {
   DCHECK_LE(access_unit_size, size);
   h264_parser_->SetStream(es, access_unit_size);
 
+  // The NAL units located here are reused to convert the access unit.
+  access_unit_nalus_.clear();
   while (true) {
     bool is_eos = false;
     H264NALU nalu;
@@ -196,6 +204,7 @@ bool EsParserH264::ParseInternal() {
     }
     if (is_eos)
       break;
+    access_unit_nalus_.push_back(nalu);
 
     switch (nalu.nal_unit_type) {
       case H264NALU::kAUD: {
@@ -274,19 +283,27 @@ bool EsParserH264::EmitFrame(int64_t access_unit_pos,
   // Emit a frame.
   DVLOG(LOG_LEVEL_ES) << "Emit frame: stream_pos=" << current_access_unit_pos_
                       << " size=" << access_unit_size;
-  int es_size;
-  const uint8_t* es;
-  es_queue_->PeekAt(current_access_unit_pos_, &es, &es_size);
-  CHECK_GE(es_size, access_unit_size);
-
-  // Convert frame to unit stream format.
-  std::vector<uint8_t> converted_frame;
-  if (!stream_converter_->ConvertByteStreamToNalUnitStream(
-          es, access_unit_size, &converted_frame)) {
+  if (access_unit_nalus_.empty()) {
     DLOG(ERROR) << "Failure to convert video frame to unit stream format.";
     return false;
   }
 
+  // Convert frame to unit stream format, directly into the sample buffer.
+  // The NAL units point to the ES queue, which is only trimmed afterwards.
+  const size_t converted_frame_size =
+      H264ByteToUnitStreamConverter::GetNalUnitStreamSize(
+          &access_unit_nalus_[0], access_unit_nalus_.size());
+  scoped_refptr<MediaSample> media_sample;
+  uint8_t* converted_frame = NULL;
+  if (converted_frame_size > 0) {
+    media_sample =
+        MediaSample::CreateWithSize(converted_frame_size, is_key_frame);
+    converted_frame = media_sample->writable_data();
+  }
+  // Also records the SPS and PPS for the decoder configuration.
+  stream_converter_->ConvertNalusToNalUnitStream(
+      &access_unit_nalus_[0], access_unit_nalus_.size(), converted_frame);
+
   if (decoder_config_check_pending_) {
     // Update the video decoder configuration if needed.
     const H264PPS* pps = h264_parser_->GetPPS(pps_id);
@@ -307,10 +324,12 @@ bool EsParserH264::EmitFrame(int64_t access_unit_pos,
     }
   }
 
-  // Create the media sample, emitting always the previous sample after
-  // calculating its duration.
-  scoped_refptr<MediaSample> media_sample = MediaSample::CopyFrom(
-      converted_frame.data(), converted_frame.size(), is_key_frame);
+  if (!media_sample) {
+    DLOG(WARNING) << "Dropping video frame without slice data.";
+    return true;
+  }
+
+  // Emit always the previous sample after calculating its duration.
   media_sample->set_dts(current_timing_desc.dts);
   media_sample->set_pts(current_timing_desc.pts);
   if (pending_sample_) {
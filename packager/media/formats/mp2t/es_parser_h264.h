@@ -9,19 +9,19 @@
 
 #include <list>
 #include <utility>
+#include <vector>
 
 #include "packager/base/callback.h"
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/filters/h264_parser.h"
 #include "packager/media/formats/mp2t/es_parser.h"
 
 namespace edash_packager {
 namespace media {
 
 class H264ByteToUnitStreamConverter;
-class H264Parser;
 class OffsetByteQueue;
-struct H264SPS;
 
 namespace mp2t {
 
@@ -43,6 +43,7 @@ class EsParserH264 : public EsParser {
                      int64_t pts,
                      int64_t dts) OVERRIDE;
   virtual void Flush() OVERRIDE;
+  virtual void DiscardPending() OVERRIDE;
   virtual void Reset() OVERRIDE;
 
  private:
@@ -87,6 +88,8 @@ class EsParserH264 : public EsParser {
   scoped_ptr<H264Parser> h264_parser_;
   int64_t current_access_unit_pos_;
   int64_t next_access_unit_pos_;
+  // NAL units of the access unit being emitted, located by |h264_parser_|.
+  std::vector<H264NALU> access_unit_nalus_;
 
   // Filter to convert H.264 Annex B byte stream to unit stream.
   scoped_ptr<H264ByteToUnitStreamConverter> stream_converter_;
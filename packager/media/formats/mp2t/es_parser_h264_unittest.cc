@@ -119,7 +119,8 @@ class EsParserH264Test : public testing::Test {
  public:
   EsParserH264Test()
       : sample_count_(0),
-        first_frame_is_key_frame_(false) {}
+        first_frame_is_key_frame_(false),
+        truncated_pes_index_(-1) {}
 
   void LoadStream(const char* filename);
   void ProcessPesPackets(const std::vector<Packet>& pes_packets);
@@ -145,6 +146,9 @@ class EsParserH264Test : public testing::Test {
  protected:
   size_t sample_count_;
   bool first_frame_is_key_frame_;
+  // If not negative, only the first half of this PES packet is passed to the
+  // ES parser, as if the rest was lost, and is then discarded.
+  int truncated_pes_index_;
 };
 
 void EsParserH264Test::LoadStream(const char* filename) {
@@ -192,6 +196,12 @@ void EsParserH264Test::ProcessPesPackets(
       pts = au_idx * kMpegTicksPerFrame;
     }
 
+    if (static_cast<int>(k) == truncated_pes_index_) {
+      ASSERT_TRUE(es_parser.Parse(
+          &stream_[cur_pes_offset], cur_pes_size / 2, pts, dts));
+      es_parser.DiscardPending();
+      continue;
+    }
     ASSERT_TRUE(
         es_parser.Parse(&stream_[cur_pes_offset], cur_pes_size, pts, dts));
   }
@@ -267,6 +277,20 @@ TEST_F(EsParserH264Test, SeveralPesPerAccessUnit) {
   EXPECT_TRUE(first_frame_is_key_frame());
 }
 
+TEST_F(EsParserH264Test, TruncatedPesDiscarded) {
+  LoadStream("bear.h264");
+
+  // One to one equivalence between PES packets and access units.
+  std::vector<Packet> pes_packets(access_units_);
+  truncated_pes_index_ = 5;
+
+  // Process each PES packet. The truncated access unit is dropped rather
+  // than emitted with the start of the next one.
+  ProcessPesPackets(pes_packets);
+  EXPECT_EQ(sample_count(), access_units_.size() - 1);
+  EXPECT_TRUE(first_frame_is_key_frame());
+}
+
 TEST_F(EsParserH264Test, NonIFrameStart) {
   LoadStream("bear_no_iframe_start.h264");
 
@@ -44,6 +44,7 @@
         'adts_header_unittest.cc',
         'es_parser_h264_unittest.cc',
         'mp2t_media_parser_unittest.cc',
+        'ts_section_pes_unittest.cc',
       ],
       'dependencies': [
         '../../../testing/gtest.gyp:gtest',
@@ -0,0 +1,161 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/file_util.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/formats/mp2t/mp2t_media_parser.h"
+#include "packager/media/formats/mp2t/ts_packet.h"
+#include "packager/media/test/benchmark_util.h"
+#include "packager/media/test/long_input_util.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace {
+
+const size_t kNumPackets = 8192;
+const int kPid = 0x100;
+const uint8_t kTsSyncByte = 0x47;
+// Duration of the looped bear-1280x720.ts input.
+const double kLoopedInputDurationInSeconds = 120;
+// Seven TS packets, as in a UDP datagram.
+const size_t kDatagramSize = 7 * 188;
+// A read size which does not split the input on packet boundaries.
+const size_t kUnalignedReadSize = 64 * 1024;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+namespace mp2t {
+
+class Mp2tBenchmark : public ::testing::Test {
+ public:
+  Mp2tBenchmark() : num_samples_(0) {
+    // Payload only packets of a single PID, with the payload unit start
+    // indicator set every 16 packets, as for a PES stream.
+    packets_ = GenerateSyntheticData(kNumPackets * TsPacket::kPacketSize);
+    for (size_t i = 0; i < kNumPackets; ++i) {
+      uint8_t* packet = &packets_[i * TsPacket::kPacketSize];
+      const bool payload_unit_start = (i % 16) == 0;
+      packet[0] = kTsSyncByte;
+      packet[1] = (payload_unit_start ? 0x40 : 0x00) | (kPid >> 8);
+      packet[2] = kPid & 0xff;
+      packet[3] = 0x10 | (i & 0x0f);
+    }
+  }
+
+  void ParseTsPackets() {
+    for (size_t i = 0; i < kNumPackets; ++i) {
+      scoped_ptr<TsPacket> ts_packet(TsPacket::Parse(
+          &packets_[i * TsPacket::kPacketSize], TsPacket::kPacketSize));
+      ASSERT_TRUE(ts_packet);
+    }
+  }
+
+  void ParseTsPacketsInPlace() {
+    TsPacket ts_packet;
+    for (size_t i = 0; i < kNumPackets; ++i) {
+      ASSERT_TRUE(ts_packet.ParseFrom(&packets_[i * TsPacket::kPacketSize],
+                                      TsPacket::kPacketSize));
+    }
+  }
+
+  void ParseMp2tFile() {
+    ParseMp2tFileInChunks(ts_file_.size());
+  }
+
+  // Feeds the parser with |chunk_size| bytes at a time.
+  void ParseMp2tFileInChunks(size_t chunk_size) {
+    num_samples_ = 0;
+    Mp2tMediaParser parser;
+    parser.Init(base::Bind(&Mp2tBenchmark::OnInit, base::Unretained(this)),
+                base::Bind(&Mp2tBenchmark::OnNewSample,
+                           base::Unretained(this)),
+                NULL);
+    for (size_t pos = 0; pos < ts_file_.size(); pos += chunk_size) {
+      const size_t size = std::min(chunk_size, ts_file_.size() - pos);
+      ASSERT_TRUE(parser.Parse(&ts_file_[pos], size));
+    }
+    parser.Flush();
+    ASSERT_LT(0u, num_samples_);
+  }
+
+ protected:
+  void OnInit(const std::vector<scoped_refptr<StreamInfo> >& stream_infos) {}
+
+  bool OnNewSample(uint32_t track_id,
+                   const scoped_refptr<MediaSample>& sample) {
+    ++num_samples_;
+    return true;
+  }
+
+  std::vector<uint8_t> packets_;
+  std::vector<uint8_t> ts_file_;
+  size_t num_samples_;
+};
+
+TEST_F(Mp2tBenchmark, TsPacketParse) {
+  RunThroughputBenchmark(
+      "TsPacketParse",
+      packets_.size(),
+      base::Bind(&Mp2tBenchmark::ParseTsPackets, base::Unretained(this)));
+}
+
+TEST_F(Mp2tBenchmark, TsPacketParseFrom) {
+  RunThroughputBenchmark(
+      "TsPacketParseFrom",
+      packets_.size(),
+      base::Bind(&Mp2tBenchmark::ParseTsPacketsInPlace,
+                 base::Unretained(this)));
+}
+
+TEST_F(Mp2tBenchmark, Mp2tMediaParserParse) {
+  ts_file_ = ReadTestDataFile("bear-1280x720.ts");
+  ASSERT_FALSE(ts_file_.empty());
+  RunThroughputBenchmark(
+      "Mp2tMediaParserParse",
+      ts_file_.size(),
+      base::Bind(&Mp2tBenchmark::ParseMp2tFile, base::Unretained(this)));
+}
+
+// bear-1280x720.ts looped, fed as UDP datagrams (aligned packets, parsed in
+// place) and as file reads (unaligned, a partial packet is carried over).
+TEST_F(Mp2tBenchmark, Mp2tMediaParserLoopedInput) {
+  base::FilePath looped_file;
+  ASSERT_TRUE(base::CreateTemporaryFile(&looped_file));
+  ASSERT_TRUE(WriteLongTestInput("bear-1280x720.ts",
+                                 kLoopedInputDurationInSeconds,
+                                 looped_file.value(),
+                                 NULL));
+  std::string looped_input;
+  ASSERT_TRUE(base::ReadFileToString(looped_file, &looped_input));
+  base::DeleteFile(looped_file, false);
+  ts_file_.assign(looped_input.begin(), looped_input.end());
+
+  RunThroughputBenchmark(
+      "Mp2tMediaParserLoopedDatagrams",
+      ts_file_.size(),
+      base::Bind(&Mp2tBenchmark::ParseMp2tFileInChunks,
+                 base::Unretained(this),
+                 kDatagramSize));
+  RunThroughputBenchmark(
+      "Mp2tMediaParserLoopedUnalignedReads",
+      ts_file_.size(),
+      base::Bind(&Mp2tBenchmark::ParseMp2tFileInChunks,
+                 base::Unretained(this),
+                 kUnalignedReadSize));
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace edash_packager
@@ -4,6 +4,8 @@
 
 #include "packager/media/formats/mp2t/mp2t_media_parser.h"
 
+#include <algorithm>
+
 #include "packager/base/bind.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/stl_util.h"
@@ -23,6 +25,9 @@ namespace edash_packager {
 namespace media {
 namespace mp2t {
 
+// Value of the first byte of every TS packet.
+const uint8_t kTsSyncword = 0x47;
+
 enum StreamType {
   // ISO-13818.1 / ITU H.222 Table 2.34 "Stream type assignments"
   kStreamTypeMpeg1Audio = 0x3,
@@ -146,11 +151,12 @@ void PidState::ResetState() {
 
 Mp2tMediaParser::Mp2tMediaParser()
     : sbr_in_mimetype_(false),
+      pid_table_(TsPacket::kNumPids, static_cast<PidState*>(NULL)),
       is_initialized_(false) {
 }
 
 Mp2tMediaParser::~Mp2tMediaParser() {
-  STLDeleteValues(&pids_);
+  DeletePidStates();
 }
 
 void Mp2tMediaParser::Init(
@@ -177,7 +183,7 @@ void Mp2tMediaParser::Flush() {
     pid_state->Flush();
   }
   EmitRemainingSamples();
-  STLDeleteValues(&pids_);
+  DeletePidStates();
 
   // Remove any bytes left in the TS buffer.
   // (i.e. any partial TS packet => less than 188 bytes).
@@ -187,67 +193,120 @@ void Mp2tMediaParser::Flush() {
 bool Mp2tMediaParser::Parse(const uint8_t* buf, int size) {
   DVLOG(1) << "Mp2tMediaParser::Parse size=" << size;
 
-  // Add the data to the parser state.
-  ts_byte_queue_.Push(buf, size);
-
-  while (true) {
+  // Complete the partial TS packet left over by the previous call, if any,
+  // through the TS buffer. Only as many bytes as needed are added, so that the
+  // buffer is usually emptied and the rest of the data parsed in place.
+  while (size > 0) {
     const uint8_t* ts_buffer;
     int ts_buffer_size;
     ts_byte_queue_.Peek(&ts_buffer, &ts_buffer_size);
-    if (ts_buffer_size < TsPacket::kPacketSize)
+    if (ts_buffer_size == 0)
       break;
 
-    // Synchronization.
-    int skipped_bytes = TsPacket::Sync(ts_buffer, ts_buffer_size);
-    if (skipped_bytes > 0) {
+    const int append_size =
+        std::min(size, TsPacket::kPacketSize - ts_buffer_size);
+    ts_byte_queue_.Push(buf, append_size);
+    buf += append_size;
+    size -= append_size;
+
+    ts_byte_queue_.Peek(&ts_buffer, &ts_buffer_size);
+    int consumed = 0;
+    if (!ParseTsPackets(ts_buffer, ts_buffer_size, &consumed))
+      return false;
+    ts_byte_queue_.Pop(consumed);
+  }
+
+  // Parse the complete packets in place, and keep the trailing partial packet
+  // for the next call.
+  int consumed = 0;
+  if (!ParseTsPackets(buf, size, &consumed))
+    return false;
+  if (consumed < size)
+    ts_byte_queue_.Push(buf + consumed, size - consumed);
+
+  // Emit the A/V buffers that kept accumulating during TS parsing.
+  return EmitRemainingSamples();
+}
+
+bool Mp2tMediaParser::ParseTsPackets(const uint8_t* buf,
+                                     int size,
+                                     int* consumed) {
+  DCHECK(consumed);
+
+  // Reused for every packet.
+  TsPacket ts_packet;
+  int pos = 0;
+  while (size - pos >= TsPacket::kPacketSize) {
+    const uint8_t* packet = buf + pos;
+    // Synchronization, only when the packets are not aligned any more.
+    if (packet[0] != kTsSyncword) {
+      int skipped_bytes = TsPacket::Sync(packet, size - pos);
       DVLOG(1) << "Packet not aligned on a TS syncword:"
                << " skipped_bytes=" << skipped_bytes;
-      ts_byte_queue_.Pop(skipped_bytes);
+      pos += skipped_bytes;
       continue;
     }
 
     // Parse the TS header, skipping 1 byte if the header is invalid.
-    scoped_ptr<TsPacket> ts_packet(TsPacket::Parse(ts_buffer, ts_buffer_size));
-    if (!ts_packet) {
+    if (!ts_packet.ParseFrom(packet, size - pos)) {
       DVLOG(1) << "Error: invalid TS packet";
-      ts_byte_queue_.Pop(1);
+      pos += 1;
       continue;
     }
     DVLOG(LOG_LEVEL_TS)
-        << "Processing PID=" << ts_packet->pid()
-        << " start_unit=" << ts_packet->payload_unit_start_indicator();
+        << "Processing PID=" << ts_packet.pid()
+        << " start_unit=" << ts_packet.payload_unit_start_indicator();
 
     // Parse the section.
-    std::map<int, PidState*>::iterator it = pids_.find(ts_packet->pid());
-    if (it == pids_.end() &&
-        ts_packet->pid() == TsSection::kPidPat) {
+    PidState* pid_state = FindPidState(ts_packet.pid());
+    if (!pid_state && ts_packet.pid() == TsSection::kPidPat) {
       // Create the PAT state here if needed.
       scoped_ptr<TsSection> pat_section_parser(
           new TsSectionPat(
               base::Bind(&Mp2tMediaParser::RegisterPmt,
                          base::Unretained(this))));
       scoped_ptr<PidState> pat_pid_state(
-          new PidState(ts_packet->pid(), PidState::kPidPat,
+          new PidState(ts_packet.pid(), PidState::kPidPat,
                        pat_section_parser.Pass()));
       pat_pid_state->Enable();
-      it = pids_.insert(
-          std::pair<int, PidState*>(ts_packet->pid(),
-                                    pat_pid_state.release())).first;
+      pid_state = pat_pid_state.get();
+      AddPidState(ts_packet.pid(), pat_pid_state.release());
     }
 
-    if (it != pids_.end()) {
-      if (!it->second->PushTsPacket(*ts_packet))
+    if (pid_state) {
+      if (!pid_state->PushTsPacket(ts_packet)) {
+        *consumed = pos;
         return false;
+      }
     } else {
-      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << ts_packet->pid();
+      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << ts_packet.pid();
     }
 
     // Go to the next packet.
-    ts_byte_queue_.Pop(TsPacket::kPacketSize);
+    pos += TsPacket::kPacketSize;
   }
 
-  // Emit the A/V buffers that kept accumulating during TS parsing.
-  return EmitRemainingSamples();
+  *consumed = pos;
+  return true;
+}
+
+void Mp2tMediaParser::AddPidState(int pid, PidState* pid_state) {
+  DCHECK(pid_state);
+  DCHECK(!FindPidState(pid));
+  pids_.insert(std::pair<int, PidState*>(pid, pid_state));
+  pid_table_[pid] = pid_state;
+}
+
+PidState* Mp2tMediaParser::FindPidState(int pid) const {
+  DCHECK_GE(pid, 0);
+  DCHECK_LT(pid, TsPacket::kNumPids);
+  return pid_table_[pid];
+}
+
+void Mp2tMediaParser::DeletePidStates() {
+  for (PidMap::const_iterator it = pids_.begin(); it != pids_.end(); ++it)
+    pid_table_[it->first] = NULL;
+  STLDeleteValues(&pids_);
 }
 
 void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
@@ -275,7 +334,7 @@ void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
   scoped_ptr<PidState> pmt_pid_state(
       new PidState(pmt_pid, PidState::kPidPmt, pmt_section_parser.Pass()));
   pmt_pid_state->Enable();
-  pids_.insert(std::pair<int, PidState*>(pmt_pid, pmt_pid_state.release()));
+  AddPidState(pmt_pid, pmt_pid_state.release());
 }
 
 void Mp2tMediaParser::RegisterPes(int pmt_pid,
@@ -284,8 +343,7 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
   DVLOG(1) << "RegisterPes:"
            << " pes_pid=" << pes_pid
            << " stream_type=" << std::hex << stream_type << std::dec;
-  std::map<int, PidState*>::iterator it = pids_.find(pes_pid);
-  if (it != pids_.end())
+  if (FindPidState(pes_pid))
     return;
 
   // Create a stream parser corresponding to the stream type.
@@ -322,7 +380,7 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
   scoped_ptr<PidState> pes_pid_state(
       new PidState(pes_pid, pid_type, pes_section_parser.Pass()));
   pes_pid_state->Enable();
-  pids_.insert(std::pair<int, PidState*>(pes_pid, pes_pid_state.release()));
+  AddPidState(pes_pid, pes_pid_state.release());
 }
 
 void Mp2tMediaParser::OnNewStreamInfo(
@@ -330,15 +388,15 @@ void Mp2tMediaParser::OnNewStreamInfo(
   DCHECK(new_stream_info);
   DVLOG(1) << "OnVideoConfigChanged for pid=" << new_stream_info->track_id();
 
-  PidMap::iterator pid_state = pids_.find(new_stream_info->track_id());
-  if (pid_state == pids_.end()) {
+  PidState* pid_state = FindPidState(new_stream_info->track_id());
+  if (!pid_state) {
     LOG(ERROR) << "PID State for new stream not found (pid = "
                << new_stream_info->track_id() << ").";
     return;
   }
 
   // Set the stream configuration information for the PID.
-  pid_state->second->set_config(new_stream_info);
+  pid_state->set_config(new_stream_info);
 
   // Finish initialization if all streams have configs.
   FinishInitializationIfNeeded();
@@ -389,13 +447,13 @@ void Mp2tMediaParser::OnEmitSample(uint32_t pes_pid,
       << new_sample->pts();
 
   // Add the sample to the appropriate PID sample queue.
-  PidMap::iterator pid_state = pids_.find(pes_pid);
-  if (pid_state == pids_.end()) {
+  PidState* pid_state = FindPidState(pes_pid);
+  if (!pid_state) {
     LOG(ERROR) << "PID State for new sample not found (pid = "
                << pes_pid << ").";
     return;
   }
-  pid_state->second->sample_queue().push_back(new_sample);
+  pid_state->sample_queue().push_back(new_sample);
 }
 
 bool Mp2tMediaParser::EmitRemainingSamples() {
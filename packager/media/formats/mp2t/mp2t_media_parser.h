@@ -7,6 +7,7 @@
 
 #include <deque>
 #include <map>
+#include <vector>
 
 #include "packager/base/memory/ref_counted.h"
 #include "packager/base/memory/scoped_ptr.h"
@@ -44,6 +45,21 @@ class Mp2tMediaParser : public MediaParser {
  private:
   typedef std::map<int, PidState*> PidMap;
 
+  // Parse the TS packets at the beginning of |buf|, resynchronizing on sync
+  // loss. |*consumed| is set to the number of bytes processed; the remaining
+  // bytes are less than a packet.
+  // Return false if a packet could not be processed.
+  bool ParseTsPackets(const uint8_t* buf, int size, int* consumed);
+
+  // Register the state of a PID. Takes ownership of |pid_state|.
+  void AddPidState(int pid, PidState* pid_state);
+
+  // Return the state of a PID, or NULL if the PID is not registered.
+  PidState* FindPidState(int pid) const;
+
+  // Delete the state of all the PIDs.
+  void DeletePidStates();
+
   // Callback invoked to register a Program Map Table.
   // Note: Does nothing if the PID is already registered.
   void RegisterPmt(int program_number, int pmt_pid);
@@ -81,8 +97,11 @@ class Mp2tMediaParser : public MediaParser {
   // Bytes of the TS media.
   ByteQueue ts_byte_queue_;
 
-  // List of PIDs and their states.
+  // List of PIDs and their states, in PID order.
   PidMap pids_;
+  // The states of |pids_|, indexed by PID, for the lookup done for every TS
+  // packet. Entries of unregistered PIDs are NULL.
+  std::vector<PidState*> pid_table_;
 
   // Whether |init_cb_| has been invoked.
   bool is_initialized_;
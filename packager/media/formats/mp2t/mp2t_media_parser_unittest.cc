@@ -137,6 +137,26 @@ TEST_F(Mp2tMediaParserTest, UnalignedAppend512) {
   EXPECT_EQ(video_frame_count_, 82);
 }
 
+TEST_F(Mp2tMediaParserTest, AlignedAppend1316) {
+  // Test appends of seven TS packets, as in UDP datagrams.
+  ParseMpeg2TsFile("bear-1280x720.ts", 7 * 188);
+  EXPECT_EQ(video_frame_count_, 80);
+  parser_->Flush();
+  EXPECT_EQ(video_frame_count_, 82);
+}
+
+TEST_F(Mp2tMediaParserTest, ResyncAfterGarbage) {
+  InitializeParser();
+
+  // Bytes which are not part of a TS packet, before the stream.
+  std::vector<uint8_t> buffer(50, 0xab);
+  std::vector<uint8_t> ts_file = ReadTestDataFile("bear-1280x720.ts");
+  buffer.insert(buffer.end(), ts_file.begin(), ts_file.end());
+  EXPECT_TRUE(AppendDataInPieces(buffer.data(), buffer.size(), 7 * 188));
+  parser_->Flush();
+  EXPECT_EQ(video_frame_count_, 82);
+}
+
 TEST_F(Mp2tMediaParserTest, TimestampWrapAround) {
   // "bear-1280x720_ptswraparound.ts" has been transcoded
   // from bear-1280x720.mp4 by applying a time offset of 95442s
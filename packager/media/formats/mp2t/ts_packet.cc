@@ -43,10 +43,23 @@ int TsPacket::Sync(const uint8_t* buf, int size) {
 
 // static
 TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
+  scoped_ptr<TsPacket> ts_packet(new TsPacket());
+  if (!ts_packet->ParseFrom(buf, size))
+    return NULL;
+  return ts_packet.release();
+}
+
+TsPacket::TsPacket() {
+}
+
+TsPacket::~TsPacket() {
+}
+
+bool TsPacket::ParseFrom(const uint8_t* buf, int size) {
   if (size < kPacketSize) {
     DVLOG(1) << "Buffer does not hold one full TS packet:"
              << " buffer_size=" << size;
-    return NULL;
+    return false;
   }
 
   DCHECK_EQ(buf[0], kTsHeaderSyncword);
@@ -54,47 +67,33 @@ TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
     DVLOG(1) << "Not on a TS syncword:"
              << " buf[0]="
              << std::hex << static_cast<int>(buf[0]) << std::dec;
-    return NULL;
+    return false;
   }
 
-  scoped_ptr<TsPacket> ts_packet(new TsPacket());
-  bool status = ts_packet->ParseHeader(buf);
-  if (!status) {
+  if (!ParseHeader(buf)) {
     DVLOG(1) << "Parsing header failed";
-    return NULL;
+    return false;
   }
-  return ts_packet.release();
-}
-
-TsPacket::TsPacket() {
-}
-
-TsPacket::~TsPacket() {
+  return true;
 }
 
 bool TsPacket::ParseHeader(const uint8_t* buf) {
-  BitReader bit_reader(buf, kPacketSize);
-  payload_ = buf;
-  payload_size_ = kPacketSize;
-
-  // Read the TS header: 4 bytes.
-  int syncword;
-  int transport_error_indicator;
-  int payload_unit_start_indicator;
-  int transport_priority;
-  int transport_scrambling_control;
-  int adaptation_field_control;
-  RCHECK(bit_reader.ReadBits(8, &syncword));
-  RCHECK(bit_reader.ReadBits(1, &transport_error_indicator));
-  RCHECK(bit_reader.ReadBits(1, &payload_unit_start_indicator));
-  RCHECK(bit_reader.ReadBits(1, &transport_priority));
-  RCHECK(bit_reader.ReadBits(13, &pid_));
-  RCHECK(bit_reader.ReadBits(2, &transport_scrambling_control));
-  RCHECK(bit_reader.ReadBits(2, &adaptation_field_control));
-  RCHECK(bit_reader.ReadBits(4, &continuity_counter_));
-  payload_unit_start_indicator_ = (payload_unit_start_indicator != 0);
-  payload_ += 4;
-  payload_size_ -= 4;
+  // Read the TS header: 4 bytes. It is read directly rather than with a
+  // BitReader since this is done for every packet.
+  // - syncword: 8 bits
+  // - transport_error_indicator: 1 bit
+  // - payload_unit_start_indicator: 1 bit
+  // - transport_priority: 1 bit
+  // - PID: 13 bits
+  // - transport_scrambling_control: 2 bits
+  // - adaptation_field_control: 2 bits
+  // - continuity_counter: 4 bits
+  payload_unit_start_indicator_ = (buf[1] & 0x40) != 0;
+  pid_ = ((buf[1] & 0x1f) << 8) | buf[2];
+  const int adaptation_field_control = (buf[3] >> 4) & 0x3;
+  continuity_counter_ = buf[3] & 0x0f;
+  payload_ = buf + 4;
+  payload_size_ = kPacketSize - 4;
 
   // Default values when no adaptation field.
   discontinuity_indicator_ = false;
@@ -105,8 +104,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
     return true;
 
   // Read the adaptation field if needed.
-  int adaptation_field_length;
-  RCHECK(bit_reader.ReadBits(8, &adaptation_field_length));
+  const int adaptation_field_length = buf[4];
   DVLOG(LOG_LEVEL_TS) << "adaptation_field_length=" << adaptation_field_length;
   payload_ += 1;
   payload_size_ -= 1;
@@ -129,6 +127,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
   if (adaptation_field_length == 0)
     return true;
 
+  BitReader bit_reader(payload_, payload_size_);
   bool status = ParseAdaptationField(&bit_reader, adaptation_field_length);
   payload_ += adaptation_field_length;
   payload_size_ -= adaptation_field_length;
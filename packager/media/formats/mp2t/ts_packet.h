@@ -19,6 +19,8 @@ namespace mp2t {
 class TsPacket {
  public:
   static const int kPacketSize = 188;
+  // Number of distinct PIDs, which are 13-bit values.
+  static const int kNumPids = 1 << 13;
 
   // Return the number of bytes to discard
   // to be synchronized on a TS syncword.
@@ -29,8 +31,14 @@ class TsPacket {
   // Return NULL otherwise.
   static TsPacket* Parse(const uint8_t* buf, int size);
 
+  TsPacket();
   ~TsPacket();
 
+  // Parse a TS packet into this object, which can be reused for successive
+  // packets to avoid an allocation per packet.
+  // Return true only when parsing was successful.
+  bool ParseFrom(const uint8_t* buf, int size);
+
   // TS header accessors.
   bool payload_unit_start_indicator() const {
     return payload_unit_start_indicator_;
@@ -45,8 +53,6 @@ class TsPacket {
   int payload_size() const { return payload_size_; }
 
  private:
-  TsPacket();
-
   // Parse an Mpeg2 TS header.
   // The buffer size should be at least |kPacketSize|
   bool ParseHeader(const uint8_t* buf);
@@ -83,12 +83,17 @@ namespace media {
 namespace mp2t {
 
 TsSectionPes::TsSectionPes(scoped_ptr<EsParser> es_parser)
-  : es_parser_(es_parser.release()),
+  : pes_header_parsed_(false),
+    es_bytes_remaining_(-1),
+    pending_pts_(kNoTimestamp),
+    pending_dts_(kNoTimestamp),
+    es_parser_(es_parser.release()),
     wait_for_pusi_(true),
     previous_pts_valid_(false),
     previous_pts_(0),
     previous_dts_valid_(false),
-    previous_dts_(0) {
+    previous_dts_(0),
+    num_truncated_pes_(0) {
   DCHECK(es_parser_);
 }
 
@@ -102,36 +107,59 @@ bool TsSectionPes::Parse(bool payload_unit_start_indicator,
   if (wait_for_pusi_ && !payload_unit_start_indicator)
     return true;
 
-  bool parse_result = true;
   if (payload_unit_start_indicator) {
-    // Try emitting a packet since we might have a pending PES packet
-    // with an undefined size.
-    // In this case, a unit is emitted when the next unit is coming.
-    int raw_pes_size;
-    const uint8_t* raw_pes;
-    pes_byte_queue_.Peek(&raw_pes, &raw_pes_size);
-    if (raw_pes_size > 0)
-      parse_result = Emit(true);
-
-    // Reset the state.
+    // A PES packet whose size is unknown ends when the next one starts.
+    // Its payload has already been passed to the ES parser.
+    if (pes_header_parsed_ && es_bytes_remaining_ > 0) {
+      // The PES packet was cut short, e.g. by lost TS packets. The part of
+      // it already passed to the ES parser cannot be completed.
+      ++num_truncated_pes_;
+      LOG(WARNING) << "PES packet truncated, " << es_bytes_remaining_
+                   << " bytes missing (" << num_truncated_pes_
+                   << " truncated PES packets on pid " << es_parser_->pid()
+                   << ").";
+      es_parser_->DiscardPending();
+    }
     ResetPesState();
 
     // Update the state.
     wait_for_pusi_ = false;
   }
 
-  // Add the data to the parser state.
-  if (size > 0)
-    pes_byte_queue_.Push(buf, size);
+  if (pes_header_parsed_)
+    return EmitEsData(buf, size);
+
+  // The PES header is parsed in place unless it spans several TS packets,
+  // in which case its bytes are accumulated until it is complete.
+  const uint8_t* raw_pes = buf;
+  int raw_pes_size = size;
+  if (!pes_header_.empty()) {
+    pes_header_.insert(pes_header_.end(), buf, buf + size);
+    raw_pes = &pes_header_[0];
+    raw_pes_size = pes_header_.size();
+  }
+
+  int header_size = 0;
+  if (!ParsePesHeader(raw_pes, raw_pes_size, &header_size)) {
+    ResetPesState();
+    return false;
+  }
+  if (header_size == 0) {
+    // Wait for more data to come.
+    if (pes_header_.empty())
+      pes_header_.assign(buf, buf + size);
+    return true;
+  }
 
-  // Try emitting the current PES packet.
-  return (parse_result && Emit(false));
+  bool parse_result =
+      EmitEsData(raw_pes + header_size, raw_pes_size - header_size);
+  pes_header_.clear();
+  return parse_result;
 }
 
 void TsSectionPes::Flush() {
-  // Try emitting a packet since we might have a pending PES packet
-  // with an undefined size.
-  Emit(true);
+  // Any ES payload received so far has already been passed to the ES parser.
+  ResetPesState();
 
   // Flush the underlying ES parser.
   es_parser_->Flush();
@@ -148,40 +176,16 @@ void TsSectionPes::Reset() {
   es_parser_->Reset();
 }
 
-bool TsSectionPes::Emit(bool emit_for_unknown_size) {
-  int raw_pes_size;
-  const uint8_t* raw_pes;
-  pes_byte_queue_.Peek(&raw_pes, &raw_pes_size);
+bool TsSectionPes::ParsePesHeader(const uint8_t* raw_pes,
+                                  int raw_pes_size,
+                                  int* header_size) {
+  *header_size = 0;
 
   // A PES should be at least 6 bytes.
   // Wait for more data to come if not enough bytes.
   if (raw_pes_size < 6)
     return true;
 
-  // Check whether we have enough data to start parsing.
-  int pes_packet_length =
-      (static_cast<int>(raw_pes[4]) << 8) |
-      (static_cast<int>(raw_pes[5]));
-  if ((pes_packet_length == 0 && !emit_for_unknown_size) ||
-      (pes_packet_length != 0 && raw_pes_size < pes_packet_length + 6)) {
-    // Wait for more data to come either because:
-    // - there are not enough bytes,
-    // - or the PES size is unknown and the "force emit" flag is not set.
-    //   (PES size might be unknown for video PES packet).
-    return true;
-  }
-  DVLOG(LOG_LEVEL_PES) << "pes_packet_length=" << pes_packet_length;
-
-  // Parse the packet.
-  bool parse_result = ParseInternal(raw_pes, raw_pes_size);
-
-  // Reset the state.
-  ResetPesState();
-
-  return parse_result;
-}
-
-bool TsSectionPes::ParseInternal(const uint8_t* raw_pes, int raw_pes_size) {
   BitReader bit_reader(raw_pes, raw_pes_size);
 
   // Read up to the pes_packet_length (6 bytes).
@@ -193,15 +197,23 @@ bool TsSectionPes::ParseInternal(const uint8_t* raw_pes, int raw_pes_size) {
   RCHECK(bit_reader.ReadBits(16, &pes_packet_length));
 
   RCHECK(packet_start_code_prefix == kPesStartCode);
-  DVLOG(LOG_LEVEL_PES) << "stream_id=" << std::hex << stream_id << std::dec;
-  if (pes_packet_length == 0)
-    pes_packet_length = bit_reader.bits_available() / 8;
+  DVLOG(LOG_LEVEL_PES) << "stream_id=" << std::hex << stream_id << std::dec
+                       << " pes_packet_length=" << pes_packet_length;
 
   // Ignore the PES for unknown stream IDs.
   // See ITU H.222 Table 2-22 "Stream_id assignments"
   bool is_audio_stream_id = ((stream_id & 0xe0) == 0xc0);
   bool is_video_stream_id = ((stream_id & 0xf0) == 0xe0);
-  if (!is_audio_stream_id && !is_video_stream_id)
+  if (!is_audio_stream_id && !is_video_stream_id) {
+    pes_header_parsed_ = true;
+    es_bytes_remaining_ = 0;
+    *header_size = 6;
+    return true;
+  }
+
+  // Wait for the whole PES header, whose size is given by
+  // "pes_header_data_length".
+  if (raw_pes_size < 9 || raw_pes_size < 9 + raw_pes[8])
     return true;
 
   // Read up to "pes_header_data_length".
@@ -236,13 +248,15 @@ bool TsSectionPes::ParseInternal(const uint8_t* raw_pes, int raw_pes_size) {
   RCHECK(bit_reader.ReadBits(8, &pes_header_data_length));
   int pes_header_start_size = bit_reader.bits_available() / 8;
 
-  // Compute the size and the offset of the ES payload.
+  // Compute the size of the ES payload, if known, and the size of the header.
   // "6" for the 6 bytes read before and including |pes_packet_length|.
   // "3" for the 3 bytes read before and including |pes_header_data_length|.
-  int es_size = pes_packet_length - 3 - pes_header_data_length;
+  int es_size = -1;
+  if (pes_packet_length != 0) {
+    es_size = pes_packet_length - 3 - pes_header_data_length;
+    RCHECK(es_size >= 0);
+  }
   int es_offset = 6 + 3 + pes_header_data_length;
-  RCHECK(es_size >= 0);
-  RCHECK(es_offset + es_size <= raw_pes_size);
 
   // Read the timing information section.
   bool is_pts_valid = false;
@@ -266,6 +280,12 @@ bool TsSectionPes::ParseInternal(const uint8_t* raw_pes, int raw_pes_size) {
     is_dts_valid = true;
   }
 
+  // Discard the rest of the PES packet header.
+  DCHECK_EQ(bit_reader.bits_available() % 8, 0);
+  int pes_header_remaining_size = pes_header_data_length -
+      (pes_header_start_size - bit_reader.bits_available() / 8);
+  RCHECK(pes_header_remaining_size >= 0);
+
   // Convert and unroll the timestamps.
   int64_t media_pts(kNoTimestamp);
   int64_t media_dts(kNoTimestamp);
@@ -286,24 +306,53 @@ bool TsSectionPes::ParseInternal(const uint8_t* raw_pes, int raw_pes_size) {
     media_dts = dts;
   }
 
-  // Discard the rest of the PES packet header.
-  DCHECK_EQ(bit_reader.bits_available() % 8, 0);
-  int pes_header_remaining_size = pes_header_data_length -
-      (pes_header_start_size - bit_reader.bits_available() / 8);
-  RCHECK(pes_header_remaining_size >= 0);
+  // HLS recommendation: "In AVC video, you should have both a DTS and a
+  // PTS in each PES header".
+  // However, some streams do not comply with this recommendation.
+  DVLOG_IF(1, is_video_stream_id && !is_pts_valid)
+      << "Each video PES should have a PTS";
 
-  // Read the PES packet.
   DVLOG(LOG_LEVEL_PES)
-      << "Emit a reassembled PES:"
-      << " size=" << es_size
+      << "PES header:"
+      << " es_size=" << es_size
       << " pts=" << media_pts
       << " dts=" << media_dts
       << " data_alignment_indicator=" << data_alignment_indicator;
-  return es_parser_->Parse(&raw_pes[es_offset], es_size, media_pts, media_dts);
+  pes_header_parsed_ = true;
+  es_bytes_remaining_ = es_size;
+  pending_pts_ = media_pts;
+  pending_dts_ = media_dts;
+  *header_size = es_offset;
+  return true;
+}
+
+bool TsSectionPes::EmitEsData(const uint8_t* es, int es_size) {
+  DCHECK(pes_header_parsed_);
+  if (es_bytes_remaining_ >= 0) {
+    // Ignore anything beyond the end of the PES packet.
+    if (es_size > es_bytes_remaining_)
+      es_size = es_bytes_remaining_;
+    es_bytes_remaining_ -= es_size;
+    if (es_bytes_remaining_ == 0)
+      wait_for_pusi_ = true;
+  }
+  if (es_size == 0)
+    return true;
+
+  // The timestamps apply to the first ES bytes of the PES packet.
+  bool parse_result =
+      es_parser_->Parse(es, es_size, pending_pts_, pending_dts_);
+  pending_pts_ = kNoTimestamp;
+  pending_dts_ = kNoTimestamp;
+  return parse_result;
 }
 
 void TsSectionPes::ResetPesState() {
-  pes_byte_queue_.Reset();
+  pes_header_.clear();
+  pes_header_parsed_ = false;
+  es_bytes_remaining_ = -1;
+  pending_pts_ = kNoTimestamp;
+  pending_dts_ = kNoTimestamp;
   wait_for_pusi_ = true;
 }
 
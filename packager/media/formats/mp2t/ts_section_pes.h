@@ -7,9 +7,10 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/scoped_ptr.h"
-#include "packager/media/base/byte_queue.h"
 #include "packager/media/formats/mp2t/ts_section.h"
 
 namespace edash_packager {
@@ -18,6 +19,12 @@ namespace mp2t {
 
 class EsParser;
 
+// Parses PES packets and forwards their ES payload to an ES parser.
+// The PES packets are not reassembled: the ES payload carried by each TS
+// packet is handed to the ES parser as soon as it is received, so that the
+// ES parser's own buffer is the only place the ES bytes are copied to.
+// A PES packet of known size cut short by the next one is thus not dropped
+// here: the ES parser is told to discard its pending bytes instead.
 class TsSectionPes : public TsSection {
  public:
   explicit TsSectionPes(scoped_ptr<EsParser> es_parser);
@@ -30,20 +37,35 @@ class TsSectionPes : public TsSection {
   virtual void Flush() OVERRIDE;
   virtual void Reset() OVERRIDE;
 
+  // Number of PES packets of known size which were cut short by the start of
+  // the next PES packet.
+  int64_t num_truncated_pes() const { return num_truncated_pes_; }
+
  private:
-  // Emit a reassembled PES packet.
-  // Return true if successful.
-  // |emit_for_unknown_size| is used to force emission for PES packets
-  // whose size is unknown.
-  bool Emit(bool emit_for_unknown_size);
+  // Parse the header of a PES packet, return true if successful.
+  // |header_size| is set to the size of the PES header, or to 0 if
+  // |raw_pes| does not contain the whole header yet.
+  bool ParsePesHeader(const uint8_t* raw_pes,
+                      int raw_pes_size,
+                      int* header_size);
 
-  // Parse a PES packet, return true if successful.
-  bool ParseInternal(const uint8_t* raw_pes, int raw_pes_size);
+  // Forward a piece of the ES payload of the current PES packet to the ES
+  // parser. Return true if successful.
+  bool EmitEsData(const uint8_t* es, int es_size);
 
   void ResetPesState();
 
-  // Bytes of the current PES.
-  ByteQueue pes_byte_queue_;
+  // Bytes of a PES header which spans several TS packets.
+  std::vector<uint8_t> pes_header_;
+  bool pes_header_parsed_;
+
+  // Number of ES bytes left in the current PES packet, or -1 if the size of
+  // the PES packet is unknown.
+  int es_bytes_remaining_;
+
+  // Timestamps of the current PES packet, not yet passed to the ES parser.
+  int64_t pending_pts_;
+  int64_t pending_dts_;
 
   // ES parser.
   scoped_ptr<EsParser> es_parser_;
@@ -57,6 +79,8 @@ class TsSectionPes : public TsSection {
   bool previous_dts_valid_;
   int64_t previous_dts_;
 
+  int64_t num_truncated_pes_;
+
   DISALLOW_COPY_AND_ASSIGN(TsSectionPes);
 };
 
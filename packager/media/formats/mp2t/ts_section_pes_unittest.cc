@@ -0,0 +1,228 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "packager/media/base/timestamp.h"
+#include "packager/media/formats/mp2t/es_parser.h"
+#include "packager/media/formats/mp2t/ts_section_pes.h"
+
+namespace edash_packager {
+namespace media {
+namespace mp2t {
+
+namespace {
+
+const uint32_t kPid = 0x100;
+const int kVideoStreamId = 0xe0;
+const int kPaddingStreamId = 0xbe;
+const int64_t kPts = 0x123456789LL;
+// Size of a PES header carrying a PTS.
+const size_t kPesHeaderSize = 14;
+
+// Records the calls made by TsSectionPes.
+class RecordingEsParser : public EsParser {
+ public:
+  struct Call {
+    std::vector<uint8_t> data;
+    int64_t pts;
+    int64_t dts;
+  };
+
+  RecordingEsParser(std::vector<Call>* calls, int* num_discards)
+      : EsParser(kPid), calls_(calls), num_discards_(num_discards) {}
+  virtual ~RecordingEsParser() {}
+
+  virtual bool Parse(const uint8_t* buf,
+                     int size,
+                     int64_t pts,
+                     int64_t dts) OVERRIDE {
+    Call call;
+    call.data.assign(buf, buf + size);
+    call.pts = pts;
+    call.dts = dts;
+    calls_->push_back(call);
+    return true;
+  }
+  virtual void Flush() OVERRIDE {}
+  virtual void DiscardPending() OVERRIDE { ++*num_discards_; }
+  virtual void Reset() OVERRIDE {}
+
+ private:
+  std::vector<Call>* calls_;
+  int* num_discards_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingEsParser);
+};
+
+// Builds a PES packet carrying |es| and a PTS. The PES packet length is left
+// unspecified if |known_size| is false.
+std::vector<uint8_t> BuildPes(int stream_id,
+                              const std::vector<uint8_t>& es,
+                              bool known_size) {
+  const size_t pes_packet_length =
+      known_size ? kPesHeaderSize - 6 + es.size() : 0;
+  const uint8_t header[] = {
+      0x00, 0x00, 0x01, static_cast<uint8_t>(stream_id),
+      static_cast<uint8_t>(pes_packet_length >> 8),
+      static_cast<uint8_t>(pes_packet_length & 0xff),
+      // '10', no scrambling, PTS only, 5 bytes of optional fields.
+      0x80, 0x80, 0x05,
+      static_cast<uint8_t>(0x21 | ((kPts >> 29) & 0x0e)),
+      static_cast<uint8_t>(kPts >> 22),
+      static_cast<uint8_t>(((kPts >> 14) & 0xfe) | 0x01),
+      static_cast<uint8_t>(kPts >> 7),
+      static_cast<uint8_t>(((kPts << 1) & 0xfe) | 0x01),
+  };
+  std::vector<uint8_t> pes(header, header + sizeof(header));
+  pes.insert(pes.end(), es.begin(), es.end());
+  return pes;
+}
+
+std::vector<uint8_t> BuildEs(size_t size) {
+  std::vector<uint8_t> es(size);
+  for (size_t i = 0; i < size; ++i)
+    es[i] = i % 251;
+  return es;
+}
+
+}  // namespace
+
+class TsSectionPesTest : public testing::Test {
+ public:
+  TsSectionPesTest()
+      : num_discards_(0),
+        ts_section_pes_(scoped_ptr<EsParser>(
+            new RecordingEsParser(&calls_, &num_discards_))) {}
+
+ protected:
+  // Feeds |pes| to the PES parser in TS payloads of |payload_size| bytes.
+  void FeedPes(const std::vector<uint8_t>& pes, size_t payload_size) {
+    for (size_t offset = 0; offset < pes.size(); offset += payload_size) {
+      const size_t size = std::min(payload_size, pes.size() - offset);
+      ASSERT_TRUE(ts_section_pes_.Parse(offset == 0, &pes[offset], size));
+    }
+  }
+
+  // Returns the ES bytes received by the ES parser.
+  std::vector<uint8_t> ReceivedEs() {
+    std::vector<uint8_t> es;
+    for (size_t i = 0; i < calls_.size(); ++i)
+      es.insert(es.end(), calls_[i].data.begin(), calls_[i].data.end());
+    return es;
+  }
+
+  std::vector<RecordingEsParser::Call> calls_;
+  int num_discards_;
+  TsSectionPes ts_section_pes_;
+};
+
+TEST_F(TsSectionPesTest, KnownSizeForwardedPerPayload) {
+  const std::vector<uint8_t> es = BuildEs(1000);
+  FeedPes(BuildPes(kVideoStreamId, es, true), 184);
+
+  EXPECT_EQ(es, ReceivedEs());
+  // The first payload carries the PES header, every other payload is passed
+  // to the ES parser as is.
+  ASSERT_EQ(6u, calls_.size());
+  EXPECT_EQ(184 - kPesHeaderSize, calls_[0].data.size());
+  EXPECT_EQ(kPts, calls_[0].pts);
+  EXPECT_EQ(kNoTimestamp, calls_[0].dts);
+  for (size_t i = 1; i < calls_.size(); ++i)
+    EXPECT_EQ(kNoTimestamp, calls_[i].pts);
+}
+
+TEST_F(TsSectionPesTest, KnownSizeIgnoresTrailingBytes) {
+  const std::vector<uint8_t> es = BuildEs(100);
+  std::vector<uint8_t> pes = BuildPes(kVideoStreamId, es, true);
+  pes.resize(pes.size() + 20, 0xff);
+  FeedPes(pes, 184);
+  // The PES packet is complete: anything up to the next unit start is
+  // ignored.
+  const uint8_t garbage[] = {0x01, 0x02, 0x03};
+  ASSERT_TRUE(ts_section_pes_.Parse(false, garbage, sizeof(garbage)));
+
+  EXPECT_EQ(es, ReceivedEs());
+  EXPECT_EQ(0, num_discards_);
+}
+
+TEST_F(TsSectionPesTest, TruncatedKnownSizeDiscarded) {
+  const std::vector<uint8_t> es1 = BuildEs(1000);
+  const std::vector<uint8_t> es2 = BuildEs(300);
+  std::vector<uint8_t> pes1 = BuildPes(kVideoStreamId, es1, true);
+  // Only the first two TS packets of the PES packet are received.
+  pes1.resize(2 * 184);
+  FeedPes(pes1, 184);
+  EXPECT_EQ(0, num_discards_);
+
+  // The next PES packet starts while the first one is still expecting ES
+  // bytes: the partial payload is discarded by the ES parser.
+  const size_t num_calls = calls_.size();
+  FeedPes(BuildPes(kVideoStreamId, es2, true), 184);
+  EXPECT_EQ(1, num_discards_);
+  EXPECT_EQ(1, ts_section_pes_.num_truncated_pes());
+  ASSERT_LT(num_calls, calls_.size());
+  EXPECT_EQ(kPts, calls_[num_calls].pts);
+
+  // A complete PES packet of known size is not discarded.
+  FeedPes(BuildPes(kVideoStreamId, es2, true), 184);
+  EXPECT_EQ(1, num_discards_);
+  EXPECT_EQ(1, ts_section_pes_.num_truncated_pes());
+}
+
+TEST_F(TsSectionPesTest, HeaderSpanningPayloads) {
+  const std::vector<uint8_t> es = BuildEs(500);
+  const std::vector<uint8_t> pes = BuildPes(kVideoStreamId, es, true);
+  // Split within the PES header, before and after the fixed part.
+  for (size_t split = 1; split < kPesHeaderSize; ++split) {
+    calls_.clear();
+    ASSERT_TRUE(ts_section_pes_.Parse(true, &pes[0], split));
+    EXPECT_TRUE(calls_.empty());
+    ASSERT_TRUE(
+        ts_section_pes_.Parse(false, &pes[split], pes.size() - split));
+    EXPECT_EQ(es, ReceivedEs());
+    ASSERT_FALSE(calls_.empty());
+    EXPECT_EQ(kPts, calls_[0].pts);
+  }
+}
+
+TEST_F(TsSectionPesTest, UnknownSizeEndsAtNextUnitStart) {
+  const std::vector<uint8_t> es1 = BuildEs(700);
+  const std::vector<uint8_t> es2 = BuildEs(300);
+  FeedPes(BuildPes(kVideoStreamId, es1, false), 184);
+  EXPECT_EQ(es1, ReceivedEs());
+
+  const size_t num_calls = calls_.size();
+  FeedPes(BuildPes(kVideoStreamId, es2, false), 184);
+  ASSERT_LT(num_calls, calls_.size());
+  EXPECT_EQ(kPts, calls_[num_calls].pts);
+
+  std::vector<uint8_t> expected_es(es1);
+  expected_es.insert(expected_es.end(), es2.begin(), es2.end());
+  EXPECT_EQ(expected_es, ReceivedEs());
+  // A PES packet of unknown size is never truncated.
+  EXPECT_EQ(0, num_discards_);
+  EXPECT_EQ(0, ts_section_pes_.num_truncated_pes());
+}
+
+TEST_F(TsSectionPesTest, UnknownStreamIdIgnored) {
+  FeedPes(BuildPes(kPaddingStreamId, BuildEs(400), true), 184);
+  EXPECT_TRUE(calls_.empty());
+}
+
+TEST_F(TsSectionPesTest, InvalidStartCode) {
+  std::vector<uint8_t> pes = BuildPes(kVideoStreamId, BuildEs(100), true);
+  pes[2] = 0x02;
+  EXPECT_FALSE(ts_section_pes_.Parse(true, &pes[0], pes.size()));
+  EXPECT_TRUE(calls_.empty());
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace edash_packager
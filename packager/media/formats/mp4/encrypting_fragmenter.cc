@@ -6,21 +6,50 @@
 
 #include "packager/media/formats/mp4/encrypting_fragmenter.h"
 
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
 #include "packager/media/base/aes_encryptor.h"
 #include "packager/media/base/buffer_reader.h"
+#include "packager/media/base/buffer_writer.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
+#include "packager/media/base/pipeline_stats.h"
+#include "packager/media/base/worker_pool.h"
 #include "packager/media/formats/mp4/box_definitions.h"
-#include "packager/media/formats/mp4/cenc.h"
+
+namespace edash_packager {
+namespace media {
+namespace mp4 {
 
 namespace {
 // Generate 64bit IV by default.
 const size_t kDefaultIvSize = 8u;
-}  // namespace
 
-namespace edash_packager {
-namespace media {
-namespace mp4 {
+// Encrypt |sample| into |dest| with |encryptor|. Only the cipher bytes of
+// |subsamples| are encrypted if there are subsamples, the whole sample
+// otherwise. |dest| should have room for the sample data.
+void EncryptSampleData(AesCtrEncryptor* encryptor,
+                       const MediaSample& sample,
+                       const std::vector<SubsampleEntry>& subsamples,
+                       uint8_t* dest) {
+  const uint8_t* data = sample.data();
+  if (subsamples.empty()) {
+    CHECK(encryptor->Encrypt(data, sample.data_size(), dest));
+    return;
+  }
+  for (std::vector<SubsampleEntry>::const_iterator it = subsamples.begin();
+       it != subsamples.end();
+       ++it) {
+    memcpy(dest, data, it->clear_bytes);
+    data += it->clear_bytes;
+    dest += it->clear_bytes;
+    CHECK(encryptor->Encrypt(data, it->cipher_bytes, dest));
+    data += it->cipher_bytes;
+    dest += it->cipher_bytes;
+  }
+}
+
+}  // namespace
 
 EncryptingFragmenter::EncryptingFragmenter(
     TrackFragment* traf,
@@ -30,7 +59,11 @@ EncryptingFragmenter::EncryptingFragmenter(
     : Fragmenter(traf),
       encryption_key_(encryption_key.Pass()),
       nalu_length_size_(nalu_length_size),
-      clear_time_(clear_time) {
+      clear_time_(clear_time),
+      encryption_pool_(NULL),
+      batches_done_cv_(&batches_lock_),
+      num_pending_batches_(0),
+      encryption_stats_(NULL) {
   DCHECK(encryption_key_);
 }
 EncryptingFragmenter::~EncryptingFragmenter() {}
@@ -43,11 +76,6 @@ Status EncryptingFragmenter::AddSample(scoped_refptr<MediaSample> sample) {
     if (!status.ok())
       return status;
   }
-  if (encryptor_) {
-    Status status = EncryptSample(sample);
-    if (!status.ok())
-      return status;
-  }
   return Fragmenter::AddSample(sample);
 }
 
@@ -76,6 +104,8 @@ Status EncryptingFragmenter::InitializeFragment(int64_t first_sample_dts) {
 void EncryptingFragmenter::FinalizeFragment() {
   if (encryptor_) {
     DCHECK_LE(clear_time_, 0);
+    if (encryption_pool_)
+      EncryptPendingSamples();
     FinalizeFragmentForEncryption();
   } else {
     DCHECK_GT(clear_time_, 0);
@@ -84,6 +114,11 @@ void EncryptingFragmenter::FinalizeFragment() {
   Fragmenter::FinalizeFragment();
 }
 
+void EncryptingFragmenter::EnableParallelEncryption(WorkerPool* worker_pool) {
+  DCHECK(worker_pool);
+  encryption_pool_ = worker_pool;
+}
+
 Status EncryptingFragmenter::PrepareFragmentForEncryption(
     bool enable_encryption) {
   return (!enable_encryption || encryptor_) ? Status::OK : CreateEncryptor();
@@ -124,47 +159,145 @@ Status EncryptingFragmenter::CreateEncryptor() {
   return Status::OK;
 }
 
-void EncryptingFragmenter::EncryptBytes(uint8_t* data, uint32_t size) {
-  DCHECK(encryptor_);
-  CHECK(encryptor_->Encrypt(data, size, data));
-}
-
-Status EncryptingFragmenter::EncryptSample(scoped_refptr<MediaSample> sample) {
-  DCHECK(encryptor_);
+Status EncryptingFragmenter::AppendSampleData(
+    scoped_refptr<MediaSample> sample) {
+  if (!encryptor_)
+    return Fragmenter::AppendSampleData(sample);
 
   FrameCENCInfo cenc_info(encryptor_->iv());
-  uint8_t* data = sample->writable_data();
-  if (!IsSubsampleEncryptionRequired()) {
-    EncryptBytes(data, sample->data_size());
-  } else {
-    BufferReader reader(data, sample->data_size());
-    while (reader.HasBytes(1)) {
-      uint64_t nalu_length;
-      if (!reader.ReadNBytesInto8(&nalu_length, nalu_length_size_))
-        return Status(error::MUXER_FAILURE, "Fail to read nalu_length.");
-
-      SubsampleEntry subsample;
-      subsample.clear_bytes = nalu_length_size_ + 1;
-      subsample.cipher_bytes = nalu_length - 1;
-      if (!reader.SkipBytes(nalu_length)) {
-        return Status(error::MUXER_FAILURE,
-                      "Sample size does not match nalu_length.");
-      }
-
-      EncryptBytes(data + subsample.clear_bytes, subsample.cipher_bytes);
-      cenc_info.AddSubsample(subsample);
-      data += nalu_length_size_ + nalu_length;
-    }
+  size_t encrypted_size = sample->data_size();
+  if (IsSubsampleEncryptionRequired()) {
+    Status status = GenerateSubsamples(*sample, &cenc_info);
+    if (!status.ok())
+      return status;
+    encrypted_size = 0;
+    for (size_t i = 0; i < cenc_info.subsamples().size(); ++i)
+      encrypted_size += cenc_info.subsamples()[i].cipher_bytes;
 
     // The length of per-sample auxiliary datum, defined in CENC ch. 7.
     traf()->auxiliary_size.sample_info_sizes.push_back(cenc_info.ComputeSize());
   }
-
   cenc_info.Write(aux_data());
+
+  if (encryption_pool_) {
+    // The sample is encrypted with the rest of the fragment in
+    // FinalizeFragment. Only its IV is needed to move on to the next sample.
+    pending_samples_.resize(pending_samples_.size() + 1);
+    pending_samples_.back().sample = sample;
+    pending_samples_.back().cenc_info = cenc_info;
+    encryptor_->SkipKeyStreamAndUpdateIv(encrypted_size);
+    return Status::OK;
+  }
+
+  // Encrypt straight into the fragment buffer, so the sample data is read
+  // once and written once, and the sample itself is left untouched.
+  ScopedStageTimer encryption_timer(encryption_stats_);
+  encryption_timer.set_count(1);
+  encryption_timer.set_bytes(sample->data_size());
+  EncryptSampleData(encryptor_.get(),
+                    *sample,
+                    cenc_info.subsamples(),
+                    data()->Grow(sample->data_size()));
   encryptor_->UpdateIv();
   return Status::OK;
 }
 
+Status EncryptingFragmenter::GenerateSubsamples(const MediaSample& sample,
+                                                FrameCENCInfo* cenc_info) {
+  DCHECK(IsSubsampleEncryptionRequired());
+
+  BufferReader reader(sample.data(), sample.data_size());
+  while (reader.HasBytes(1)) {
+    uint64_t nalu_length;
+    if (!reader.ReadNBytesInto8(&nalu_length, nalu_length_size_))
+      return Status(error::MUXER_FAILURE, "Fail to read nalu_length.");
+
+    SubsampleEntry subsample;
+    subsample.clear_bytes = nalu_length_size_ + 1;
+    subsample.cipher_bytes = nalu_length - 1;
+    if (!reader.SkipBytes(nalu_length)) {
+      return Status(error::MUXER_FAILURE,
+                    "Sample size does not match nalu_length.");
+    }
+    cenc_info->AddSubsample(subsample);
+  }
+  return Status::OK;
+}
+
+void EncryptingFragmenter::EncryptPendingSamples() {
+  DCHECK(encryption_pool_);
+  if (pending_samples_.empty())
+    return;
+
+  uint64_t total_size = 0;
+  for (size_t i = 0; i < pending_samples_.size(); ++i)
+    total_size += pending_samples_[i].sample->data_size();
+  // Records the wall time of the parallel encryption.
+  ScopedStageTimer encryption_timer(encryption_stats_);
+  encryption_timer.set_count(pending_samples_.size());
+  encryption_timer.set_bytes(total_size);
+  uint8_t* dest = data()->Grow(total_size);
+
+  // Split the samples into consecutive batches of about the same size, one
+  // per thread.
+  const uint64_t batch_size =
+      total_size / encryption_pool_->num_threads() + 1;
+  std::vector<size_t> batch_ends;
+  uint64_t size = 0;
+  for (size_t i = 0; i < pending_samples_.size(); ++i) {
+    size += pending_samples_[i].sample->data_size();
+    if (size >= batch_size || i + 1 == pending_samples_.size()) {
+      batch_ends.push_back(i + 1);
+      size = 0;
+    }
+  }
+
+  {
+    base::AutoLock auto_lock(batches_lock_);
+    DCHECK_EQ(0u, num_pending_batches_);
+    num_pending_batches_ = batch_ends.size();
+  }
+  size_t begin = 0;
+  for (size_t i = 0; i < batch_ends.size(); ++i) {
+    encryption_pool_->PostTask(
+        base::Bind(&EncryptingFragmenter::EncryptSampleBatch,
+                   base::Unretained(this), begin, batch_ends[i], dest));
+    for (; begin < batch_ends[i]; ++begin)
+      dest += pending_samples_[begin].sample->data_size();
+  }
+
+  base::AutoLock auto_lock(batches_lock_);
+  while (num_pending_batches_ > 0)
+    batches_done_cv_.Wait();
+  pending_samples_.clear();
+}
+
+void EncryptingFragmenter::EncryptSampleBatch(size_t begin,
+                                              size_t end,
+                                              uint8_t* dest) {
+  DCHECK_LT(begin, end);
+  DCHECK_LE(end, pending_samples_.size());
+
+  AesCtrEncryptor encryptor;
+  CHECK(encryptor.InitializeWithIv(encryption_key_->key,
+                                   pending_samples_[begin].cenc_info.iv()));
+  for (size_t i = begin; i < end; ++i) {
+    const PendingSample& pending_sample = pending_samples_[i];
+    if (i != begin)
+      CHECK(encryptor.SetIv(pending_sample.cenc_info.iv()));
+    EncryptSampleData(&encryptor,
+                      *pending_sample.sample,
+                      pending_sample.cenc_info.subsamples(),
+                      dest);
+    dest += pending_sample.sample->data_size();
+  }
+
+  base::AutoLock auto_lock(batches_lock_);
+  DCHECK_GT(num_pending_batches_, 0u);
+  if (--num_pending_batches_ == 0)
+    batches_done_cv_.Signal();
+}
+
 }  // namespace mp4
 }  // namespace media
 }  // namespace edash_packager
@@ -7,6 +7,11 @@
 #ifndef MEDIA_FORMATS_MP4_ENCRYPTING_FRAGMENTER_H_
 #define MEDIA_FORMATS_MP4_ENCRYPTING_FRAGMENTER_H_
 
+#include <vector>
+
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/formats/mp4/cenc.h"
 #include "packager/media/formats/mp4/fragmenter.h"
 
 namespace edash_packager {
@@ -14,6 +19,8 @@ namespace media {
 
 class AesCtrEncryptor;
 struct EncryptionKey;
+class StageStats;
+class WorkerPool;
 
 namespace mp4 {
 
@@ -40,6 +47,21 @@ class EncryptingFragmenter : public Fragmenter {
   virtual void FinalizeFragment() OVERRIDE;
   /// @}
 
+  /// Encrypt the samples of each fragment in parallel when the fragment is
+  /// finalized, instead of one by one as they are added. The IVs and
+  /// subsample information are still generated in sample order.
+  /// @param worker_pool runs the encryption. It may be shared with other
+  ///        fragmenters. The caller retains ownership. It should outlive the
+  ///        fragmenter.
+  void EnableParallelEncryption(WorkerPool* worker_pool);
+
+  /// Record the encryption of the samples.
+  /// @param encryption_stats is the StageStats of the encryption. The caller
+  ///        retains ownership. It should outlive the fragmenter.
+  void set_encryption_stats(StageStats* encryption_stats) {
+    encryption_stats_ = encryption_stats;
+  }
+
  protected:
   /// Prepare current fragment for encryption.
   /// @return OK on success, an error status otherwise.
@@ -47,6 +69,10 @@ class EncryptingFragmenter : public Fragmenter {
   /// Finalize current fragment for encryption.
   virtual void FinalizeFragmentForEncryption();
 
+  /// Fragmenter implementation override. Encrypts the sample data, if
+  /// encryption is enabled, directly into the mdat buffer.
+  virtual Status AppendSampleData(scoped_refptr<MediaSample> sample) OVERRIDE;
+
   /// Create the encryptor for the internal encryption key. The existing
   /// encryptor will be reset if it is not NULL.
   /// @return OK on success, an error status otherwise.
@@ -60,8 +86,21 @@ class EncryptingFragmenter : public Fragmenter {
   }
 
  private:
-  void EncryptBytes(uint8_t* data, uint32_t size);
-  Status EncryptSample(scoped_refptr<MediaSample> sample);
+  // A sample of the current fragment waiting for parallel encryption.
+  struct PendingSample {
+    scoped_refptr<MediaSample> sample;
+    FrameCENCInfo cenc_info;
+  };
+
+  // Fill in the subsamples of |cenc_info| from the NAL units of |sample|.
+  Status GenerateSubsamples(const MediaSample& sample,
+                            FrameCENCInfo* cenc_info);
+  // Encrypt |pending_samples_| on |encryption_pool_| into the mdat buffer.
+  void EncryptPendingSamples();
+  // Encrypt |pending_samples_| in [|begin|, |end|) into |dest|. Runs on
+  // |encryption_pool_|. Signals |batches_done_cv_| when it is the last batch
+  // of the fragment to complete.
+  void EncryptSampleBatch(size_t begin, size_t end, uint8_t* dest);
 
   // Should we enable subsample encryption?
   bool IsSubsampleEncryptionRequired() { return nalu_length_size_ != 0; }
@@ -74,6 +113,18 @@ class EncryptingFragmenter : public Fragmenter {
   const uint8_t nalu_length_size_;
   int64_t clear_time_;
 
+  // Only set if parallel encryption is enabled. Not owned.
+  WorkerPool* encryption_pool_;
+  std::vector<PendingSample> pending_samples_;
+  // The pool may be shared, so the batches of this fragmenter are counted
+  // rather than waiting for the pool to be idle.
+  base::Lock batches_lock_;
+  base::ConditionVariable batches_done_cv_;
+  // Protected by |batches_lock_|.
+  size_t num_pending_batches_;
+  // Can be NULL.
+  StageStats* encryption_stats_;
+
   DISALLOW_COPY_AND_ASSIGN(EncryptingFragmenter);
 };
 
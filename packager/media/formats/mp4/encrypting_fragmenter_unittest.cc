@@ -0,0 +1,166 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/key_source.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/test/status_test_util.h"
+#include "packager/media/base/worker_pool.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/encrypting_fragmenter.h"
+
+namespace {
+
+const uint8_t kKey[] = {0xe5, 0x00, 0x7e, 0x6e, 0x9d, 0xcd, 0x5a, 0xc0,
+                        0x95, 0x20, 0x2e, 0xd3, 0x75, 0x83, 0x82, 0xcd};
+const uint8_t kIv64[] = {0x4a, 0x72, 0x10, 0x2e, 0x53, 0x5c, 0x18, 0x20};
+const uint8_t kIv128[] = {0x4a, 0x72, 0x10, 0x2e, 0x53, 0x5c, 0x18, 0x20,
+                          0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0};
+const int kNumSamples = 50;
+const int64_t kSampleDuration = 1000;
+const size_t kNumEncryptionThreads = 4;
+
+struct EncryptingFragmenterTestCase {
+  const uint8_t* iv;
+  size_t iv_size;
+  // Subsample encryption is used if it is not 0.
+  uint8_t nalu_length_size;
+};
+
+const EncryptingFragmenterTestCase kEncryptingFragmenterTestCases[] = {
+    {kIv64, arraysize(kIv64), 0},
+    {kIv64, arraysize(kIv64), 4},
+    {kIv128, arraysize(kIv128), 0},
+    {kIv128, arraysize(kIv128), 4},
+};
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+namespace mp4 {
+
+class EncryptingFragmenterTest
+    : public ::testing::TestWithParam<EncryptingFragmenterTestCase> {
+ public:
+  virtual void SetUp() OVERRIDE {
+    iv_.assign(GetParam().iv, GetParam().iv + GetParam().iv_size);
+    nalu_length_size_ = GetParam().nalu_length_size;
+  }
+
+ protected:
+  scoped_ptr<EncryptingFragmenter> CreateFragmenter(TrackFragment* traf) {
+    scoped_ptr<EncryptionKey> encryption_key(new EncryptionKey());
+    encryption_key->key.assign(kKey, kKey + arraysize(kKey));
+    encryption_key->iv = iv_;
+    // No clear lead.
+    const int64_t kClearTime = 0;
+    return scoped_ptr<EncryptingFragmenter>(new EncryptingFragmenter(
+        traf, encryption_key.Pass(), kClearTime, nalu_length_size_));
+  }
+
+  // Create a sample of |sample_index|-dependent size. Samples are made of
+  // length-prefixed NAL units if subsample encryption is used.
+  scoped_refptr<MediaSample> CreateSample(int sample_index) {
+    BufferWriter writer;
+    const int num_nalus = nalu_length_size_ ? sample_index % 3 + 1 : 1;
+    for (int i = 0; i < num_nalus; ++i) {
+      const uint32_t nalu_size = 50 + sample_index * 37 % 300 + i * 7;
+      if (nalu_length_size_)
+        writer.AppendNBytes(nalu_size, nalu_length_size_);
+      for (uint32_t j = 0; j < nalu_size; ++j)
+        writer.AppendInt(static_cast<uint8_t>(j * sample_index));
+    }
+    scoped_refptr<MediaSample> sample =
+        MediaSample::CopyFrom(writer.Buffer(), writer.Size(), true);
+    sample->set_dts(sample_index * kSampleDuration);
+    sample->set_pts(sample_index * kSampleDuration);
+    sample->set_duration(kSampleDuration);
+    return sample;
+  }
+
+  // Check that |fragmenter| produced the same fragment as |expected|.
+  void CheckSameFragment(EncryptingFragmenter* expected,
+                         const TrackFragment& expected_traf,
+                         EncryptingFragmenter* fragmenter,
+                         const TrackFragment& traf) {
+    BufferWriter* expected_data = expected->data();
+    BufferWriter* data = fragmenter->data();
+    ASSERT_EQ(expected_data->Size(), data->Size());
+    EXPECT_EQ(0, memcmp(expected_data->Buffer(), data->Buffer(),
+                        expected_data->Size()));
+
+    BufferWriter* expected_aux_data = expected->aux_data();
+    BufferWriter* aux_data = fragmenter->aux_data();
+    ASSERT_EQ(expected_aux_data->Size(), aux_data->Size());
+    EXPECT_EQ(0, memcmp(expected_aux_data->Buffer(), aux_data->Buffer(),
+                        expected_aux_data->Size()));
+    EXPECT_EQ(expected_traf.auxiliary_size.sample_info_sizes,
+              traf.auxiliary_size.sample_info_sizes);
+  }
+
+  std::vector<uint8_t> iv_;
+  uint8_t nalu_length_size_;
+};
+
+// Parallel encryption should produce the same fragment as serial encryption,
+// including when several fragmenters share the encryption threads.
+TEST_P(EncryptingFragmenterTest, ParallelEncryption) {
+  WorkerPool encryption_pool("EncryptionThread", kNumEncryptionThreads);
+
+  TrackFragment serial_traf;
+  scoped_ptr<EncryptingFragmenter> serial_fragmenter =
+      CreateFragmenter(&serial_traf);
+  TrackFragment parallel_traf;
+  scoped_ptr<EncryptingFragmenter> parallel_fragmenter =
+      CreateFragmenter(&parallel_traf);
+  parallel_fragmenter->EnableParallelEncryption(&encryption_pool);
+  TrackFragment other_parallel_traf;
+  scoped_ptr<EncryptingFragmenter> other_parallel_fragmenter =
+      CreateFragmenter(&other_parallel_traf);
+  other_parallel_fragmenter->EnableParallelEncryption(&encryption_pool);
+
+  // Two fragments, to check that the IVs carry over.
+  const int kNumFragments = 2;
+  for (int fragment = 0; fragment < kNumFragments; ++fragment) {
+    for (int i = 0; i < kNumSamples; ++i) {
+      scoped_refptr<MediaSample> sample =
+          CreateSample(fragment * kNumSamples + i);
+      ASSERT_OK(serial_fragmenter->AddSample(sample));
+      ASSERT_OK(parallel_fragmenter->AddSample(sample));
+      ASSERT_OK(other_parallel_fragmenter->AddSample(sample));
+    }
+    serial_fragmenter->FinalizeFragment();
+    {
+      // Both parallel fragmenters use the pool at the same time.
+      ClosureThread other_thread(
+          "FinalizeFragment",
+          base::Bind(&EncryptingFragmenter::FinalizeFragment,
+                     base::Unretained(other_parallel_fragmenter.get())));
+      other_thread.Start();
+      parallel_fragmenter->FinalizeFragment();
+      other_thread.Join();
+    }
+
+    CheckSameFragment(serial_fragmenter.get(), serial_traf,
+                      parallel_fragmenter.get(), parallel_traf);
+    CheckSameFragment(serial_fragmenter.get(), serial_traf,
+                      other_parallel_fragmenter.get(), other_parallel_traf);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(IvSizesAndSubsamples,
+                        EncryptingFragmenterTest,
+                        ::testing::ValuesIn(kEncryptingFragmenterTestCases));
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace edash_packager
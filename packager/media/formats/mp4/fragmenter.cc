@@ -43,13 +43,16 @@ Status Fragmenter::AddSample(scoped_refptr<MediaSample> sample) {
       return status;
   }
 
+  Status status = AppendSampleData(sample);
+  if (!status.ok())
+    return status;
+
   // Fill in sample parameters. It will be optimized later.
   traf_->runs[0].sample_sizes.push_back(sample->data_size());
   traf_->runs[0].sample_durations.push_back(sample->duration());
   traf_->runs[0].sample_flags.push_back(
       sample->is_key_frame() ? 0 : TrackFragmentHeader::kNonKeySampleMask);
 
-  data_->AppendArray(sample->data(), sample->data_size());
   fragment_duration_ += sample->duration();
 
   int64_t pts = sample->pts();
@@ -70,6 +73,11 @@ Status Fragmenter::AddSample(scoped_refptr<MediaSample> sample) {
   return Status::OK;
 }
 
+Status Fragmenter::AppendSampleData(scoped_refptr<MediaSample> sample) {
+  data_->AppendArray(sample->data(), sample->data_size());
+  return Status::OK;
+}
+
 Status Fragmenter::InitializeFragment(int64_t first_sample_dts) {
   fragment_initialized_ = true;
   fragment_finalized_ = false;
@@ -63,6 +63,11 @@ class Fragmenter {
  protected:
   TrackFragment* traf() { return traf_; }
 
+  /// Append the data of @a sample to the mdat buffer of the fragment.
+  /// Subclasses can override it to transform the data while it is copied.
+  /// @return OK on success, an error status otherwise.
+  virtual Status AppendSampleData(scoped_refptr<MediaSample> sample);
+
   /// Optimize sample entries table. If all values in @a entries are identical,
   /// then @a entries is cleared and the value is assigned to @a default_value;
   /// otherwise it is a NOP. Return true if the table is optimized.
@@ -57,6 +57,7 @@
       ],
       'dependencies': [
         '../../base/media_base.gyp:base',
+        '../../file/file.gyp:file',
       ],
     },
     {
@@ -69,6 +70,7 @@
         'chunk_info_iterator_unittest.cc',
         'composition_offset_iterator_unittest.cc',
         'decoding_time_iterator_unittest.cc',
+        'encrypting_fragmenter_unittest.cc',
         'es_descriptor_unittest.cc',
         'mp4_media_parser_unittest.cc',
         'sync_sample_iterator_unittest.cc',
@@ -0,0 +1,240 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/file/file.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/mp4_media_parser.h"
+#include "packager/media/test/benchmark_util.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace {
+
+const char kFragmentedMp4File[] = "bear-1280x720-av_frag.mp4";
+const char kProgressiveMp4File[] = "bear-1280x720.mp4";
+const uint64_t kReadSamplesMaxBytes = 0x10000;
+
+// About an hour of 30fps video in the 'moov' box.
+const uint32_t kNumMoovSamples = 108000;
+const uint32_t kSamplesPerChunk = 30;
+const uint32_t kKeyFrameInterval = 60;
+// Ten seconds of video in the 'moof' box.
+const uint32_t kNumMoofSamples = 300;
+
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+namespace mp4 {
+
+class MP4Benchmark : public ::testing::Test {
+ public:
+  MP4Benchmark() : num_samples_(0) {}
+
+  void ParseFragmentedFile() {
+    ParseBuffer(fragmented_file_);
+  }
+
+  void ParseProgressiveFile() {
+    ParseBuffer(progressive_file_);
+  }
+
+  void ReadProgressiveFile() {
+    num_samples_ = 0;
+    File* file = File::Open(
+        GetTestDataFilePath(kProgressiveMp4File).value().c_str(), "r");
+    ASSERT_TRUE(file != NULL);
+    MP4MediaParser parser;
+    InitializeParser(&parser);
+    ASSERT_TRUE(parser.LoadMoov(file));
+    ASSERT_TRUE(parser.random_access());
+    bool eos = false;
+    while (!eos)
+      ASSERT_TRUE(parser.ReadSamples(kReadSamplesMaxBytes, &eos));
+    ASSERT_TRUE(file->Close());
+    ASSERT_LT(0u, num_samples_);
+  }
+
+  void WriteMoov() {
+    BufferWriter writer;
+    moov_.Write(&writer);
+    box_size_ = writer.Size();
+  }
+
+  void WriteMoof() {
+    BufferWriter writer;
+    moof_.Write(&writer);
+    box_size_ = writer.Size();
+  }
+
+ protected:
+  void InitializeParser(MP4MediaParser* parser) {
+    parser->Init(base::Bind(&MP4Benchmark::OnInit, base::Unretained(this)),
+                 base::Bind(&MP4Benchmark::OnNewSample,
+                            base::Unretained(this)),
+                 NULL);
+  }
+
+  void ParseBuffer(const std::vector<uint8_t>& buffer) {
+    num_samples_ = 0;
+    MP4MediaParser parser;
+    InitializeParser(&parser);
+    ASSERT_TRUE(parser.Parse(&buffer[0], buffer.size()));
+    ASSERT_LT(0u, num_samples_);
+  }
+
+  void OnInit(const std::vector<scoped_refptr<StreamInfo> >& stream_infos) {}
+
+  bool OnNewSample(uint32_t track_id,
+                   const scoped_refptr<MediaSample>& sample) {
+    ++num_samples_;
+    return true;
+  }
+
+  // A video track with a large sample table, as for a long progressive file.
+  void PrepareMoov() {
+    moov_.header.timescale = 1000;
+    moov_.header.next_track_id = 2;
+
+    Track track;
+    track.header.track_id = 1;
+    track.header.width = 1280;
+    track.header.height = 720;
+    track.media.header.timescale = 30000;
+    track.media.handler.type = kVideo;
+
+    SampleDescription& description =
+        track.media.information.sample_table.description;
+    description.type = kVideo;
+    VideoSampleEntry entry;
+    entry.format = FOURCC_AVC1;
+    entry.width = 1280;
+    entry.height = 720;
+    entry.avcc.data = GenerateSyntheticData(32);
+    description.video_entries.push_back(entry);
+
+    SampleTable& sample_table = track.media.information.sample_table;
+    DecodingTime decoding_time;
+    decoding_time.sample_count = kNumMoovSamples;
+    decoding_time.sample_delta = 1001;
+    sample_table.decoding_time_to_sample.decoding_time.push_back(
+        decoding_time);
+
+    ChunkInfo chunk_info;
+    chunk_info.first_chunk = 1;
+    chunk_info.samples_per_chunk = kSamplesPerChunk;
+    chunk_info.sample_description_index = 1;
+    sample_table.sample_to_chunk.chunk_info.push_back(chunk_info);
+
+    const std::vector<uint8_t> random_sizes =
+        GenerateSyntheticData(kNumMoovSamples);
+    sample_table.sample_size.sample_size = 0;
+    sample_table.sample_size.sample_count = kNumMoovSamples;
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < kNumMoovSamples; ++i) {
+      const uint32_t size = 1000 + random_sizes[i] * 100;
+      sample_table.sample_size.sizes.push_back(size);
+      if (i % kSamplesPerChunk == 0)
+        sample_table.chunk_large_offset.offsets.push_back(offset);
+      if (i % kKeyFrameInterval == 0)
+        sample_table.sync_sample.sample_number.push_back(i + 1);
+      offset += size;
+    }
+    moov_.tracks.push_back(track);
+  }
+
+  // A video fragment with all the per sample fields present in 'trun'.
+  void PrepareMoof() {
+    moof_.header.sequence_number = 1;
+
+    TrackFragment traf;
+    traf.header.track_id = 1;
+    traf.header.flags = TrackFragmentHeader::kDefaultBaseIsMoofMask;
+    traf.decode_time.decode_time = 0;
+
+    TrackFragmentRun trun;
+    trun.flags = TrackFragmentRun::kDataOffsetPresentMask |
+                 TrackFragmentRun::kSampleDurationPresentMask |
+                 TrackFragmentRun::kSampleSizePresentMask |
+                 TrackFragmentRun::kSampleFlagsPresentMask |
+                 TrackFragmentRun::kSampleCompTimeOffsetsPresentMask;
+    trun.sample_count = kNumMoofSamples;
+    trun.data_offset = 0;
+    const std::vector<uint8_t> random_sizes =
+        GenerateSyntheticData(kNumMoofSamples);
+    for (uint32_t i = 0; i < kNumMoofSamples; ++i) {
+      trun.sample_durations.push_back(1001);
+      trun.sample_sizes.push_back(1000 + random_sizes[i] * 100);
+      trun.sample_flags.push_back(
+          i == 0 ? 0 : TrackFragmentHeader::kNonKeySampleMask);
+      trun.sample_composition_time_offsets.push_back((i % 3) * 1001);
+    }
+    traf.runs.push_back(trun);
+    moof_.tracks.push_back(traf);
+  }
+
+  std::vector<uint8_t> fragmented_file_;
+  std::vector<uint8_t> progressive_file_;
+  size_t num_samples_;
+  Movie moov_;
+  MovieFragment moof_;
+  size_t box_size_;
+};
+
+TEST_F(MP4Benchmark, ParseFragmented) {
+  fragmented_file_ = ReadTestDataFile(kFragmentedMp4File);
+  ASSERT_FALSE(fragmented_file_.empty());
+  RunThroughputBenchmark(
+      "MP4MediaParserFragmented",
+      fragmented_file_.size(),
+      base::Bind(&MP4Benchmark::ParseFragmentedFile, base::Unretained(this)));
+}
+
+TEST_F(MP4Benchmark, ParseProgressive) {
+  progressive_file_ = ReadTestDataFile(kProgressiveMp4File);
+  ASSERT_FALSE(progressive_file_.empty());
+  RunThroughputBenchmark(
+      "MP4MediaParserProgressive",
+      progressive_file_.size(),
+      base::Bind(&MP4Benchmark::ParseProgressiveFile, base::Unretained(this)));
+}
+
+TEST_F(MP4Benchmark, ReadSamplesProgressive) {
+  progressive_file_ = ReadTestDataFile(kProgressiveMp4File);
+  ASSERT_FALSE(progressive_file_.empty());
+  RunThroughputBenchmark(
+      "MP4MediaParserProgressiveRandomAccess",
+      progressive_file_.size(),
+      base::Bind(&MP4Benchmark::ReadProgressiveFile, base::Unretained(this)));
+}
+
+TEST_F(MP4Benchmark, WriteMoov) {
+  PrepareMoov();
+  WriteMoov();
+  RunThroughputBenchmark(
+      "BoxWriteMoov",
+      box_size_,
+      base::Bind(&MP4Benchmark::WriteMoov, base::Unretained(this)));
+}
+
+TEST_F(MP4Benchmark, WriteMoof) {
+  PrepareMoof();
+  WriteMoof();
+  RunThroughputBenchmark(
+      "BoxWriteMoof",
+      box_size_,
+      base::Bind(&MP4Benchmark::WriteMoof, base::Unretained(this)));
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace edash_packager
@@ -4,19 +4,23 @@
 
 #include "packager/media/formats/mp4/mp4_media_parser.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "packager/base/callback.h"
 #include "packager/base/callback_helpers.h"
 #include "packager/base/logging.h"
 #include "packager/base/memory/ref_counted.h"
+#include "packager/base/stl_util.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/media/base/aes_encryptor.h"
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/decrypt_config.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/base/video_stream_info.h"
+#include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 #include "packager/media/formats/mp4/box_reader.h"
 #include "packager/media/formats/mp4/es_descriptor.h"
@@ -34,6 +38,12 @@ uint64_t Rescale(uint64_t time_in_old_scale,
 
 const char kWidevineKeySystemId[] = "edef8ba979d64acea3c827dcd51d21ed";
 
+// Enough to hold a box header with 64-bit box size.
+const size_t kBoxHeaderReadSize = 16;
+// Minimum size of the reads in random access mode. Samples reference the
+// read buffers directly instead of being copied out of them.
+const size_t kReadBufferSize = 0x100000;  // 1MB.
+
 }  // namespace
 
 namespace edash_packager {
@@ -41,7 +51,12 @@ namespace media {
 namespace mp4 {
 
 MP4MediaParser::MP4MediaParser()
-    : state_(kWaitingForInit), moof_head_(0), mdat_tail_(0) {}
+    : state_(kWaitingForInit),
+      moof_head_(0),
+      mdat_tail_(0),
+      random_access_file_(NULL),
+      random_access_position_(0),
+      read_buffer_offset_(0) {}
 
 MP4MediaParser::~MP4MediaParser() {
   STLDeleteValues(&decryptor_map_);
@@ -108,6 +123,167 @@ bool MP4MediaParser::Parse(const uint8_t* buf, int size) {
   return true;
 }
 
+bool MP4MediaParser::LoadMoov(File* file) {
+  DCHECK(file);
+  DCHECK_EQ(state_, kParsingBoxes);
+  DCHECK(!moov_);
+
+  uint64_t start_position;
+  if (!file->Tell(&start_position)) {
+    DVLOG(1) << "File is not seekable. 'moov' will be parsed from the stream.";
+    return true;
+  }
+
+  const int64_t file_size = file->Size();
+  if (file_size < 0) {
+    DVLOG(1) << "File size is unknown. 'moov' will be parsed from the stream.";
+    return true;
+  }
+
+  // Walk through the top-level box headers until 'moov' is found.
+  std::vector<uint8_t> moov_data;
+  uint64_t moov_position = 0;
+  uint64_t position = 0;
+  while (moov_data.empty()) {
+    uint8_t header[kBoxHeaderReadSize];
+    RCHECK(file->Seek(position));
+    int64_t bytes_read = file->Read(header, sizeof(header));
+    if (bytes_read <= 0)
+      break;
+
+    FourCC type;
+    uint64_t box_size;
+    bool err = false;
+    if (!BoxReader::StartTopLevelBox(header, bytes_read, &type, &box_size,
+                                     &err)) {
+      RCHECK(!err);
+      break;
+    }
+
+    if (type == FOURCC_MOOV) {
+      // |box_size| comes straight from the file. Make sure the box fits in the
+      // file before allocating memory for it.
+      if (box_size > static_cast<uint64_t>(file_size) - position) {
+        LOG(ERROR) << "'moov' box size " << box_size << " at position "
+                   << position << " exceeds the file size " << file_size;
+        return false;
+      }
+      moov_data.resize(box_size);
+      RCHECK(file->Seek(position));
+      RCHECK(file->Read(vector_as_array(&moov_data), box_size) ==
+             static_cast<int64_t>(box_size));
+      moov_position = position;
+    }
+    position += box_size;
+  }
+
+  if (moov_data.empty()) {
+    // Leave it to the stream parser to report the error, if any.
+    DVLOG(1) << "No 'moov' box found while scanning top-level boxes.";
+    RCHECK(file->Seek(start_position));
+    return true;
+  }
+
+  bool err = false;
+  scoped_ptr<BoxReader> reader(BoxReader::ReadTopLevelBox(
+      vector_as_array(&moov_data), moov_data.size(), &err));
+  RCHECK(reader);
+  scoped_ptr<Movie> moov(new Movie);
+  RCHECK(moov->Parse(reader.get()));
+
+  if (!moov->extends.tracks.empty()) {
+    // Samples of fragmented files are described by the 'moof' boxes following
+    // the 'moov', which are handled well by the stream parser.
+    RCHECK(file->Seek(start_position));
+    return true;
+  }
+
+  random_access_file_ = file;
+  random_access_position_ = moov_position + moov_data.size();
+  moov_ = moov.Pass();
+  return ProcessMoov();
+}
+
+bool MP4MediaParser::ReadSamples(uint64_t max_bytes, bool* eos) {
+  DCHECK(random_access());
+  DCHECK(eos);
+
+  *eos = false;
+  if (state_ == kError)
+    return false;
+  DCHECK_EQ(kEmittingSamples, state_);
+
+  uint64_t bytes_read = 0;
+  while (bytes_read < max_bytes) {
+    if (!runs_->IsRunValid()) {
+      *eos = true;
+      return true;
+    }
+
+    // Skip this entire track if it is not audio nor video.
+    if (!runs_->IsSampleValid() || (!runs_->is_audio() && !runs_->is_video())) {
+      if (!runs_->AdvanceRun()) {
+        ChangeState(kError);
+        return false;
+      }
+      continue;
+    }
+
+    const uint64_t sample_offset = runs_->sample_offset();
+    const size_t sample_size = runs_->sample_size();
+    if (!read_buffer_ || sample_offset < read_buffer_offset_ ||
+        sample_offset + sample_size >
+            read_buffer_offset_ + read_buffer_->size()) {
+      if (!FillReadBuffer(sample_offset, sample_size)) {
+        ChangeState(kError);
+        return false;
+      }
+      bytes_read += read_buffer_->size();
+    }
+
+    bool err = false;
+    if (!EmitSample(MediaSample::FromSharedBuffer(
+                        read_buffer_,
+                        sample_offset - read_buffer_offset_,
+                        sample_size,
+                        runs_->is_keyframe()),
+                    &err)) {
+      DCHECK(err);
+      ChangeState(kError);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MP4MediaParser::FillReadBuffer(uint64_t offset, size_t min_size) {
+  DCHECK(random_access_file_);
+
+  if (offset != random_access_position_) {
+    if (!random_access_file_->Seek(offset)) {
+      LOG(ERROR) << "Cannot seek to sample at offset " << offset;
+      return false;
+    }
+    random_access_position_ = offset;
+  }
+
+  // Always use a new buffer: the samples referencing the previous one may
+  // still be in use.
+  std::vector<uint8_t> data(std::max(min_size, kReadBufferSize));
+  const int64_t size =
+      random_access_file_->Read(vector_as_array(&data), data.size());
+  if (size < static_cast<int64_t>(min_size)) {
+    LOG(ERROR) << "Cannot read sample at offset " << offset;
+    return false;
+  }
+  random_access_position_ += size;
+  data.resize(size);
+
+  read_buffer_ = base::RefCountedBytes::TakeVector(&data);
+  read_buffer_offset_ = offset;
+  return true;
+}
+
 bool MP4MediaParser::ParseBox(bool* err) {
   const uint8_t* buf;
   int size;
@@ -120,10 +296,12 @@ bool MP4MediaParser::ParseBox(bool* err) {
     return false;
 
   if (reader->type() == FOURCC_MDAT) {
-    // The code ends up here only if a MOOV box is not yet seen.
+    // The code ends up here only if a MOOV box is not yet seen. Seekable files
+    // with MDAT before MOOV are handled by LoadMoov().
     DCHECK(!moov_);
 
-    NOTIMPLEMENTED() << " Files with MDAT before MOOV is not supported yet.";
+    NOTIMPLEMENTED() << " Non-seekable files with MDAT before MOOV is not "
+                        "supported yet.";
     *err = true;
     return false;
   }
@@ -154,6 +332,11 @@ bool MP4MediaParser::ParseBox(bool* err) {
 bool MP4MediaParser::ParseMoov(BoxReader* reader) {
   moov_.reset(new Movie);
   RCHECK(moov_->Parse(reader));
+  return ProcessMoov();
+}
+
+bool MP4MediaParser::ProcessMoov() {
+  DCHECK(moov_);
   runs_.reset();
 
   std::vector<scoped_refptr<StreamInfo> > streams;
@@ -368,8 +551,8 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
   }
 
   if (!runs_->IsSampleValid()) {
-    runs_->AdvanceRun();
-    return true;
+    *err = !runs_->AdvanceRun();
+    return !*err;
   }
 
   DCHECK(!(*err));
@@ -381,8 +564,10 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
     return false;
 
   // Skip this entire track if it is not audio nor video.
-  if (!runs_->is_audio() && !runs_->is_video())
-    runs_->AdvanceRun();
+  if (!runs_->is_audio() && !runs_->is_video()) {
+    *err = !runs_->AdvanceRun();
+    return !*err;
+  }
 
   // Attempt to cache the auxiliary information first. Aux info is usually
   // placed in a contiguous block before the sample data, rather than being
@@ -405,6 +590,11 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
 
   scoped_refptr<MediaSample> stream_sample(MediaSample::CopyFrom(
       buf, runs_->sample_size(), runs_->is_keyframe()));
+  return EmitSample(stream_sample, err);
+}
+
+bool MP4MediaParser::EmitSample(const scoped_refptr<MediaSample>& stream_sample,
+                                bool* err) {
   if (runs_->is_encrypted()) {
     scoped_ptr<DecryptConfig> decrypt_config = runs_->GetDecryptConfig();
     if (!decrypt_config ||
@@ -477,6 +667,9 @@ bool MP4MediaParser::DecryptSampleBuffer(const DecryptConfig* decrypt_config,
     return false;
   }
 
+  ScopedStageTimer decryption_timer(decryption_stats());
+  decryption_timer.set_count(1);
+  decryption_timer.set_bytes(buffer_size);
   if (decrypt_config->subsamples().empty()) {
     // Sample not encrypted using subsample encryption. Decrypt whole.
     if (!encryptor->Decrypt(buffer, buffer_size, buffer)) {
@@ -16,6 +16,7 @@
 #include "packager/base/compiler_specific.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/base/memory/ref_counted.h"
+#include "packager/base/memory/ref_counted_memory.h"
 #include "packager/base/memory/scoped_ptr.h"
 #include "packager/media/base/media_parser.h"
 #include "packager/media/base/offset_byte_queue.h"
@@ -25,6 +26,7 @@ namespace media {
 
 class AesCtrEncryptor;
 class DecryptConfig;
+class File;
 
 namespace mp4 {
 
@@ -47,6 +49,32 @@ class MP4MediaParser : public MediaParser {
   virtual bool Parse(const uint8_t* buf, int size) OVERRIDE;
   /// @}
 
+  /// Load the 'moov' box directly from a seekable file. Only top-level box
+  /// headers are read while looking for the 'moov' box, so a 'moov' placed
+  /// after the 'mdat' is found without reading the media data in between.
+  /// If the file is not fragmented, the parser switches to random access
+  /// mode: samples are read from @a file by their chunk offsets through
+  /// ReadSamples() and Parse() must not be called. Otherwise, the file
+  /// position is restored and parsing proceeds through Parse().
+  /// @param file points to the opened input file. It is retained but not
+  ///        owned, and must outlive the parser.
+  /// @return true on success, including the case that the file is not
+  ///         seekable or is fragmented; false on error.
+  bool LoadMoov(File* file);
+
+  /// @return true if samples are read directly from the file passed to
+  ///         LoadMoov(), false otherwise.
+  bool random_access() const { return random_access_file_ != NULL; }
+
+  /// Read samples directly from the file passed to LoadMoov() and emit them
+  /// in the order of their offsets in the file. Only valid if
+  /// random_access() is true.
+  /// @param max_bytes is the approximate amount of sample data to read
+  ///        before returning.
+  /// @param[out] eos is set to true if all samples have been emitted.
+  /// @return true on success, false on error.
+  bool ReadSamples(uint64_t max_bytes, bool* eos);
+
  private:
   enum State {
     kWaitingForInit,
@@ -59,6 +87,9 @@ class MP4MediaParser : public MediaParser {
   bool ParseMoov(mp4::BoxReader* reader);
   bool ParseMoof(mp4::BoxReader* reader);
 
+  // Emit stream info and set up sample iteration for |moov_|.
+  bool ProcessMoov();
+
   bool FetchKeysIfNecessary(
       const std::vector<ProtectionSystemSpecificHeader>& headers);
 
@@ -80,6 +111,14 @@ class MP4MediaParser : public MediaParser {
 
   bool EnqueueSample(bool* err);
 
+  // Decrypt |sample| if needed, and emit it with the timing information of the
+  // current sample of |runs_|.
+  bool EmitSample(const scoped_refptr<MediaSample>& sample, bool* err);
+
+  // Read |random_access_file_| into a new |read_buffer_| starting at |offset|.
+  // At least |min_size| bytes must be available.
+  bool FillReadBuffer(uint64_t offset, size_t min_size);
+
   void Reset();
 
   State state_;
@@ -105,6 +144,15 @@ class MP4MediaParser : public MediaParser {
   typedef std::map<std::vector<uint8_t>, AesCtrEncryptor*> DecryptorMap;
   DecryptorMap decryptor_map_;
 
+  // Only set in random access mode. Not owned.
+  File* random_access_file_;
+  // Current position of |random_access_file_|, used to avoid redundant seeks.
+  uint64_t random_access_position_;
+  // Last chunk read from |random_access_file_|, starting at
+  // |read_buffer_offset_|. Shared with the samples sliced from it.
+  scoped_refptr<base::RefCountedBytes> read_buffer_;
+  uint64_t read_buffer_offset_;
+
   DISALLOW_COPY_AND_ASSIGN(MP4MediaParser);
 };
 
@@ -8,10 +8,12 @@
 #include <gtest/gtest.h>
 
 #include "packager/base/bind.h"
+#include "packager/base/file_util.h"
 #include "packager/base/logging.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
+#include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/mp4_media_parser.h"
 #include "packager/media/test/test_data_util.h"
 
@@ -167,6 +169,59 @@ TEST_F(MP4MediaParserTest, NON_FRAGMENTED_MP4) {
   EXPECT_EQ(201u, num_samples_);
 }
 
+TEST_F(MP4MediaParserTest, NON_FRAGMENTED_MP4_RandomAccess) {
+  InitializeParser(NULL);
+
+  File* file = File::Open(
+      GetTestDataFilePath("bear-1280x720.mp4").value().c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_TRUE(parser_->LoadMoov(file));
+  EXPECT_TRUE(parser_->random_access());
+  EXPECT_EQ(2u, num_streams_);
+
+  bool eos = false;
+  while (!eos)
+    ASSERT_TRUE(parser_->ReadSamples(4096, &eos));
+  EXPECT_EQ(201u, num_samples_);
+  EXPECT_TRUE(file->Close());
+}
+
+TEST_F(MP4MediaParserTest, LoadMoovFromFragmentedMP4) {
+  InitializeParser(NULL);
+
+  File* file = File::Open(
+      GetTestDataFilePath("bear-1280x720-av_frag.mp4").value().c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_TRUE(parser_->LoadMoov(file));
+  // Fragmented files are still parsed as a stream.
+  EXPECT_FALSE(parser_->random_access());
+  EXPECT_EQ(0u, num_streams_);
+
+  uint64_t position;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(0u, position);
+  EXPECT_TRUE(file->Close());
+}
+
+TEST_F(MP4MediaParserTest, LoadMoovRejectsOversizedBox) {
+  InitializeParser(NULL);
+
+  // A 'moov' box header claiming almost 2GB in a 64 byte file.
+  uint8_t data[64] = {0x7f, 0xff, 0xff, 0xf0, 'm', 'o', 'o', 'v'};
+  base::FilePath path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&path));
+  ASSERT_EQ(static_cast<int>(sizeof(data)),
+            file_util::WriteFile(path, reinterpret_cast<const char*>(data),
+                                 sizeof(data)));
+
+  File* file = File::Open(path.value().c_str(), "r");
+  ASSERT_TRUE(file != NULL);
+  EXPECT_FALSE(parser_->LoadMoov(file));
+  EXPECT_FALSE(parser_->random_access());
+  EXPECT_TRUE(file->Close());
+  base::DeleteFile(path, false);
+}
+
 TEST_F(MP4MediaParserTest, CencWithoutDecryptionSource) {
   // Parsing should fail but it will get the streams successfully.
   EXPECT_FALSE(ParseMP4File("bear-1280x720-v_frag-cenc.mp4", 512));
@@ -98,6 +98,8 @@ Status MP4Muxer::Initialize() {
     segmenter_.reset(
         new MultiSegmentSegmenter(options(), ftyp.Pass(), moov.Pass()));
   }
+  if (pipeline_stats())
+    segmenter_->SetPipelineStats(pipeline_stats());
 
   Status segmenter_initialized =
       segmenter_->Initialize(streams(),
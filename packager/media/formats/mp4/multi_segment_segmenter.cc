@@ -56,7 +56,7 @@ Status MultiSegmentSegmenter::DoInitialize() {
   scoped_ptr<BufferWriter> buffer(new BufferWriter);
   ftyp()->Write(buffer.get());
   moov()->Write(buffer.get());
-  Status status = buffer->WriteToFile(file);
+  Status status = WriteBufferToFile(buffer.get(), file);
   if (!file->Close()) {
     LOG(WARNING) << "Failed to close the file properly: "
                  << options().output_file_name;
@@ -167,9 +167,9 @@ Status MultiSegmentSegmenter::WriteSegment() {
   const size_t segment_size = buffer->Size() + fragment_buffer()->Size();
   DCHECK_NE(segment_size, 0u);
 
-  Status status = buffer->WriteToFile(file);
+  Status status = WriteBufferToFile(buffer.get(), file);
   if (status.ok())
-    status = fragment_buffer()->WriteToFile(file);
+    status = WriteBufferToFile(fragment_buffer(), file);
 
   if (!file->Close())
     LOG(WARNING) << "Failed to close the file properly: " << file_name;
@@ -14,6 +14,7 @@
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/media_stream.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/base/video_stream_info.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 #include "packager/media/formats/mp4/key_rotation_fragmenter.h"
@@ -123,10 +124,24 @@ Segmenter::Segmenter(const MuxerOptions& options,
       sidx_(new SegmentIndex()),
       segment_initialized_(false),
       end_of_segment_(false),
-      muxer_listener_(NULL) {}
+      muxer_listener_(NULL),
+      fragment_stats_(NULL),
+      segment_stats_(NULL),
+      encryption_stats_(NULL),
+      write_stats_(NULL) {}
 
 Segmenter::~Segmenter() { STLDeleteElements(&fragmenters_); }
 
+void Segmenter::SetPipelineStats(PipelineStats* pipeline_stats) {
+  DCHECK(pipeline_stats);
+  DCHECK(fragmenters_.empty());
+  const std::string& output = options_.output_file_name;
+  fragment_stats_ = pipeline_stats->GetStageStats(output, kFragmentStage);
+  segment_stats_ = pipeline_stats->GetStageStats(output, kSegmentStage);
+  encryption_stats_ = pipeline_stats->GetStageStats(output, kEncryptStage);
+  write_stats_ = pipeline_stats->GetStageStats(output, kWriteStage);
+}
+
 Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
                              event::MuxerListener* muxer_listener,
                              KeySource* encryption_key_source,
@@ -159,12 +174,13 @@ Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
     SampleDescription& description =
         moov_->tracks[i].media.information.sample_table.description;
 
+    EncryptingFragmenter* encrypting_fragmenter;
     const bool key_rotation_enabled = crypto_period_duration_in_seconds != 0;
     if (key_rotation_enabled) {
       GenerateEncryptedSampleEntryForKeyRotation(clear_lead_in_seconds,
                                                  &description);
 
-      fragmenters_[i] = new KeyRotationFragmenter(
+      encrypting_fragmenter = new KeyRotationFragmenter(
           moof_.get(),
           &moof_->tracks[i],
           encryption_key_source,
@@ -172,29 +188,35 @@ Status Segmenter::Initialize(const std::vector<MediaStream*>& streams,
           crypto_period_duration_in_seconds * streams[i]->info()->time_scale(),
           clear_lead_in_seconds * streams[i]->info()->time_scale(),
           nalu_length_size);
-      continue;
+    } else {
+      scoped_ptr<EncryptionKey> encryption_key(new EncryptionKey());
+      Status status =
+          encryption_key_source->GetKey(track_type, encryption_key.get());
+      if (!status.ok())
+        return status;
+
+      GenerateEncryptedSampleEntry(
+          *encryption_key, clear_lead_in_seconds, &description);
+
+      // One and only one pssh box is needed.
+      if (moov_->pssh.empty()) {
+        moov_->pssh.resize(1);
+        moov_->pssh[0].raw_box = encryption_key->pssh;
+      }
+
+      encrypting_fragmenter = new EncryptingFragmenter(
+          &moof_->tracks[i],
+          encryption_key.Pass(),
+          clear_lead_in_seconds * streams[i]->info()->time_scale(),
+          nalu_length_size);
     }
-
-    scoped_ptr<EncryptionKey> encryption_key(new EncryptionKey());
-    Status status =
-        encryption_key_source->GetKey(track_type, encryption_key.get());
-    if (!status.ok())
-      return status;
-
-    GenerateEncryptedSampleEntry(
-        *encryption_key, clear_lead_in_seconds, &description);
-
-    // One and only one pssh box is needed.
-    if (moov_->pssh.empty()) {
-      moov_->pssh.resize(1);
-      moov_->pssh[0].raw_box = encryption_key->pssh;
+    if (options_.encryption_worker_pool) {
+      encrypting_fragmenter->EnableParallelEncryption(
+          options_.encryption_worker_pool);
     }
-
-    fragmenters_[i] = new EncryptingFragmenter(
-        &moof_->tracks[i],
-        encryption_key.Pass(),
-        clear_lead_in_seconds * streams[i]->info()->time_scale(),
-        nalu_length_size);
+    if (encryption_stats_)
+      encrypting_fragmenter->set_encryption_stats(encryption_stats_);
+    fragmenters_[i] = encrypting_fragmenter;
   }
 
   // Choose the first stream if there is no VIDEO.
@@ -281,7 +303,10 @@ Status Segmenter::AddSample(const MediaStream* stream,
       return status;
   }
 
-  status = fragmenter->AddSample(sample);
+  {
+    ScopedStageTimer fragment_timer(fragment_stats_);
+    status = fragmenter->AddSample(sample);
+  }
   if (!status.ok())
     return status;
 
@@ -313,62 +338,79 @@ void Segmenter::InitializeSegment() {
 
 Status Segmenter::FinalizeSegment() {
   segment_initialized_ = false;
+  ScopedStageTimer segment_timer(segment_stats_);
+  segment_timer.set_count(1);
+  segment_timer.set_bytes(fragment_buffer_->Size());
   return DoFinalizeSegment();
 }
 
+Status Segmenter::WriteBufferToFile(BufferWriter* buffer, File* file) {
+  ScopedStageTimer write_timer(write_stats_);
+  write_timer.set_count(1);
+  write_timer.set_bytes(buffer->Size());
+  return buffer->WriteToFile(file);
+}
+
 uint32_t Segmenter::GetReferenceStreamId() {
   DCHECK(sidx_);
   return sidx_->reference_id - 1;
 }
 
 Status Segmenter::FinalizeFragment(Fragmenter* fragmenter) {
-  fragmenter->FinalizeFragment();
-
-  // Check if all tracks are ready for fragmentation.
-  for (std::vector<Fragmenter*>::iterator it = fragmenters_.begin();
-       it != fragmenters_.end();
-       ++it) {
-    if (!(*it)->fragment_finalized())
-      return Status::OK;
-  }
+  {
+    // Segment finalization, which writes the segment, is recorded
+    // separately.
+    ScopedStageTimer fragment_timer(fragment_stats_);
+    fragmenter->FinalizeFragment();
+
+    // Check if all tracks are ready for fragmentation.
+    for (std::vector<Fragmenter*>::iterator it = fragmenters_.begin();
+         it != fragmenters_.end();
+         ++it) {
+      if (!(*it)->fragment_finalized())
+        return Status::OK;
+    }
 
-  MediaData mdat;
-  // Fill in data offsets. Data offset base is moof size + mdat box size.
-  // (mdat is still empty, mdat size is the same as mdat box size).
-  uint64_t base = moof_->ComputeSize() + mdat.ComputeSize();
-  for (uint i = 0; i < moof_->tracks.size(); ++i) {
-    TrackFragment& traf = moof_->tracks[i];
-    Fragmenter* fragmenter = fragmenters_[i];
-    if (fragmenter->aux_data()->Size() > 0) {
-      traf.auxiliary_offset.offsets[0] += base;
-      base += fragmenter->aux_data()->Size();
+    MediaData mdat;
+    // Fill in data offsets. Data offset base is moof size + mdat box size.
+    // (mdat is still empty, mdat size is the same as mdat box size).
+    uint64_t base = moof_->ComputeSize() + mdat.ComputeSize();
+    for (uint i = 0; i < moof_->tracks.size(); ++i) {
+      TrackFragment& traf = moof_->tracks[i];
+      Fragmenter* fragmenter = fragmenters_[i];
+      if (fragmenter->aux_data()->Size() > 0) {
+        traf.auxiliary_offset.offsets[0] += base;
+        base += fragmenter->aux_data()->Size();
+      }
+      traf.runs[0].data_offset += base;
+      base += fragmenter->data()->Size();
     }
-    traf.runs[0].data_offset += base;
-    base += fragmenter->data()->Size();
-  }
 
-  // Generate segment reference.
-  sidx_->references.resize(sidx_->references.size() + 1);
-  fragmenters_[GetReferenceStreamId()]->GenerateSegmentReference(
-      &sidx_->references[sidx_->references.size() - 1]);
-  sidx_->references[sidx_->references.size() - 1].referenced_size = base;
-
-  // Write the fragment to buffer.
-  moof_->Write(fragment_buffer_.get());
-
-  for (uint i = 0; i < moof_->tracks.size(); ++i) {
-    Fragmenter* fragmenter = fragmenters_[i];
-    mdat.data_size =
-        fragmenter->aux_data()->Size() + fragmenter->data()->Size();
-    mdat.Write(fragment_buffer_.get());
-    if (fragmenter->aux_data()->Size()) {
-      fragment_buffer_->AppendBuffer(*fragmenter->aux_data());
+    // Generate segment reference.
+    sidx_->references.resize(sidx_->references.size() + 1);
+    fragmenters_[GetReferenceStreamId()]->GenerateSegmentReference(
+        &sidx_->references[sidx_->references.size() - 1]);
+    sidx_->references[sidx_->references.size() - 1].referenced_size = base;
+
+    // Write the fragment to buffer.
+    moof_->Write(fragment_buffer_.get());
+
+    for (uint i = 0; i < moof_->tracks.size(); ++i) {
+      Fragmenter* fragmenter = fragmenters_[i];
+      mdat.data_size =
+          fragmenter->aux_data()->Size() + fragmenter->data()->Size();
+      mdat.Write(fragment_buffer_.get());
+      if (fragmenter->aux_data()->Size()) {
+        fragment_buffer_->AppendBuffer(*fragmenter->aux_data());
+      }
+      fragment_buffer_->AppendBuffer(*fragmenter->data());
     }
-    fragment_buffer_->AppendBuffer(*fragmenter->data());
-  }
 
-  // Increase sequence_number for next fragment.
-  ++moof_->header.sequence_number;
+    // Increase sequence_number for next fragment.
+    ++moof_->header.sequence_number;
+    fragment_timer.set_count(1);
+    fragment_timer.set_bytes(base);
+  }
 
   if (end_of_segment_)
     return FinalizeSegment();
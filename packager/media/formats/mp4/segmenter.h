@@ -20,9 +20,12 @@ namespace media {
 struct MuxerOptions;
 
 class BufferWriter;
+class File;
 class KeySource;
 class MediaSample;
 class MediaStream;
+class PipelineStats;
+class StageStats;
 
 namespace event {
 class MuxerListener;
@@ -50,6 +53,11 @@ class Segmenter {
             scoped_ptr<Movie> moov);
   virtual ~Segmenter();
 
+  /// Record the stats of the output. Should be called before Initialize().
+  /// @param pipeline_stats is the collector of the stats. The caller retains
+  ///        ownership. It should outlive the segmenter.
+  void SetPipelineStats(PipelineStats* pipeline_stats);
+
   /// Initialize the segmenter.
   /// Calling other public methods of this class without this method returning
   /// Status::OK results in an undefined behavior.
@@ -102,6 +110,12 @@ class Segmenter {
   BufferWriter* fragment_buffer() { return fragment_buffer_.get(); }
   SegmentIndex* sidx() { return sidx_.get(); }
   event::MuxerListener* muxer_listener() { return muxer_listener_; }
+  /// @return The StageStats of the writes, NULL if not recorded.
+  StageStats* write_stats() { return write_stats_; }
+
+  /// Write @a buffer to @a file and clear it, recording the write stats.
+  /// @return OK on success, an error status otherwise.
+  Status WriteBufferToFile(BufferWriter* buffer, File* file);
 
  private:
   virtual Status DoInitialize() = 0;
@@ -126,6 +140,11 @@ class Segmenter {
   bool segment_initialized_;
   bool end_of_segment_;
   event::MuxerListener* muxer_listener_;
+  // Set if stats are recorded.
+  StageStats* fragment_stats_;
+  StageStats* segment_stats_;
+  StageStats* encryption_stats_;
+  StageStats* write_stats_;
 
   DISALLOW_COPY_AND_ASSIGN(Segmenter);
 };
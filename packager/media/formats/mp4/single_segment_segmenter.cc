@@ -6,10 +6,13 @@
 
 #include "packager/media/formats/mp4/single_segment_segmenter.h"
 
+#include <algorithm>
+
 #include "packager/base/file_util.h"
 #include "packager/media/base/buffer_writer.h"
 #include "packager/media/base/media_stream.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 
@@ -79,7 +82,7 @@ Status SingleSegmentSegmenter::DoFinalize() {
   ftyp()->Write(buffer.get());
   moov()->Write(buffer.get());
   vod_sidx_->Write(buffer.get());
-  Status status = buffer->WriteToFile(file.get());
+  Status status = WriteBufferToFile(buffer.get(), file.get());
   if (!status.ok())
     return status;
 
@@ -91,20 +94,27 @@ Status SingleSegmentSegmenter::DoFinalize() {
                   "Cannot open file to read " + temp_file_name_);
   }
 
-  const int kBufSize = 0x40000;  // 256KB.
-  scoped_ptr<uint8_t[]> buf(new uint8_t[kBufSize]);
-  while (!temp_file->Eof()) {
-    int64_t size = temp_file->Read(buf.get(), kBufSize);
-    if (size <= 0) {
-      return Status(error::FILE_FAILURE,
-                    "Failed to read file " + temp_file_name_);
-    }
-    int64_t size_written = file->Write(buf.get(), size);
-    if (size_written != size) {
-      return Status(error::FILE_FAILURE,
-                    "Failed to write file " + options().output_file_name);
-    }
+  // Let the kernel do the copy if possible, which avoids reading the media
+  // data back into memory.
+  const int64_t temp_file_size = temp_file->Size();
+  int64_t bytes_copied = 0;
+  {
+    ScopedStageTimer write_timer(write_stats());
+    bytes_copied = File::CopyFile(temp_file.get(), file.get());
+    write_timer.set_count(1);
+    write_timer.set_bytes(std::max<int64_t>(bytes_copied, 0));
   }
+  if (bytes_copied != temp_file_size) {
+    return Status(error::FILE_FAILURE,
+                  "Failed to copy " + temp_file_name_ + " to " +
+                      options().output_file_name);
+  }
+  temp_file.reset();
+
+  // The temp file is no longer needed. Remove it so that the disk space is
+  // released right away.
+  if (!base::DeleteFile(base::FilePath(temp_file_name_), false))
+    LOG(WARNING) << "Failed to delete temp file " << temp_file_name_;
   return Status::OK;
 }
 
@@ -168,7 +178,7 @@ Status SingleSegmentSegmenter::DoFinalizeSegment() {
   vod_sidx_->references.push_back(vod_ref);
 
   // Append fragment buffer to temp file.
-  return fragment_buffer()->WriteToFile(temp_file_.get());
+  return WriteBufferToFile(fragment_buffer(), temp_file_.get());
 }
 
 }  // namespace mp4
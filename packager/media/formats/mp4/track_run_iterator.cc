@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <limits>
 
+#include "packager/base/stl_util.h"
 #include "packager/media/base/buffer_reader.h"
 #include "packager/media/formats/mp4/chunk_info_iterator.h"
 #include "packager/media/formats/mp4/composition_offset_iterator.h"
@@ -62,12 +63,174 @@ TrackRunInfo::TrackRunInfo()
       aux_info_total_size(0) {}
 TrackRunInfo::~TrackRunInfo() {}
 
+// Walks the sample table of a track in a non-fragmented file, creating a run
+// for one chunk at a time. Only the positions in the tables are kept, so the
+// memory used does not depend on the length of the track.
+class ChunkRunIterator {
+ public:
+  explicit ChunkRunIterator(const Track& track);
+  ~ChunkRunIterator();
+
+  /// Verifies that the sample table can be iterated.
+  /// @return true on success, false otherwise.
+  bool Init();
+
+  /// @return true if there are chunks left, false otherwise.
+  bool IsValid() const { return chunk_index_ < num_chunks_; }
+
+  /// @return true if the chunks are stored in the order of their offsets.
+  bool HasOrderedChunkOffsets() const;
+
+  /// @return The offset of the current chunk. Only valid if IsValid().
+  int64_t chunk_offset() const {
+    DCHECK(IsValid());
+    return chunk_offsets_[chunk_index_];
+  }
+
+  /// Fill @a run with the current chunk, then advance to the next chunk.
+  /// Only valid if IsValid().
+  /// @return true on success, false if the sample table is invalid.
+  bool ReadChunk(TrackRunInfo* run);
+
+ private:
+  const Track& track_;
+  const SampleDescription& stsd_;
+  const SampleSize& sample_size_;
+  const std::vector<uint64_t>& chunk_offsets_;
+  DecodingTimeIterator decoding_time_;
+  CompositionOffsetIterator composition_offset_;
+  ChunkInfoIterator chunk_info_;
+  SyncSampleIterator sync_sample_;
+  const bool has_composition_offset_;
+  const uint32_t num_samples_;
+  const uint32_t num_chunks_;
+  uint32_t chunk_index_;
+  uint32_t sample_index_;
+  int64_t run_start_dts_;
+
+  DISALLOW_COPY_AND_ASSIGN(ChunkRunIterator);
+};
+
+ChunkRunIterator::ChunkRunIterator(const Track& track)
+    : track_(track),
+      stsd_(track.media.information.sample_table.description),
+      sample_size_(track.media.information.sample_table.sample_size),
+      chunk_offsets_(
+          track.media.information.sample_table.chunk_large_offset.offsets),
+      decoding_time_(
+          track.media.information.sample_table.decoding_time_to_sample),
+      composition_offset_(
+          track.media.information.sample_table.composition_time_to_sample),
+      chunk_info_(track.media.information.sample_table.sample_to_chunk),
+      sync_sample_(track.media.information.sample_table.sync_sample),
+      has_composition_offset_(composition_offset_.IsValid()),
+      num_samples_(sample_size_.sample_count),
+      num_chunks_(chunk_offsets_.size()),
+      chunk_index_(0),
+      sample_index_(0),
+      run_start_dts_(0) {}
+
+ChunkRunIterator::~ChunkRunIterator() {}
+
+bool ChunkRunIterator::Init() {
+  // Check that total number of samples match.
+  DCHECK_EQ(num_samples_, decoding_time_.NumSamples());
+  if (has_composition_offset_)
+    DCHECK_EQ(num_samples_, composition_offset_.NumSamples());
+  if (num_chunks_ > 0)
+    DCHECK_EQ(num_samples_, chunk_info_.NumSamples(1, num_chunks_));
+  DCHECK_GE(num_chunks_, chunk_info_.LastFirstChunk());
+
+  if (num_samples_ > 0) {
+    // Verify relevant tables are not empty.
+    RCHECK(decoding_time_.IsValid());
+    RCHECK(chunk_info_.IsValid());
+  }
+  return true;
+}
+
+bool ChunkRunIterator::HasOrderedChunkOffsets() const {
+  for (uint32_t i = 1; i < num_chunks_; ++i) {
+    if (chunk_offsets_[i] < chunk_offsets_[i - 1])
+      return false;
+  }
+  return true;
+}
+
+bool ChunkRunIterator::ReadChunk(TrackRunInfo* run) {
+  DCHECK(IsValid());
+  RCHECK(chunk_info_.current_chunk() == chunk_index_ + 1);
+
+  run->track_id = track_.header.track_id;
+  run->timescale = track_.media.header.timescale;
+  run->start_dts = run_start_dts_;
+  run->sample_start_offset = chunk_offsets_[chunk_index_];
+
+  uint32_t desc_idx = chunk_info_.sample_description_index();
+  RCHECK(desc_idx > 0);  // Descriptions are one-indexed in the file.
+  desc_idx -= 1;
+
+  run->track_type = stsd_.type;
+  run->audio_description = NULL;
+  run->video_description = NULL;
+  if (run->track_type == kAudio) {
+    RCHECK(!stsd_.audio_entries.empty());
+    if (desc_idx > stsd_.audio_entries.size())
+      desc_idx = 0;
+    run->audio_description = &stsd_.audio_entries[desc_idx];
+    // We don't support encrypted non-fragmented mp4 for now.
+    RCHECK(!run->audio_description->sinf.info.track_encryption.is_encrypted);
+  } else if (run->track_type == kVideo) {
+    RCHECK(!stsd_.video_entries.empty());
+    if (desc_idx > stsd_.video_entries.size())
+      desc_idx = 0;
+    run->video_description = &stsd_.video_entries[desc_idx];
+    // We don't support encrypted non-fragmented mp4 for now.
+    RCHECK(!run->video_description->sinf.info.track_encryption.is_encrypted);
+  }
+
+  uint32_t samples_per_chunk = chunk_info_.samples_per_chunk();
+  run->samples.resize(samples_per_chunk);
+  for (uint32_t k = 0; k < samples_per_chunk; ++k) {
+    SampleInfo& sample = run->samples[k];
+    sample.size = sample_size_.sample_size != 0
+                      ? sample_size_.sample_size
+                      : sample_size_.sizes[sample_index_];
+    sample.duration = decoding_time_.sample_delta();
+    sample.cts_offset =
+        has_composition_offset_ ? composition_offset_.sample_offset() : 0;
+    sample.is_keyframe = sync_sample_.IsSyncSample();
+
+    run_start_dts_ += sample.duration;
+
+    // Advance to next sample. Should success except for last sample.
+    ++sample_index_;
+    RCHECK(chunk_info_.AdvanceSample() && sync_sample_.AdvanceSample());
+    if (sample_index_ == num_samples_) {
+      // We should hit end of tables for decoding time and composition
+      // offset.
+      RCHECK(!decoding_time_.AdvanceSample());
+      if (has_composition_offset_)
+        RCHECK(!composition_offset_.AdvanceSample());
+    } else {
+      RCHECK(decoding_time_.AdvanceSample());
+      if (has_composition_offset_)
+        RCHECK(composition_offset_.AdvanceSample());
+    }
+  }
+
+  ++chunk_index_;
+  return true;
+}
+
 TrackRunIterator::TrackRunIterator(const Movie* moov)
     : moov_(moov), sample_dts_(0), sample_offset_(0) {
   CHECK(moov);
 }
 
-TrackRunIterator::~TrackRunIterator() {}
+TrackRunIterator::~TrackRunIterator() {
+  STLDeleteElements(&chunk_run_iterators_);
+}
 
 static void PopulateSampleInfo(const TrackExtends& trex,
                                const TrackFragmentHeader& tfhd,
@@ -137,7 +300,9 @@ class CompareMinTrackRunDataOffset {
 
 bool TrackRunIterator::Init() {
   runs_.clear();
+  STLDeleteElements(&chunk_run_iterators_);
 
+  bool ordered_chunk_offsets = true;
   for (std::vector<Track>::const_iterator trak = moov_->tracks.begin();
        trak != moov_->tracks.end(); ++trak) {
     const SampleDescription& stsd =
@@ -160,106 +325,30 @@ bool TrackRunIterator::Init() {
                  << " ignored.";
     }
 
-    DecodingTimeIterator decoding_time(
-        trak->media.information.sample_table.decoding_time_to_sample);
-    CompositionOffsetIterator composition_offset(
-        trak->media.information.sample_table.composition_time_to_sample);
-    bool has_composition_offset = composition_offset.IsValid();
-    ChunkInfoIterator chunk_info(
-        trak->media.information.sample_table.sample_to_chunk);
-    SyncSampleIterator sync_sample(
-        trak->media.information.sample_table.sync_sample);
     // Skip processing saiz and saio boxes for non-fragmented mp4 as we
     // don't support encrypted non-fragmented mp4.
+    scoped_ptr<ChunkRunIterator> chunk_run_iterator(
+        new ChunkRunIterator(*trak));
+    RCHECK(chunk_run_iterator->Init());
+    if (!chunk_run_iterator->HasOrderedChunkOffsets())
+      ordered_chunk_offsets = false;
+    chunk_run_iterators_.push_back(chunk_run_iterator.release());
+  }
 
-    const SampleSize& sample_size =
-        trak->media.information.sample_table.sample_size;
-    const std::vector<uint64_t>& chunk_offset_vector =
-        trak->media.information.sample_table.chunk_large_offset.offsets;
-
-    int64_t run_start_dts = 0;
-
-    uint32_t num_samples = sample_size.sample_count;
-    uint32_t num_chunks = chunk_offset_vector.size();
-
-    // Check that total number of samples match.
-    DCHECK_EQ(num_samples, decoding_time.NumSamples());
-    if (has_composition_offset)
-      DCHECK_EQ(num_samples, composition_offset.NumSamples());
-    if (num_chunks > 0)
-      DCHECK_EQ(num_samples, chunk_info.NumSamples(1, num_chunks));
-    DCHECK_GE(num_chunks, chunk_info.LastFirstChunk());
-
-    if (num_samples > 0) {
-      // Verify relevant tables are not empty.
-      RCHECK(decoding_time.IsValid());
-      RCHECK(chunk_info.IsValid());
-    }
-
-    uint32_t sample_index = 0;
-    for (uint32_t chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
-      RCHECK(chunk_info.current_chunk() == chunk_index + 1);
-
-      TrackRunInfo tri;
-      tri.track_id = trak->header.track_id;
-      tri.timescale = trak->media.header.timescale;
-      tri.start_dts = run_start_dts;
-      tri.sample_start_offset = chunk_offset_vector[chunk_index];
-
-      uint32_t desc_idx = chunk_info.sample_description_index();
-      RCHECK(desc_idx > 0);  // Descriptions are one-indexed in the file.
-      desc_idx -= 1;
-
-      tri.track_type = stsd.type;
-      if (tri.track_type == kAudio) {
-        RCHECK(!stsd.audio_entries.empty());
-        if (desc_idx > stsd.audio_entries.size())
-          desc_idx = 0;
-        tri.audio_description = &stsd.audio_entries[desc_idx];
-        // We don't support encrypted non-fragmented mp4 for now.
-        RCHECK(!tri.audio_description->sinf.info.track_encryption.is_encrypted);
-      } else if (tri.track_type == kVideo) {
-        RCHECK(!stsd.video_entries.empty());
-        if (desc_idx > stsd.video_entries.size())
-          desc_idx = 0;
-        tri.video_description = &stsd.video_entries[desc_idx];
-        // We don't support encrypted non-fragmented mp4 for now.
-        RCHECK(!tri.video_description->sinf.info.track_encryption.is_encrypted);
-      }
-
-      uint32_t samples_per_chunk = chunk_info.samples_per_chunk();
-      tri.samples.resize(samples_per_chunk);
-      for (uint32_t k = 0; k < samples_per_chunk; ++k) {
-        SampleInfo& sample = tri.samples[k];
-        sample.size = sample_size.sample_size != 0
-                          ? sample_size.sample_size
-                          : sample_size.sizes[sample_index];
-        sample.duration = decoding_time.sample_delta();
-        sample.cts_offset =
-            has_composition_offset ? composition_offset.sample_offset() : 0;
-        sample.is_keyframe = sync_sample.IsSyncSample();
-
-        run_start_dts += sample.duration;
-
-        // Advance to next sample. Should success except for last sample.
-        ++sample_index;
-        RCHECK(chunk_info.AdvanceSample() && sync_sample.AdvanceSample());
-        if (sample_index == num_samples) {
-          // We should hit end of tables for decoding time and composition
-          // offset.
-          RCHECK(!decoding_time.AdvanceSample());
-          if (has_composition_offset)
-            RCHECK(!composition_offset.AdvanceSample());
-        } else {
-          RCHECK(decoding_time.AdvanceSample());
-          if (has_composition_offset)
-            RCHECK(composition_offset.AdvanceSample());
-        }
-      }
-
-      runs_.push_back(tri);
+  // Usually the chunks of each track are stored in order, so the chunks can
+  // be read one at a time, picking the track with the lowest chunk offset.
+  if (ordered_chunk_offsets)
+    return ReadNextChunk();
+
+  // Otherwise read all the chunks up front and sort them.
+  for (size_t i = 0; i < chunk_run_iterators_.size(); ++i) {
+    ChunkRunIterator* chunk_run_iterator = chunk_run_iterators_[i];
+    while (chunk_run_iterator->IsValid()) {
+      runs_.push_back(TrackRunInfo());
+      RCHECK(chunk_run_iterator->ReadChunk(&runs_.back()));
     }
   }
+  STLDeleteElements(&chunk_run_iterators_);
 
   std::sort(runs_.begin(), runs_.end(), CompareMinTrackRunDataOffset());
   run_itr_ = runs_.begin();
@@ -269,6 +358,7 @@ bool TrackRunIterator::Init() {
 
 bool TrackRunIterator::Init(const MovieFragment& moof) {
   runs_.clear();
+  STLDeleteElements(&chunk_run_iterators_);
 
   for (size_t i = 0; i < moof.tracks.size(); i++) {
     const TrackFragment& traf = moof.tracks[i];
@@ -376,9 +466,39 @@ bool TrackRunIterator::Init(const MovieFragment& moof) {
   return true;
 }
 
-void TrackRunIterator::AdvanceRun() {
+bool TrackRunIterator::AdvanceRun() {
+  if (!chunk_run_iterators_.empty())
+    return ReadNextChunk();
+
   ++run_itr_;
   ResetRun();
+  return true;
+}
+
+ChunkRunIterator* TrackRunIterator::NextChunkRunIterator() const {
+  ChunkRunIterator* next = NULL;
+  for (size_t i = 0; i < chunk_run_iterators_.size(); ++i) {
+    ChunkRunIterator* chunk_run_iterator = chunk_run_iterators_[i];
+    if (chunk_run_iterator->IsValid() &&
+        (!next || chunk_run_iterator->chunk_offset() < next->chunk_offset())) {
+      next = chunk_run_iterator;
+    }
+  }
+  return next;
+}
+
+bool TrackRunIterator::ReadNextChunk() {
+  // The current run, if any, is replaced by the next chunk.
+  ChunkRunIterator* next = NextChunkRunIterator();
+  runs_.resize(next ? 1 : 0);
+  run_itr_ = runs_.end();
+  if (!next)
+    return true;
+
+  RCHECK(next->ReadChunk(&runs_[0]));
+  run_itr_ = runs_.begin();
+  ResetRun();
+  return true;
 }
 
 void TrackRunIterator::ResetRun() {
@@ -443,7 +563,12 @@ int64_t TrackRunIterator::GetMaxClearOffset() {
     if (AuxInfoNeedsToBeCached())
       offset = std::min(offset, aux_info_offset());
   }
-  if (run_itr_ != runs_.end()) {
+  if (!chunk_run_iterators_.empty()) {
+    // Chunks read on demand have no auxiliary information.
+    const ChunkRunIterator* next_chunk = NextChunkRunIterator();
+    if (IsRunValid() && next_chunk)
+      offset = std::min(offset, next_chunk->chunk_offset());
+  } else if (run_itr_ != runs_.end()) {
     std::vector<TrackRunInfo>::const_iterator next_run = run_itr_ + 1;
     if (next_run != runs_.end()) {
       offset = std::min(offset, next_run->sample_start_offset);
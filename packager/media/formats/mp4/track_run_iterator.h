@@ -18,6 +18,7 @@ class DecryptConfig;
 
 namespace mp4 {
 
+class ChunkRunIterator;
 struct SampleInfo;
 struct TrackRunInfo;
 
@@ -29,7 +30,10 @@ class TrackRunIterator {
   ~TrackRunIterator();
 
   /// For non-fragmented mp4, moov contains all the chunk information; This
-  /// function sets up the iterator to access all the chunks.
+  /// function sets up the iterator to access all the chunks. The sample
+  /// tables are normally expanded one chunk at a time, as the iterator
+  /// advances, so that the startup time and memory use do not grow with the
+  /// duration of the file.
   /// For fragmented mp4, chunk and sample information are generally contained
   /// in moof. This function is a no-op in this case. Init(moof) will be called
   /// later after parsing moof.
@@ -49,7 +53,9 @@ class TrackRunIterator {
 
   /// Advance iterator to the next run. Require that the iterator point to a
   /// valid run.
-  void AdvanceRun();
+  /// @return true on success, false if the next chunk of a non-fragmented
+  ///         mp4 cannot be read from the sample table.
+  bool AdvanceRun();
   /// Advance iterator to the next sample. Require that the iterator point to a
   /// valid sample.
   void AdvanceSample();
@@ -105,9 +111,18 @@ class TrackRunIterator {
   void ResetRun();
   const TrackEncryption& track_encryption() const;
 
+  // Returns the ChunkRunIterator with the lowest chunk offset, or NULL if all
+  // the chunks have been read.
+  ChunkRunIterator* NextChunkRunIterator() const;
+  // Replaces the current run with the next chunk in |chunk_run_iterators_|.
+  bool ReadNextChunk();
+
   const Movie* moov_;
 
   std::vector<TrackRunInfo> runs_;
+  // Set if the chunks of a non-fragmented mp4 are read on demand, in which
+  // case |runs_| only contains the current chunk. One per track.
+  std::vector<ChunkRunIterator*> chunk_run_iterators_;
   std::vector<TrackRunInfo>::const_iterator run_itr_;
   std::vector<SampleInfo>::const_iterator sample_itr_;
 
@@ -143,6 +143,29 @@ class TrackRunIteratorTest : public testing::Test {
     frag->runs[0].sample_sizes[1] = 10;
   }
 
+  // Set up the sample tables of |track| for a non-fragmented file, with two
+  // samples in each chunk. Sample sizes are 1, 2, 3, ... and every other
+  // sample is a sync sample.
+  void SetSampleTables(const std::vector<uint64_t>& chunk_offsets,
+                       uint32_t sample_delta,
+                       Track* track) {
+    SampleTable* stbl = &track->media.information.sample_table;
+    const uint32_t num_samples = chunk_offsets.size() * 2;
+
+    DecodingTime decoding_time = {num_samples, sample_delta};
+    stbl->decoding_time_to_sample.decoding_time.push_back(decoding_time);
+    ChunkInfo chunk_info = {1, 2, 1};
+    stbl->sample_to_chunk.chunk_info.push_back(chunk_info);
+    stbl->sample_size.sample_size = 0;
+    stbl->sample_size.sample_count = num_samples;
+    for (uint32_t i = 0; i < num_samples; ++i) {
+      stbl->sample_size.sizes.push_back(i + 1);
+      if (i % 2 == 0)
+        stbl->sync_sample.sample_number.push_back(i + 1);
+    }
+    stbl->chunk_large_offset.offsets = chunk_offsets;
+  }
+
   void SetAscending(std::vector<uint32_t>* vec) {
     vec->resize(10);
     for (size_t i = 0; i < vec->size(); i++)
@@ -421,6 +444,120 @@ TEST_F(TrackRunIteratorTest, UnexpectedOrderingTest) {
   EXPECT_EQ(iter_->GetMaxClearOffset(), 10000);
 }
 
+// Chunks of the audio and video tracks are interleaved. They are expected in
+// the order of their offsets.
+TEST_F(TrackRunIteratorTest, NonFragmentedTest) {
+  const uint64_t kAudioChunkOffsets[] = {100, 300, 500};
+  const uint64_t kVideoChunkOffsets[] = {200, 400};
+  SetSampleTables(
+      std::vector<uint64_t>(kAudioChunkOffsets,
+                            kAudioChunkOffsets + arraysize(kAudioChunkOffsets)),
+      1024,
+      &moov_.tracks[0]);
+  SetSampleTables(
+      std::vector<uint64_t>(kVideoChunkOffsets,
+                            kVideoChunkOffsets + arraysize(kVideoChunkOffsets)),
+      1,
+      &moov_.tracks[1]);
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+
+  EXPECT_TRUE(iter_->IsRunValid());
+  EXPECT_EQ(1u, iter_->track_id());
+  EXPECT_TRUE(iter_->is_audio());
+  EXPECT_EQ(100, iter_->sample_offset());
+  EXPECT_EQ(1, iter_->sample_size());
+  EXPECT_EQ(0, iter_->dts());
+  EXPECT_EQ(1024, iter_->duration());
+  EXPECT_TRUE(iter_->is_keyframe());
+  EXPECT_EQ(100, iter_->GetMaxClearOffset());
+  iter_->AdvanceSample();
+  EXPECT_EQ(101, iter_->sample_offset());
+  EXPECT_EQ(2, iter_->sample_size());
+  EXPECT_EQ(1024, iter_->dts());
+  EXPECT_FALSE(iter_->is_keyframe());
+  iter_->AdvanceSample();
+  EXPECT_FALSE(iter_->IsSampleValid());
+  EXPECT_EQ(200, iter_->GetMaxClearOffset());
+
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_EQ(2u, iter_->track_id());
+  EXPECT_TRUE(iter_->is_video());
+  EXPECT_EQ(200, iter_->sample_offset());
+  EXPECT_EQ(1, iter_->sample_size());
+  EXPECT_EQ(0, iter_->dts());
+
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_EQ(1u, iter_->track_id());
+  EXPECT_EQ(300, iter_->sample_offset());
+  EXPECT_EQ(3, iter_->sample_size());
+  EXPECT_EQ(2048, iter_->dts());
+  EXPECT_TRUE(iter_->is_keyframe());
+
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_EQ(2u, iter_->track_id());
+  EXPECT_EQ(400, iter_->sample_offset());
+  EXPECT_EQ(2, iter_->dts());
+  EXPECT_EQ(400, iter_->GetMaxClearOffset());
+
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_EQ(1u, iter_->track_id());
+  EXPECT_EQ(500, iter_->sample_offset());
+  EXPECT_EQ(5, iter_->sample_size());
+  EXPECT_EQ(4096, iter_->dts());
+  iter_->AdvanceSample();
+  EXPECT_EQ(6, iter_->sample_size());
+  EXPECT_EQ(505, iter_->GetMaxClearOffset());
+
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_FALSE(iter_->IsRunValid());
+}
+
+// The chunks of a track are not stored in order. They are still expected in
+// the order of their offsets.
+TEST_F(TrackRunIteratorTest, NonFragmentedUnorderedChunksTest) {
+  const uint64_t kAudioChunkOffsets[] = {300, 100};
+  SetSampleTables(
+      std::vector<uint64_t>(kAudioChunkOffsets,
+                            kAudioChunkOffsets + arraysize(kAudioChunkOffsets)),
+      1024,
+      &moov_.tracks[0]);
+  moov_.tracks[1].media.information.sample_table.description.type = kHint;
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+
+  EXPECT_EQ(100, iter_->sample_offset());
+  EXPECT_EQ(3, iter_->sample_size());
+  EXPECT_EQ(2048, iter_->dts());
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_EQ(300, iter_->sample_offset());
+  EXPECT_EQ(1, iter_->sample_size());
+  EXPECT_EQ(0, iter_->dts());
+  ASSERT_TRUE(iter_->AdvanceRun());
+  EXPECT_FALSE(iter_->IsRunValid());
+}
+
+// Errors in the sample table are reported when the chunk is reached.
+TEST_F(TrackRunIteratorTest, NonFragmentedInvalidSampleTableTest) {
+  const uint64_t kAudioChunkOffsets[] = {100, 200};
+  SetSampleTables(
+      std::vector<uint64_t>(kAudioChunkOffsets,
+                            kAudioChunkOffsets + arraysize(kAudioChunkOffsets)),
+      1024,
+      &moov_.tracks[0]);
+  moov_.tracks[1].media.information.sample_table.description.type = kHint;
+  // Invalid sample description index for the second chunk.
+  ChunkInfo chunk_info = {2, 2, 0};
+  moov_.tracks[0].media.information.sample_table.sample_to_chunk.chunk_info
+      .push_back(chunk_info);
+  iter_.reset(new TrackRunIterator(&moov_));
+  ASSERT_TRUE(iter_->Init());
+
+  EXPECT_EQ(100, iter_->sample_offset());
+  EXPECT_FALSE(iter_->AdvanceRun());
+  EXPECT_FALSE(iter_->IsRunValid());
+}
+
 }  // namespace mp4
 }  // namespace media
 }  // namespace edash_packager
@@ -13,6 +13,7 @@
 #include "packager/media/base/audio_stream_info.h"
 #include "packager/media/base/key_source.h"
 #include "packager/media/base/media_sample.h"
+#include "packager/media/base/pipeline_stats.h"
 #include "packager/media/base/status.h"
 #include "packager/media/base/video_stream_info.h"
 #include "packager/media/formats/mp2t/adts_header.h"
@@ -733,8 +734,13 @@ bool WvmMediaParser::DemuxNextPes(uint8_t* read_ptr, bool is_program_end) {
       LOG(ERROR) << "Source content is encrypted, but decryption not enabled";
       return false;
     }
+    const size_t crypto_unit_size =
+        sample_data_.size() - crypto_unit_start_pos_;
+    ScopedStageTimer decryption_timer(decryption_stats());
+    decryption_timer.set_count(1);
+    decryption_timer.set_bytes(crypto_unit_size);
     content_decryptor_->Decrypt(&sample_data_[crypto_unit_start_pos_],
-                                sample_data_.size() - crypto_unit_start_pos_,
+                                crypto_unit_size,
                                 &sample_data_[crypto_unit_start_pos_]);
   }
   // Demux media sample if we are at program end or if we are not at a
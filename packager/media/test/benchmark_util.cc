@@ -0,0 +1,75 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/test/benchmark_util.h"
+
+#include <stdio.h>
+
+#include "packager/base/time/time.h"
+
+namespace {
+const int64_t kMinBenchmarkTimeInMilliseconds = 1000;
+const int kMinIterations = 3;
+const double kBytesPerMegabyte = 1024.0 * 1024.0;
+}  // namespace
+
+namespace edash_packager {
+namespace media {
+
+void RunThroughputBenchmark(const std::string& name,
+                            uint64_t bytes_per_iteration,
+                            const base::Closure& iteration) {
+  // Warm up the caches, and the lazy initializations of the code measured.
+  iteration.Run();
+
+  const base::TimeDelta min_time =
+      base::TimeDelta::FromMilliseconds(kMinBenchmarkTimeInMilliseconds);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  base::TimeDelta elapsed;
+  int64_t num_iterations = 0;
+  while (num_iterations < kMinIterations || elapsed < min_time) {
+    iteration.Run();
+    ++num_iterations;
+    elapsed = base::TimeTicks::Now() - start;
+  }
+
+  const double seconds = elapsed.InSecondsF();
+  PrintPerfResult(name,
+                  "throughput",
+                  bytes_per_iteration * num_iterations / kBytesPerMegabyte /
+                      seconds,
+                  "MB/s");
+  PrintPerfResult(name,
+                  "time_per_iteration",
+                  seconds * base::Time::kMicrosecondsPerSecond / num_iterations,
+                  "us");
+}
+
+void PrintPerfResult(const std::string& name,
+                     const std::string& metric,
+                     double value,
+                     const std::string& unit) {
+  printf("*RESULT %s: %s= %.2f %s\n",
+         name.c_str(),
+         metric.c_str(),
+         value,
+         unit.c_str());
+  fflush(stdout);
+}
+
+std::vector<uint8_t> GenerateSyntheticData(size_t size) {
+  std::vector<uint8_t> data(size);
+  // A linear congruential generator is enough, and keeps runs comparable.
+  uint32_t state = 0x12345678;
+  for (size_t i = 0; i < size; ++i) {
+    state = state * 1103515245 + 12345;
+    data[i] = static_cast<uint8_t>(state >> 16);
+  }
+  return data;
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -0,0 +1,50 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Helpers of the packager_benchmarks and packager_perf_test targets.
+
+#ifndef MEDIA_TEST_BENCHMARK_UTIL_H_
+#define MEDIA_TEST_BENCHMARK_UTIL_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/callback.h"
+
+namespace edash_packager {
+namespace media {
+
+/// Run @a iteration repeatedly, for at least a second and at least a few
+/// times, and print its throughput to standard output in the format of the
+/// perf test results:
+///     *RESULT <name>: throughput= <MB/s> MB/s
+///     *RESULT <name>: time_per_iteration= <us> us
+/// @param name is the name of the benchmark.
+/// @param bytes_per_iteration is the amount of data processed by each call
+///        of @a iteration.
+/// @param iteration is the code to measure.
+void RunThroughputBenchmark(const std::string& name,
+                            uint64_t bytes_per_iteration,
+                            const base::Closure& iteration);
+
+/// Print a measurement to standard output in the format of the perf test
+/// results:
+///     *RESULT <name>: <metric>= <value> <unit>
+void PrintPerfResult(const std::string& name,
+                     const std::string& metric,
+                     double value,
+                     const std::string& unit);
+
+/// @return @a size bytes of deterministic pseudo-random data, for use as
+///         synthetic media payload.
+std::vector<uint8_t> GenerateSyntheticData(size_t size);
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_TEST_BENCHMARK_UTIL_H_
@@ -0,0 +1,506 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/test/long_input_util.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/logging.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/buffer_reader.h"
+#include "packager/media/base/container_names.h"
+#include "packager/media/base/media_parser.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/file_closer.h"
+#include "packager/media/formats/mp2t/mp2t_media_parser.h"
+#include "packager/media/formats/mp4/fourccs.h"
+#include "packager/media/formats/mp4/mp4_media_parser.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace edash_packager {
+namespace media {
+namespace {
+
+// Durations, or timestamp offsets, of the tracks in their timescale, indexed
+// by track ID. The track IDs of TS files are the PIDs.
+typedef std::map<uint32_t, int64_t> TrackTimeMap;
+
+const size_t kTsPacketSize = 188;
+const uint8_t kTsSyncByte = 0x47;
+// PES start code, stream id, packet length, flags and header data length.
+const size_t kPesHeaderSize = 9;
+const size_t kPesTimestampSize = 5;
+const int64_t kPesTimestampMask = 0x1ffffffffLL;
+
+// Collects the duration of the tracks from the samples emitted by a parser.
+class TrackDurationCollector {
+ public:
+  TrackDurationCollector() {}
+
+  void OnInit(const std::vector<scoped_refptr<StreamInfo> >& stream_infos) {
+    for (size_t i = 0; i < stream_infos.size(); ++i)
+      time_scales_[stream_infos[i]->track_id()] = stream_infos[i]->time_scale();
+  }
+
+  bool OnNewSample(uint32_t track_id,
+                   const scoped_refptr<MediaSample>& sample) {
+    std::map<uint32_t, TrackTimes>::iterator it = tracks_.find(track_id);
+    if (it == tracks_.end()) {
+      TrackTimes times;
+      times.first_dts = sample->dts();
+      times.last_dts = sample->dts();
+      times.last_delta = 0;
+      times.last_duration = sample->duration();
+      tracks_[track_id] = times;
+      return true;
+    }
+    TrackTimes& times = it->second;
+    times.last_delta = sample->dts() - times.last_dts;
+    times.last_dts = sample->dts();
+    times.last_duration = sample->duration();
+    return true;
+  }
+
+  // Gets the duration of each track, and the duration of the longest track
+  // in seconds. The duration of the last sample is estimated from the
+  // previous one if it is not known.
+  bool GetDurations(TrackTimeMap* durations, double* max_duration_in_seconds) {
+    *max_duration_in_seconds = 0;
+    for (std::map<uint32_t, TrackTimes>::const_iterator it = tracks_.begin();
+         it != tracks_.end(); ++it) {
+      const TrackTimes& times = it->second;
+      const int64_t last_duration =
+          times.last_duration > 0 ? times.last_duration : times.last_delta;
+      const int64_t duration =
+          times.last_dts + last_duration - times.first_dts;
+      const uint32_t time_scale = time_scales_[it->first];
+      if (duration <= 0 || time_scale == 0) {
+        LOG(ERROR) << "Cannot compute the duration of track " << it->first;
+        return false;
+      }
+      (*durations)[it->first] = duration;
+      *max_duration_in_seconds =
+          std::max(*max_duration_in_seconds,
+                   static_cast<double>(duration) / time_scale);
+    }
+    return !durations->empty();
+  }
+
+ private:
+  struct TrackTimes {
+    int64_t first_dts;
+    int64_t last_dts;
+    int64_t last_delta;
+    int64_t last_duration;
+  };
+
+  std::map<uint32_t, uint32_t> time_scales_;
+  std::map<uint32_t, TrackTimes> tracks_;
+
+  DISALLOW_COPY_AND_ASSIGN(TrackDurationCollector);
+};
+
+bool WriteBuffer(const std::vector<uint8_t>& buffer, File* file) {
+  return file->Write(&buffer[0], buffer.size()) ==
+         static_cast<int64_t>(buffer.size());
+}
+
+// PTS and DTS, as coded in the PES header: 33 bits split into 3, 15 and 15
+// bits, each followed by a marker bit.
+int64_t ReadPesTimestamp(const uint8_t* data) {
+  return (static_cast<int64_t>(data[0] & 0x0e) << 29) |
+         (static_cast<int64_t>(data[1]) << 22) |
+         (static_cast<int64_t>(data[2] & 0xfe) << 14) |
+         (static_cast<int64_t>(data[3]) << 7) |
+         (data[4] >> 1);
+}
+
+void WritePesTimestamp(int64_t timestamp, uint8_t* data) {
+  timestamp &= kPesTimestampMask;
+  data[0] = (data[0] & 0xf1) | ((timestamp >> 29) & 0x0e);
+  data[1] = (timestamp >> 22) & 0xff;
+  data[2] = ((timestamp >> 14) & 0xfe) | (data[2] & 0x01);
+  data[3] = (timestamp >> 7) & 0xff;
+  data[4] = ((timestamp << 1) & 0xfe) | (data[4] & 0x01);
+}
+
+// Base of the PCR: 33 bits followed by the reserved bits and the extension.
+int64_t ReadPcrBase(const uint8_t* data) {
+  return (static_cast<int64_t>(data[0]) << 25) |
+         (static_cast<int64_t>(data[1]) << 17) |
+         (static_cast<int64_t>(data[2]) << 9) |
+         (static_cast<int64_t>(data[3]) << 1) |
+         (data[4] >> 7);
+}
+
+void WritePcrBase(int64_t pcr_base, uint8_t* data) {
+  pcr_base &= kPesTimestampMask;
+  data[0] = (pcr_base >> 25) & 0xff;
+  data[1] = (pcr_base >> 17) & 0xff;
+  data[2] = (pcr_base >> 9) & 0xff;
+  data[3] = (pcr_base >> 1) & 0xff;
+  data[4] = ((pcr_base << 7) & 0x80) | (data[4] & 0x7f);
+}
+
+// Shifts the PCR, PTS and DTS of a TS packet, and renumbers its continuity
+// counter to follow the previous packet of the same PID.
+bool RewriteTsPacket(const TrackTimeMap& pes_offsets,
+                     int64_t pcr_offset,
+                     std::map<int, int>* continuity_counters,
+                     uint8_t* packet) {
+  if (packet[0] != kTsSyncByte) {
+    LOG(ERROR) << "Invalid TS sync byte.";
+    return false;
+  }
+  const int pid = ((packet[1] & 0x1f) << 8) | packet[2];
+  const bool payload_unit_start = (packet[1] & 0x40) != 0;
+  const int adaptation_field_control = (packet[3] >> 4) & 0x3;
+  const bool has_adaptation_field = (adaptation_field_control & 0x2) != 0;
+  const bool has_payload = (adaptation_field_control & 0x1) != 0;
+
+  // The counter is only incremented by the packets with a payload.
+  int continuity_counter = packet[3] & 0x0f;
+  std::map<int, int>::const_iterator counter = continuity_counters->find(pid);
+  if (counter != continuity_counters->end()) {
+    continuity_counter =
+        has_payload ? (counter->second + 1) % 16 : counter->second;
+  }
+  (*continuity_counters)[pid] = continuity_counter;
+  packet[3] = (packet[3] & 0xf0) | continuity_counter;
+
+  size_t payload_offset = 4;
+  if (has_adaptation_field) {
+    const size_t adaptation_field_length = packet[4];
+    payload_offset += 1 + adaptation_field_length;
+    if (payload_offset > kTsPacketSize) {
+      LOG(ERROR) << "Invalid TS adaptation field length.";
+      return false;
+    }
+    // PCR flag.
+    if (adaptation_field_length >= 7 && (packet[5] & 0x10) != 0)
+      WritePcrBase(ReadPcrBase(&packet[6]) + pcr_offset, &packet[6]);
+  }
+
+  if (!has_payload || !payload_unit_start)
+    return true;
+  TrackTimeMap::const_iterator pes_offset = pes_offsets.find(pid);
+  // Not a PES of a track, e.g. PAT or PMT.
+  if (pes_offset == pes_offsets.end())
+    return true;
+
+  uint8_t* pes = packet + payload_offset;
+  const size_t pes_size = kTsPacketSize - payload_offset;
+  if (pes_size < kPesHeaderSize || pes[0] != 0 || pes[1] != 0 ||
+      pes[2] != 1) {
+    LOG(ERROR) << "Invalid PES header for PID " << pid;
+    return false;
+  }
+  const int pts_dts_flags = pes[7] >> 6;
+  const size_t num_timestamps =
+      pts_dts_flags == 0x3 ? 2 : (pts_dts_flags == 0x2 ? 1 : 0);
+  if (pes_size < kPesHeaderSize + num_timestamps * kPesTimestampSize) {
+    LOG(ERROR) << "Truncated PES header for PID " << pid;
+    return false;
+  }
+  for (size_t i = 0; i < num_timestamps; ++i) {
+    uint8_t* timestamp = pes + kPesHeaderSize + i * kPesTimestampSize;
+    WritePesTimestamp(ReadPesTimestamp(timestamp) + pes_offset->second,
+                      timestamp);
+  }
+  return true;
+}
+
+bool WriteLongTs(const std::vector<uint8_t>& source,
+                 const TrackTimeMap& durations,
+                 int num_copies,
+                 File* output) {
+  if (source.size() % kTsPacketSize != 0) {
+    LOG(ERROR) << "TS file size is not a multiple of the packet size.";
+    return false;
+  }
+  // All the timestamps are in 90 kHz. The PCR follows the longest track.
+  int64_t pcr_duration = 0;
+  for (TrackTimeMap::const_iterator it = durations.begin();
+       it != durations.end(); ++it) {
+    pcr_duration = std::max(pcr_duration, it->second);
+  }
+
+  std::map<int, int> continuity_counters;
+  std::vector<uint8_t> buffer;
+  for (int copy = 0; copy < num_copies; ++copy) {
+    TrackTimeMap offsets;
+    for (TrackTimeMap::const_iterator it = durations.begin();
+         it != durations.end(); ++it) {
+      offsets[it->first] = it->second * copy;
+    }
+    buffer = source;
+    for (size_t offset = 0; offset < buffer.size(); offset += kTsPacketSize) {
+      if (!RewriteTsPacket(offsets, pcr_duration * copy, &continuity_counters,
+                           &buffer[offset])) {
+        return false;
+      }
+    }
+    if (!WriteBuffer(buffer, output))
+      return false;
+  }
+  return true;
+}
+
+void WriteBigEndian32(uint32_t value, uint8_t* data) {
+  data[0] = (value >> 24) & 0xff;
+  data[1] = (value >> 16) & 0xff;
+  data[2] = (value >> 8) & 0xff;
+  data[3] = value & 0xff;
+}
+
+void WriteBigEndian64(uint64_t value, uint8_t* data) {
+  WriteBigEndian32(value >> 32, data);
+  WriteBigEndian32(value & 0xffffffff, data + 4);
+}
+
+// Reads the header of the box at the start of |data|. Boxes extending to the
+// end of the file are not supported.
+bool ReadBoxHeader(const uint8_t* data,
+                   size_t size,
+                   uint32_t* type,
+                   size_t* header_size,
+                   size_t* box_size) {
+  BufferReader reader(data, size);
+  uint32_t size32 = 0;
+  if (!reader.Read4(&size32) || !reader.Read4(type))
+    return false;
+  uint64_t size64 = size32;
+  if (size32 == 1 && !reader.Read8(&size64))
+    return false;
+  *header_size = reader.pos();
+  if (size64 < *header_size || size64 > size)
+    return false;
+  *box_size = size64;
+  return true;
+}
+
+// Shifts the decode time in the 'tfdt' box of the 'traf' box |traf|, by the
+// offset of the track in its 'tfhd' box.
+bool RewriteTraf(const TrackTimeMap& decode_time_offsets,
+                 uint8_t* traf,
+                 size_t traf_size) {
+  uint32_t type = 0;
+  size_t header_size = 0;
+  size_t box_size = 0;
+  if (!ReadBoxHeader(traf, traf_size, &type, &header_size, &box_size))
+    return false;
+
+  int64_t decode_time_offset = 0;
+  for (size_t pos = header_size; pos < box_size;) {
+    uint8_t* child = traf + pos;
+    size_t child_header_size = 0;
+    size_t child_size = 0;
+    if (!ReadBoxHeader(child, box_size - pos, &type, &child_header_size,
+                       &child_size)) {
+      return false;
+    }
+    // Both are full boxes. 'tfhd' comes before 'tfdt'.
+    BufferReader reader(child + child_header_size,
+                        child_size - child_header_size);
+    uint8_t version = 0;
+    if (type == mp4::FOURCC_TFHD) {
+      uint32_t track_id = 0;
+      if (!reader.Read1(&version) || !reader.SkipBytes(3) ||
+          !reader.Read4(&track_id)) {
+        return false;
+      }
+      TrackTimeMap::const_iterator offset =
+          decode_time_offsets.find(track_id);
+      if (offset != decode_time_offsets.end())
+        decode_time_offset = offset->second;
+    } else if (type == mp4::FOURCC_TFDT) {
+      if (!reader.Read1(&version) || !reader.SkipBytes(3))
+        return false;
+      uint8_t* decode_time_data = child + child_header_size + reader.pos();
+      if (version == 1) {
+        uint64_t decode_time = 0;
+        if (!reader.Read8(&decode_time))
+          return false;
+        WriteBigEndian64(decode_time + decode_time_offset, decode_time_data);
+      } else {
+        uint32_t decode_time = 0;
+        if (!reader.Read4(&decode_time))
+          return false;
+        WriteBigEndian32(decode_time + decode_time_offset, decode_time_data);
+      }
+    }
+    pos += child_size;
+  }
+  return true;
+}
+
+// Shifts the sequence number in the 'mfhd' box and the decode times of the
+// 'moof' box |moof|.
+bool RewriteMoof(uint32_t sequence_number_offset,
+                 const TrackTimeMap& decode_time_offsets,
+                 uint8_t* moof,
+                 size_t moof_size) {
+  uint32_t type = 0;
+  size_t header_size = 0;
+  size_t box_size = 0;
+  if (!ReadBoxHeader(moof, moof_size, &type, &header_size, &box_size))
+    return false;
+
+  for (size_t pos = header_size; pos < box_size;) {
+    uint8_t* child = moof + pos;
+    size_t child_header_size = 0;
+    size_t child_size = 0;
+    if (!ReadBoxHeader(child, box_size - pos, &type, &child_header_size,
+                       &child_size)) {
+      return false;
+    }
+    if (type == mp4::FOURCC_MFHD) {
+      BufferReader reader(child + child_header_size,
+                          child_size - child_header_size);
+      uint32_t sequence_number = 0;
+      if (!reader.SkipBytes(4) || !reader.Read4(&sequence_number))
+        return false;
+      WriteBigEndian32(sequence_number + sequence_number_offset,
+                       child + child_header_size + 4);
+    } else if (type == mp4::FOURCC_TRAF) {
+      if (!RewriteTraf(decode_time_offsets, child, child_size))
+        return false;
+    }
+    pos += child_size;
+  }
+  return true;
+}
+
+bool WriteLongMp4(const std::vector<uint8_t>& source,
+                  const TrackTimeMap& durations,
+                  int num_copies,
+                  File* output) {
+  // The boxes before the first fragment are written once. The fragments are
+  // copied, without the segment boxes, whose contents would not match.
+  std::vector<uint8_t> header;
+  std::vector<uint8_t> fragments;
+  std::vector<size_t> moof_offsets;
+  for (size_t pos = 0; pos < source.size();) {
+    uint32_t type = 0;
+    size_t header_size = 0;
+    size_t box_size = 0;
+    if (!ReadBoxHeader(&source[pos], source.size() - pos, &type, &header_size,
+                       &box_size)) {
+      LOG(ERROR) << "Invalid box at offset " << pos;
+      return false;
+    }
+    const uint8_t* box = &source[pos];
+    if (type == mp4::FOURCC_MOOF) {
+      moof_offsets.push_back(fragments.size());
+      fragments.insert(fragments.end(), box, box + box_size);
+    } else if (type == mp4::FOURCC_MDAT) {
+      fragments.insert(fragments.end(), box, box + box_size);
+    } else if (type != mp4::FOURCC_SIDX && type != mp4::FOURCC_STYP &&
+               moof_offsets.empty()) {
+      header.insert(header.end(), box, box + box_size);
+    }
+    pos += box_size;
+  }
+  if (moof_offsets.empty()) {
+    LOG(ERROR) << "Only fragmented MP4 files are supported.";
+    return false;
+  }
+
+  if (!WriteBuffer(header, output))
+    return false;
+  std::vector<uint8_t> buffer;
+  for (int copy = 0; copy < num_copies; ++copy) {
+    TrackTimeMap offsets;
+    for (TrackTimeMap::const_iterator it = durations.begin();
+         it != durations.end(); ++it) {
+      offsets[it->first] = it->second * copy;
+    }
+    buffer = fragments;
+    for (size_t i = 0; i < moof_offsets.size(); ++i) {
+      if (!RewriteMoof(moof_offsets.size() * copy, offsets,
+                       &buffer[moof_offsets[i]],
+                       buffer.size() - moof_offsets[i])) {
+        LOG(ERROR) << "Invalid 'moof' box.";
+        return false;
+      }
+    }
+    if (!WriteBuffer(buffer, output))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool WriteLongTestInput(const std::string& test_data_file,
+                        double min_duration_in_seconds,
+                        const std::string& output_file_name,
+                        double* duration_in_seconds) {
+  const std::vector<uint8_t> source = ReadTestDataFile(test_data_file);
+  if (source.empty())
+    return false;
+
+  const MediaContainerName container =
+      DetermineContainer(&source[0], source.size());
+  scoped_ptr<MediaParser> parser;
+  switch (container) {
+    case CONTAINER_MOV:
+      parser.reset(new mp4::MP4MediaParser());
+      break;
+    case CONTAINER_MPEG2TS:
+      parser.reset(new mp2t::Mp2tMediaParser());
+      break;
+    default:
+      LOG(ERROR) << "Unsupported container of " << test_data_file;
+      return false;
+  }
+
+  TrackDurationCollector collector;
+  parser->Init(base::Bind(&TrackDurationCollector::OnInit,
+                          base::Unretained(&collector)),
+               base::Bind(&TrackDurationCollector::OnNewSample,
+                          base::Unretained(&collector)),
+               NULL);
+  if (!parser->Parse(&source[0], source.size())) {
+    LOG(ERROR) << "Cannot parse " << test_data_file;
+    return false;
+  }
+  parser->Flush();
+
+  TrackTimeMap durations;
+  double source_duration_in_seconds = 0;
+  if (!collector.GetDurations(&durations, &source_duration_in_seconds))
+    return false;
+  const int num_copies = std::max(
+      1,
+      static_cast<int>(
+          ceil(min_duration_in_seconds / source_duration_in_seconds)));
+
+  scoped_ptr<File, FileCloser> output(
+      File::Open(output_file_name.c_str(), "w"));
+  if (!output) {
+    LOG(ERROR) << "Cannot open " << output_file_name;
+    return false;
+  }
+  const bool success =
+      container == CONTAINER_MPEG2TS
+          ? WriteLongTs(source, durations, num_copies, output.get())
+          : WriteLongMp4(source, durations, num_copies, output.get());
+  if (success && duration_in_seconds)
+    *duration_in_seconds = num_copies * source_duration_in_seconds;
+  return success;
+}
+
+}  // namespace media
+}  // namespace edash_packager
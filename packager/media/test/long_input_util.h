@@ -0,0 +1,40 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// Generation of long synthetic inputs from the short test clips.
+
+#ifndef MEDIA_TEST_LONG_INPUT_UTIL_H_
+#define MEDIA_TEST_LONG_INPUT_UTIL_H_
+
+#include <string>
+
+namespace edash_packager {
+namespace media {
+
+/// Write copies of a test data file back to back, with the timestamps of each
+/// copy shifted to follow the previous copy, so that the output is a single
+/// continuous stream.
+/// Supported inputs are MPEG-2 TS files and fragmented MP4 files. For TS
+/// files, the PTS, DTS, PCR and continuity counters are rewritten. For MP4
+/// files, the 'ftyp' and 'moov' boxes are written once, followed by the
+/// 'moof' and 'mdat' boxes of each copy, with their sequence numbers and
+/// decode times rewritten; 'sidx' and 'styp' boxes are dropped.
+/// @param test_data_file is the name of the test data file to copy.
+/// @param min_duration_in_seconds is the minimum duration of the output.
+///        The file is copied as many times as needed to reach it.
+/// @param output_file_name is the name of the file to write.
+/// @param[out] duration_in_seconds is set to the duration of the output.
+///             Can be NULL.
+/// @return true on success, false otherwise.
+bool WriteLongTestInput(const std::string& test_data_file,
+                        double min_duration_in_seconds,
+                        const std::string& output_file_name,
+                        double* duration_in_seconds);
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // MEDIA_TEST_LONG_INPUT_UTIL_H_
@@ -0,0 +1,476 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// End-to-end throughput tests on long synthetic inputs. The wall time, the
+// peak resident set size and the input bytes processed per second of each
+// configuration are compared to the baselines in
+// media/test/data/packager_perf_baselines.json. A configuration without a
+// baseline is only reported, unless --require_perf_baselines is set.
+//
+// Switches:
+//   --long_input_duration=<seconds>  Duration of the inputs, 600 by default.
+//   --perf_baselines=<file>          Alternative baseline file.
+//   --perf_tolerance=<ratio>         Allowed regression, 0.2 by default.
+//   --require_perf_baselines         Fail configurations without a baseline.
+//   --update_perf_baselines          Record the results as the baselines.
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/command_line.h"
+#include "packager/base/file_util.h"
+#include "packager/base/json/json_reader.h"
+#include "packager/base/json/json_writer.h"
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/time/time.h"
+#include "packager/base/values.h"
+#include "packager/media/base/demuxer.h"
+#include "packager/media/base/key_source.h"
+#include "packager/media/base/media_stream.h"
+#include "packager/media/base/muxer.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/base/test/status_test_util.h"
+#include "packager/media/file/file.h"
+#include "packager/media/file/file_closer.h"
+#include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/media/test/benchmark_util.h"
+#include "packager/media/test/long_input_util.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/packager.h"
+
+using ::testing::ValuesIn;
+
+namespace edash_packager {
+namespace media {
+namespace {
+
+const char* kMediaFiles[] = {"bear-1280x720.ts", "bear-640x360-av_frag.mp4"};
+
+const char kLongInputDurationSwitch[] = "long_input_duration";
+const char kPerfBaselinesSwitch[] = "perf_baselines";
+const char kPerfToleranceSwitch[] = "perf_tolerance";
+const char kRequirePerfBaselinesSwitch[] = "require_perf_baselines";
+const char kUpdatePerfBaselinesSwitch[] = "update_perf_baselines";
+
+const double kDefaultLongInputDurationInSeconds = 600;
+const double kDefaultPerfTolerance = 0.2;
+const char kPerfBaselinesFile[] = "packager_perf_baselines.json";
+
+// Baseline fields.
+const char kInputDurationField[] = "input_duration_seconds";
+const char kWallTimeField[] = "wall_seconds";
+const char kPeakRssField[] = "peak_rss_kb";
+const char kBytesPerSecondField[] = "bytes_per_second";
+
+// Muxer options.
+const double kSegmentDurationInSeconds = 2.0;
+const double kFragmentDurationInSeconds = 2.0;
+const int kNumSubsegmentsPerSidx = 0;
+
+const char kSegmentTemplateSuffix[] = "_$Number$.m4s";
+
+// Encryption constants.
+const char kKeyIdHex[] = "e5007e6e9dcd5ac095202ed3758382cd";
+const char kKeyHex[] = "6fc96fe628a265b13aeddec0bc421f4d";
+const char kPsshHex[] =
+    "08011210e5007e6e9dcd5ac095202ed3"
+    "758382cd1a0d7769646576696e655f746573742211544553545f"
+    "434f4e54454e545f49445f312a025344";
+const double kClearLeadInSeconds = 0;
+const double kCryptoPeriodDurationInSeconds = 10;
+const uint32_t kMaxSdPixels = 768 * 576;
+
+struct PerfResult {
+  double wall_seconds;
+  double peak_rss_kb;
+  double bytes_per_second;
+};
+
+// Resets the peak resident set size of the process, so that each test
+// measures its own. Only supported on Linux; the peak of the process is
+// reported otherwise.
+void ResetPeakRss() {
+#if defined(OS_LINUX)
+  FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+  if (clear_refs) {
+    fputs("5", clear_refs);
+    fclose(clear_refs);
+  }
+#endif
+}
+
+double GetPeakRssInKilobytes() {
+#if defined(OS_LINUX)
+  std::string status;
+  if (File::ReadFileToString("/proc/self/status", &status)) {
+    const char kPeakRssPrefix[] = "VmHWM:";
+    const size_t pos = status.find(kPeakRssPrefix);
+    if (pos != std::string::npos) {
+      int peak_rss_kb = 0;
+      if (sscanf(status.c_str() + pos + strlen(kPeakRssPrefix), "%d",
+                 &peak_rss_kb) == 1) {
+        return peak_rss_kb;
+      }
+    }
+  }
+#endif
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(OS_MACOSX)
+  // In bytes.
+  return usage.ru_maxrss / 1024.0;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+double GetDoubleSwitch(const char* name, double default_value) {
+  const std::string value =
+      CommandLine::ForCurrentProcess()->GetSwitchValueASCII(name);
+  double result = default_value;
+  if (!value.empty())
+    CHECK(base::StringToDouble(value, &result)) << "Invalid --" << name;
+  return result;
+}
+
+std::string GetBaselinesFile() {
+  const std::string file =
+      CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+          kPerfBaselinesSwitch);
+  return file.empty() ? GetTestDataFilePath(kPerfBaselinesFile).value()
+                      : file;
+}
+
+// Key source generating a different key for each crypto period, so that key
+// rotation can be measured without a key server.
+class RotatingKeySource : public KeySource {
+ public:
+  RotatingKeySource() {}
+  virtual ~RotatingKeySource() {}
+
+  virtual Status GetKey(TrackType track_type, EncryptionKey* key) OVERRIDE {
+    return GetCryptoPeriodKey(0, track_type, key);
+  }
+
+  virtual Status GetCryptoPeriodKey(uint32_t crypto_period_index,
+                                    TrackType track_type,
+                                    EncryptionKey* key) OVERRIDE {
+    const size_t kKeySize = 16;
+    key->key_id.assign(kKeySize, static_cast<uint8_t>(track_type));
+    key->key.assign(kKeySize, static_cast<uint8_t>(track_type));
+    for (size_t i = 0; i < sizeof(crypto_period_index); ++i) {
+      const uint8_t byte = (crypto_period_index >> (8 * i)) & 0xff;
+      key->key_id[kKeySize - 1 - i] = byte;
+      key->key[i] = byte;
+    }
+    key->pssh = PsshBoxFromPsshData(key->key_id);
+    key->iv.clear();
+    return Status::OK;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RotatingKeySource);
+};
+
+MediaStream* FindFirstStreamOfType(const std::vector<MediaStream*>& streams,
+                                   StreamType stream_type) {
+  typedef std::vector<MediaStream*>::const_iterator StreamIterator;
+  for (StreamIterator it = streams.begin(); it != streams.end(); ++it) {
+    if ((*it)->info()->stream_type() == stream_type)
+      return *it;
+  }
+  return NULL;
+}
+
+}  // namespace
+
+class PackagerPerfTest : public ::testing::TestWithParam<const char*> {
+ public:
+  PackagerPerfTest() {}
+
+  static void SetUpTestCase() {
+    ASSERT_TRUE(base::CreateNewTempDirectory("packager_perf_",
+                                             &input_directory_));
+  }
+
+  static void TearDownTestCase() {
+    base::DeleteFile(input_directory_, true);
+  }
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(base::CreateNewTempDirectory("packager_", &test_directory_));
+
+    // The long inputs are generated once, as they take a while to write.
+    input_duration_ = GetDoubleSwitch(kLongInputDurationSwitch,
+                                      kDefaultLongInputDurationInSeconds);
+    input_ = input_directory_.AppendASCII(GetParam()).value();
+    if (!base::PathExists(input_directory_.AppendASCII(GetParam()))) {
+      double duration = 0;
+      ASSERT_TRUE(
+          WriteLongTestInput(GetParam(), input_duration_, input_, &duration));
+      LOG(INFO) << "Generated " << input_ << " of " << duration << " seconds.";
+    }
+    input_size_ = File::GetFileSize(input_.c_str());
+    ASSERT_LT(0, input_size_);
+  }
+
+  virtual void TearDown() OVERRIDE { base::DeleteFile(test_directory_, true); }
+
+ protected:
+  std::string GetFullPath(const std::string& file_name) {
+    return test_directory_.AppendASCII(file_name).value();
+  }
+
+  MuxerOptions SetupOptions(bool single_segment) {
+    MuxerOptions options;
+    options.single_segment = single_segment;
+    options.segment_duration = kSegmentDurationInSeconds;
+    options.fragment_duration = kFragmentDurationInSeconds;
+    options.segment_sap_aligned = true;
+    options.fragment_sap_aligned = true;
+    options.num_subsegments_per_sidx = kNumSubsegmentsPerSidx;
+    options.temp_dir = test_directory_.value();
+    return options;
+  }
+
+  std::vector<StreamDescriptor> SetupStreamDescriptors(bool single_segment) {
+    const char* kStreams[] = {"video", "audio"};
+    std::vector<StreamDescriptor> descriptors;
+    for (size_t i = 0; i < arraysize(kStreams); ++i) {
+      StreamDescriptor descriptor;
+      descriptor.stream_selector = kStreams[i];
+      descriptor.input = input_;
+      if (single_segment) {
+        descriptor.output = GetFullPath(std::string(kStreams[i]) + ".mp4");
+      } else {
+        descriptor.output = GetFullPath(std::string(kStreams[i]) + "_init.mp4");
+        descriptor.segment_template =
+            GetFullPath(std::string(kStreams[i]) + kSegmentTemplateSuffix);
+      }
+      descriptors.push_back(descriptor);
+    }
+    return descriptors;
+  }
+
+ public:
+  // Packages the input with the library API, the MPD included.
+  void Package(bool single_segment, bool enable_encryption) {
+    PackagingParams params;
+    params.muxer_options = SetupOptions(single_segment);
+    params.mpd_output = GetFullPath("output.mpd");
+    if (enable_encryption) {
+      EncryptionParams& encryption = params.encryption_params;
+      encryption.key_provider = kFixedKeyProvider;
+      encryption.key_id = kKeyIdHex;
+      encryption.key = kKeyHex;
+      encryption.pssh = kPsshHex;
+      encryption.max_sd_pixels = kMaxSdPixels;
+      encryption.clear_lead = kClearLeadInSeconds;
+    }
+
+    const size_t kThreadPerInput = 0;
+    const size_t kSerialEncryption = 0;
+    Packager packager(kThreadPerInput, kSerialEncryption);
+    ASSERT_OK(packager.Run(params, SetupStreamDescriptors(single_segment)));
+  }
+
+  // Key rotation needs a key source generating crypto period keys, which the
+  // library API only supports with a key server, so the pipeline is set up
+  // directly.
+  void PackageWithKeyRotation() {
+    Demuxer demuxer(input_);
+    ASSERT_OK(demuxer.Initialize());
+    RotatingKeySource key_source;
+
+    const StreamType kStreamTypes[] = {kStreamVideo, kStreamAudio};
+    const std::vector<StreamDescriptor> descriptors =
+        SetupStreamDescriptors(false);
+    std::vector<Muxer*> muxers;
+    STLElementDeleter<std::vector<Muxer*> > deleter(&muxers);
+    for (size_t i = 0; i < arraysize(kStreamTypes); ++i) {
+      MediaStream* stream =
+          FindFirstStreamOfType(demuxer.streams(), kStreamTypes[i]);
+      ASSERT_TRUE(stream != NULL);
+      MuxerOptions options = SetupOptions(false);
+      options.output_file_name = descriptors[i].output;
+      options.segment_template = descriptors[i].segment_template;
+      muxers.push_back(new mp4::MP4Muxer(options));
+      muxers.back()->AddStream(stream);
+      muxers.back()->SetKeySource(&key_source,
+                                  kMaxSdPixels,
+                                  kClearLeadInSeconds,
+                                  kCryptoPeriodDurationInSeconds);
+    }
+    ASSERT_OK(demuxer.Run());
+  }
+
+ protected:
+  // Measures |run|, reports the result and checks it against the baseline
+  // of |mode|.
+  void Measure(const std::string& mode, const base::Closure& run) {
+    ResetPeakRss();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    run.Run();
+    if (HasFatalFailure())
+      return;
+    PerfResult result;
+    result.wall_seconds = (base::TimeTicks::Now() - start).InSecondsF();
+    result.peak_rss_kb = GetPeakRssInKilobytes();
+    result.bytes_per_second = input_size_ / result.wall_seconds;
+
+    const std::string name = GetBaselineName(mode);
+    PrintPerfResult(name, kWallTimeField, result.wall_seconds, "s");
+    PrintPerfResult(name, kPeakRssField, result.peak_rss_kb, "kB");
+    PrintPerfResult(name, kBytesPerSecondField, result.bytes_per_second,
+                    "bytes/s");
+
+    if (CommandLine::ForCurrentProcess()->HasSwitch(
+            kUpdatePerfBaselinesSwitch)) {
+      UpdateBaseline(name, result);
+    } else {
+      CheckBaseline(name, result);
+    }
+  }
+
+ private:
+  // Baseline names are used as dictionary keys, thus cannot contain dots.
+  std::string GetBaselineName(const std::string& mode) {
+    std::string name = mode + "_" + GetParam();
+    std::replace(name.begin(), name.end(), '.', '_');
+    std::replace(name.begin(), name.end(), '-', '_');
+    return name;
+  }
+
+  // A missing baseline file is treated as an empty one.
+  scoped_ptr<base::DictionaryValue> ReadBaselines() {
+    std::string json;
+    if (!File::ReadFileToString(GetBaselinesFile().c_str(), &json))
+      return scoped_ptr<base::DictionaryValue>(new base::DictionaryValue);
+    scoped_ptr<base::Value> value(base::JSONReader::Read(json));
+    base::DictionaryValue* baselines = NULL;
+    if (!value || !value->GetAsDictionary(&baselines)) {
+      ADD_FAILURE() << "Invalid baseline file " << GetBaselinesFile();
+      return scoped_ptr<base::DictionaryValue>(new base::DictionaryValue);
+    }
+    ignore_result(value.release());
+    return scoped_ptr<base::DictionaryValue>(baselines);
+  }
+
+  // A missing baseline only fails the test with --require_perf_baselines,
+  // as the baselines are recorded on a reference machine and the results of
+  // other machines cannot be compared to them anyway.
+  void CheckBaseline(const std::string& name, const PerfResult& result) {
+    scoped_ptr<base::DictionaryValue> baselines = ReadBaselines();
+    base::DictionaryValue* baseline = NULL;
+    double bytes_per_second = 0;
+    double peak_rss_kb = 0;
+    double input_duration = 0;
+    double wall_seconds = 0;
+    if (!baselines->GetDictionary(name, &baseline) ||
+        !baseline->GetDouble(kBytesPerSecondField, &bytes_per_second) ||
+        !baseline->GetDouble(kPeakRssField, &peak_rss_kb) ||
+        !baseline->GetDouble(kInputDurationField, &input_duration) ||
+        !baseline->GetDouble(kWallTimeField, &wall_seconds)) {
+      if (CommandLine::ForCurrentProcess()->HasSwitch(
+              kRequirePerfBaselinesSwitch)) {
+        ADD_FAILURE() << "No complete baseline for " << name << " in "
+                      << GetBaselinesFile() << ". Record it with --"
+                      << kUpdatePerfBaselinesSwitch << ".";
+      } else {
+        LOG(WARNING) << "No complete baseline for " << name << " in "
+                     << GetBaselinesFile() << ": the result is not checked.";
+      }
+      return;
+    }
+    const double tolerance =
+        GetDoubleSwitch(kPerfToleranceSwitch, kDefaultPerfTolerance);
+
+    EXPECT_GE(result.bytes_per_second, bytes_per_second * (1 - tolerance))
+        << name << " throughput regressed.";
+    EXPECT_LE(result.peak_rss_kb, peak_rss_kb * (1 + tolerance))
+        << name << " peak memory regressed.";
+    // The wall time is only comparable for inputs of the same duration.
+    if (input_duration == input_duration_) {
+      EXPECT_LE(result.wall_seconds, wall_seconds * (1 + tolerance))
+          << name << " wall time regressed.";
+    }
+  }
+
+  void UpdateBaseline(const std::string& name, const PerfResult& result) {
+    scoped_ptr<base::DictionaryValue> baselines = ReadBaselines();
+    base::DictionaryValue* baseline = new base::DictionaryValue;
+    baseline->SetDouble(kInputDurationField, input_duration_);
+    baseline->SetDouble(kWallTimeField, result.wall_seconds);
+    baseline->SetDouble(kPeakRssField, result.peak_rss_kb);
+    baseline->SetDouble(kBytesPerSecondField, result.bytes_per_second);
+    baselines->Set(name, baseline);
+
+    std::string json;
+    base::JSONWriter::WriteWithOptions(
+        baselines.get(), base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+    scoped_ptr<File, FileCloser> file(
+        File::Open(GetBaselinesFile().c_str(), "w"));
+    ASSERT_TRUE(file);
+    ASSERT_EQ(static_cast<int64_t>(json.size()),
+              file->Write(json.data(), json.size()));
+  }
+
+  static base::FilePath input_directory_;
+  base::FilePath test_directory_;
+  std::string input_;
+  int64_t input_size_;
+  double input_duration_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackagerPerfTest);
+};
+
+base::FilePath PackagerPerfTest::input_directory_;
+
+TEST_P(PackagerPerfTest, Vod) {
+  Measure("vod",
+          base::Bind(&PackagerPerfTest::Package,
+                     base::Unretained(this),
+                     true,
+                     false));
+}
+
+TEST_P(PackagerPerfTest, Live) {
+  Measure("live",
+          base::Bind(&PackagerPerfTest::Package,
+                     base::Unretained(this),
+                     false,
+                     false));
+}
+
+TEST_P(PackagerPerfTest, Encrypted) {
+  Measure("encrypted",
+          base::Bind(&PackagerPerfTest::Package,
+                     base::Unretained(this),
+                     true,
+                     true));
+}
+
+TEST_P(PackagerPerfTest, KeyRotation) {
+  Measure("key_rotation",
+          base::Bind(&PackagerPerfTest::PackageWithKeyRotation,
+                     base::Unretained(this)));
+}
+
+INSTANTIATE_TEST_CASE_P(PackagerPerfE2ETest,
+                        PackagerPerfTest,
+                        ValuesIn(kMediaFiles));
+
+}  // namespace media
+}  // namespace edash_packager
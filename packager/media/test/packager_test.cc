@@ -4,18 +4,32 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <arpa/inet.h>
 #include <gtest/gtest.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <algorithm>
+
+#include "packager/base/bind.h"
 #include "packager/base/file_util.h"
+#include "packager/base/stl_util.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/cancellation_flag.h"
+#include "packager/base/threading/platform_thread.h"
 #include "packager/base/time/clock.h"
+#include "packager/media/base/closure_thread.h"
 #include "packager/media/base/demuxer.h"
+#include "packager/media/base/job_scheduler.h"
 #include "packager/media/base/key_source.h"
+#include "packager/media/base/live_ingest_reactor.h"
 #include "packager/media/base/media_stream.h"
 #include "packager/media/base/muxer.h"
 #include "packager/media/base/stream_info.h"
 #include "packager/media/base/test/status_test_util.h"
+#include "packager/media/file/file.h"
 #include "packager/media/formats/mp4/mp4_muxer.h"
 #include "packager/media/test/test_data_util.h"
 
@@ -75,6 +89,83 @@ MediaStream* FindFirstAudioStream(const std::vector<MediaStream*>& streams) {
   return FindFirstStreamOfType(streams, kStreamAudio);
 }
 
+// UDP input constants.
+const char kUdpInput[] = "bear-1280x720.ts";
+const size_t kDatagramSize = 7 * 188;
+const size_t kDatagramsPerBurst = 16;
+const int kBurstIntervalInMilliseconds = 1;
+
+// Sends |data| to |address| in datagrams, again and again until |stop| is
+// set.
+void SendUntilStopped(const std::vector<uint8_t>& data,
+                      const struct sockaddr_in& address,
+                      base::CancellationFlag* stop) {
+  const int send_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  CHECK_NE(-1, send_socket);
+  size_t num_datagrams = 0;
+  while (!stop->IsSet()) {
+    for (size_t offset = 0; offset < data.size() && !stop->IsSet();
+         offset += kDatagramSize) {
+      const size_t size = std::min(kDatagramSize, data.size() - offset);
+      sendto(send_socket, &data[offset], size, 0,
+             reinterpret_cast<const struct sockaddr*>(&address),
+             sizeof(address));
+      if (++num_datagrams % kDatagramsPerBurst == 0) {
+        base::PlatformThread::Sleep(
+            base::TimeDelta::FromMilliseconds(kBurstIntervalInMilliseconds));
+      }
+    }
+  }
+  close(send_socket);
+}
+
+// Finds a free UDP port on the loopback interface, by binding to port 0.
+void GetFreeLoopbackAddress(struct sockaddr_in* address) {
+  memset(address, 0, sizeof(*address));
+  address->sin_family = AF_INET;
+  address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const int probe_socket = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_NE(-1, probe_socket);
+  socklen_t address_length = sizeof(*address);
+  ASSERT_EQ(0, bind(probe_socket,
+                    reinterpret_cast<struct sockaddr*>(address),
+                    sizeof(*address)));
+  ASSERT_EQ(0, getsockname(probe_socket,
+                           reinterpret_cast<struct sockaddr*>(address),
+                           &address_length));
+  close(probe_socket);
+}
+
+std::string GetUdpUrl(const struct sockaddr_in& address) {
+  return std::string(kUdpFilePrefix) + "127.0.0.1:" +
+         base::UintToString(ntohs(address.sin_port));
+}
+
+void RunDemuxer(Demuxer* demuxer, Status* status) {
+  *status = demuxer->Run();
+}
+
+// Demuxes an input. Its streams may or may not be connected to muxers.
+class DemuxJob : public JobScheduler::Job {
+ public:
+  explicit DemuxJob(Demuxer* demuxer) : demuxer_(demuxer) {}
+  virtual ~DemuxJob() {}
+
+  virtual Status Run() OVERRIDE { return demuxer_->Run(); }
+  virtual void Cancel() OVERRIDE { demuxer_->Cancel(); }
+  virtual bool IsAsynchronous() OVERRIDE {
+    return demuxer_->SupportsRunAsync();
+  }
+  virtual void Start(const DoneCB& done_cb) OVERRIDE {
+    demuxer_->RunAsync(done_cb);
+  }
+
+ private:
+  Demuxer* demuxer_;
+
+  DISALLOW_COPY_AND_ASSIGN(DemuxJob);
+};
+
 }  // namespace
 
 class FakeClock : public base::Clock {
@@ -366,6 +457,165 @@ TEST_P(PackagerTest, MP4MuxerMultiSegmentsUnencryptedVideo) {
   EXPECT_TRUE(ContentsEqual(kOutputVideo, kOutputVideo2));
 }
 
+// A live input which goes silent must not keep the other inputs from
+// reporting their failure: the failure cancels the blocked read.
+TEST(PackagerCancelTest, SilentUdpInputAndFailingFileInput) {
+  struct sockaddr_in address;
+  ASSERT_NO_FATAL_FAILURE(GetFreeLoopbackAddress(&address));
+
+  // The UDP input is sent until the demuxer is initialized, then stops.
+  const std::vector<uint8_t> udp_data = ReadTestDataFile(kUdpInput);
+  ASSERT_FALSE(udp_data.empty());
+  base::CancellationFlag stop_sending;
+  ClosureThread sender_thread(
+      "UdpSender",
+      base::Bind(&SendUntilStopped, udp_data, address, &stop_sending));
+  Demuxer udp_demuxer(GetUdpUrl(address));
+  sender_thread.Start();
+  const Status udp_init_status = udp_demuxer.Initialize();
+  stop_sending.Set();
+  sender_thread.Join();
+  ASSERT_OK(udp_init_status);
+
+  // The file input fails as its output cannot be written.
+  Demuxer file_demuxer(GetTestDataFilePath(kMediaFiles[0]).value());
+  ASSERT_OK(file_demuxer.Initialize());
+  MuxerOptions options;
+  options.single_segment = false;
+  options.segment_duration = kSegmentDurationInSeconds;
+  options.fragment_duration = kFragmentDurationInSecodns;
+  options.output_file_name = "/nonexistent/directory/init.mp4";
+  options.segment_template = "/nonexistent/directory/$Number$.m4s";
+  mp4::MP4Muxer muxer(options);
+  muxer.AddStream(FindFirstVideoStream(file_demuxer.streams()));
+
+  DemuxJob udp_job(&udp_demuxer);
+  DemuxJob file_job(&file_demuxer);
+  const size_t kUnlimitedConcurrentJobs = 0;
+  JobScheduler scheduler(kUnlimitedConcurrentJobs);
+  scheduler.AddJob("udp", &udp_job);
+  scheduler.AddJob("file", &file_job);
+  const Status status = scheduler.Run();
+  EXPECT_FALSE(status.ok());
+  EXPECT_NE(error::CANCELLED, status.error_code());
+
+  ASSERT_EQ(2u, scheduler.job_stats().size());
+  EXPECT_EQ(error::CANCELLED,
+            scheduler.job_stats()[0].status.error_code());
+}
+
+#if defined(OS_LINUX)
+// A UDP input received through a LiveIngestReactor is parsed on the worker
+// threads of the reactor until it is cancelled.
+TEST(PackagerLiveIngestTest, UdpInputThroughReactor) {
+  struct sockaddr_in address;
+  ASSERT_NO_FATAL_FAILURE(GetFreeLoopbackAddress(&address));
+  const std::vector<uint8_t> udp_data = ReadTestDataFile(kUdpInput);
+  ASSERT_FALSE(udp_data.empty());
+  base::CancellationFlag stop_sending;
+  ClosureThread sender_thread(
+      "UdpSender",
+      base::Bind(&SendUntilStopped, udp_data, address, &stop_sending));
+
+  const size_t kNumReceiveThreads = 1;
+  const size_t kNumWorkerThreads = 2;
+  LiveIngestReactor reactor(kNumReceiveThreads, kNumWorkerThreads);
+  Demuxer demuxer(GetUdpUrl(address));
+  demuxer.SetLiveIngestReactor(&reactor);
+  sender_thread.Start();
+  const Status init_status = demuxer.Initialize();
+  Status run_status;
+  if (init_status.ok()) {
+    ClosureThread demuxer_thread(
+        "Demuxer", base::Bind(&RunDemuxer, &demuxer, &run_status));
+    demuxer_thread.Start();
+    const int kRunTimeInMilliseconds = 200;
+    base::PlatformThread::Sleep(
+        base::TimeDelta::FromMilliseconds(kRunTimeInMilliseconds));
+    demuxer.Cancel();
+    demuxer_thread.Join();
+  }
+  stop_sending.Set();
+  sender_thread.Join();
+
+  ASSERT_OK(init_status);
+  EXPECT_TRUE(FindFirstVideoStream(demuxer.streams()) != NULL);
+  EXPECT_TRUE(FindFirstAudioStream(demuxer.streams()) != NULL);
+  EXPECT_EQ(error::CANCELLED, run_status.error_code());
+}
+
+// Inputs received through a LiveIngestReactor do not hold scheduler threads,
+// so that a single thread is enough to run the failing file input, which
+// cancels them.
+TEST(PackagerLiveIngestTest, ReactorInputsDoNotUseSchedulerThreads) {
+  const size_t kNumUdpInputs = 2;
+  struct sockaddr_in addresses[kNumUdpInputs];
+  for (size_t i = 0; i < kNumUdpInputs; ++i)
+    ASSERT_NO_FATAL_FAILURE(GetFreeLoopbackAddress(&addresses[i]));
+  const std::vector<uint8_t> udp_data = ReadTestDataFile(kUdpInput);
+  ASSERT_FALSE(udp_data.empty());
+  const size_t kNumReceiveThreads = 1;
+  const size_t kNumWorkerThreads = 2;
+  LiveIngestReactor reactor(kNumReceiveThreads, kNumWorkerThreads);
+  base::CancellationFlag stop_sending;
+
+  std::vector<ClosureThread*> sender_threads;
+  STLElementDeleter<std::vector<ClosureThread*> > sender_threads_deleter(
+      &sender_threads);
+  std::vector<Demuxer*> udp_demuxers;
+  STLElementDeleter<std::vector<Demuxer*> > udp_demuxers_deleter(
+      &udp_demuxers);
+  for (size_t i = 0; i < kNumUdpInputs; ++i) {
+    udp_demuxers.push_back(new Demuxer(GetUdpUrl(addresses[i])));
+    udp_demuxers.back()->SetLiveIngestReactor(&reactor);
+    sender_threads.push_back(new ClosureThread(
+        "UdpSender",
+        base::Bind(&SendUntilStopped, udp_data, addresses[i], &stop_sending)));
+    sender_threads.back()->Start();
+  }
+  Status init_status;
+  for (size_t i = 0; i < kNumUdpInputs && init_status.ok(); ++i)
+    init_status = udp_demuxers[i]->Initialize();
+
+  // The file input fails as its output cannot be written.
+  Demuxer file_demuxer(GetTestDataFilePath(kMediaFiles[0]).value());
+  MuxerOptions options;
+  options.single_segment = false;
+  options.segment_duration = kSegmentDurationInSeconds;
+  options.fragment_duration = kFragmentDurationInSecodns;
+  options.output_file_name = "/nonexistent/directory/init.mp4";
+  options.segment_template = "/nonexistent/directory/$Number$.m4s";
+  mp4::MP4Muxer muxer(options);
+
+  Status status;
+  std::vector<JobScheduler::JobStats> job_stats;
+  if (init_status.ok() && (init_status = file_demuxer.Initialize()).ok()) {
+    muxer.AddStream(FindFirstVideoStream(file_demuxer.streams()));
+    std::vector<DemuxJob*> jobs;
+    STLElementDeleter<std::vector<DemuxJob*> > jobs_deleter(&jobs);
+    JobScheduler scheduler(1);
+    for (size_t i = 0; i < kNumUdpInputs; ++i) {
+      jobs.push_back(new DemuxJob(udp_demuxers[i]));
+      scheduler.AddJob("udp", jobs.back());
+    }
+    jobs.push_back(new DemuxJob(&file_demuxer));
+    scheduler.AddJob("file", jobs.back());
+    status = scheduler.Run();
+    job_stats = scheduler.job_stats();
+  }
+  stop_sending.Set();
+  for (size_t i = 0; i < sender_threads.size(); ++i)
+    sender_threads[i]->Join();
+
+  ASSERT_OK(init_status);
+  EXPECT_FALSE(status.ok());
+  EXPECT_NE(error::CANCELLED, status.error_code());
+  ASSERT_EQ(kNumUdpInputs + 1, job_stats.size());
+  for (size_t i = 0; i < kNumUdpInputs; ++i)
+    EXPECT_EQ(error::CANCELLED, job_stats[i].status.error_code());
+}
+#endif  // defined(OS_LINUX)
+
 INSTANTIATE_TEST_CASE_P(PackagerEndToEnd,
                         PackagerTestBasic,
                         ValuesIn(kMediaFiles));
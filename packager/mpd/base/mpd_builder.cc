@@ -6,11 +6,10 @@
 
 #include "packager/mpd/base/mpd_builder.h"
 
-#include <libxml/tree.h>
-#include <libxml/xmlstring.h>
-
 #include <cmath>
+#include <limits>
 #include <list>
+#include <set>
 #include <string>
 
 #include "packager/base/logging.h"
@@ -21,16 +20,21 @@
 #include "packager/media/file/file.h"
 #include "packager/mpd/base/content_protection_element.h"
 #include "packager/mpd/base/mpd_utils.h"
-#include "packager/mpd/base/xml/xml_node.h"
+#include "packager/mpd/base/xml/xml_writer.h"
 
 namespace edash_packager {
 
-using xml::XmlNode;
-using xml::RepresentationXmlNode;
-using xml::AdaptationSetXmlNode;
+using xml::XmlWriter;
 
 namespace {
 
+typedef MediaInfo::ContentProtectionXml ContentProtectionXml;
+typedef ContentProtectionXml::AttributeNameValuePair AttributeNameValuePair;
+
+// Representation elements are serialized separately and cached. They are
+// nested as MPD > Period > AdaptationSet > Representation.
+const int kRepresentationIndentLevel = 3;
+
 std::string GetMimeType(
     const std::string& prefix,
     MediaInfo::ContainerType container_type) {
@@ -51,7 +55,7 @@ std::string GetMimeType(
   return std::string();
 }
 
-void AddMpdNameSpaceInfo(XmlNode* mpd) {
+void AddMpdNameSpaceInfo(XmlWriter* mpd) {
   DCHECK(mpd);
 
   static const char kXmlNamespace[] = "urn:mpeg:DASH:schema:MPD:2011";
@@ -65,29 +69,6 @@ void AddMpdNameSpaceInfo(XmlNode* mpd) {
   mpd->SetStringAttribute("xsi:schemaLocation", kDashSchemaMpd2011);
 }
 
-bool IsPeriodNode(xmlNodePtr node) {
-  DCHECK(node);
-  int kEqual = 0;
-  return xmlStrcmp(node->name, reinterpret_cast<const xmlChar*>("Period")) ==
-         kEqual;
-}
-
-// Find the first <Period> element. This does not recurse down the tree,
-// only checks direct children. Returns the pointer to Period element on
-// success, otherwise returns false.
-// As noted here, we must traverse.
-// http://www.xmlsoft.org/tutorial/ar01s04.html
-xmlNodePtr FindPeriodNode(XmlNode* xml_node) {
-  for (xmlNodePtr node = xml_node->GetRawPtr()->xmlChildrenNode;
-       node != NULL;
-       node = node->next) {
-    if (IsPeriodNode(node))
-      return node;
-  }
-
-  return NULL;
-}
-
 bool Positive(double d) {
   return d > 0.0;
 }
@@ -108,7 +89,7 @@ std::string XmlDateTimeNowWithOffset(int32_t offset_seconds) {
                             time_exploded.second);
 }
 
-void SetIfPositive(const char* attr_name, double value, XmlNode* mpd) {
+void SetIfPositive(const char* attr_name, double value, XmlWriter* mpd) {
   if (Positive(value)) {
     mpd->SetStringAttribute(attr_name, SecondsToXmlDuration(value));
   }
@@ -158,27 +139,311 @@ int SearchTimedOutRepeatIndex(uint64_t timeshift_limit,
   return (timeshift_limit - segment_info.start_time) / segment_info.duration;
 }
 
-// Overload this function to support different types of |output|.
-// Note that this could be done by call MpdBuilder::ToString() and use the
-// result to write to a file, it requires an extra copy.
-bool WriteXmlCharArrayToOutput(xmlChar* doc,
-                               int doc_size,
-                               std::string* output) {
-  DCHECK(doc);
-  DCHECK(output);
-  output->assign(doc, doc + doc_size);
+std::string RangeToString(const Range& range) {
+  return base::Uint64ToString(range.begin()) + "-" +
+         base::Uint64ToString(range.end());
+}
+
+// The functions below serialize the child elements of AdaptationSet and
+// Representation.
+
+bool WriteAttributes(const google::protobuf::RepeatedPtrField<
+                         AttributeNameValuePair>& attributes,
+                     const std::string& element_name,
+                     XmlWriter* writer) {
+  DCHECK(writer);
+  for (int i = 0; i < attributes.size(); ++i) {
+    const AttributeNameValuePair& attribute = attributes.Get(i);
+    const std::string& name = attribute.name();
+    const std::string& value = attribute.value();
+
+    if (name.empty()) {
+      LOG(ERROR) << "For element " << element_name
+                 << ", no name specified for attribute with value: " << value;
+      return false;
+    }
+
+    writer->SetStringAttribute(name.c_str(), value);
+  }
+
   return true;
 }
 
-bool WriteXmlCharArrayToOutput(xmlChar* doc,
-                               int doc_size,
-                               media::File* output) {
-  DCHECK(doc);
-  DCHECK(output);
-  if (output->Write(doc, doc_size) < doc_size)
-    return false;
+// This function is recursive. Note that elements.size() == 0 is a terminating
+// condition.
+bool WriteSubelements(const google::protobuf::RepeatedPtrField<
+                          ContentProtectionXml::Element>& elements,
+                      const std::string& element_name,
+                      XmlWriter* writer) {
+  DCHECK(writer);
+  for (int i = 0; i < elements.size(); ++i) {
+    const ContentProtectionXml::Element& subelement = elements.Get(i);
+    const std::string& subelement_name = subelement.name();
+    if (subelement_name.empty()) {
+      LOG(ERROR) << "Subelement name was not specified for node "
+                 << element_name;
+      return false;
+    }
+
+    writer->StartElement(subelement_name);
+    if (!WriteAttributes(subelement.attributes(), subelement_name, writer)) {
+      LOG(ERROR) << "Failed to set attributes for " << subelement_name;
+      return false;
+    }
 
-  return output->Flush();
+    if (!WriteSubelements(subelement.subelements(), subelement_name, writer)) {
+      LOG(ERROR) << "Failed to add subelements to " << subelement_name;
+      return false;
+    }
+    writer->EndElement();
+  }
+
+  return true;
+}
+
+void WriteContentProtectionElements(
+    const std::list<ContentProtectionElement>& content_protection_elements,
+    XmlWriter* writer) {
+  std::list<ContentProtectionElement>::const_iterator content_protection_it =
+      content_protection_elements.begin();
+  for (; content_protection_it != content_protection_elements.end();
+       ++content_protection_it) {
+    writer->StartElement("ContentProtection");
+    writer->SetStringAttribute("value", content_protection_it->value);
+    writer->SetStringAttribute("schemeIdUri",
+                               content_protection_it->scheme_id_uri);
+
+    typedef std::map<std::string, std::string> AttributesMapType;
+    const AttributesMapType& additional_attributes =
+        content_protection_it->additional_attributes;
+
+    AttributesMapType::const_iterator attributes_it =
+        additional_attributes.begin();
+    for (; attributes_it != additional_attributes.end(); ++attributes_it) {
+      writer->SetStringAttribute(attributes_it->first.c_str(),
+                                 attributes_it->second);
+    }
+
+    writer->SetContent(content_protection_it->subelements);
+    writer->EndElement();
+  }
+}
+
+// content_protection_xml.scheme_id_uri and content_protection_xml.value takes
+// precedence over attributes in content_protection_xml.attributes.
+bool WriteContentProtectionElementsFromMediaInfo(const MediaInfo& media_info,
+                                                 XmlWriter* writer) {
+  for (int i = 0; i < media_info.content_protections().size(); ++i) {
+    const ContentProtectionXml& content_protection_xml =
+        media_info.content_protections(i);
+    std::string scheme_id_uri;
+    if (!GetSchemeIdAttribute(content_protection_xml, &scheme_id_uri)) {
+      LOG(ERROR) << "ContentProtection element requires schemeIdUri.";
+      return false;
+    }
+
+    writer->StartElement("ContentProtection");
+    if (!WriteAttributes(content_protection_xml.attributes(),
+                         "ContentProtection",
+                         writer)) {
+      LOG(ERROR) << "Failed to set attributes for ContentProtection.";
+      return false;
+    }
+
+    writer->SetStringAttribute("schemeIdUri", scheme_id_uri);
+    if (content_protection_xml.has_value()) {
+      // Note that |value| is an optional field.
+      writer->SetStringAttribute("value", content_protection_xml.value());
+    }
+
+    if (!WriteSubelements(content_protection_xml.subelements(),
+                          "ContentProtection",
+                          writer)) {
+      LOG(ERROR) << "Failed to add sublements to ContentProtection.";
+      return false;
+    }
+    writer->EndElement();
+  }
+
+  return true;
+}
+
+bool WriteVideoInfo(
+    const google::protobuf::RepeatedPtrField<MediaInfo_VideoInfo>&
+        repeated_video_info,
+    XmlWriter* writer) {
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  // Make sure that all the widths and heights match.
+  for (int i = 0; i < repeated_video_info.size(); ++i) {
+    const MediaInfo_VideoInfo& video_info = repeated_video_info.Get(i);
+    if (video_info.width() <= 0 || video_info.height() <= 0)
+      return false;
+
+    if (width == 0) {
+      width = video_info.width();
+    } else if (width != video_info.width()) {
+      return false;
+    }
+
+    if (height == 0) {
+      height = video_info.height();
+    } else if (height != video_info.height()) {
+      return false;
+    }
+  }
+
+  if (width != 0)
+    writer->SetIntegerAttribute("width", width);
+
+  if (height != 0)
+    writer->SetIntegerAttribute("height", height);
+
+  return true;
+}
+
+// MPD expects one number for sampling frequency, or if it is a range it should
+// be space separated.
+void WriteAudioSamplingRateInfo(
+    const google::protobuf::RepeatedPtrField<MediaInfo_AudioInfo>&
+        repeated_audio_info,
+    XmlWriter* writer) {
+  bool has_sampling_frequency = false;
+  uint32_t min_sampling_frequency = std::numeric_limits<uint32_t>::max();
+  uint32_t max_sampling_frequency = 0;
+
+  for (int i = 0; i < repeated_audio_info.size(); ++i) {
+    const MediaInfo_AudioInfo& audio_info = repeated_audio_info.Get(i);
+    if (audio_info.has_sampling_frequency()) {
+      has_sampling_frequency = true;
+      const uint32_t sampling_frequency = audio_info.sampling_frequency();
+      if (sampling_frequency < min_sampling_frequency)
+        min_sampling_frequency = sampling_frequency;
+
+      if (sampling_frequency > max_sampling_frequency)
+        max_sampling_frequency = sampling_frequency;
+    }
+  }
+
+  if (has_sampling_frequency) {
+    if (min_sampling_frequency == max_sampling_frequency) {
+      writer->SetIntegerAttribute("audioSamplingRate", min_sampling_frequency);
+    } else {
+      std::string sample_rate_string =
+          base::UintToString(min_sampling_frequency) + " " +
+          base::UintToString(max_sampling_frequency);
+      writer->SetStringAttribute("audioSamplingRate", sample_rate_string);
+    }
+  }
+}
+
+// Find all the unique number-of-channels in |repeated_audio_info|, and make
+// AudioChannelConfiguration for each number-of-channels.
+void WriteAudioChannelInfo(
+    const google::protobuf::RepeatedPtrField<MediaInfo_AudioInfo>&
+        repeated_audio_info,
+    XmlWriter* writer) {
+  std::set<uint32_t> num_channels;
+  for (int i = 0; i < repeated_audio_info.size(); ++i) {
+    if (repeated_audio_info.Get(i).has_num_channels())
+      num_channels.insert(repeated_audio_info.Get(i).num_channels());
+  }
+
+  std::set<uint32_t>::const_iterator num_channels_it = num_channels.begin();
+  for (; num_channels_it != num_channels.end(); ++num_channels_it) {
+    const char kAudioChannelConfigScheme[] =
+        "urn:mpeg:dash:23003:3:audio_channel_configuration:2011";
+    writer->StartElement("AudioChannelConfiguration");
+    writer->SetStringAttribute("schemeIdUri", kAudioChannelConfigScheme);
+    writer->SetIntegerAttribute("value", *num_channels_it);
+    writer->EndElement();
+  }
+}
+
+void WriteVODOnlyInfo(const MediaInfo& media_info, XmlWriter* writer) {
+  if (media_info.has_media_file_name()) {
+    writer->StartElement("BaseURL");
+    writer->SetContent(media_info.media_file_name());
+    writer->EndElement();
+  }
+
+  const bool need_segment_base = media_info.has_index_range() ||
+                                 media_info.has_init_range() ||
+                                 media_info.has_reference_time_scale();
+
+  if (need_segment_base) {
+    writer->StartElement("SegmentBase");
+    if (media_info.has_index_range()) {
+      writer->SetStringAttribute("indexRange",
+                                 RangeToString(media_info.index_range()));
+    }
+
+    if (media_info.has_reference_time_scale()) {
+      writer->SetIntegerAttribute("timescale",
+                                  media_info.reference_time_scale());
+    }
+
+    if (media_info.has_init_range()) {
+      writer->StartElement("Initialization");
+      writer->SetStringAttribute("range",
+                                 RangeToString(media_info.init_range()));
+      writer->EndElement();
+    }
+    writer->EndElement();
+  }
+}
+
+bool WriteLiveOnlyInfo(const MediaInfo& media_info,
+                       const std::list<SegmentInfo>& segment_infos,
+                       uint32_t start_number,
+                       XmlWriter* writer) {
+  // The spec does not allow '$Number$' and '$Time$' in initialization
+  // attribute.
+  if (media_info.has_init_segment_name()) {
+    const std::string& init_segment_name = media_info.init_segment_name();
+    if (init_segment_name.find("$Number$") != std::string::npos ||
+        init_segment_name.find("$Time$") != std::string::npos) {
+      LOG(ERROR) << "$Number$ and $Time$ cannot be used for "
+                    "SegmentTemplate@initialization";
+      return false;
+    }
+  }
+
+  writer->StartElement("SegmentTemplate");
+  if (media_info.has_reference_time_scale()) {
+    writer->SetIntegerAttribute("timescale",
+                                media_info.reference_time_scale());
+  }
+
+  if (media_info.has_init_segment_name()) {
+    writer->SetStringAttribute("initialization",
+                               media_info.init_segment_name());
+  }
+
+  if (media_info.has_segment_template()) {
+    writer->SetStringAttribute("media", media_info.segment_template());
+
+    if (media_info.segment_template().find("$Number") != std::string::npos) {
+      DCHECK_GE(start_number, 1u);
+      writer->SetIntegerAttribute("startNumber", start_number);
+    }
+  }
+
+  writer->StartElement("SegmentTimeline");
+  for (std::list<SegmentInfo>::const_iterator it = segment_infos.begin();
+       it != segment_infos.end();
+       ++it) {
+    writer->StartElement("S");
+    writer->SetIntegerAttribute("t", it->start_time);
+    writer->SetIntegerAttribute("d", it->duration);
+    if (it->repeat > 0)
+      writer->SetIntegerAttribute("r", it->repeat);
+    writer->EndElement();
+  }
+  writer->EndElement();
+  writer->EndElement();
+  return true;
 }
 
 }  // namespace
@@ -189,7 +454,8 @@ MpdOptions::MpdOptions()
       // TODO(tinskip): Set min_buffer_time in unit tests rather than here.
       min_buffer_time(2.0),
       time_shift_buffer_depth(0),
-      suggested_presentation_delay(0) {}
+      suggested_presentation_delay(0),
+      mpd_write_interval(0) {}
 
 MpdOptions::~MpdOptions() {}
 
@@ -218,70 +484,34 @@ AdaptationSet* MpdBuilder::AddAdaptationSet() {
 bool MpdBuilder::WriteMpdToFile(media::File* output_file) {
   base::AutoLock scoped_lock(lock_);
   DCHECK(output_file);
-  return WriteMpdToOutput(output_file);
+  std::string mpd;
+  if (!WriteMpd(&mpd))
+    return false;
+
+  const int64_t mpd_size = mpd.size();
+  if (output_file->Write(mpd.data(), mpd.size()) < mpd_size)
+    return false;
+
+  return output_file->Flush();
 }
 
 bool MpdBuilder::ToString(std::string* output) {
   base::AutoLock scoped_lock(lock_);
   DCHECK(output);
-  return WriteMpdToOutput(output);
-}
-
-template <typename OutputType>
-bool MpdBuilder::WriteMpdToOutput(OutputType* output) {
-  xmlInitParser();
-  xml::ScopedXmlPtr<xmlDoc>::type doc(GenerateMpd());
-  if (!doc.get())
+  std::string mpd;
+  if (!WriteMpd(&mpd))
     return false;
 
-  static const int kNiceFormat = 1;
-  int doc_str_size = 0;
-  xmlChar* doc_str = NULL;
-  xmlDocDumpFormatMemoryEnc(
-      doc.get(), &doc_str, &doc_str_size, "UTF-8", kNiceFormat);
-
-  bool result = WriteXmlCharArrayToOutput(doc_str, doc_str_size, output);
-  xmlFree(doc_str);
-
-  // Cleanup, free the doc then cleanup parser.
-  doc.reset();
-  xmlCleanupParser();
-  return result;
+  output->swap(mpd);
+  return true;
 }
 
-xmlDocPtr MpdBuilder::GenerateMpd() {
-  // Setup nodes.
-  static const char kXmlVersion[] = "1.0";
-  xml::ScopedXmlPtr<xmlDoc>::type doc(xmlNewDoc(BAD_CAST kXmlVersion));
-  XmlNode mpd("MPD");
-
-  // Iterate thru AdaptationSets and add them to one big Period element.
-  XmlNode period("Period");
-  std::list<AdaptationSet*>::iterator adaptation_sets_it =
-      adaptation_sets_.begin();
-  for (; adaptation_sets_it != adaptation_sets_.end(); ++adaptation_sets_it) {
-    xml::ScopedXmlPtr<xmlNode>::type child((*adaptation_sets_it)->GetXml());
-    if (!child.get() || !period.AddChild(child.Pass()))
-      return NULL;
-  }
-
-  // Add baseurls to MPD.
-  std::list<std::string>::const_iterator base_urls_it = base_urls_.begin();
-  for (; base_urls_it != base_urls_.end(); ++base_urls_it) {
-    XmlNode base_url("BaseURL");
-    base_url.SetContent(*base_urls_it);
-
-    if (!mpd.AddChild(base_url.PassScopedPtr()))
-      return NULL;
-  }
-
-  if (type_ == kDynamic) {
-    // This is the only Period and it is a regular period.
-    period.SetStringAttribute("start", "PT0S");
-  }
-
-  if (!mpd.AddChild(period.PassScopedPtr()))
-    return NULL;
+// The MPD is serialized directly with XmlWriter, without building a libxml2
+// document.
+bool MpdBuilder::WriteMpd(std::string* output) {
+  XmlWriter mpd(0, output);
+  mpd.WriteXmlDeclaration();
+  mpd.StartElement("MPD");
 
   AddMpdNameSpaceInfo(&mpd);
   AddCommonMpdInfo(&mpd);
@@ -297,12 +527,34 @@ xmlDocPtr MpdBuilder::GenerateMpd() {
       break;
   }
 
-  DCHECK(doc);
-  xmlDocSetRootElement(doc.get(), mpd.Release());
-  return doc.release();
+  // Add baseurls to MPD.
+  std::list<std::string>::const_iterator base_urls_it = base_urls_.begin();
+  for (; base_urls_it != base_urls_.end(); ++base_urls_it) {
+    mpd.StartElement("BaseURL");
+    mpd.SetContent(*base_urls_it);
+    mpd.EndElement();
+  }
+
+  // Iterate thru AdaptationSets and add them to one big Period element.
+  mpd.StartElement("Period");
+  if (type_ == kDynamic) {
+    // This is the only Period and it is a regular period.
+    mpd.SetStringAttribute("start", "PT0S");
+  }
+
+  std::list<AdaptationSet*>::iterator adaptation_sets_it =
+      adaptation_sets_.begin();
+  for (; adaptation_sets_it != adaptation_sets_.end(); ++adaptation_sets_it) {
+    if (!(*adaptation_sets_it)->WriteXml(type_, &mpd))
+      return false;
+  }
+
+  mpd.EndElement();
+  mpd.EndElement();
+  return true;
 }
 
-void MpdBuilder::AddCommonMpdInfo(XmlNode* mpd_node) {
+void MpdBuilder::AddCommonMpdInfo(XmlWriter* mpd_node) {
   if (Positive(mpd_options_.min_buffer_time)) {
     mpd_node->SetStringAttribute(
         "minBufferTime",
@@ -313,7 +565,7 @@ void MpdBuilder::AddCommonMpdInfo(XmlNode* mpd_node) {
   }
 }
 
-void MpdBuilder::AddStaticMpdInfo(XmlNode* mpd_node) {
+void MpdBuilder::AddStaticMpdInfo(XmlWriter* mpd_node) {
   DCHECK(mpd_node);
   DCHECK_EQ(MpdBuilder::kStatic, type_);
 
@@ -324,10 +576,10 @@ void MpdBuilder::AddStaticMpdInfo(XmlNode* mpd_node) {
   mpd_node->SetStringAttribute("profiles", kStaticMpdProfile);
   mpd_node->SetStringAttribute(
       "mediaPresentationDuration",
-      SecondsToXmlDuration(GetStaticMpdDuration(mpd_node)));
+      SecondsToXmlDuration(GetStaticMpdDuration()));
 }
 
-void MpdBuilder::AddDynamicMpdInfo(XmlNode* mpd_node) {
+void MpdBuilder::AddDynamicMpdInfo(XmlWriter* mpd_node) {
   DCHECK(mpd_node);
   DCHECK_EQ(MpdBuilder::kDynamic, type_);
 
@@ -370,33 +622,19 @@ void MpdBuilder::AddDynamicMpdInfo(XmlNode* mpd_node) {
                 mpd_node);
 }
 
-float MpdBuilder::GetStaticMpdDuration(XmlNode* mpd_node) {
-  DCHECK(mpd_node);
+float MpdBuilder::GetStaticMpdDuration() {
   DCHECK_EQ(MpdBuilder::kStatic, type_);
 
-  xmlNodePtr period_node = FindPeriodNode(mpd_node);
-  DCHECK(period_node) << "Period element must be a child of mpd_node.";
-  DCHECK(IsPeriodNode(period_node));
-
   // Attribute mediaPresentationDuration must be present for 'static' MPD. So
-  // setting "PT0S" is required even if none of the representaions have duration
-  // attribute.
+  // setting "PT0S" is required even if none of the representaions have
+  // duration.
   float max_duration = 0.0f;
-  for (xmlNodePtr adaptation_set = xmlFirstElementChild(period_node);
-       adaptation_set;
-       adaptation_set = xmlNextElementSibling(adaptation_set)) {
-    for (xmlNodePtr representation = xmlFirstElementChild(adaptation_set);
-         representation;
-         representation = xmlNextElementSibling(representation)) {
-      float duration = 0.0f;
-      if (GetDurationAttribute(representation, &duration)) {
-        max_duration = max_duration > duration ? max_duration : duration;
-
-        // 'duration' attribute is there only to help generate MPD, not
-        // necessary for MPD, remove the attribute.
-        xmlUnsetProp(representation, BAD_CAST "duration");
-      }
-    }
+  for (std::list<AdaptationSet*>::const_iterator iter =
+           adaptation_sets_.begin();
+       iter != adaptation_sets_.end();
+       ++iter) {
+    const float duration = (*iter)->GetMediaDurationSeconds();
+    max_duration = max_duration > duration ? max_duration : duration;
   }
 
   return max_duration;
@@ -454,28 +692,37 @@ void AdaptationSet::AddContentProtectionElement(
   RemoveDuplicateAttributes(&content_protection_elements_.back());
 }
 
-// Creates a copy of <AdaptationSet> xml element, iterate thru all the
-// <Representation> (child) elements and add them to the copy.
-xml::ScopedXmlPtr<xmlNode>::type AdaptationSet::GetXml() {
+bool AdaptationSet::WriteXml(MpdBuilder::MpdType mpd_type,
+                             XmlWriter* writer) {
+  DCHECK(writer);
   base::AutoLock scoped_lock(lock_);
-  AdaptationSetXmlNode adaptation_set;
-
-  if (!adaptation_set.AddContentProtectionElements(
-           content_protection_elements_)) {
-    return xml::ScopedXmlPtr<xmlNode>::type();
-  }
+  writer->StartElement("AdaptationSet");
+  writer->SetId(id_);
+  WriteContentProtectionElements(content_protection_elements_, writer);
 
   std::list<Representation*>::iterator representation_it =
       representations_.begin();
-
   for (; representation_it != representations_.end(); ++representation_it) {
-    xml::ScopedXmlPtr<xmlNode>::type child((*representation_it)->GetXml());
-    if (!child.get() || !adaptation_set.AddChild(child.Pass()))
-      return xml::ScopedXmlPtr<xmlNode>::type();
+    if (!(*representation_it)->WriteXml(mpd_type, writer))
+      return false;
   }
 
-  adaptation_set.SetId(id_);
-  return adaptation_set.PassScopedPtr();
+  writer->EndElement();
+  return true;
+}
+
+float AdaptationSet::GetMediaDurationSeconds() {
+  base::AutoLock scoped_lock(lock_);
+  float max_duration = 0.0f;
+  for (std::list<Representation*>::const_iterator iter =
+           representations_.begin();
+       iter != representations_.end();
+       ++iter) {
+    float duration = 0.0f;
+    if ((*iter)->GetMediaDurationSeconds(&duration))
+      max_duration = max_duration > duration ? max_duration : duration;
+  }
+  return max_duration;
 }
 
 bool AdaptationSet::GetEarliestTimestamp(double* timestamp_seconds) {
@@ -507,7 +754,9 @@ Representation::Representation(const MediaInfo& media_info,
       id_(id),
       bandwidth_estimator_(BandwidthEstimator::kUseAllBlocks),
       mpd_options_(mpd_options),
-      start_number_(1) {
+      start_number_(1),
+      xml_cache_valid_(false),
+      xml_cache_mpd_type_(MpdBuilder::kStatic) {
 }
 
 Representation::~Representation() {}
@@ -551,6 +800,7 @@ void Representation::AddContentProtectionElement(
   base::AutoLock scoped_lock(lock_);
   content_protection_elements_.push_back(content_protection_element);
   RemoveDuplicateAttributes(&content_protection_elements_.back());
+  xml_cache_valid_ = false;
 }
 
 void Representation::AddNewSegment(uint64_t start_time,
@@ -574,20 +824,40 @@ void Representation::AddNewSegment(uint64_t start_time,
 
   SlideWindow();
   DCHECK_GE(segment_infos_.size(), 1u);
+  xml_cache_valid_ = false;
 }
 
-// Uses info in |media_info_| and |content_protection_elements_| to create a
-// "Representation" node.
-// MPD schema has strict ordering. The following must be done in order.
-// AddVideoInfo() (possibly adds FramePacking elements), AddAudioInfo() (Adds
-// AudioChannelConfig elements), AddContentProtectionElements*(), and
-// AddVODOnlyInfo() (Adds segment info).
-xml::ScopedXmlPtr<xmlNode>::type Representation::GetXml() {
+bool Representation::WriteXml(MpdBuilder::MpdType mpd_type,
+                              XmlWriter* writer) {
+  DCHECK(writer);
   base::AutoLock scoped_lock(lock_);
+  if (!xml_cache_valid_ || xml_cache_mpd_type_ != mpd_type) {
+    std::string xml;
+    if (!SerializeXml(mpd_type, &xml))
+      return false;
+    xml_cache_.swap(xml);
+    xml_cache_valid_ = true;
+    xml_cache_mpd_type_ = mpd_type;
+  }
+
+  writer->AddSerializedElement(xml_cache_);
+  return true;
+}
+
+// Uses info in |media_info_| and |content_protection_elements_| to serialize
+// the Representation element.
+// MPD schema has strict ordering. The child elements are written in order:
+// AudioChannelConfiguration, ContentProtection, then the segment info.
+// 'duration' is only kept for 'dynamic' MPDs. For 'static' MPDs, it is used
+// for mediaPresentationDuration instead, see
+// MpdBuilder::GetStaticMpdDuration().
+bool Representation::SerializeXml(MpdBuilder::MpdType mpd_type,
+                                  std::string* output) {
+  lock_.AssertAcquired();
 
   if (!HasRequiredMediaInfoFields()) {
     LOG(ERROR) << "MediaInfo missing required fields.";
-    return xml::ScopedXmlPtr<xmlNode>::type();
+    return false;
   }
 
   const uint64_t bandwidth = media_info_.has_bandwidth()
@@ -596,7 +866,8 @@ xml::ScopedXmlPtr<xmlNode>::type Representation::GetXml() {
 
   DCHECK(!(HasVODOnlyFields(media_info_) && HasLiveOnlyFields(media_info_)));
 
-  RepresentationXmlNode representation;
+  XmlWriter representation(kRepresentationIndentLevel, output);
+  representation.StartElement("Representation");
   // Mandatory fields for Representation.
   representation.SetId(id_);
   representation.SetIntegerAttribute("bandwidth", bandwidth);
@@ -607,40 +878,56 @@ xml::ScopedXmlPtr<xmlNode>::type Representation::GetXml() {
   const bool has_audio_info = media_info_.audio_info_size() > 0;
 
   if (has_video_info &&
-      !representation.AddVideoInfo(media_info_.video_info())) {
+      !WriteVideoInfo(media_info_.video_info(), &representation)) {
     LOG(ERROR) << "Failed to add video info to Representation XML.";
-    return xml::ScopedXmlPtr<xmlNode>::type();
+    return false;
   }
 
-  if (has_audio_info &&
-      !representation.AddAudioInfo(media_info_.audio_info())) {
-    LOG(ERROR) << "Failed to add audio info to Representation XML.";
-    return xml::ScopedXmlPtr<xmlNode>::type();
-  }
+  if (has_audio_info)
+    WriteAudioSamplingRateInfo(media_info_.audio_info(), &representation);
 
-  if (!representation.AddContentProtectionElements(
-           content_protection_elements_)) {
-    return xml::ScopedXmlPtr<xmlNode>::type();
+  const bool has_vod_only_fields = HasVODOnlyFields(media_info_);
+  if (has_vod_only_fields && media_info_.has_media_duration_seconds() &&
+      mpd_type == MpdBuilder::kDynamic) {
+    representation.SetFloatingPointAttribute(
+        "duration", media_info_.media_duration_seconds());
   }
-  if (!representation.AddContentProtectionElementsFromMediaInfo(media_info_))
-    return xml::ScopedXmlPtr<xmlNode>::type();
 
-  if (HasVODOnlyFields(media_info_) &&
-      !representation.AddVODOnlyInfo(media_info_)) {
-    LOG(ERROR) << "Failed to add VOD segment info.";
-    return xml::ScopedXmlPtr<xmlNode>::type();
+  // Attributes are all set. Add the child elements in the order required by
+  // the MPD schema.
+  if (has_audio_info)
+    WriteAudioChannelInfo(media_info_.audio_info(), &representation);
+
+  WriteContentProtectionElements(content_protection_elements_,
+                                 &representation);
+  if (!WriteContentProtectionElementsFromMediaInfo(media_info_,
+                                                   &representation)) {
+    return false;
   }
 
+  if (has_vod_only_fields)
+    WriteVODOnlyInfo(media_info_, &representation);
+
   if (HasLiveOnlyFields(media_info_) &&
-      !representation.AddLiveOnlyInfo(
-          media_info_, segment_infos_, start_number_)) {
+      !WriteLiveOnlyInfo(
+          media_info_, segment_infos_, start_number_, &representation)) {
     LOG(ERROR) << "Failed to add Live info.";
-    return xml::ScopedXmlPtr<xmlNode>::type();
+    return false;
   }
-  // TODO(rkuroiwa): It is likely that all representations have the exact same
-  // SegmentTemplate. Optimize and propagate the tag up to AdaptationSet level.
 
-  return representation.PassScopedPtr();
+  representation.EndElement();
+  return true;
+}
+
+bool Representation::GetMediaDurationSeconds(float* duration_seconds) {
+  DCHECK(duration_seconds);
+  if (!HasVODOnlyFields(media_info_) ||
+      !media_info_.has_media_duration_seconds()) {
+    return false;
+  }
+
+  *duration_seconds = static_cast<float>(media_info_.media_duration_seconds());
+  return true;
 }
 
 bool Representation::HasRequiredMediaInfoFields() {
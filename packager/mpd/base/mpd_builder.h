@@ -24,7 +24,6 @@
 #include "packager/mpd/base/media_info.pb.h"
 #include "packager/mpd/base/mpd_utils.h"
 #include "packager/mpd/base/segment_info.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 // TODO(rkuroiwa): For classes with |id_|, consider removing the field and let
 // the MPD (XML) generation functions take care of assigning an ID to each
@@ -40,8 +39,7 @@ class Representation;
 
 namespace xml {
 
-class XmlNode;
-class RepresentationXmlNode;
+class XmlWriter;
 
 }  // namespace xml
 
@@ -54,6 +52,10 @@ struct MpdOptions {
   double min_buffer_time;
   double time_shift_buffer_depth;
   double suggested_presentation_delay;
+  /// Minimum interval, in seconds, between two writes of the MPD by
+  /// SimpleMpdNotifier. If positive, updates are coalesced and written in the
+  /// background; otherwise the MPD is written on every update.
+  double mpd_write_interval;
 };
 
 /// This class generates DASH MPDs (Media Presentation Descriptions).
@@ -100,31 +102,22 @@ class MpdBuilder {
   bool ToStringImpl(std::string* output);
 
   // This is a helper method for writing out MPDs, called from WriteMpdToFile()
-  // and ToString().
-  template <typename OutputType>
-  bool WriteMpdToOutput(OutputType* output);
-
-  // Returns the document pointer to the MPD. This must be freed by the caller
-  // using appropriate xmlDocPtr freeing function.
-  // On failure, this returns NULL.
-  xmlDocPtr GenerateMpd();
+  // and ToString(). Appends the MPD to |output|.
+  // On failure, this returns false.
+  bool WriteMpd(std::string* output);
 
   // Set MPD attributes common to all profiles. Uses non-zero |mpd_options_| to
   // set attributes for the MPD.
-  void AddCommonMpdInfo(xml::XmlNode* mpd_node);
+  void AddCommonMpdInfo(xml::XmlWriter* mpd_node);
 
-  // Adds 'static' MPD attributes and elements to |mpd_node|. This assumes that
-  // the first child element is a Period element.
-  void AddStaticMpdInfo(xml::XmlNode* mpd_node);
+  // Adds 'static' MPD attributes to |mpd_node|.
+  void AddStaticMpdInfo(xml::XmlWriter* mpd_node);
 
   // Same as AddStaticMpdInfo() but for 'dynamic' MPDs.
-  void AddDynamicMpdInfo(xml::XmlNode* mpd_node);
-
-  float GetStaticMpdDuration(xml::XmlNode* mpd_node);
+  void AddDynamicMpdInfo(xml::XmlWriter* mpd_node);
 
-  // Set MPD attributes for dynamic profile MPD. Uses non-zero |mpd_options_| as
-  // well as various calculations to set attributes for the MPD.
-  void SetDynamicMpdAttributes(xml::XmlNode* mpd_node);
+  // Returns the longest media duration of the Representations, in seconds.
+  float GetStaticMpdDuration();
 
   // Gets the earliest, normalized segment timestamp. Returns true if
   // successful, false otherwise.
@@ -165,12 +158,6 @@ class AdaptationSet {
   ///        then the former is used.
   void AddContentProtectionElement(const ContentProtectionElement& element);
 
-  /// Makes a copy of AdaptationSet xml element with its child Representation
-  /// and ContentProtection elements.
-  /// @return On success returns a non-NULL ScopedXmlPtr. Otherwise returns a
-  ///         NULL ScopedXmlPtr.
-  xml::ScopedXmlPtr<xmlNode>::type GetXml();
-
   // Must be unique in the Period.
   uint32_t id() const { return id_; }
 
@@ -185,6 +172,14 @@ class AdaptationSet {
                 const MpdOptions& mpd_options_,
                 base::AtomicSequenceNumber* representation_counter);
 
+  // Serializes the AdaptationSet element with its child Representation and
+  // ContentProtection elements to |writer|. Returns false on failure.
+  bool WriteXml(MpdBuilder::MpdType mpd_type, xml::XmlWriter* writer);
+
+  // Returns the longest media duration of the Representations, in seconds, or
+  // 0 if none of them has a media duration.
+  float GetMediaDurationSeconds();
+
   // Gets the earliest, normalized segment timestamp. Returns true if
   // successful, false otherwise.
   bool GetEarliestTimestamp(double* timestamp_seconds);
@@ -229,9 +224,6 @@ class Representation {
   /// @param size of the segment in bytes.
   void AddNewSegment(uint64_t start_time, uint64_t duration, uint64_t size);
 
-  /// @return Copy of <Representation>.
-  xml::ScopedXmlPtr<xmlNode>::type GetXml();
-
   /// @return ID number for <Representation>.
   uint32_t id() const { return id_; }
 
@@ -248,7 +240,17 @@ class Representation {
                  const MpdOptions& mpd_options,
                  uint32_t representation_id);
 
-  bool AddLiveInfo(xml::RepresentationXmlNode* representation);
+  // Adds the Representation element to |writer|. The serialized element is
+  // cached, and only regenerated when the Representation changes.
+  // Returns false on failure.
+  bool WriteXml(MpdBuilder::MpdType mpd_type, xml::XmlWriter* writer);
+
+  // Serializes the Representation element to |output|. |lock_| must be held.
+  bool SerializeXml(MpdBuilder::MpdType mpd_type, std::string* output);
+
+  // Gets the media duration of a VOD Representation. Returns true if
+  // |media_info_| has it, false otherwise.
+  bool GetMediaDurationSeconds(float* duration_seconds);
 
   // Returns true if |media_info_| has required fields to generate a valid
   // Representation. Otherwise returns false.
@@ -290,6 +292,12 @@ class Representation {
   // Starts from 1.
   uint32_t start_number_;
 
+  // Cached serialized Representation element, valid if |xml_cache_valid_| is
+  // true and it was serialized for |xml_cache_mpd_type_|.
+  std::string xml_cache_;
+  bool xml_cache_valid_;
+  MpdBuilder::MpdType xml_cache_mpd_type_;
+
   DISALLOW_COPY_AND_ASSIGN(Representation);
 };
 
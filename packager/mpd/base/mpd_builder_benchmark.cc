@@ -0,0 +1,75 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/test/benchmark_util.h"
+#include "packager/mpd/base/mpd_builder.h"
+
+namespace edash_packager {
+
+namespace {
+
+const uint32_t kTimeScale = 1000;
+const uint64_t kSegmentDuration = 2000;
+const uint64_t kSegmentSize = 500000;
+// About three hours of two second segments.
+const size_t kNumSegments = 5000;
+
+MediaInfo GetVideoMediaInfo() {
+  MediaInfo media_info;
+  MediaInfo::VideoInfo* video_info = media_info.add_video_info();
+  video_info->set_codec("avc1.010101");
+  video_info->set_width(1280);
+  video_info->set_height(720);
+  video_info->set_time_scale(kTimeScale);
+  media_info.set_reference_time_scale(kTimeScale);
+  media_info.set_container_type(MediaInfo::CONTAINER_MP4);
+  media_info.set_init_segment_name("init.mp4");
+  media_info.set_segment_template("$Time$.mp4");
+  return media_info;
+}
+
+}  // namespace
+
+class MpdBuilderBenchmark : public ::testing::Test {
+ public:
+  MpdBuilderBenchmark() : mpd_(MpdBuilder::kDynamic, MpdOptions()) {}
+
+  void SetUp() {
+    Representation* representation =
+        mpd_.AddAdaptationSet()->AddRepresentation(GetVideoMediaInfo());
+    ASSERT_TRUE(representation);
+    // Vary the durations so that the segments do not collapse into a few
+    // repeated S elements of the SegmentTimeline.
+    uint64_t start_time = 0;
+    for (size_t i = 0; i < kNumSegments; ++i) {
+      const uint64_t duration = kSegmentDuration + (i % 2);
+      representation->AddNewSegment(start_time, duration, kSegmentSize + i);
+      start_time += duration;
+    }
+  }
+
+  void GenerateMpd() {
+    ASSERT_TRUE(mpd_.ToString(&mpd_output_));
+  }
+
+ protected:
+  MpdBuilder mpd_;
+  std::string mpd_output_;
+};
+
+TEST_F(MpdBuilderBenchmark, ToString) {
+  GenerateMpd();
+  media::RunThroughputBenchmark(
+      "MpdBuilderToString",
+      mpd_output_.size(),
+      base::Bind(&MpdBuilderBenchmark::GenerateMpd, base::Unretained(this)));
+}
+
+}  // namespace edash_packager
@@ -6,6 +6,8 @@
 
 #include <gtest/gtest.h>
 #include <inttypes.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
 #include <libxml/xmlstring.h>
 
 #include "packager/base/file_util.h"
@@ -16,6 +18,8 @@
 #include "packager/media/file/file.h"
 #include "packager/mpd/base/mpd_builder.h"
 #include "packager/mpd/base/mpd_utils.h"
+#include "packager/mpd/base/xml/scoped_xml_ptr.h"
+#include "packager/mpd/base/xml/xml_writer.h"
 #include "packager/mpd/test/mpd_builder_test_helper.h"
 #include "packager/mpd/test/xml_compare.h"
 
@@ -31,6 +35,7 @@ const int kDefaultStartNumber = 1;
 // Get 'id' attribute from |node|, convert it to std::string and convert it to a
 // number.
 void ExpectXmlElementIdEqual(xmlNodePtr node, uint32_t id) {
+  ASSERT_TRUE(node);
   const char kId[] = "id";
   xml::ScopedXmlPtr<xmlChar>::type id_attribute_xml_str(
       xmlGetProp(node, BAD_CAST kId));
@@ -44,14 +49,9 @@ void ExpectXmlElementIdEqual(xmlNodePtr node, uint32_t id) {
   ASSERT_EQ(id, id_attribute_unsigned);
 }
 
-// Using template to support both AdaptationSet and Representation.
-template <typename T>
-void CheckIdEqual(uint32_t expected_id, T* node) {
-  ASSERT_EQ(expected_id, node->id());
-
-  // Also check if the XML generated by libxml2 has the correct id attribute.
-  xml::ScopedXmlPtr<xmlNode>::type node_xml(node->GetXml());
-  ASSERT_NO_FATAL_FAILURE(ExpectXmlElementIdEqual(node_xml.get(), expected_id));
+xml::ScopedXmlPtr<xmlDoc>::type ParseXml(const std::string& xml) {
+  return xml::ScopedXmlPtr<xmlDoc>::type(
+      xmlParseMemory(xml.data(), xml.size()));
 }
 }  // namespace
 
@@ -68,6 +68,12 @@ class MpdBuilderTest: public ::testing::Test {
 
     ASSERT_NO_FATAL_FAILURE(
         ExpectMpdToEqualExpectedOutputFile(mpd_doc, expected_output_file));
+
+    // The output is also expected to be formatted exactly as the file.
+    std::string expected_mpd;
+    ASSERT_TRUE(base::ReadFileToString(
+        GetTestDataFilePath(expected_output_file), &expected_mpd));
+    EXPECT_EQ(expected_mpd, mpd_doc);
   }
 
  protected:
@@ -293,7 +299,16 @@ TEST_F(StaticMpdBuilderTest, CheckAdaptationSetId) {
 
   AdaptationSet adaptation_set(
       kAdaptationSetId, MpdOptions(), &sequence_counter);
-  ASSERT_NO_FATAL_FAILURE(CheckIdEqual(kAdaptationSetId, &adaptation_set));
+  ASSERT_EQ(kAdaptationSetId, adaptation_set.id());
+
+  // Also check if the serialized XML has the correct id attribute.
+  std::string output;
+  xml::XmlWriter writer(0, &output);
+  ASSERT_TRUE(adaptation_set.WriteXml(MpdBuilder::kStatic, &writer));
+  xml::ScopedXmlPtr<xmlDoc>::type doc(ParseXml(output));
+  ASSERT_TRUE(doc);
+  ASSERT_NO_FATAL_FAILURE(ExpectXmlElementIdEqual(
+      xmlDocGetRootElement(doc.get()), kAdaptationSetId));
 }
 
 TEST_F(StaticMpdBuilderTest, CheckRepresentationId) {
@@ -303,7 +318,83 @@ TEST_F(StaticMpdBuilderTest, CheckRepresentationId) {
   Representation representation(
       video_media_info, MpdOptions(), kRepresentationId);
   EXPECT_TRUE(representation.Init());
-  ASSERT_NO_FATAL_FAILURE(CheckIdEqual(kRepresentationId, &representation));
+  ASSERT_EQ(kRepresentationId, representation.id());
+
+  // Also check if the serialized XML has the correct id attribute. The
+  // Representation is serialized as a child element.
+  std::string output;
+  xml::XmlWriter writer(0, &output);
+  writer.StartElement("AdaptationSet");
+  ASSERT_TRUE(representation.WriteXml(MpdBuilder::kStatic, &writer));
+  writer.EndElement();
+  xml::ScopedXmlPtr<xmlDoc>::type doc(ParseXml(output));
+  ASSERT_TRUE(doc);
+  ASSERT_NO_FATAL_FAILURE(ExpectXmlElementIdEqual(
+      xmlFirstElementChild(xmlDocGetRootElement(doc.get())),
+      kRepresentationId));
+}
+
+// ContentProtection elements in MediaInfo are added to the Representation,
+// with their attributes and subelements.
+TEST_F(StaticMpdBuilderTest, ContentProtectionXmlFromMediaInfo) {
+  const char kMediaInfo[] =
+      "video_info {\n"
+      "  codec: \"avc1.010101\"\n"
+      "  width: 720\n"
+      "  height: 480\n"
+      "  time_scale: 10\n"
+      "}\n"
+      "content_protections {\n"
+      "  scheme_id_uri: \"http://www.foo.com/drm\"\n"
+      "  value: \"somevalue\"\n"
+      "  attributes {\n"
+      "    name: \"a\"\n"
+      "    value: \"1\"\n"
+      "  }\n"
+      "  attributes {\n"
+      "    name: \"b\"\n"
+      "    value: \"2\"\n"
+      "  }\n"
+      "  subelements {\n"
+      "    name: \"TestSubElement\"\n"
+      "    attributes {\n"
+      "      name: \"c\"\n"
+      "      value: \"3\"\n"
+      "    }\n"
+      "    attributes {\n"
+      "      name: \"d\"\n"
+      "      value: \"4\"\n"
+      "    }\n"
+      "  }\n"
+      "}\n"
+      "bandwidth: 7620\n"
+      "container_type: 1\n";
+  const char kExpectedOutput[] =
+      "<AdaptationSet>\n"
+      "  <Representation id=\"1\" bandwidth=\"7620\" codecs=\"avc1.010101\"\n"
+      "    mimeType=\"video/mp4\" width=\"720\" height=\"480\">\n"
+      "    <ContentProtection\n"
+      "      a=\"1\"\n"
+      "      b=\"2\"\n"
+      "      schemeIdUri=\"http://www.foo.com/drm\"\n"
+      "      value=\"somevalue\">\n"
+      "        <TestSubElement c=\"3\" d=\"4\"/>\n"
+      "    </ContentProtection>\n"
+      "  </Representation>\n"
+      "</AdaptationSet>";
+
+  const uint32_t kRepresentationId = 1;
+  Representation representation(
+      ConvertToMediaInfo(kMediaInfo), MpdOptions(), kRepresentationId);
+  ASSERT_TRUE(representation.Init());
+
+  std::string output;
+  xml::XmlWriter writer(0, &output);
+  writer.StartElement("AdaptationSet");
+  ASSERT_TRUE(representation.WriteXml(MpdBuilder::kStatic, &writer));
+  writer.EndElement();
+  EXPECT_TRUE(XmlEqual(kExpectedOutput, output))
+      << "Expected " << kExpectedOutput << std::endl << "Actual: " << output;
 }
 
 // Add one video check the output.
@@ -407,6 +498,27 @@ TEST_F(DynamicMpdBuilderTest, CheckMpdAttributes) {
   ASSERT_EQ(kExpectedOutput, mpd_doc);
 }
 
+// Some template names cannot be used for init segment name.
+TEST_F(DynamicMpdBuilderTest, InvalidLiveInitSegmentName) {
+  MediaInfo media_info = ConvertToMediaInfo(GetDefaultMediaInfo());
+
+  // $Number$ cannot be used for segment name.
+  media_info.set_init_segment_name("$Number$.mp4");
+  ASSERT_NO_FATAL_FAILURE(AddRepresentation(media_info));
+  std::string mpd_doc;
+  EXPECT_FALSE(mpd_.ToString(&mpd_doc));
+}
+
+TEST_F(DynamicMpdBuilderTest, InvalidLiveInitSegmentNameTime) {
+  MediaInfo media_info = ConvertToMediaInfo(GetDefaultMediaInfo());
+
+  // $Time$ as well.
+  media_info.set_init_segment_name("$Time$.mp4");
+  ASSERT_NO_FATAL_FAILURE(AddRepresentation(media_info));
+  std::string mpd_doc;
+  EXPECT_FALSE(mpd_.ToString(&mpd_doc));
+}
+
 // Estimate the bandwidth given the info from AddNewSegment().
 TEST_F(SegmentTemplateTest, OneSegmentNormal) {
   const uint64_t kStartTime = 0;
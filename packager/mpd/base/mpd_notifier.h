@@ -71,6 +71,11 @@ class MpdNotifier {
       uint32_t container_id,
       const ContentProtectionElement& content_protection_element) = 0;
 
+  /// Makes sure that all the updates notified so far are reflected in the
+  /// output. Implementations that buffer or defer updates should override it.
+  /// @return true on success, false otherwise.
+  virtual bool Flush() { return true; }
+
   /// @return The dash profile for this object.
   DashProfile dash_profile() const { return dash_profile_; }
 
@@ -6,13 +6,10 @@
 
 #include "packager/mpd/base/mpd_utils.h"
 
-#include <libxml/tree.h>
-
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/mpd/base/content_protection_element.h"
 #include "packager/mpd/base/media_info.pb.h"
-#include "packager/mpd/base/xml/scoped_xml_ptr.h"
 
 namespace {
 
@@ -86,24 +83,33 @@ std::string SecondsToXmlDuration(double seconds) {
   return "PT" + base::DoubleToString(seconds) + "S";
 }
 
-bool GetDurationAttribute(xmlNodePtr node, float* duration) {
-  DCHECK(node);
-  DCHECK(duration);
-  static const char kDuration[] = "duration";
-  xml::ScopedXmlPtr<xmlChar>::type duration_value(
-      xmlGetProp(node, BAD_CAST kDuration));
-
-  if (!duration_value)
-    return false;
+bool GetSchemeIdAttribute(
+    const MediaInfo::ContentProtectionXml& content_protection_xml,
+    std::string* scheme_id_uri_output) {
+  // Common case where 'schemeIdUri' is set directly.
+  if (content_protection_xml.has_scheme_id_uri()) {
+    scheme_id_uri_output->assign(content_protection_xml.scheme_id_uri());
+    return true;
+  }
 
-  double duration_double_precision = 0.0;
-  if (!base::StringToDouble(reinterpret_cast<const char*>(duration_value.get()),
-                            &duration_double_precision)) {
-    return false;
+  // 'schemeIdUri' is one of the attributes.
+  for (int i = 0; i < content_protection_xml.attributes().size(); ++i) {
+    const MediaInfo::ContentProtectionXml::AttributeNameValuePair& attribute =
+        content_protection_xml.attributes(i);
+    const std::string& name = attribute.name();
+    const std::string& value = attribute.value();
+    if (name == "schemeIdUri") {
+      if (value.empty())
+        LOG(WARNING) << "schemeIdUri is specified with an empty string.";
+
+      // 'schemeIdUri' is a mandatory field but MPD doesn't care what the actual
+      // value is, proceed.
+      scheme_id_uri_output->assign(value);
+      return true;
+    }
   }
 
-  *duration = static_cast<float>(duration_double_precision);
-  return true;
+  return false;
 }
 
 bool MoreThanOneTrue(bool b1, bool b2, bool b3) {
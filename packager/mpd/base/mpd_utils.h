@@ -9,13 +9,12 @@
 #ifndef MPD_BASE_MPD_UTILS_H_
 #define MPD_BASE_MPD_UTILS_H_
 
-#include <libxml/tree.h>
-
 #include <string>
 
+#include "packager/mpd/base/media_info.pb.h"
+
 namespace edash_packager {
 
-class MediaInfo;
 struct ContentProtectionElement;
 struct SegmentInfo;
 
@@ -35,8 +34,12 @@ std::string GetCodecs(const MediaInfo& media_info);
 
 std::string SecondsToXmlDuration(double seconds);
 
-// Tries to get "duration" attribute from |node|. On success |duration| is set.
-bool GetDurationAttribute(xmlNodePtr node, float* duration);
+// Returns true if 'schemeIdUri' is set in |content_protection_xml| and sets
+// |scheme_id_uri_output|. This function checks
+// ContentProtectionXml::scheme_id_uri before searching thru attributes.
+bool GetSchemeIdAttribute(
+    const MediaInfo::ContentProtectionXml& content_protection_xml,
+    std::string* scheme_id_uri_output);
 
 bool MoreThanOneTrue(bool b1, bool b2, bool b3);
 bool AtLeastOneTrue(bool b1, bool b2, bool b3);
@@ -6,34 +6,78 @@
 
 #include "packager/mpd/base/simple_mpd_notifier.h"
 
+#include "packager/base/file_util.h"
 #include "packager/base/logging.h"
+#include "packager/base/threading/simple_thread.h"
 #include "packager/media/file/file.h"
 #include "packager/mpd/base/mpd_builder.h"
 #include "packager/mpd/base/mpd_utils.h"
 
 using edash_packager::media::File;
 
+namespace {
+const char kTempFileSuffix[] = ".tmp";
+
+// Strip the local file prefix, if any, to get a path usable with base file
+// utilities.
+std::string GetLocalPath(const std::string& file_name) {
+  const std::string local_file_prefix(edash_packager::media::kLocalFilePrefix);
+  if (file_name.compare(0, local_file_prefix.size(), local_file_prefix) == 0)
+    return file_name.substr(local_file_prefix.size());
+  return file_name;
+}
+}  // namespace
+
 namespace edash_packager {
 
+class SimpleMpdNotifier::WriterThread : public base::SimpleThread {
+ public:
+  explicit WriterThread(SimpleMpdNotifier* notifier)
+      : base::SimpleThread("MpdWriter"), notifier_(notifier) {}
+  virtual ~WriterThread() {}
+
+ private:
+  virtual void Run() OVERRIDE { notifier_->WriteMpdInBackground(); }
+
+  SimpleMpdNotifier* const notifier_;
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
 SimpleMpdNotifier::SimpleMpdNotifier(DashProfile dash_profile,
                                      const MpdOptions& mpd_options,
                                      const std::vector<std::string>& base_urls,
                                      const std::string& output_path)
     : MpdNotifier(dash_profile),
       output_path_(output_path),
+      mpd_write_interval_(base::TimeDelta::FromMilliseconds(
+          static_cast<int64_t>(mpd_options.mpd_write_interval * 1000))),
       mpd_builder_(new MpdBuilder(dash_profile == kLiveProfile
                                       ? MpdBuilder::kDynamic
                                       : MpdBuilder::kStatic,
-                                  mpd_options)) {
+                                  mpd_options)),
+      writer_cv_(&lock_),
+      writer_running_(false),
+      mpd_dirty_(false),
+      background_write_failed_(false) {
   DCHECK(dash_profile == kLiveProfile || dash_profile == kOnDemandProfile);
   for (size_t i = 0; i < base_urls.size(); ++i)
     mpd_builder_->AddBaseUrl(base_urls[i]);
 }
 
 SimpleMpdNotifier::~SimpleMpdNotifier() {
+  if (writer_thread_)
+    Flush();
 }
 
 bool SimpleMpdNotifier::Init() {
+  if (mpd_write_interval_ > base::TimeDelta()) {
+    base::AutoLock auto_lock(lock_);
+    DCHECK(!writer_thread_);
+    writer_running_ = true;
+    writer_thread_.reset(new WriterThread(this));
+    writer_thread_->Start();
+  }
   return true;
 }
 
@@ -45,42 +89,46 @@ bool SimpleMpdNotifier::NotifyNewContainer(const MediaInfo& media_info,
   if (content_type == kUnknown)
     return false;
 
-  base::AutoLock auto_lock(lock_);
-  // TODO(kqyang): Consider adding a new method MpdBuilder::AddRepresentation.
-  // Most of the codes here can be moved inside.
-  AdaptationSet** adaptation_set = &adaptation_set_map_[content_type];
-  if (*adaptation_set == NULL)
-    *adaptation_set = mpd_builder_->AddAdaptationSet();
-
-  DCHECK(*adaptation_set);
-  Representation* representation =
-      (*adaptation_set)->AddRepresentation(media_info);
-  if (representation == NULL)
-    return false;
+  {
+    base::AutoLock auto_lock(lock_);
+    // TODO(kqyang): Consider adding a new method MpdBuilder::AddRepresentation.
+    // Most of the codes here can be moved inside.
+    AdaptationSet** adaptation_set = &adaptation_set_map_[content_type];
+    if (*adaptation_set == NULL)
+      *adaptation_set = mpd_builder_->AddAdaptationSet();
 
-  *container_id = representation->id();
+    DCHECK(*adaptation_set);
+    Representation* representation =
+        (*adaptation_set)->AddRepresentation(media_info);
+    if (representation == NULL)
+      return false;
 
-  if (mpd_builder_->type() == MpdBuilder::kStatic)
-    return WriteMpdToFile();
+    *container_id = representation->id();
 
-  DCHECK(!ContainsKey(representation_map_, representation->id()));
-  representation_map_[representation->id()] = representation;
-  return true;
+    if (mpd_builder_->type() == MpdBuilder::kDynamic) {
+      DCHECK(!ContainsKey(representation_map_, representation->id()));
+      representation_map_[representation->id()] = representation;
+      return true;
+    }
+  }
+  return MpdUpdated();
 }
 
 bool SimpleMpdNotifier::NotifyNewSegment(uint32_t container_id,
                                          uint64_t start_time,
                                          uint64_t duration,
                                          uint64_t size) {
-  base::AutoLock auto_lock(lock_);
+  {
+    base::AutoLock auto_lock(lock_);
 
-  RepresentationMap::iterator it = representation_map_.find(container_id);
-  if (it == representation_map_.end()) {
-    LOG(ERROR) << "Unexpected container_id: " << container_id;
-    return false;
+    RepresentationMap::iterator it = representation_map_.find(container_id);
+    if (it == representation_map_.end()) {
+      LOG(ERROR) << "Unexpected container_id: " << container_id;
+      return false;
+    }
+    it->second->AddNewSegment(start_time, duration, size);
   }
-  it->second->AddNewSegment(start_time, duration, size);
-  return WriteMpdToFile();
+  return MpdUpdated();
 }
 
 bool SimpleMpdNotifier::AddContentProtectionElement(
@@ -90,6 +138,28 @@ bool SimpleMpdNotifier::AddContentProtectionElement(
   return false;
 }
 
+bool SimpleMpdNotifier::Flush() {
+  bool write_mpd = false;
+  bool background_write_failed = false;
+  {
+    base::AutoLock auto_lock(lock_);
+    if (!writer_thread_)
+      return true;
+    writer_running_ = false;
+    writer_cv_.Signal();
+  }
+  writer_thread_->Join();
+  {
+    base::AutoLock auto_lock(lock_);
+    writer_thread_.reset();
+    write_mpd = mpd_dirty_;
+    background_write_failed = background_write_failed_;
+  }
+  if (write_mpd && !WriteMpdToFile())
+    return false;
+  return !background_write_failed;
+}
+
 SimpleMpdNotifier::ContentType SimpleMpdNotifier::GetContentType(
     const MediaInfo& media_info) {
   const bool has_video = media_info.video_info().size() > 0;
@@ -107,18 +177,64 @@ SimpleMpdNotifier::ContentType SimpleMpdNotifier::GetContentType(
   return has_video ? kVideo : (has_audio ? kAudio : kText);
 }
 
+bool SimpleMpdNotifier::MpdUpdated() {
+  {
+    base::AutoLock auto_lock(lock_);
+    if (writer_running_) {
+      mpd_dirty_ = true;
+      writer_cv_.Signal();
+      return true;
+    }
+  }
+  return WriteMpdToFile();
+}
+
+void SimpleMpdNotifier::WriteMpdInBackground() {
+  base::AutoLock auto_lock(lock_);
+  base::TimeTicks next_write_time = base::TimeTicks::Now();
+  while (writer_running_) {
+    if (!mpd_dirty_) {
+      writer_cv_.Wait();
+      continue;
+    }
+    // Let more updates accumulate until the interval has passed.
+    const base::TimeTicks now = base::TimeTicks::Now();
+    if (now < next_write_time) {
+      writer_cv_.TimedWait(next_write_time - now);
+      continue;
+    }
+    next_write_time = now + mpd_write_interval_;
+
+    bool success;
+    {
+      base::AutoUnlock auto_unlock(lock_);
+      success = WriteMpdToFile();
+    }
+    if (!success)
+      background_write_failed_ = true;
+  }
+}
+
 bool SimpleMpdNotifier::WriteMpdToFile() {
   CHECK(!output_path_.empty());
 
+  base::AutoLock write_lock(write_lock_);
   std::string mpd;
-  if (!mpd_builder_->ToString(&mpd)) {
-    LOG(ERROR) << "Failed to write MPD to string.";
-    return false;
+  {
+    base::AutoLock auto_lock(lock_);
+    mpd_dirty_ = false;
+    if (!mpd_builder_->ToString(&mpd)) {
+      LOG(ERROR) << "Failed to write MPD to string.";
+      return false;
+    }
   }
 
-  File* file = File::Open(output_path_.c_str(), "w");
+  // Write to a temporary file first and rename it, so the output file is
+  // replaced atomically.
+  const std::string temp_file_name = output_path_ + kTempFileSuffix;
+  File* file = File::Open(temp_file_name.c_str(), "w");
   if (!file) {
-    LOG(ERROR) << "Failed to open file for writing: " << output_path_;
+    LOG(ERROR) << "Failed to open file for writing: " << temp_file_name;
     return false;
   }
 
@@ -127,14 +243,27 @@ bool SimpleMpdNotifier::WriteMpdToFile() {
   while (mpd_bytes_left > 0) {
     int64_t length = file->Write(mpd_char_ptr, mpd_bytes_left);
     if (length <= 0) {
-      LOG(ERROR) << "Failed to write to file '" << output_path_ << "' ("
+      LOG(ERROR) << "Failed to write to file '" << temp_file_name << "' ("
                  << length << ").";
+      file->Close();
       return false;
     }
     mpd_char_ptr += length;
     mpd_bytes_left -= length;
   }
-  return file->Close();
+  if (!file->Close()) {
+    LOG(ERROR) << "Failed to close file '" << temp_file_name << "'.";
+    return false;
+  }
+
+  if (!base::ReplaceFile(base::FilePath(GetLocalPath(temp_file_name)),
+                         base::FilePath(GetLocalPath(output_path_)),
+                         NULL)) {
+    LOG(ERROR) << "Failed to rename '" << temp_file_name << "' to '"
+               << output_path_ << "'.";
+    return false;
+  }
+  return true;
 }
 
 }  // namespace edash_packager
@@ -12,7 +12,9 @@
 #include <vector>
 
 #include "packager/base/memory/scoped_ptr.h"
+#include "packager/base/synchronization/condition_variable.h"
 #include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
 #include "packager/mpd/base/mpd_notifier.h"
 
 namespace edash_packager {
@@ -24,7 +26,10 @@ class Representation;
 struct MpdOptions;
 
 /// A simple MpdNotifier implementation which receives muxer listener event and
-/// generates an Mpd file.
+/// generates an Mpd file. The file is replaced atomically, so readers never see
+/// a partially written MPD. If MpdOptions::mpd_write_interval is positive, the
+/// updates are coalesced and written by a background thread at most once per
+/// interval.
 class SimpleMpdNotifier : public MpdNotifier {
  public:
   SimpleMpdNotifier(DashProfile dash_profile,
@@ -45,9 +50,12 @@ class SimpleMpdNotifier : public MpdNotifier {
   virtual bool AddContentProtectionElement(
       uint32_t id,
       const ContentProtectionElement& content_protection_element) OVERRIDE;
+  virtual bool Flush() OVERRIDE;
   /// @}
 
  private:
+  class WriterThread;
+
   enum ContentType {
     kUnknown,
     kVideo,
@@ -55,13 +63,28 @@ class SimpleMpdNotifier : public MpdNotifier {
     kText
   };
   ContentType GetContentType(const MediaInfo& media_info);
+  // Called after the MPD is modified. Writes the MPD, or leaves it to the
+  // writer thread if it is running. |lock_| should not be held.
+  bool MpdUpdated();
+  // Body of |writer_thread_|.
+  void WriteMpdInBackground();
   bool WriteMpdToFile();
 
   std::string output_path_;
+  const base::TimeDelta mpd_write_interval_;
 
   scoped_ptr<MpdBuilder> mpd_builder_;
 
   base::Lock lock_;
+  // Serializes WriteMpdToFile(). Acquired before |lock_|.
+  base::Lock write_lock_;
+
+  // Background writer state, protected by |lock_|.
+  scoped_ptr<WriterThread> writer_thread_;
+  base::ConditionVariable writer_cv_;
+  bool writer_running_;
+  bool mpd_dirty_;
+  bool background_write_failed_;
 
   typedef std::map<ContentType, AdaptationSet*> AdaptationSetMap;
   AdaptationSetMap adaptation_set_map_;
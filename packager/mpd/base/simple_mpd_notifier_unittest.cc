@@ -0,0 +1,113 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/file_util.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/mpd/base/media_info.pb.h"
+#include "packager/mpd/base/mpd_builder.h"
+#include "packager/mpd/base/simple_mpd_notifier.h"
+#include "packager/mpd/test/mpd_builder_test_helper.h"
+
+namespace edash_packager {
+
+namespace {
+const char kLiveMediaInfo[] =
+    "video_info {\n"
+    "  codec: \"avc1.010101\"\n"
+    "  width: 720\n"
+    "  height: 480\n"
+    "  time_scale: 10\n"
+    "}\n"
+    "reference_time_scale: 1000\n"
+    "container_type: 1\n"
+    "init_segment_name: \"init.mp4\"\n"
+    "segment_template: \"$Time$.mp4\"\n";
+const uint64_t kSegmentDuration = 1000;
+const uint64_t kSegmentSize = 10000;
+// Long enough that no background write happens during the test after the
+// first one.
+const double kLongWriteInterval = 1000.0;
+const int kFirstWriteTimeoutMs = 10000;
+}  // namespace
+
+class SimpleMpdNotifierTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(base::CreateTemporaryFile(&output_path_));
+    ASSERT_TRUE(base::DeleteFile(output_path_, false));
+    temp_path_ = base::FilePath(output_path_.value() + ".tmp");
+  }
+
+  virtual void TearDown() {
+    base::DeleteFile(output_path_, false);
+    base::DeleteFile(temp_path_, false);
+  }
+
+  std::string ReadMpd() {
+    std::string mpd;
+    base::ReadFileToString(output_path_, &mpd);
+    return mpd;
+  }
+
+  MpdOptions mpd_options_;
+  std::vector<std::string> no_base_urls_;
+  base::FilePath output_path_;
+  base::FilePath temp_path_;
+};
+
+TEST_F(SimpleMpdNotifierTest, OnDemandWritesMpd) {
+  SimpleMpdNotifier notifier(
+      kOnDemandProfile, mpd_options_, no_base_urls_, output_path_.value());
+  ASSERT_TRUE(notifier.Init());
+
+  uint32_t container_id;
+  ASSERT_TRUE(notifier.NotifyNewContainer(
+      GetTestMediaInfo(kFileNameVideoMediaInfo1), &container_id));
+  EXPECT_FALSE(base::PathExists(temp_path_));
+  ASSERT_NO_FATAL_FAILURE(ExpectMpdToEqualExpectedOutputFile(
+      ReadMpd(), kFileNameExpectedMpdOutputVideo1));
+}
+
+TEST_F(SimpleMpdNotifierTest, LiveCoalescesUpdates) {
+  mpd_options_.mpd_write_interval = kLongWriteInterval;
+  SimpleMpdNotifier notifier(
+      kLiveProfile, mpd_options_, no_base_urls_, output_path_.value());
+  ASSERT_TRUE(notifier.Init());
+
+  uint32_t container_id;
+  ASSERT_TRUE(notifier.NotifyNewContainer(ConvertToMediaInfo(kLiveMediaInfo),
+                                          &container_id));
+
+  // The first update is written right away, in the background.
+  ASSERT_TRUE(notifier.NotifyNewSegment(
+      container_id, 0, kSegmentDuration, kSegmentSize));
+  for (int i = 0; i < kFirstWriteTimeoutMs && !base::PathExists(output_path_);
+       ++i) {
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  }
+  const std::string first_mpd = ReadMpd();
+  ASSERT_FALSE(first_mpd.empty());
+  EXPECT_EQ(std::string::npos, first_mpd.find(" r=\""));
+
+  // The next updates are held back until the interval passes or the notifier
+  // is flushed.
+  const int kNumSegments = 5;
+  for (int i = 1; i < kNumSegments; ++i) {
+    ASSERT_TRUE(notifier.NotifyNewSegment(
+        container_id, i * kSegmentDuration, kSegmentDuration, kSegmentSize));
+  }
+  EXPECT_EQ(first_mpd, ReadMpd());
+
+  ASSERT_TRUE(notifier.Flush());
+  const std::string final_mpd = ReadMpd();
+  EXPECT_NE(std::string::npos, final_mpd.find(" r=\"4\""));
+  EXPECT_FALSE(base::PathExists(temp_path_));
+}
+
+}  // namespace edash_packager
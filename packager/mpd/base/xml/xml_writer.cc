@@ -0,0 +1,188 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/mpd/base/xml/xml_writer.h"
+
+#include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
+
+namespace edash_packager {
+namespace xml {
+
+namespace {
+
+const int kIndentSize = 2;
+
+void AppendEscapedAttribute(const std::string& value, std::string* output) {
+  for (size_t i = 0; i < value.size(); ++i) {
+    switch (value[i]) {
+      case '<':
+        output->append("&lt;");
+        break;
+      case '>':
+        output->append("&gt;");
+        break;
+      case '&':
+        output->append("&amp;");
+        break;
+      case '"':
+        output->append("&quot;");
+        break;
+      case '\n':
+        output->append("&#10;");
+        break;
+      case '\r':
+        output->append("&#13;");
+        break;
+      case '\t':
+        output->append("&#9;");
+        break;
+      default:
+        output->push_back(value[i]);
+        break;
+    }
+  }
+}
+
+void AppendEscapedText(const std::string& text, std::string* output) {
+  for (size_t i = 0; i < text.size(); ++i) {
+    switch (text[i]) {
+      case '<':
+        output->append("&lt;");
+        break;
+      case '>':
+        output->append("&gt;");
+        break;
+      case '&':
+        output->append("&amp;");
+        break;
+      case '\r':
+        output->append("&#13;");
+        break;
+      default:
+        output->push_back(text[i]);
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+XmlWriter::XmlWriter(int indent_level, std::string* output)
+    : base_indent_level_(indent_level), output_(output) {
+  DCHECK_GE(indent_level, 0);
+  DCHECK(output);
+}
+
+XmlWriter::~XmlWriter() {}
+
+void XmlWriter::WriteXmlDeclaration() {
+  DCHECK(open_elements_.empty());
+  output_->append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+}
+
+void XmlWriter::StartElement(const std::string& name) {
+  if (!open_elements_.empty()) {
+    CloseStartTag(true);
+    DCHECK(!open_elements_.back().has_content)
+        << "An element cannot have both content and child elements.";
+  }
+  Indent(base_indent_level_ + open_elements_.size());
+  output_->push_back('<');
+  output_->append(name);
+
+  Element element = {name, false, false};
+  open_elements_.push_back(element);
+}
+
+void XmlWriter::EndElement() {
+  DCHECK(!open_elements_.empty());
+  const Element& element = open_elements_.back();
+  if (!element.start_tag_closed) {
+    CloseStartTag(false);
+    output_->append("/>\n");
+  } else {
+    if (!element.has_content)
+      Indent(base_indent_level_ + open_elements_.size() - 1);
+    output_->append("</");
+    output_->append(element.name);
+    output_->append(">\n");
+  }
+  open_elements_.pop_back();
+}
+
+void XmlWriter::SetStringAttribute(const char* attribute_name,
+                                   const std::string& attribute) {
+  DCHECK(attribute_name);
+  DCHECK(!open_elements_.empty());
+  DCHECK(!open_elements_.back().start_tag_closed)
+      << "Attributes must be set before children or content are added.";
+  for (size_t i = 0; i < attributes_.size(); ++i) {
+    if (attributes_[i].first == attribute_name) {
+      attributes_[i].second = attribute;
+      return;
+    }
+  }
+  attributes_.push_back(std::make_pair(attribute_name, attribute));
+}
+
+void XmlWriter::SetIntegerAttribute(const char* attribute_name,
+                                    uint64_t number) {
+  SetStringAttribute(attribute_name, base::Uint64ToString(number));
+}
+
+void XmlWriter::SetFloatingPointAttribute(const char* attribute_name,
+                                          double number) {
+  SetStringAttribute(attribute_name, base::DoubleToString(number));
+}
+
+void XmlWriter::SetId(uint32_t id) {
+  SetIntegerAttribute("id", id);
+}
+
+void XmlWriter::SetContent(const std::string& content) {
+  DCHECK(!open_elements_.empty());
+  DCHECK(!open_elements_.back().start_tag_closed);
+  // An element with empty content has no children.
+  if (content.empty())
+    return;
+  CloseStartTag(false);
+  output_->push_back('>');
+  open_elements_.back().start_tag_closed = true;
+  open_elements_.back().has_content = true;
+  AppendEscapedText(content, output_);
+}
+
+void XmlWriter::AddSerializedElement(const std::string& element) {
+  DCHECK(!open_elements_.empty());
+  CloseStartTag(true);
+  output_->append(element);
+}
+
+void XmlWriter::CloseStartTag(bool has_children) {
+  Element& element = open_elements_.back();
+  if (element.start_tag_closed)
+    return;
+  for (size_t i = 0; i < attributes_.size(); ++i) {
+    output_->push_back(' ');
+    output_->append(attributes_[i].first);
+    output_->append("=\"");
+    AppendEscapedAttribute(attributes_[i].second, output_);
+    output_->push_back('"');
+  }
+  attributes_.clear();
+  if (has_children) {
+    output_->append(">\n");
+    element.start_tag_closed = true;
+  }
+}
+
+void XmlWriter::Indent(int level) {
+  output_->append(level * kIndentSize, ' ');
+}
+
+}  // namespace xml
+}  // namespace edash_packager
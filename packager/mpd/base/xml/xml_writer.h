@@ -0,0 +1,109 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// XmlWriter serializes XML directly into a string, without building a DOM.
+// Child elements are indented by two spaces per level, and elements without
+// children or content are written as empty-element tags.
+
+#ifndef MPD_BASE_XML_XML_WRITER_H_
+#define MPD_BASE_XML_XML_WRITER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "packager/base/macros.h"
+
+namespace edash_packager {
+namespace xml {
+
+/// Streaming XML writer. Elements are started and ended in document order;
+/// attributes of an element must be set before its first child or content.
+/// None of the pointer parameters should be NULL.
+class XmlWriter {
+ public:
+  /// @param indent_level is the nesting level of the first element written,
+  ///        which determines its indentation. Use a non-zero value to
+  ///        serialize a fragment to be added with AddSerializedElement() to
+  ///        an element at @a indent_level - 1.
+  /// @param[out] output is where the XML is appended. Not owned.
+  XmlWriter(int indent_level, std::string* output);
+  ~XmlWriter();
+
+  /// Write the XML declaration. Should be called before the root element.
+  void WriteXmlDeclaration();
+
+  /// Start an element. Unless it is the first element written, the element is
+  /// a child of the current element.
+  /// @param name is the name of the element.
+  void StartElement(const std::string& name);
+
+  /// End the current element.
+  void EndElement();
+
+  /// Set a string attribute of the current element. Setting an attribute
+  /// that is already set replaces its value but keeps its position.
+  /// @param attribute_name The name (lhs) of the attribute.
+  /// @param attribute The value (rhs) of the attribute.
+  void SetStringAttribute(const char* attribute_name,
+                          const std::string& attribute);
+
+  /// Sets an interger attribute of the current element.
+  /// @param attribute_name The name (lhs) of the attribute.
+  /// @param number The value (rhs) of the attribute.
+  void SetIntegerAttribute(const char* attribute_name, uint64_t number);
+
+  /// Set a floating point number attribute of the current element.
+  /// @param attribute_name is the name of the attribute to set.
+  /// @param number is the value (rhs) of the attribute.
+  void SetFloatingPointAttribute(const char* attribute_name, double number);
+
+  /// Sets 'id=@a id' attribute of the current element.
+  /// @param id is the ID for this element.
+  void SetId(uint32_t id);
+
+  /// Set the text content of the current element. @a content is escaped, so
+  /// it is written out as text even if it contains markup or references.
+  /// Note: An element can have either content or child elements, not both.
+  /// @param content is the text content of the element.
+  void SetContent(const std::string& content);
+
+  /// Add a child element serialized by another XmlWriter to the current
+  /// element.
+  /// @param element is the serialized element. It should have been written
+  ///        at the indent level of the children of the current element.
+  void AddSerializedElement(const std::string& element);
+
+ private:
+  struct Element {
+    std::string name;
+    // True if the start tag has been closed, i.e. the element has content or
+    // children.
+    bool start_tag_closed;
+    bool has_content;
+  };
+
+  // Close the start tag of the current element, if it is still open.
+  // |has_children| tells whether the element gets child elements, which are
+  // placed on their own lines.
+  void CloseStartTag(bool has_children);
+  void Indent(int level);
+
+  const int base_indent_level_;
+  std::string* const output_;
+  std::vector<Element> open_elements_;
+  // Attributes of the current element while its start tag is open.
+  std::vector<std::pair<std::string, std::string> > attributes_;
+
+  DISALLOW_COPY_AND_ASSIGN(XmlWriter);
+};
+
+}  // namespace xml
+}  // namespace edash_packager
+
+#endif  // MPD_BASE_XML_XML_WRITER_H_
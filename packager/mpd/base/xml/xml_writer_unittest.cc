@@ -0,0 +1,141 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "packager/mpd/base/xml/xml_writer.h"
+
+namespace edash_packager {
+namespace xml {
+
+TEST(XmlWriterTest, Elements) {
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.WriteXmlDeclaration();
+  writer.StartElement("Root");
+  writer.SetStringAttribute("a", "1");
+  writer.SetIntegerAttribute("b", 12345678901234ULL);
+  writer.StartElement("Child");
+  writer.SetId(3);
+  writer.EndElement();
+  writer.StartElement("Parent");
+  writer.StartElement("Text");
+  writer.SetContent("text");
+  writer.EndElement();
+  writer.EndElement();
+  writer.EndElement();
+
+  EXPECT_EQ(
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<Root a=\"1\" b=\"12345678901234\">\n"
+      "  <Child id=\"3\"/>\n"
+      "  <Parent>\n"
+      "    <Text>text</Text>\n"
+      "  </Parent>\n"
+      "</Root>\n",
+      output);
+}
+
+// Setting an attribute again replaces the value, but keeps the position.
+TEST(XmlWriterTest, ReplaceAttribute) {
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.StartElement("Element");
+  writer.SetStringAttribute("a", "1");
+  writer.SetStringAttribute("b", "2");
+  writer.SetStringAttribute("a", "3");
+  writer.EndElement();
+
+  EXPECT_EQ("<Element a=\"3\" b=\"2\"/>\n", output);
+}
+
+TEST(XmlWriterTest, SerializedElement) {
+  std::string child;
+  XmlWriter child_writer(1, &child);
+  child_writer.StartElement("Child");
+  child_writer.StartElement("Grandchild");
+  child_writer.EndElement();
+  child_writer.EndElement();
+
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.StartElement("Parent");
+  writer.SetStringAttribute("a", "1");
+  writer.AddSerializedElement(child);
+  writer.AddSerializedElement(child);
+  writer.EndElement();
+
+  EXPECT_EQ(
+      "<Parent a=\"1\">\n"
+      "  <Child>\n"
+      "    <Grandchild/>\n"
+      "  </Child>\n"
+      "  <Child>\n"
+      "    <Grandchild/>\n"
+      "  </Child>\n"
+      "</Parent>\n",
+      output);
+}
+
+TEST(XmlWriterTest, EscapeAttributes) {
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.StartElement("Element");
+  writer.SetStringAttribute("a", "<tag attr=\"value\">'quoted'</tag>");
+  writer.SetStringAttribute("b", "&amp; & \t\n\r");
+  writer.EndElement();
+
+  EXPECT_EQ(
+      "<Element a=\"&lt;tag attr=&quot;value&quot;&gt;'quoted'&lt;/tag&gt;\" "
+      "b=\"&amp;amp; &amp; &#9;&#10;&#13;\"/>\n",
+      output);
+}
+
+// Content is written as text: markup and references are escaped, not
+// interpreted.
+TEST(XmlWriterTest, EscapeContent) {
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.StartElement("Parent");
+  writer.StartElement("Markup");
+  writer.SetContent("<tag attr=\"value\">'quoted'</tag>");
+  writer.EndElement();
+  writer.StartElement("References");
+  writer.SetContent("&amp; &#65; &unknown; &unterminated");
+  writer.EndElement();
+  writer.StartElement("Whitespace");
+  writer.SetContent("tab\tnewline\ncarriage return\r");
+  writer.EndElement();
+  writer.StartElement("Utf8");
+  writer.SetContent("\xc3\xa9\xe2\x82\xac");
+  writer.EndElement();
+  writer.EndElement();
+
+  EXPECT_EQ(
+      "<Parent>\n"
+      "  <Markup>&lt;tag attr=\"value\"&gt;'quoted'&lt;/tag&gt;</Markup>\n"
+      "  <References>&amp;amp; &amp;#65; &amp;unknown; &amp;unterminated"
+      "</References>\n"
+      "  <Whitespace>tab\tnewline\ncarriage return&#13;</Whitespace>\n"
+      "  <Utf8>\xc3\xa9\xe2\x82\xac</Utf8>\n"
+      "</Parent>\n",
+      output);
+}
+
+TEST(XmlWriterTest, EmptyContent) {
+  std::string output;
+  XmlWriter writer(0, &output);
+  writer.StartElement("Element");
+  writer.SetContent("");
+  writer.EndElement();
+
+  EXPECT_EQ("<Element/>\n", output);
+}
+
+}  // namespace xml
+}  // namespace edash_packager
@@ -46,8 +46,8 @@
         'base/simple_mpd_notifier.cc',
         'base/simple_mpd_notifier.h',
         'base/xml/scoped_xml_ptr.h',
-        'base/xml/xml_node.cc',
-        'base/xml/xml_node.h',
+        'base/xml/xml_writer.cc',
+        'base/xml/xml_writer.h',
       ],
       'dependencies': [
         '../base/base.gyp:base',
@@ -66,11 +66,13 @@
       'sources': [
         'base/bandwidth_estimator_unittest.cc',
         'base/mpd_builder_unittest.cc',
-        'base/xml/xml_node_unittest.cc',
+        'base/simple_mpd_notifier_unittest.cc',
+        'base/xml/xml_writer_unittest.cc',
         'test/mpd_builder_test_helper.cc',
         'test/mpd_builder_test_helper.h',
         'test/xml_compare.cc',
         'test/xml_compare.h',
+        'test/xml_compare_unittest.cc',
         'util/mpd_writer_unittest.cc',
       ],
       'dependencies': [
@@ -0,0 +1,97 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/mpd/test/xml_compare.h"
+
+namespace edash_packager {
+
+// Make sure XmlEqual() is functioning correctly.
+TEST(XmlCompareTest, XmlEqual) {
+  static const char kXml1[] =
+      "<A>\n"
+      "  <B\n"
+      "    c=\"1\""
+      "    e=\"foobar\""
+      "    somelongnameattribute=\"somevalue\">\n"
+      "      <Bchild childvalue=\"3\"\n"
+      "              f=\"4\"/>\n"
+      "  </B>\n"
+      "  <C />\n"
+      "</A>";
+
+
+  // This is same as kXml1 but the attributes are reordered. Note that the
+  // children are not reordered.
+  static const char kXml1AttributeReorder[] =
+      "<A>\n"
+      "  <B\n"
+      "    c=\"1\""
+      "    somelongnameattribute=\"somevalue\"\n"
+      "    e=\"foobar\">"
+      "      <Bchild childvalue=\"3\"\n"
+      "              f=\"4\"/>\n"
+      "  </B>\n"
+      "  <C />\n"
+      "</A>";
+
+  // <C> is before <B>.
+  static const char kXml1ChildrenReordered[] =
+      "<A>\n"
+      "  <C />\n"
+      "  <B\n"
+      "    d=\"2\""
+      "    c=\"1\""
+      "    somelongnameattribute=\"somevalue\"\n"
+      "    e=\"foobar\">"
+      "      <Bchild childvalue=\"3\"\n"
+      "              f=\"4\"/>\n"
+      "  </B>\n"
+      "</A>";
+
+  // <C> is before <B>.
+  static const char kXml1RemovedAttributes[] =
+      "<A>\n"
+      "  <B\n"
+      "    d=\"2\"\n>"
+      "      <Bchild f=\"4\"/>\n"
+      "  </B>\n"
+      "  <C />\n"
+      "</A>";
+
+  static const char kXml2[] =
+      "<A>\n"
+      "  <C />\n"
+      "</A>";
+
+  // In XML <C />, <C></C>, and <C/> mean the same thing.
+  static const char kXml2DifferentSyntax[] =
+      "<A>\n"
+      "  <C></C>\n"
+      "</A>";
+
+  static const char kXml2MoreDifferentSyntax[] =
+      "<A>\n"
+      "  <C/>\n"
+      "</A>";
+
+  // Identity.
+  ASSERT_TRUE(XmlEqual(kXml1, kXml1));
+
+  // Equivalent.
+  ASSERT_TRUE(XmlEqual(kXml1, kXml1AttributeReorder));
+  ASSERT_TRUE(XmlEqual(kXml2, kXml2DifferentSyntax));
+  ASSERT_TRUE(XmlEqual(kXml2, kXml2MoreDifferentSyntax));
+
+  // Different.
+  ASSERT_FALSE(XmlEqual(kXml1, kXml2));
+  ASSERT_FALSE(XmlEqual(kXml1, kXml1ChildrenReordered));
+  ASSERT_FALSE(XmlEqual(kXml1, kXml1RemovedAttributes));
+  ASSERT_FALSE(XmlEqual(kXml1AttributeReorder, kXml1ChildrenReordered));
+}
+
+}  // namespace edash_packager
@@ -0,0 +1,718 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/packager.h"
+
+#include <map>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/logging.h"
+#include "packager/base/stl_util.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/key_source_cache.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/demuxer.h"
+#include "packager/media/base/job_scheduler.h"
+#include "packager/media/base/key_source.h"
+#include "packager/media/base/live_ingest_reactor.h"
+#include "packager/media/base/media_stream.h"
+#include "packager/media/base/muxer_util.h"
+#include "packager/media/base/pipeline_stats.h"
+#include "packager/media/base/request_signer.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/base/widevine_key_source.h"
+#include "packager/media/base/worker_pool.h"
+#include "packager/media/event/mpd_notify_muxer_listener.h"
+#include "packager/media/event/vod_media_info_dump_muxer_listener.h"
+#include "packager/media/file/file.h"
+#include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/mpd/base/simple_mpd_notifier.h"
+
+namespace edash_packager {
+namespace media {
+
+using event::MpdNotifyMuxerListener;
+using event::MuxerListener;
+using event::VodMediaInfoDumpMuxerListener;
+
+namespace {
+
+const size_t kMaxCachedKeySources = 16;
+
+// Demux and Mux(es) used to remux a source file/stream. Run by a
+// JobScheduler.
+class RemuxJob : public JobScheduler::Job {
+ public:
+  RemuxJob(const std::string& input,
+           scoped_ptr<Demuxer> demuxer,
+           int muxer_queue_size)
+      : input_(input),
+        demuxer_(demuxer.Pass()),
+        muxer_queue_size_(muxer_queue_size) {}
+
+  virtual ~RemuxJob() {
+    STLDeleteElements(&muxers_);
+  }
+
+  void AddMuxer(scoped_ptr<Muxer> mux) {
+    muxers_.push_back(mux.release());
+  }
+
+  const std::string& input() const { return input_; }
+  Demuxer* demuxer() { return demuxer_.get(); }
+  bool has_muxers() const { return !muxers_.empty(); }
+
+  virtual Status Run() OVERRIDE {
+    DCHECK(demuxer_);
+    StartMuxerPipelines();
+    return StopMuxerPipelines(demuxer_->Run());
+  }
+
+  virtual void Cancel() OVERRIDE {
+    demuxer_->Cancel();
+    // The demuxer may be blocked on a full muxer queue.
+    for (std::vector<Muxer*>::iterator it = muxers_.begin();
+         it != muxers_.end();
+         ++it) {
+      (*it)->Cancel();
+    }
+  }
+
+  // Live inputs received through a LiveIngestReactor are remuxed on the
+  // threads of the reactor.
+  virtual bool IsAsynchronous() OVERRIDE {
+    return demuxer_->SupportsRunAsync();
+  }
+
+  virtual void Start(const DoneCB& done_cb) OVERRIDE {
+    StartMuxerPipelines();
+    demuxer_->RunAsync(base::Bind(
+        &RemuxJob::OnDemuxerDone, base::Unretained(this), done_cb));
+  }
+
+ private:
+  void StartMuxerPipelines() {
+    if (muxer_queue_size_ <= 0)
+      return;
+    for (std::vector<Muxer*>::iterator it = muxers_.begin();
+         it != muxers_.end();
+         ++it) {
+      (*it)->StartPipeline(muxer_queue_size_);
+    }
+  }
+
+  // Returns |status|, or the first muxer error if |status| is OK.
+  Status StopMuxerPipelines(Status status) {
+    // The muxer threads, if any, have to be stopped even if demuxing failed.
+    for (std::vector<Muxer*>::iterator it = muxers_.begin();
+         it != muxers_.end();
+         ++it) {
+      Status muxer_status = (*it)->StopPipeline();
+      if (status.ok())
+        status = muxer_status;
+    }
+    return status;
+  }
+
+  void OnDemuxerDone(const DoneCB& done_cb, const Status& status) {
+    done_cb.Run(StopMuxerPipelines(status));
+  }
+
+  std::string input_;
+  scoped_ptr<Demuxer> demuxer_;
+  int muxer_queue_size_;
+  std::vector<Muxer*> muxers_;
+
+  DISALLOW_COPY_AND_ASSIGN(RemuxJob);
+};
+
+void DumpStreamInfo(const std::vector<MediaStream*>& streams) {
+  printf("Found %zu stream(s).\n", streams.size());
+  for (size_t i = 0; i < streams.size(); ++i)
+    printf("Stream [%zu] %s\n", i, streams[i]->info()->ToString().c_str());
+}
+
+Status CreateSigner(const WidevineKeyServerParams& params,
+                    scoped_ptr<RequestSigner>* signer) {
+  if (!params.aes_signing_key.empty()) {
+    signer->reset(AesRequestSigner::CreateSigner(
+        params.signer, params.aes_signing_key, params.aes_signing_iv));
+    if (!*signer) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Cannot create an AES signer object from '" +
+                        params.aes_signing_key + "':'" +
+                        params.aes_signing_iv + "'.");
+    }
+  } else if (!params.rsa_signing_key_path.empty()) {
+    std::string rsa_private_key;
+    if (!File::ReadFileToString(params.rsa_signing_key_path.c_str(),
+                                &rsa_private_key)) {
+      return Status(error::FILE_FAILURE,
+                    "Failed to read from '" + params.rsa_signing_key_path +
+                        "'.");
+    }
+    signer->reset(RsaRequestSigner::CreateSigner(params.signer,
+                                                 rsa_private_key));
+    if (!*signer) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Cannot create a RSA signer object from '" +
+                        params.rsa_signing_key_path + "'.");
+    }
+  }
+  return Status::OK;
+}
+
+Status CreateWidevineKeySource(const WidevineKeyServerParams& params,
+                               scoped_ptr<WidevineKeySource>* key_source) {
+  key_source->reset(new WidevineKeySource(params.key_server_url));
+  if (!params.signer.empty()) {
+    scoped_ptr<RequestSigner> request_signer;
+    Status status = CreateSigner(params, &request_signer);
+    if (!status.ok())
+      return status;
+    (*key_source)->set_signer(request_signer.Pass());
+  }
+  return Status::OK;
+}
+
+Status CreateEncryptionKeySource(const EncryptionParams& params,
+                                 scoped_ptr<KeySource>* key_source) {
+  if (params.key_provider == kWidevineKeyProvider) {
+    scoped_ptr<WidevineKeySource> widevine_key_source;
+    Status status =
+        CreateWidevineKeySource(params.key_server, &widevine_key_source);
+    if (!status.ok())
+      return status;
+
+    std::vector<uint8_t> content_id;
+    if (!base::HexStringToBytes(params.content_id, &content_id)) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Invalid content_id hex string specified.");
+    }
+    status = widevine_key_source->FetchKeys(content_id, params.policy);
+    if (!status.ok())
+      return status;
+    *key_source = widevine_key_source.Pass();
+  } else if (params.key_provider == kFixedKeyProvider) {
+    *key_source = KeySource::CreateFromHexStrings(
+        params.key_id, params.key, params.pssh, "");
+    if (!*key_source) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Invalid fixed encryption key.");
+    }
+  }
+  return Status::OK;
+}
+
+Status CreateDecryptionKeySource(const DecryptionParams& params,
+                                 scoped_ptr<KeySource>* key_source) {
+  if (params.key_provider == kWidevineKeyProvider) {
+    scoped_ptr<WidevineKeySource> widevine_key_source;
+    Status status =
+        CreateWidevineKeySource(params.key_server, &widevine_key_source);
+    if (!status.ok())
+      return status;
+    *key_source = widevine_key_source.Pass();
+  } else if (params.key_provider == kFixedKeyProvider) {
+    *key_source =
+        KeySource::CreateFromHexStrings(params.key_id, params.key, "", "");
+    if (!*key_source) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Invalid fixed decryption key.");
+    }
+  }
+  return Status::OK;
+}
+
+MediaStream* FindFirstStreamOfType(const std::vector<MediaStream*>& streams,
+                                   StreamType stream_type) {
+  typedef std::vector<MediaStream*>::const_iterator StreamIterator;
+  for (StreamIterator it = streams.begin(); it != streams.end(); ++it) {
+    if ((*it)->info()->stream_type() == stream_type)
+      return *it;
+  }
+  return NULL;
+}
+
+Status AddStreamToMuxer(const std::vector<MediaStream*>& streams,
+                        const std::string& stream_selector,
+                        Muxer* muxer) {
+  DCHECK(muxer);
+
+  MediaStream* stream = NULL;
+  if (stream_selector == "video") {
+    stream = FindFirstStreamOfType(streams, kStreamVideo);
+  } else if (stream_selector == "audio") {
+    stream = FindFirstStreamOfType(streams, kStreamAudio);
+  } else {
+    // Expect stream_selector to be a zero based stream id.
+    size_t stream_id;
+    if (!base::StringToSizeT(stream_selector, &stream_id) ||
+        stream_id >= streams.size()) {
+      return Status(error::INVALID_ARGUMENT,
+                    base::StringPrintf(
+                        "Invalid stream selector '%s'; should be 'audio', "
+                        "'video', or a number within [0, %zu].",
+                        stream_selector.c_str(), streams.size() - 1));
+    }
+    stream = streams[stream_id];
+    DCHECK(stream);
+  }
+
+  // This could occur only if stream_selector=audio|video and the corresponding
+  // stream does not exist in the input.
+  if (!stream) {
+    return Status(error::INVALID_ARGUMENT,
+                  "No " + stream_selector + " stream found in the input.");
+  }
+  muxer->AddStream(stream);
+  return Status::OK;
+}
+
+Status ValidateKeyServerParams(const WidevineKeyServerParams& params) {
+  if (params.key_server_url.empty())
+    return Status(error::INVALID_ARGUMENT, "Key server URL not specified.");
+  if (!params.aes_signing_key.empty() && !params.rsa_signing_key_path.empty()) {
+    return Status(error::INVALID_ARGUMENT,
+                  "AES and RSA signing keys are exclusive.");
+  }
+  if (!params.signer.empty() && params.rsa_signing_key_path.empty() &&
+      (params.aes_signing_key.empty() || params.aes_signing_iv.empty())) {
+    return Status(error::INVALID_ARGUMENT,
+                  "AES signing key and IV or RSA signing key not specified.");
+  }
+  return Status::OK;
+}
+
+Status ValidateEncryptionParams(const EncryptionParams& params) {
+  if (params.key_provider == kWidevineKeyProvider) {
+    Status status = ValidateKeyServerParams(params.key_server);
+    if (!status.ok())
+      return status;
+    if (params.content_id.empty())
+      return Status(error::INVALID_ARGUMENT, "Content ID not specified.");
+  } else if (params.key_provider == kFixedKeyProvider) {
+    if (params.key_id.empty() || params.key.empty())
+      return Status(error::INVALID_ARGUMENT, "Key ID or key not specified.");
+  }
+  if (params.max_sd_pixels <= 0)
+    return Status(error::INVALID_ARGUMENT, "max_sd_pixels must be positive.");
+  if (params.crypto_period_duration < 0) {
+    return Status(error::INVALID_ARGUMENT,
+                  "crypto_period_duration should not be negative.");
+  }
+  if (params.crypto_period_duration > 0 &&
+      params.key_provider != kWidevineKeyProvider) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Key rotation requires the Widevine key provider.");
+  }
+  return Status::OK;
+}
+
+Status ValidateDecryptionParams(const DecryptionParams& params) {
+  if (params.key_provider == kWidevineKeyProvider)
+    return ValidateKeyServerParams(params.key_server);
+  if (params.key_provider == kFixedKeyProvider &&
+      (params.key_id.empty() || params.key.empty())) {
+    return Status(error::INVALID_ARGUMENT, "Key ID or key not specified.");
+  }
+  return Status::OK;
+}
+
+Status ValidateParams(const PackagingParams& params,
+                      const std::vector<StreamDescriptor>& stream_descriptors) {
+  Status status = ValidateEncryptionParams(params.encryption_params);
+  if (!status.ok())
+    return status;
+  status = ValidateDecryptionParams(params.decryption_params);
+  if (!status.ok())
+    return status;
+  if (params.output_media_info && !params.mpd_output.empty()) {
+    return Status(error::UNIMPLEMENTED,
+                  "output_media_info and mpd_output do not work together.");
+  }
+  if (params.output_media_info && !params.muxer_options.single_segment) {
+    // TODO(rkuroiwa, kqyang): Support partial media info dump for live.
+    return Status(error::UNIMPLEMENTED,
+                  "output_media_info is only supported with single_segment.");
+  }
+  if (stream_descriptors.empty())
+    return Status(error::INVALID_ARGUMENT, "No stream specified.");
+  for (size_t i = 0; i < stream_descriptors.size(); ++i) {
+    const StreamDescriptor& descriptor = stream_descriptors[i];
+    if (descriptor.input.empty())
+      return Status(error::INVALID_ARGUMENT, "Stream input not specified.");
+    if (params.dump_stream_info && descriptor.output.empty())
+      continue;
+    if (descriptor.stream_selector.empty()) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Stream stream_selector not specified.");
+    }
+    if (descriptor.output.empty())
+      return Status(error::INVALID_ARGUMENT, "Stream output not specified.");
+    if (!descriptor.segment_template.empty() &&
+        !ValidateSegmentTemplate(descriptor.segment_template)) {
+      return Status(error::INVALID_ARGUMENT,
+                    "Segment template with '" + descriptor.segment_template +
+                        "' is invalid.");
+    }
+  }
+  return Status::OK;
+}
+
+// Writes the performance report of a job to a file, periodically while the
+// job runs if an interval is set, and once more on destruction.
+class PerformanceReportWriter {
+ public:
+  PerformanceReportWriter(const PipelineStats* pipeline_stats,
+                          const std::string& output_file_name,
+                          double interval_in_seconds)
+      : pipeline_stats_(pipeline_stats),
+        output_file_name_(output_file_name),
+        interval_(base::TimeDelta::FromMilliseconds(
+            static_cast<int64_t>(interval_in_seconds * 1000))),
+        stop_event_(true, false) {
+    DCHECK(pipeline_stats_);
+    if (interval_ > base::TimeDelta()) {
+      writer_thread_.reset(new ClosureThread(
+          "PerformanceReportWriter",
+          base::Bind(&PerformanceReportWriter::WriterLoop,
+                     base::Unretained(this))));
+      writer_thread_->Start();
+    }
+  }
+
+  ~PerformanceReportWriter() {
+    if (writer_thread_) {
+      stop_event_.Signal();
+      writer_thread_->Join();
+    }
+    WriteReport();
+  }
+
+ private:
+  void WriterLoop() {
+    while (!stop_event_.TimedWait(interval_))
+      WriteReport();
+  }
+
+  void WriteReport() {
+    const std::string report = pipeline_stats_->ToJson();
+    File* file = File::Open(output_file_name_.c_str(), "w");
+    if (!file) {
+      LOG(ERROR) << "Cannot open " << output_file_name_ << " for writing.";
+      return;
+    }
+    if (file->Write(report.data(), report.size()) !=
+        static_cast<int64_t>(report.size())) {
+      LOG(ERROR) << "Failed to write the performance report to "
+                 << output_file_name_;
+    }
+    if (!file->Close())
+      LOG(WARNING) << "Failed to close " << output_file_name_;
+  }
+
+  const PipelineStats* pipeline_stats_;
+  const std::string output_file_name_;
+  const base::TimeDelta interval_;
+  base::WaitableEvent stop_event_;
+  scoped_ptr<ClosureThread> writer_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerformanceReportWriter);
+};
+
+Status CreateRemuxJobs(const PackagingParams& params,
+                       const std::vector<StreamDescriptor>& stream_descriptors,
+                       KeySource* key_source,
+                       WorkerPool* encryption_worker_pool,
+                       LiveIngestReactor* live_ingest_reactor,
+                       PipelineStats* pipeline_stats,
+                       MpdNotifier* mpd_notifier,
+                       std::vector<MuxerListener*>* muxer_listeners,
+                       std::vector<RemuxJob*>* remux_jobs) {
+  DCHECK(muxer_listeners);
+  DCHECK(remux_jobs);
+
+  const EncryptionParams& encryption_params = params.encryption_params;
+  // Every input is demuxed once, by a single job feeding all the muxers of
+  // the input, however its descriptors are ordered.
+  std::map<std::string, RemuxJob*> remux_job_by_input;
+  for (std::vector<StreamDescriptor>::const_iterator stream_iter =
+           stream_descriptors.begin();
+       stream_iter != stream_descriptors.end();
+       ++stream_iter) {
+    // Process stream descriptor.
+    MuxerOptions stream_muxer_options(params.muxer_options);
+    stream_muxer_options.output_file_name = stream_iter->output;
+    stream_muxer_options.segment_template = stream_iter->segment_template;
+    stream_muxer_options.bandwidth = stream_iter->bandwidth;
+    stream_muxer_options.encryption_worker_pool = encryption_worker_pool;
+
+    RemuxJob*& remux_job = remux_job_by_input[stream_iter->input];
+    if (!remux_job) {
+      // New remux job needed. Create demux and job.
+      scoped_ptr<Demuxer> demuxer(new Demuxer(stream_iter->input));
+      if (params.decryption_params.key_provider != kNoKeyProvider) {
+        scoped_ptr<KeySource> decryption_key_source;
+        Status status = CreateDecryptionKeySource(params.decryption_params,
+                                                  &decryption_key_source);
+        if (!status.ok())
+          return status;
+        demuxer->SetKeySource(decryption_key_source.Pass());
+      }
+      if (params.read_ahead_num_buffers >= 2 &&
+          params.read_ahead_buffer_size > 0) {
+        demuxer->EnableReadAhead(params.read_ahead_num_buffers,
+                                 params.read_ahead_buffer_size);
+      }
+      if (live_ingest_reactor)
+        demuxer->SetLiveIngestReactor(live_ingest_reactor);
+      if (pipeline_stats)
+        demuxer->SetPipelineStats(pipeline_stats);
+      Status status = demuxer->Initialize();
+      if (!status.ok())
+        return status;
+      if (params.dump_stream_info) {
+        printf("\nFile \"%s\":\n", stream_iter->input.c_str());
+        DumpStreamInfo(demuxer->streams());
+      }
+      remux_jobs->push_back(new RemuxJob(
+          stream_iter->input, demuxer.Pass(), params.muxer_queue_size));
+      remux_job = remux_jobs->back();
+    }
+    if (params.dump_stream_info && stream_iter->output.empty())
+      continue;  // just need stream info.
+
+    scoped_ptr<Muxer> muxer(new mp4::MP4Muxer(stream_muxer_options));
+    if (key_source) {
+      muxer->SetKeySource(key_source,
+                          encryption_params.max_sd_pixels,
+                          encryption_params.clear_lead,
+                          encryption_params.crypto_period_duration);
+    }
+    if (pipeline_stats)
+      muxer->SetPipelineStats(pipeline_stats);
+
+    scoped_ptr<MuxerListener> muxer_listener;
+    DCHECK(!(params.output_media_info && mpd_notifier));
+    if (params.output_media_info) {
+      const std::string output_mpd_file_name =
+          stream_muxer_options.output_file_name + ".media_info";
+      scoped_ptr<VodMediaInfoDumpMuxerListener>
+          vod_media_info_dump_muxer_listener(
+              new VodMediaInfoDumpMuxerListener(output_mpd_file_name));
+      vod_media_info_dump_muxer_listener->SetContentProtectionSchemeIdUri(
+          params.scheme_id_uri);
+      muxer_listener = vod_media_info_dump_muxer_listener.Pass();
+    }
+    if (mpd_notifier) {
+      scoped_ptr<MpdNotifyMuxerListener> mpd_notify_muxer_listener(
+          new MpdNotifyMuxerListener(mpd_notifier));
+      mpd_notify_muxer_listener->SetContentProtectionSchemeIdUri(
+          params.scheme_id_uri);
+      muxer_listener = mpd_notify_muxer_listener.Pass();
+    }
+
+    if (muxer_listener) {
+      muxer_listeners->push_back(muxer_listener.release());
+      muxer->SetMuxerListener(muxer_listeners->back());
+    }
+
+    Status status = AddStreamToMuxer(remux_job->demuxer()->streams(),
+                                     stream_iter->stream_selector,
+                                     muxer.get());
+    if (!status.ok())
+      return status;
+    remux_job->AddMuxer(muxer.Pass());
+  }
+
+  // Drop the jobs of the inputs that only had their stream info dumped.
+  std::vector<RemuxJob*>::iterator job_iter = remux_jobs->begin();
+  while (job_iter != remux_jobs->end()) {
+    if ((*job_iter)->has_muxers()) {
+      ++job_iter;
+    } else {
+      delete *job_iter;
+      job_iter = remux_jobs->erase(job_iter);
+    }
+  }
+  return Status::OK;
+}
+
+Status RunRemuxJobs(const std::vector<RemuxJob*>& remux_jobs,
+                    JobScheduler* scheduler) {
+  for (std::vector<RemuxJob*>::const_iterator job_iter = remux_jobs.begin();
+       job_iter != remux_jobs.end();
+       ++job_iter) {
+    scheduler->AddJob((*job_iter)->input(), *job_iter);
+  }
+
+  Status status = scheduler->Run();
+
+  const std::vector<JobScheduler::JobStats>& job_stats =
+      scheduler->job_stats();
+  for (size_t i = 0; i < job_stats.size(); ++i) {
+    LOG(INFO) << "Remux job for '" << job_stats[i].name << "': "
+              << job_stats[i].status.ToString() << ", wall time "
+              << job_stats[i].wall_time.InSecondsF() << "s, CPU time "
+              << job_stats[i].cpu_time.InSecondsF() << "s.";
+  }
+  return status;
+}
+
+}  // namespace
+
+StreamDescriptor::StreamDescriptor() : bandwidth(0) {}
+
+StreamDescriptor::~StreamDescriptor() {}
+
+WidevineKeyServerParams::WidevineKeyServerParams() {}
+
+WidevineKeyServerParams::~WidevineKeyServerParams() {}
+
+EncryptionParams::EncryptionParams()
+    : key_provider(kNoKeyProvider),
+      max_sd_pixels(768 * 576),
+      clear_lead(0),
+      crypto_period_duration(0) {}
+
+EncryptionParams::~EncryptionParams() {}
+
+DecryptionParams::DecryptionParams() : key_provider(kNoKeyProvider) {}
+
+DecryptionParams::~DecryptionParams() {}
+
+PackagingParams::PackagingParams()
+    : output_media_info(false),
+      scheme_id_uri("urn:uuid:edef8ba9-79d6-4ace-a3c8-27dcd51d21ed"),
+      dump_stream_info(false),
+      muxer_queue_size(0),
+      read_ahead_num_buffers(0),
+      read_ahead_buffer_size(0x40000),
+      performance_report_interval(0) {}
+
+PackagingParams::~PackagingParams() {}
+
+Packager::Packager(size_t num_remux_threads, size_t num_encryption_threads)
+    : key_source_cache_(
+          new KeySourceCache(kMaxCachedKeySources,
+                             base::Bind(&CreateEncryptionKeySource))) {
+  if (num_remux_threads > 0)
+    remux_worker_pool_.reset(new WorkerPool("RemuxJob", num_remux_threads));
+  if (num_encryption_threads > 1) {
+    encryption_worker_pool_.reset(
+        new WorkerPool("EncryptionThread", num_encryption_threads));
+  }
+}
+
+Packager::~Packager() {}
+
+void Packager::EnableLiveIngest(size_t num_receive_threads,
+                                size_t num_worker_threads) {
+  DCHECK(!live_ingest_reactor_);
+  live_ingest_reactor_.reset(
+      new LiveIngestReactor(num_receive_threads, num_worker_threads));
+}
+
+Status Packager::Run(const PackagingParams& params,
+                     const std::vector<StreamDescriptor>& stream_descriptors) {
+  Status status = ValidateParams(params, stream_descriptors);
+  if (!status.ok())
+    return status;
+
+  const EncryptionParams& encryption_params = params.encryption_params;
+  if (encryption_params.key_provider == kNoKeyProvider)
+    return RunWithKeySource(params, stream_descriptors, NULL);
+
+  // Key sources with key rotation are not shared between jobs, as they
+  // produce keys for a single stream of crypto periods.
+  if (encryption_params.crypto_period_duration > 0) {
+    scoped_ptr<KeySource> key_source;
+    status = CreateEncryptionKeySource(encryption_params, &key_source);
+    if (!status.ok())
+      return status;
+    return RunWithKeySource(params, stream_descriptors, key_source.get());
+  }
+
+  // A key source missing from the cache is created, e.g. fetched from the
+  // key server, without blocking the jobs using other key sources.
+  KeySource* key_source = NULL;
+  status = key_source_cache_->Acquire(encryption_params, &key_source);
+  if (!status.ok())
+    return status;
+  status = RunWithKeySource(params, stream_descriptors, key_source);
+  key_source_cache_->Release(key_source);
+  return status;
+}
+
+Status Packager::RunWithKeySource(
+    const PackagingParams& params,
+    const std::vector<StreamDescriptor>& stream_descriptors,
+    KeySource* encryption_key_source) {
+  scoped_ptr<MpdNotifier> mpd_notifier;
+  if (!params.mpd_output.empty()) {
+    DashProfile profile = params.muxer_options.single_segment
+                              ? kOnDemandProfile
+                              : kLiveProfile;
+    mpd_notifier.reset(new SimpleMpdNotifier(profile,
+                                             params.mpd_options,
+                                             params.base_urls,
+                                             params.mpd_output));
+    if (!mpd_notifier->Init())
+      return Status(error::UNKNOWN, "MpdNotifier failed to initialize.");
+  }
+
+  // Declared before the jobs, which refer to it.
+  scoped_ptr<PipelineStats> pipeline_stats;
+  if (!params.performance_report_output.empty())
+    pipeline_stats.reset(new PipelineStats);
+
+  // TODO(kqyang): Should Muxer::SetMuxerListener take owership of the
+  // muxer_listeners object? Then we can get rid of |muxer_listeners|.
+  std::vector<MuxerListener*> muxer_listeners;
+  STLElementDeleter<std::vector<MuxerListener*> > deleter(&muxer_listeners);
+  std::vector<RemuxJob*> remux_jobs;
+  STLElementDeleter<std::vector<RemuxJob*> > scoped_jobs_deleter(&remux_jobs);
+  Status status = CreateRemuxJobs(params,
+                                  stream_descriptors,
+                                  encryption_key_source,
+                                  encryption_worker_pool_.get(),
+                                  live_ingest_reactor_.get(),
+                                  pipeline_stats.get(),
+                                  mpd_notifier.get(),
+                                  &muxer_listeners,
+                                  &remux_jobs);
+  if (!status.ok())
+    return status;
+
+  const size_t kUnlimitedConcurrentJobs = 0;
+  scoped_ptr<JobScheduler> scheduler(
+      remux_worker_pool_ ? new JobScheduler(remux_worker_pool_.get())
+                         : new JobScheduler(kUnlimitedConcurrentJobs));
+  {
+    // The report is also written if the job fails.
+    scoped_ptr<PerformanceReportWriter> report_writer;
+    if (pipeline_stats) {
+      report_writer.reset(
+          new PerformanceReportWriter(pipeline_stats.get(),
+                                      params.performance_report_output,
+                                      params.performance_report_interval));
+    }
+    status = RunRemuxJobs(remux_jobs, scheduler.get());
+  }
+  if (!status.ok())
+    return status;
+
+  if (mpd_notifier && !mpd_notifier->Flush())
+    return Status(error::FILE_FAILURE, "Failed to write the MPD.");
+  return Status::OK;
+}
+
+}  // namespace media
+}  // namespace edash_packager
@@ -9,12 +9,35 @@
     'common.gypi',
   ],
   'targets': [
+    {
+      'target_name': 'libpackager',
+      'type': 'static_library',
+      'sources': [
+        'key_source_cache.cc',
+        'key_source_cache.h',
+        'packager.cc',
+        'packager.h',
+      ],
+      'dependencies': [
+        'media/base/media_base.gyp:base',
+        'media/event/media_event.gyp:media_event',
+        'media/file/file.gyp:file',
+        'media/filters/filters.gyp:filters',
+        'media/formats/mp2t/mp2t.gyp:mp2t',
+        'media/formats/mp4/mp4.gyp:mp4',
+        'media/formats/mpeg/mpeg.gyp:mpeg',
+        'media/formats/wvm/wvm.gyp:wvm',
+        'mpd/mpd.gyp:mpd_builder',
+      ],
+    },
     {
       'target_name': 'packager',
       'type': 'executable',
       'sources': [
         'app/fixed_key_encryption_flags.cc',
         'app/fixed_key_encryption_flags.h',
+        'app/job_spool.cc',
+        'app/job_spool.h',
         'app/libcrypto_threading.cc',
         'app/libcrypto_threading.h',
         'app/mpd_flags.cc',
@@ -32,14 +55,9 @@
         'app/widevine_encryption_flags.h',
       ],
       'dependencies': [
-        'media/event/media_event.gyp:media_event',
+        'libpackager',
+        'media/base/media_base.gyp:base',
         'media/file/file.gyp:file',
-        'media/filters/filters.gyp:filters',
-        'media/formats/mp2t/mp2t.gyp:mp2t',
-        'media/formats/mp4/mp4.gyp:mp4',
-        'media/formats/mpeg/mpeg.gyp:mpeg',
-        'media/formats/wvm/wvm.gyp:wvm',
-        'mpd/mpd.gyp:mpd_builder',
         'third_party/gflags/gflags.gyp:gflags',
         'third_party/openssl/openssl.gyp:openssl',
       ],
@@ -81,10 +99,74 @@
         'testing/gtest.gyp:gtest',
       ],
     },
+    {
+      'target_name': 'packager_unittest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'key_source_cache_unittest.cc',
+        'packager_unittest.cc',
+      ],
+      'dependencies': [
+        'libpackager',
+        'media/base/media_base.gyp:base',
+        'media/test/media_test.gyp:media_test_support',
+        'testing/gtest.gyp:gtest',
+      ],
+    },
+    {
+      # Throughput of the hot kernels. Not run as part of the tests.
+      'target_name': 'packager_benchmarks',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'media/base/aes_encryptor_benchmark.cc',
+        'media/base/buffer_writer_benchmark.cc',
+        'media/filters/h264_benchmark.cc',
+        'media/formats/mp2t/mp2t_benchmark.cc',
+        'media/formats/mp4/mp4_benchmark.cc',
+        'media/test/benchmark_util.cc',
+        'media/test/benchmark_util.h',
+        'media/test/long_input_util.cc',
+        'media/test/long_input_util.h',
+        'mpd/base/mpd_builder_benchmark.cc',
+      ],
+      'dependencies': [
+        'media/base/media_base.gyp:base',
+        'media/file/file.gyp:file',
+        'media/filters/filters.gyp:filters',
+        'media/formats/mp2t/mp2t.gyp:mp2t',
+        'media/formats/mp4/mp4.gyp:mp4',
+        'media/test/media_test.gyp:media_test_support',
+        'mpd/mpd.gyp:mpd_builder',
+        'testing/gtest.gyp:gtest',
+      ],
+    },
+    {
+      # End-to-end throughput on long inputs, compared to stored baselines.
+      # Not run as part of the tests.
+      'target_name': 'packager_perf_test',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'media/test/benchmark_util.cc',
+        'media/test/benchmark_util.h',
+        'media/test/long_input_util.cc',
+        'media/test/long_input_util.h',
+        'media/test/packager_perf_test.cc',
+      ],
+      'dependencies': [
+        'libpackager',
+        'media/base/media_base.gyp:base',
+        'media/file/file.gyp:file',
+        'media/formats/mp2t/mp2t.gyp:mp2t',
+        'media/formats/mp4/mp4.gyp:mp4',
+        'media/test/media_test.gyp:media_test_support',
+        'testing/gtest.gyp:gtest',
+      ],
+    },
     {
       'target_name': 'All',
       'type': 'none',
       'dependencies': [
+        'libpackager',
         'media/base/media_base.gyp:*',
         'media/event/media_event.gyp:*',
         'media/file/file.gyp:*',
@@ -107,6 +189,7 @@
 #        'media/formats/wvm/wvm.gyp:wvm_unittest',
         'mpd/mpd.gyp:mpd_unittest',
         'packager_test',
+        'packager_unittest',
       ],
     },
   ],
@@ -0,0 +1,230 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+//
+// In-process packaging API. The packager binary is a thin command line
+// wrapper around it.
+
+#ifndef PACKAGER_PACKAGER_H_
+#define PACKAGER_PACKAGER_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/memory/scoped_ptr.h"
+#include "packager/media/base/muxer_options.h"
+#include "packager/media/base/status.h"
+#include "packager/mpd/base/mpd_builder.h"
+
+namespace edash_packager {
+namespace media {
+
+class KeySource;
+class KeySourceCache;
+class LiveIngestReactor;
+class WorkerPool;
+
+/// Defines a single input/output stream, it's input source, output destination,
+/// stream selector, and optional segment template and user-specified bandwidth.
+struct StreamDescriptor {
+  StreamDescriptor();
+  ~StreamDescriptor();
+
+  std::string stream_selector;
+  std::string input;
+  std::string output;
+  std::string segment_template;
+  uint32_t bandwidth;
+};
+
+/// Source of the keys used to encrypt or decrypt media.
+enum KeyProvider {
+  kNoKeyProvider,
+  /// Keys are fetched from a Widevine key server.
+  kWidevineKeyProvider,
+  /// Keys are specified directly, as hex strings.
+  kFixedKeyProvider,
+};
+
+/// Parameters of the requests to a Widevine key server.
+struct WidevineKeyServerParams {
+  WidevineKeyServerParams();
+  ~WidevineKeyServerParams();
+
+  /// Key server URL.
+  std::string key_server_url;
+  /// Name of the signer. If empty, requests are not signed.
+  std::string signer;
+  /// AES signing key, in hex. Exclusive with rsa_signing_key_path.
+  std::string aes_signing_key;
+  /// AES signing IV, in hex.
+  std::string aes_signing_iv;
+  /// Path of the RSA signing key file.
+  std::string rsa_signing_key_path;
+};
+
+/// Encryption parameters of a packaging job.
+struct EncryptionParams {
+  EncryptionParams();
+  ~EncryptionParams();
+
+  KeyProvider key_provider;
+
+  /// @name kWidevineKeyProvider only.
+  /// @{
+  WidevineKeyServerParams key_server;
+  /// Content identifier, in hex.
+  std::string content_id;
+  /// Name of a stored policy.
+  std::string policy;
+  /// @}
+
+  /// @name kFixedKeyProvider only. In hex.
+  /// @{
+  std::string key_id;
+  std::string key;
+  std::string pssh;
+  /// @}
+
+  /// Streams with more pixels per frame than this are encrypted with the HD
+  /// key.
+  int max_sd_pixels;
+  /// Duration of the clear lead, in seconds.
+  double clear_lead;
+  /// Duration of each crypto period, in seconds. If 0, the key is not
+  /// rotated.
+  int crypto_period_duration;
+};
+
+/// Decryption parameters of a packaging job.
+struct DecryptionParams {
+  DecryptionParams();
+  ~DecryptionParams();
+
+  KeyProvider key_provider;
+  /// kWidevineKeyProvider only.
+  WidevineKeyServerParams key_server;
+  /// @name kFixedKeyProvider only. In hex.
+  /// @{
+  std::string key_id;
+  std::string key;
+  /// @}
+};
+
+/// Parameters of a packaging job, other than its streams.
+struct PackagingParams {
+  PackagingParams();
+  ~PackagingParams();
+
+  /// Options of the muxers. The fields specific to a stream (output file
+  /// name, segment template and bandwidth) are set from its descriptor. The
+  /// encryption worker pool is the one of the Packager.
+  MuxerOptions muxer_options;
+
+  /// MPD output file name. If empty, no MPD is written.
+  std::string mpd_output;
+  MpdOptions mpd_options;
+  /// BaseURLs of the MPD.
+  std::vector<std::string> base_urls;
+
+  /// Write the MediaInfo of each output to <output>.media_info. Exclusive
+  /// with mpd_output, and only supported with single segment outputs.
+  bool output_media_info;
+  /// Scheme ID URI of the ContentProtection elements.
+  std::string scheme_id_uri;
+
+  /// Print the stream info of the inputs to standard output. Descriptors
+  /// without output are then only used to dump their input's stream info.
+  bool dump_stream_info;
+
+  /// Size of the queues between the demuxer and the muxer threads. If 0,
+  /// samples are muxed on the demuxer thread.
+  int muxer_queue_size;
+  /// If at least 2, the inputs are read ahead with this many buffers of
+  /// read_ahead_buffer_size bytes.
+  int read_ahead_num_buffers;
+  int read_ahead_buffer_size;
+
+  /// If not empty, a JSON report of the time spent and the data processed by
+  /// each stage of the pipeline, for each stream, is written to this file
+  /// when the job completes. See PipelineStats::ToJson for its format.
+  std::string performance_report_output;
+  /// If positive, the report is also rewritten at this interval, in seconds,
+  /// while the job runs. Useful for live jobs.
+  double performance_report_interval;
+
+  EncryptionParams encryption_params;
+  DecryptionParams decryption_params;
+};
+
+/// Runs packaging jobs in process, without any global configuration.
+///
+/// Jobs can run concurrently, with different parameters. Their inputs are
+/// remuxed on threads which may be shared by all the jobs, and encryption
+/// key sources are shared by the jobs with the same encryption parameters.
+///
+/// Note: The application should enable thread safety of libcrypto before
+/// running jobs, e.g. with LibcryptoThreading.
+///
+/// Thread Safety: Run() may be called from several threads at once.
+class Packager {
+ public:
+  /// @param num_remux_threads is the number of threads remuxing the inputs
+  ///        of all the jobs. Inputs are queued until a thread is available.
+  ///        If 0, each input gets its own thread. Live inputs need one
+  ///        thread each, unless live ingest is enabled.
+  /// @param num_encryption_threads is the number of threads encrypting the
+  ///        fragments of all the outputs of all the jobs. If less than 2,
+  ///        samples are encrypted one by one on the muxer threads.
+  Packager(size_t num_remux_threads, size_t num_encryption_threads);
+  ~Packager();
+
+  /// Receive the UDP inputs of all the jobs through a shared
+  /// LiveIngestReactor, which parses them on a fixed number of threads,
+  /// instead of reading each of them on its own remux thread. Live inputs
+  /// then do not use the remux threads, so that the number of channels is
+  /// not limited by the number of threads. Only supported on Linux. Should be
+  /// called before Run().
+  /// @param num_receive_threads is the number of threads receiving from the
+  ///        sockets of the inputs. Should not be 0.
+  /// @param num_worker_threads is the number of threads parsing and muxing
+  ///        the inputs. Should not be 0.
+  void EnableLiveIngest(size_t num_receive_threads, size_t num_worker_threads);
+
+  /// Run a packaging job and wait for it to complete. The first input which
+  /// fails cancels the other inputs of the job.
+  /// @param params contains the parameters of the job.
+  /// @param stream_descriptors describes the streams to package. Each input
+  ///        is read once, however many of its streams are packaged.
+  /// @return OK on success, an error status otherwise.
+  Status Run(const PackagingParams& params,
+             const std::vector<StreamDescriptor>& stream_descriptors);
+
+ private:
+  // Runs a validated job. |encryption_key_source| is NULL if the job is not
+  // encrypted.
+  Status RunWithKeySource(
+      const PackagingParams& params,
+      const std::vector<StreamDescriptor>& stream_descriptors,
+      KeySource* encryption_key_source);
+
+  // Set if the threads are shared by the jobs.
+  scoped_ptr<WorkerPool> remux_worker_pool_;
+  // Set if parallel encryption is enabled. Shared by all the muxers.
+  scoped_ptr<WorkerPool> encryption_worker_pool_;
+  // Set if live ingest is enabled. Shared by the UDP inputs.
+  scoped_ptr<LiveIngestReactor> live_ingest_reactor_;
+
+  scoped_ptr<KeySourceCache> key_source_cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(Packager);
+};
+
+}  // namespace media
+}  // namespace edash_packager
+
+#endif  // PACKAGER_PACKAGER_H_
@@ -0,0 +1,207 @@
+// Copyright 2014 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/file_util.h"
+#include "packager/base/files/file_path.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/test/status_test_util.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/packager.h"
+
+namespace edash_packager {
+namespace media {
+
+namespace {
+
+const char kInput[] = "bear-1280x720.mp4";
+const char kKeyIdHex[] = "e5007e6e9dcd5ac095202ed3758382cd";
+const char kKeyHex[] = "6fc96fe628a265b13aeddec0bc421f4d";
+const size_t kNumRemuxThreads = 2;
+const size_t kNumEncryptionThreads = 2;
+const int kNumConcurrentRuns = 4;
+
+void RunJob(Packager* packager,
+            const PackagingParams* params,
+            const std::vector<StreamDescriptor>* stream_descriptors,
+            Status* status) {
+  *status = packager->Run(*params, *stream_descriptors);
+}
+
+}  // namespace
+
+class PackagerTest : public ::testing::Test {
+ public:
+  PackagerTest() : packager_(kNumRemuxThreads, kNumEncryptionThreads) {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(base::CreateNewTempDirectory("packager_", &test_directory_));
+  }
+
+  virtual void TearDown() OVERRIDE { base::DeleteFile(test_directory_, true); }
+
+ protected:
+  std::string GetFullPath(const std::string& file_name) {
+    return test_directory_.AppendASCII(file_name).value();
+  }
+
+  PackagingParams GetParams() {
+    PackagingParams params;
+    params.muxer_options.single_segment = true;
+    params.muxer_options.segment_duration = 1.0;
+    params.muxer_options.fragment_duration = 0.1;
+    params.muxer_options.temp_dir = test_directory_.value();
+    return params;
+  }
+
+  std::vector<StreamDescriptor> GetStreamDescriptors(
+      const std::string& output_prefix) {
+    std::vector<StreamDescriptor> stream_descriptors(2);
+    stream_descriptors[0].input = GetTestDataFilePath(kInput).value();
+    stream_descriptors[0].stream_selector = "video";
+    stream_descriptors[0].output = GetFullPath(output_prefix + "video.mp4");
+    stream_descriptors[1].input = GetTestDataFilePath(kInput).value();
+    stream_descriptors[1].stream_selector = "audio";
+    stream_descriptors[1].output = GetFullPath(output_prefix + "audio.mp4");
+    return stream_descriptors;
+  }
+
+  base::FilePath test_directory_;
+  Packager packager_;
+};
+
+TEST_F(PackagerTest, Run) {
+  ASSERT_OK(packager_.Run(GetParams(), GetStreamDescriptors("")));
+  EXPECT_TRUE(base::PathExists(base::FilePath(GetFullPath("video.mp4"))));
+  EXPECT_TRUE(base::PathExists(base::FilePath(GetFullPath("audio.mp4"))));
+}
+
+TEST_F(PackagerTest, ConcurrentRunsWithDifferentParams) {
+  std::vector<PackagingParams> params(kNumConcurrentRuns, GetParams());
+  std::vector<std::vector<StreamDescriptor> > stream_descriptors;
+  for (int i = 0; i < kNumConcurrentRuns; ++i) {
+    stream_descriptors.push_back(
+        GetStreamDescriptors(base::StringPrintf("%d_", i)));
+  }
+  // Clear and encrypted, single and multiple segment outputs, with two runs
+  // sharing the same key source.
+  params[1].muxer_options.single_segment = false;
+  for (size_t i = 0; i < stream_descriptors[1].size(); ++i) {
+    stream_descriptors[1][i].segment_template =
+        GetFullPath(base::StringPrintf("1_%zu_$Number$.m4s", i));
+  }
+  for (int i = 2; i < kNumConcurrentRuns; ++i) {
+    params[i].encryption_params.key_provider = kFixedKeyProvider;
+    params[i].encryption_params.key_id = kKeyIdHex;
+    params[i].encryption_params.key = kKeyHex;
+  }
+  params[3].muxer_queue_size = 4;
+
+  std::vector<Status> statuses(kNumConcurrentRuns);
+  std::vector<ClosureThread*> threads;
+  for (int i = 0; i < kNumConcurrentRuns; ++i) {
+    threads.push_back(new ClosureThread(
+        "PackagerRun",
+        base::Bind(&RunJob, &packager_, &params[i], &stream_descriptors[i],
+                   &statuses[i])));
+    threads.back()->Start();
+  }
+  for (int i = 0; i < kNumConcurrentRuns; ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  for (int i = 0; i < kNumConcurrentRuns; ++i) {
+    EXPECT_OK(statuses[i]) << "Run " << i;
+    for (size_t j = 0; j < stream_descriptors[i].size(); ++j) {
+      EXPECT_TRUE(base::PathExists(
+          base::FilePath(stream_descriptors[i][j].output)));
+    }
+  }
+  // Each run used its own parameters.
+  EXPECT_FALSE(base::ContentsEqual(base::FilePath(GetFullPath("0_video.mp4")),
+                                   base::FilePath(GetFullPath("2_video.mp4"))));
+}
+
+TEST_F(PackagerTest, NoStream) {
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(GetParams(), std::vector<StreamDescriptor>())
+                .error_code());
+}
+
+TEST_F(PackagerTest, MissingStreamFields) {
+  std::vector<StreamDescriptor> stream_descriptors = GetStreamDescriptors("");
+  stream_descriptors[1].output.clear();
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(GetParams(), stream_descriptors).error_code());
+
+  stream_descriptors = GetStreamDescriptors("");
+  stream_descriptors[0].stream_selector.clear();
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(GetParams(), stream_descriptors).error_code());
+}
+
+TEST_F(PackagerTest, InvalidSegmentTemplate) {
+  PackagingParams params = GetParams();
+  params.muxer_options.single_segment = false;
+  std::vector<StreamDescriptor> stream_descriptors = GetStreamDescriptors("");
+  stream_descriptors[0].segment_template = GetFullPath("$Foo$.m4s");
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, stream_descriptors).error_code());
+}
+
+TEST_F(PackagerTest, MediaInfoWithMpdUnimplemented) {
+  PackagingParams params = GetParams();
+  params.output_media_info = true;
+  params.mpd_output = GetFullPath("output.mpd");
+  EXPECT_EQ(error::UNIMPLEMENTED,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+}
+
+TEST_F(PackagerTest, InvalidEncryptionParams) {
+  PackagingParams params = GetParams();
+  params.encryption_params.key_provider = kFixedKeyProvider;
+  params.encryption_params.key_id = kKeyIdHex;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+
+  params = GetParams();
+  params.encryption_params.key_provider = kWidevineKeyProvider;
+  params.encryption_params.content_id = "00";
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+
+  params = GetParams();
+  params.encryption_params.key_provider = kFixedKeyProvider;
+  params.encryption_params.key_id = kKeyIdHex;
+  params.encryption_params.key = kKeyHex;
+  params.encryption_params.crypto_period_duration = 10;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+}
+
+TEST_F(PackagerTest, InvalidFixedKey) {
+  PackagingParams params = GetParams();
+  params.encryption_params.key_provider = kFixedKeyProvider;
+  params.encryption_params.key_id = kKeyIdHex;
+  params.encryption_params.key = "not hex";
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+}
+
+TEST_F(PackagerTest, InvalidDecryptionParams) {
+  PackagingParams params = GetParams();
+  params.decryption_params.key_provider = kWidevineKeyProvider;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            packager_.Run(params, GetStreamDescriptors("")).error_code());
+}
+
+}  // namespace media
+}  // namespace edash_packager